@@ -0,0 +1,272 @@
+/*
+ * bridge.c
+ *
+ * @brief Transparent byte bridge between any two ports
+ * @description See bridge.h.
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: JonathanStorey
+ *    Hardware: EFM32GG11B Microcontroller, MAX14830 UART expanders
+ *     Version: 1.0
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "usart.h"
+#include "usart_expanders.h"
+#include "expander_io.h"
+#include "bridge.h"
+
+
+/*==============================================================================
+ * PER-DIRECTION STATE
+ *============================================================================*/
+typedef struct {
+    const bridge_endpoint_t *src;
+    const bridge_endpoint_t *dst;
+    uint8_t buf[2][BRIDGE_BUFFER_SIZE];     ///< Ping-pong buffers
+    volatile bool busy[2];                  ///< Buffer handed to the sink, not yet sent
+    uint8_t fill;                           ///< Index of the buffer being filled
+    uint16_t fill_len;                      ///< Bytes in buf[fill]
+    uint8_t out;                            ///< Expander sink: buffer being queued
+    uint16_t out_len;
+    uint16_t out_off;
+    uint32_t overrun_base;                  ///< Source overrun count when the bridge started
+    bridge_dir_stats_t stats;
+} bridge_dir_t;
+
+static bridge_dir_t bridge_dirs[2];
+
+
+/**
+ * @brief Map a menu key to a bridge endpoint
+ * @param key: '1'-'8' for a native port (destination_t + 1, never Expander),
+ *             'A'-'L' for expander channels A0-A3, B0-B3, C0-C3
+ * @param endpoint: Filled in on success
+ * @return true if the key names a usable endpoint
+ */
+bool bridge_endpoint_from_key(char key, bridge_endpoint_t *endpoint)
+{
+    if (key >= 'a' && key <= 'l')
+    {
+        key = (char)(key - 'a' + 'A');
+    }
+    if (key >= '1' && key <= '8' && (key - '1') != Expander)
+    {
+        endpoint->expander = false;
+        endpoint->port = (destination_t)(key - '1');
+        return true;
+    }
+    if (key >= 'A' && key <= 'L')
+    {
+        endpoint->expander = true;
+        endpoint->expander_id = (uint8_t)(EXPANDER_A + (key - 'A') / 4);
+        endpoint->channel = (uint8_t)((key - 'A') % 4);
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief uart_write_dma() completion - hand the buffer back to its direction
+ */
+static void bridge_dma_done(int port, const void *buf, size_t len)
+{
+    (void)port;
+    (void)len;
+
+    for (uint8_t d = 0; d < 2; d++)
+    {
+        for (uint8_t i = 0; i < 2; i++)
+        {
+            if (buf == bridge_dirs[d].buf[i])
+            {
+                bridge_dirs[d].busy[i] = false;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Pull whatever the source has ready into the fill buffer
+ * @return Number of bytes read
+ */
+static uint16_t bridge_source_read(bridge_dir_t *dir, uint8_t *dst, uint16_t space)
+{
+    const bridge_endpoint_t *src = dir->src;
+
+    if (src->expander)
+    {
+        return expander_read(EXPANDER_CHANNEL(src->expander_id, src->channel), dst, space);
+    }
+    return uart_read(src->port, dst, space, 0);
+}
+
+/**
+ * @brief Overruns so far on a direction's source
+ */
+static uint32_t bridge_source_overruns(const bridge_endpoint_t *src)
+{
+    expander_rx_stats_t rx;
+
+    if (!src->expander)
+    {
+        return uart_rx_overruns(src->port);
+    }
+    expander_get_rx_stats(EXPANDER_CHANNEL(src->expander_id, src->channel), &rx);
+    return rx.rx_overruns + rx.rx_dropped;
+}
+
+/**
+ * @brief Queue as much of the out buffer as the expander channel's TX queue takes
+ * @note expander_write() copies the bytes, so the buffer is free again as soon
+ *       as all of it is queued. Without the interrupt engine the queue is
+ *       refilled into the TX FIFO from here.
+ */
+static void bridge_drain_expander(bridge_dir_t *dir)
+{
+    const bridge_endpoint_t *dst = dir->dst;
+    uint8_t ch = EXPANDER_CHANNEL(dst->expander_id, dst->channel);
+
+    if (!expander_irq_enabled() && expander_tx_pending(ch))
+    {
+        expander_io_poll();
+    }
+    if (!dir->busy[dir->out])
+    {
+        return;
+    }
+    dir->out_off += expander_write(ch, &dir->buf[dir->out][dir->out_off], dir->out_len - dir->out_off);
+    if (dir->out_off == dir->out_len)
+    {
+        dir->busy[dir->out] = false;
+    }
+}
+
+/**
+ * @brief Move one direction on by one step without blocking
+ * @param escape: Set if the Node console escape byte was seen in this direction
+ */
+static void bridge_service(bridge_dir_t *dir, bool *escape)
+{
+    const bridge_endpoint_t *dst = dir->dst;
+    uint8_t *fill_buf = dir->buf[dir->fill];
+
+    /* Fill */
+    if (dir->fill_len < BRIDGE_BUFFER_SIZE)
+    {
+        uint16_t got = bridge_source_read(dir, &fill_buf[dir->fill_len], BRIDGE_BUFFER_SIZE - dir->fill_len);
+
+        if (got && !dir->src->expander && dir->src->port == Node)
+        {
+            for (uint16_t i = 0; i < got; i++)
+            {
+                if (fill_buf[dir->fill_len + i] == BRIDGE_ESCAPE)
+                {
+                    got = i;                                            // forward what came before it only
+                    *escape = true;
+                    break;
+                }
+            }
+        }
+        dir->fill_len += got;
+        dir->stats.bytes += got;
+    }
+
+    /* Swap - only once the other buffer is free to fill */
+    if (dir->fill_len && !dir->busy[dir->fill ^ 1])
+    {
+        dir->busy[dir->fill] = true;
+        if (dst->expander)
+        {
+            dir->out = dir->fill;
+            dir->out_len = dir->fill_len;
+            dir->out_off = 0;
+        }
+        else if (!uart_write_dma(dst->port, fill_buf, dir->fill_len, bridge_dma_done))
+        {
+            dir->busy[dir->fill] = false;                               // DMA queue full - try again next pass
+            return;
+        }
+        dir->fill ^= 1;
+        dir->fill_len = 0;
+    }
+
+    if (dst->expander)
+    {
+        bridge_drain_expander(dir);
+    }
+}
+
+/**
+ * @brief Forward bytes both ways between two endpoints until Ctrl-] on the Node console
+ * @param a: First endpoint
+ * @param b: Second endpoint
+ * @param stats: Per-direction byte and overrun counts (may be NULL)
+ * @return false if the endpoints are the same, true once the bridge has been closed
+ * @note Blocks the main loop while running
+ */
+bool bridge_run(const bridge_endpoint_t *a, const bridge_endpoint_t *b, bridge_stats_t *stats)
+{
+    bool escape = false;
+    bool node_endpoint;
+    uint8_t c;
+
+    if (a->expander == b->expander &&
+        (a->expander ? (a->expander_id == b->expander_id && a->channel == b->channel) : (a->port == b->port)))
+    {
+        return false;
+    }
+    node_endpoint = (!a->expander && a->port == Node) || (!b->expander && b->port == Node);
+
+    for (uint8_t d = 0; d < 2; d++)
+    {
+        bridge_dir_t *dir = &bridge_dirs[d];
+
+        dir->src = d ? b : a;
+        dir->dst = d ? a : b;
+        dir->busy[0] = false;
+        dir->busy[1] = false;
+        dir->fill = 0;
+        dir->fill_len = 0;
+        dir->out_len = 0;
+        dir->out_off = 0;
+        dir->stats.bytes = 0;
+        dir->stats.overruns = 0;
+        dir->overrun_base = bridge_source_overruns(dir->src);
+    }
+
+    while (!escape)
+    {
+        bridge_service(&bridge_dirs[0], &escape);
+        bridge_service(&bridge_dirs[1], &escape);
+
+        if (!node_endpoint && uart_read(Node, &c, 1, 0) && c == BRIDGE_ESCAPE)
+        {
+            escape = true;
+        }
+    }
+
+    for (uint8_t d = 0; d < 2; d++)                                     // let queued data finish before the buffers are reused
+    {
+        bridge_dir_t *dir = &bridge_dirs[d];
+
+        while (dir->busy[0] || dir->busy[1] ||
+               (dir->dst->expander && expander_tx_pending(EXPANDER_CHANNEL(dir->dst->expander_id, dir->dst->channel))))
+        {
+            if (dir->dst->expander)
+            {
+                bridge_drain_expander(dir);
+            }
+        }
+        dir->stats.overruns = bridge_source_overruns(dir->src) - dir->overrun_base;
+    }
+
+    if (stats)
+    {
+        stats->a_to_b = bridge_dirs[0].stats;
+        stats->b_to_a = bridge_dirs[1].stats;
+    }
+    return true;
+}
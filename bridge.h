@@ -0,0 +1,59 @@
+/*
+ * bridge.h
+ *
+ * @brief Transparent byte bridge between any two ports
+ * @description Cross-connects two endpoints - a native destination_t port or one
+ *              of the twelve MAX14830 expander channels - so a PC on one side
+ *              can talk straight to the device on the other. Each direction
+ *              has a pair of ping-pong buffers: one fills from the source while
+ *              the other drains to the sink (by LDMA on native ports, through
+ *              the channel's expander_write() queue on the expander), so
+ *              neither direction waits on the other.
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: JonathanStorey
+ *    Hardware: EFM32GG11B Microcontroller, MAX14830 UART expanders
+ *     Version: 1.0
+ *
+ * @note Ctrl-] (0x1D) typed on the Node console ends the bridge. When the Node
+ *       port is one of the endpoints the escape byte is not forwarded.
+ * @note Expander channels must already be powered and initialised
+ */
+
+#ifndef BRIDGE_H_
+#define BRIDGE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "defines.h"
+
+#define BRIDGE_BUFFER_SIZE      256     ///< Bytes in each ping-pong buffer
+#define BRIDGE_ESCAPE           0x1D    ///< Ctrl-] ends the bridge
+
+/*==============================================================================
+ * TYPES
+ *============================================================================*/
+typedef struct {
+    bool expander;                  ///< true = MAX14830 channel, false = native port
+    destination_t port;             ///< Native port (expander == false)
+    uint8_t expander_id;            ///< EXPANDER_A/B/C (expander == true)
+    uint8_t channel;                ///< Expander UART 0-3 (expander == true)
+} bridge_endpoint_t;
+
+typedef struct {
+    uint32_t bytes;                 ///< Bytes forwarded
+    uint32_t overruns;              ///< Source overruns while the bridge ran
+} bridge_dir_stats_t;
+
+typedef struct {
+    bridge_dir_stats_t a_to_b;
+    bridge_dir_stats_t b_to_a;
+} bridge_stats_t;
+
+/*==============================================================================
+ * FUNCTION DECLARATIONS
+ *============================================================================*/
+bool bridge_endpoint_from_key(char key, bridge_endpoint_t *endpoint);
+bool bridge_run(const bridge_endpoint_t *a, const bridge_endpoint_t *b, bridge_stats_t *stats);
+
+#endif /* BRIDGE_H_ */
@@ -0,0 +1,122 @@
+/*
+ * dma.c
+ *
+ * @brief LDMA ownership and channel allocation for the node firmware
+ * @description See dma.h. Drivers start transfers with the emlib LDMA API and
+ *              register a callback for their channel; this file clears the
+ *              channel flag and calls it.
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: JonathanStorey
+ *    Hardware: EFM32GG11B Microcontroller
+ *     Version: 1.0
+ */
+
+#include <stddef.h>
+#include "em_device.h"
+#include "em_cmu.h"
+#include "em_ldma.h"
+#include "dma.h"
+
+
+static dma_channel_callback_t channel_callbacks[DMA_CHAN_COUNT];
+static void *channel_contexts[DMA_CHAN_COUNT];
+static volatile uint32_t dma_errors = 0;
+static bool dma_initialised = false;
+
+
+/**
+ * @brief Initialise the LDMA (safe to call more than once)
+ * @param None
+ * @return None
+ */
+void dma_init(void)
+{
+    if (dma_initialised)
+    {
+        return;
+    }
+
+    CMU_ClockEnable(cmuClock_LDMA, true);
+
+    LDMA_Init_t init = LDMA_INIT_DEFAULT;
+    LDMA_Init(&init);                           // also enables LDMA_IRQn
+
+    dma_initialised = true;
+}
+
+/**
+ * @brief Register the completion callback for a channel
+ * @param channel: LDMA channel (see DMA_CH_xxx)
+ * @param callback: Function to call when the channel's DONE flag is raised
+ * @param ctx: Passed back to the callback
+ */
+void dma_set_callback(unsigned int channel, dma_channel_callback_t callback, void *ctx)
+{
+    if (channel < DMA_CHAN_COUNT)
+    {
+        channel_contexts[channel] = ctx;
+        channel_callbacks[channel] = callback;
+    }
+}
+
+/**
+ * @brief Number of LDMA bus errors seen since start-up
+ */
+uint32_t dma_error_count(void)
+{
+    return dma_errors;
+}
+
+/**
+ * @brief Run a channel's completion callback by hand if its transfer is done
+ * @param channel: LDMA channel (see DMA_CH_xxx)
+ * @return true if the channel had finished and its callback was called
+ * @note Only for code that waits on a transfer while LDMA_IRQHandler() cannot
+ *       run (interrupts masked, or called from an ISR of the same priority) -
+ *       otherwise the interrupt and the caller race for the flag
+ */
+bool dma_poll_channel(unsigned int channel)
+{
+    if (channel >= DMA_CHAN_COUNT || !(LDMA->IF & (1UL << channel)))
+    {
+        return false;
+    }
+
+    LDMA->IFC = 1UL << channel;
+    if (channel_callbacks[channel] != NULL)
+    {
+        channel_callbacks[channel](channel, channel_contexts[channel]);
+    }
+    return true;
+}
+
+/*==============================================================================
+ * INTERRUPT HANDLER
+ *============================================================================*/
+
+/**
+ * @brief LDMA interrupt handler - dispatches per-channel completion callbacks
+ */
+void LDMA_IRQHandler(void)
+{
+    uint32_t pending = LDMA->IF & LDMA->IEN;
+
+    if (pending & LDMA_IF_ERROR)
+    {
+        LDMA->IFC = LDMA_IF_ERROR;
+        dma_errors++;
+    }
+
+    for (unsigned int ch = 0; ch < DMA_CHAN_COUNT; ch++)
+    {
+        if ((pending & (1UL << ch)) && (LDMA->IF & (1UL << ch)))              // an earlier callback may have polled it already
+        {
+            LDMA->IFC = 1UL << ch;                  // clear before the callback may restart the channel
+            if (channel_callbacks[ch] != NULL)
+            {
+                channel_callbacks[ch](ch, channel_contexts[ch]);
+            }
+        }
+    }
+}
@@ -0,0 +1,44 @@
+/*
+ * dma.h
+ *
+ * @brief LDMA ownership and channel allocation for the node firmware
+ * @description Single place that initialises the LDMA, owns LDMA_IRQHandler()
+ *              and dispatches per-channel completion callbacks. Channel numbers
+ *              are fixed here so drivers cannot collide.
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: JonathanStorey
+ *    Hardware: EFM32GG11B Microcontroller (24 LDMA channels)
+ *     Version: 1.0
+ */
+
+#ifndef DMA_H_
+#define DMA_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*==============================================================================
+ * CHANNEL ALLOCATION
+ *============================================================================*/
+#define DMA_CH_UART_TX(dest)    (0 + (dest))    ///< Channels 0-7: USART/UART TX, indexed by destination_t
+#define DMA_CH_UART_RX(dest)    (8 + (dest))    ///< Channels 8-15: USART/UART circular RX, indexed by destination_t
+#define DMA_CH_SPI_TX           16              ///< USART4 SPI transaction queue, TXDATA feed
+#define DMA_CH_SPI_RX           17              ///< USART4 SPI transaction queue, RXDATA drain (completion)
+
+#define DMA_MAX_XFER            2048            ///< Largest transfer one LDMA descriptor can move
+
+/**
+ * @brief Channel completion callback, called from LDMA_IRQHandler()
+ * @param channel: LDMA channel that finished
+ * @param ctx: Context registered with dma_set_callback()
+ */
+typedef void (*dma_channel_callback_t)(unsigned int channel, void *ctx);
+
+void dma_init(void);
+void dma_set_callback(unsigned int channel, dma_channel_callback_t callback, void *ctx);
+uint32_t dma_error_count(void);
+bool dma_poll_channel(unsigned int channel);
+void LDMA_IRQHandler(void);
+
+#endif /* DMA_H_ */
@@ -0,0 +1,111 @@
+/*
+ * dma_queue.c
+ *
+ * @brief Fixed-depth queue of pending DMA transmit jobs
+ * @description See dma_queue.h. No hardware dependencies.
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: JonathanStorey
+ *     Version: 1.0
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "dma_queue.h"
+
+
+void dma_queue_init(dma_queue_t *q)
+{
+    q->head = 0;
+    q->tail = 0;
+}
+
+/**
+ * @brief Append a job to the queue
+ * @param q: Queue
+ * @param buf: Buffer to transmit - must stay valid until the callback runs
+ * @param len: Number of bytes (must be non-zero)
+ * @param mark: Ordering mark stored with the job (see usart.c)
+ * @param callback: Completion callback, or NULL
+ * @return true if queued, false if the queue is full or len is zero
+ */
+bool dma_queue_push(dma_queue_t *q, const void *buf, size_t len, uint16_t mark, dma_callback_t callback)
+{
+    uint8_t head = q->head;
+    dma_job_t *job;
+
+    if (len == 0 || (uint8_t)(head - q->tail) >= DMA_QUEUE_DEPTH)
+    {
+        return false;
+    }
+
+    job = &q->jobs[head & (DMA_QUEUE_DEPTH - 1)];
+    job->buf = (const uint8_t *)buf;
+    job->len = len;
+    job->sent = 0;
+    job->mark = mark;
+    job->callback = callback;
+    q->head = head + 1;                                 // publish after the job is filled in
+    return true;
+}
+
+/**
+ * @brief Oldest job in the queue, or NULL if empty
+ */
+dma_job_t *dma_queue_front(dma_queue_t *q)
+{
+    if (q->head == q->tail)
+    {
+        return NULL;
+    }
+    return &q->jobs[q->tail & (DMA_QUEUE_DEPTH - 1)];
+}
+
+/**
+ * @brief Remove the oldest job
+ */
+void dma_queue_pop(dma_queue_t *q)
+{
+    if (q->head != q->tail)
+    {
+        q->tail = q->tail + 1;
+    }
+}
+
+uint8_t dma_queue_count(const dma_queue_t *q)
+{
+    return (uint8_t)(q->head - q->tail);
+}
+
+bool dma_queue_is_empty(const dma_queue_t *q)
+{
+    return q->head == q->tail;
+}
+
+/**
+ * @brief Work out the next piece of a job to hand to the DMA
+ * @param job: Job being transmitted
+ * @param max_chunk: Largest transfer one descriptor can move
+ * @param src: Set to the first byte of the chunk
+ * @return Chunk length in bytes (0 if the job is complete)
+ */
+size_t dma_job_next_chunk(const dma_job_t *job, size_t max_chunk, const uint8_t **src)
+{
+    size_t remaining = job->len - job->sent;
+
+    *src = job->buf + job->sent;
+    return (remaining < max_chunk) ? remaining : max_chunk;
+}
+
+/**
+ * @brief Record that a chunk has been transferred
+ * @param job: Job being transmitted
+ * @param chunk: Length returned by dma_job_next_chunk()
+ * @return true if the whole job has now been sent
+ */
+bool dma_job_advance(dma_job_t *job, size_t chunk)
+{
+    job->sent += chunk;
+    return job->sent >= job->len;
+}
@@ -0,0 +1,60 @@
+/*
+ * dma_queue.h
+ *
+ * @brief Fixed-depth queue of pending DMA transmit jobs
+ * @description Book-keeping for uart_write_dma(): each port owns one queue of
+ *              caller buffers waiting to be handed to the LDMA. Jobs longer
+ *              than one LDMA descriptor can move are sent in chunks.
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: JonathanStorey
+ *    Hardware: None (pure C, no peripheral access - can be built on a host PC)
+ *     Version: 1.0
+ *
+ * @note Push from thread or ISR context inside a critical section, pop only
+ *       from the DMA completion path
+ */
+
+#ifndef DMA_QUEUE_H_
+#define DMA_QUEUE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define DMA_QUEUE_DEPTH     8       ///< Pending jobs per queue (power of two)
+
+/**
+ * @brief Completion callback - called from interrupt context once the LDMA has
+ *        read the last byte of buf, so the buffer may be reused
+ * @param port: Port the job was queued on (destination_t value)
+ * @param buf: Buffer passed to uart_write_dma()
+ * @param len: Length passed to uart_write_dma()
+ */
+typedef void (*dma_callback_t)(int port, const void *buf, size_t len);
+
+typedef struct {
+    const uint8_t *buf;             ///< Caller buffer (RAM or flash)
+    size_t len;                     ///< Total length
+    size_t sent;                    ///< Bytes already handed to the LDMA
+    uint16_t mark;                  ///< Caller-defined ordering mark
+    dma_callback_t callback;        ///< Optional completion callback
+} dma_job_t;
+
+typedef struct {
+    dma_job_t jobs[DMA_QUEUE_DEPTH];
+    volatile uint8_t head;          ///< Next free slot
+    volatile uint8_t tail;          ///< Oldest job
+} dma_queue_t;
+
+void dma_queue_init(dma_queue_t *q);
+bool dma_queue_push(dma_queue_t *q, const void *buf, size_t len, uint16_t mark, dma_callback_t callback);
+dma_job_t *dma_queue_front(dma_queue_t *q);
+void dma_queue_pop(dma_queue_t *q);
+uint8_t dma_queue_count(const dma_queue_t *q);
+bool dma_queue_is_empty(const dma_queue_t *q);
+
+size_t dma_job_next_chunk(const dma_job_t *job, size_t max_chunk, const uint8_t **src);
+bool dma_job_advance(dma_job_t *job, size_t chunk);
+
+#endif /* DMA_QUEUE_H_ */
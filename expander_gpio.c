@@ -0,0 +1,296 @@
+/*
+ * expander_gpio.c
+ *
+ * @brief GPIO pins of the three MAX14830 expanders
+ * @description See expander_gpio.h.
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: JonathanStorey
+ *    Hardware: EFM32GG11B Microcontroller, 3 x MAX14830 on USART4
+ *     Version: 1.0
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "usart_expanders.h"
+#include "expander_io.h"
+#include "expander_gpio.h"
+
+#define GPIO_DATA_IN_SHIFT      4           // GPIODATA bits 7:4 are the input levels
+#define GPIO_CONFIG_OD_SHIFT    4           // GPIOCONFIG bits 7:4 select open drain
+
+
+/*==============================================================================
+ * PER-EXPANDER STATE
+ *============================================================================*/
+typedef struct {
+    uint16_t output_enable;         ///< GPIOCONFIG bits 3:0 of each UART, 4 bits per UART
+    uint16_t open_drain;            ///< GPIOCONFIG bits 7:4 of each UART
+    uint16_t out;                   ///< Output levels last written to GPIODATA
+    uint16_t irq_mask;              ///< Pins with a GPI interrupt armed
+} expander_gpio_state_t;
+
+static expander_gpio_state_t gpio_state[3];
+static expander_gpio_callback_t gpio_callbacks[EXPANDER_GPIO_COUNT];
+
+
+/**
+ * @brief One UART's 4 bits out of a 16-bit per-expander word
+ */
+static uint8_t gpio_nibble(uint16_t word, uint8_t uart)
+{
+    return (uint8_t)((word >> (uart * 4)) & 0x0F);
+}
+
+/**
+ * @brief Forget every pin setting - all inputs, outputs low, no interrupts
+ * @note Matches the expanders after reset, so call it again after
+ *       MAX14830_InitExpanders(). No SPI traffic.
+ */
+void expander_gpio_init(void)
+{
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        gpio_state[i].output_enable = 0;
+        gpio_state[i].open_drain = 0;
+        gpio_state[i].out = 0;
+        gpio_state[i].irq_mask = 0;
+    }
+    for (uint8_t pin = 0; pin < EXPANDER_GPIO_COUNT; pin++)
+    {
+        gpio_callbacks[pin] = NULL;
+    }
+}
+
+/**
+ * @brief Set one pin's direction and drive
+ * @param pin: Pin number (EXPANDER_GPIO())
+ * @param mode: Input, push-pull or open drain
+ * @param level: Output level, set before the driver is turned on so the pin
+ *               never glitches (ignored for inputs)
+ * @return false if the pin number is out of range
+ */
+bool expander_gpio_config(uint8_t pin, expander_gpio_mode_t mode, bool level)
+{
+    expander_gpio_state_t *gpio;
+    uint8_t expander = EXPANDER_OF_GPIO(pin);
+    uint8_t uart = UART_OF_GPIO(pin);
+    uint16_t bit = (uint16_t)(1u << (pin % EXPANDER_GPIO_PER_EXPANDER));
+
+    if (pin >= EXPANDER_GPIO_COUNT)
+    {
+        return false;
+    }
+    gpio = &gpio_state[expander - EXPANDER_A];
+
+    MAX14830_BusLock();
+    if (mode == EXPANDER_GPIO_INPUT)
+    {
+        gpio->output_enable &= ~bit;
+        gpio->open_drain &= ~bit;
+    }
+    else
+    {
+        expander_gpio_write(expander, bit, level ? bit : 0);
+        gpio->output_enable |= bit;
+        if (mode == EXPANDER_GPIO_OPEN_DRAIN)
+        {
+            gpio->open_drain |= bit;
+        }
+        else
+        {
+            gpio->open_drain &= ~bit;
+        }
+    }
+    MAX14830_WriteRegister(expander, uart, MAX14830_GPIOCONFIG_REG,
+                           (char)(gpio_nibble(gpio->output_enable, uart) | (gpio_nibble(gpio->open_drain, uart) << GPIO_CONFIG_OD_SHIFT)));
+    MAX14830_BusUnlock();
+    return true;
+}
+
+/**
+ * @brief Drive one output pin
+ * @note Costs one SPI write if the level changes, nothing if it doesn't
+ */
+void expander_gpio_set(uint8_t pin, bool level)
+{
+    uint16_t bit = (uint16_t)(1u << (pin % EXPANDER_GPIO_PER_EXPANDER));
+
+    if (pin < EXPANDER_GPIO_COUNT)
+    {
+        expander_gpio_write(EXPANDER_OF_GPIO(pin), bit, level ? bit : 0);
+    }
+}
+
+/**
+ * @brief Drive several output pins of one expander together
+ * @param expander: Expander (EXPANDER_A/B/C)
+ * @param mask: Pins to change (EXPANDER_GPIO_MASK() bits)
+ * @param levels: New levels for those pins
+ * @note GPIODATA is a per-UART register, so this is one write for each UART
+ *       whose pins change. Pins that already have the level cost nothing.
+ */
+void expander_gpio_write(uint8_t expander, uint16_t mask, uint16_t levels)
+{
+    expander_gpio_state_t *gpio;
+    uint16_t next;
+    uint16_t changed;
+
+    if (expander < EXPANDER_A || expander > EXPANDER_C)
+    {
+        return;
+    }
+    gpio = &gpio_state[expander - EXPANDER_A];
+
+    MAX14830_BusLock();
+    next = (uint16_t)((gpio->out & ~mask) | (levels & mask));
+    changed = next ^ gpio->out;
+    gpio->out = next;
+    for (uint8_t uart = MAX14830_UART0; uart <= MAX14830_UART3; uart++)
+    {
+        if (gpio_nibble(changed, uart))
+        {
+            MAX14830_WriteRegister(expander, uart, MAX14830_GPIODATA_REG, (char)gpio_nibble(next, uart));
+        }
+    }
+    MAX14830_BusUnlock();
+}
+
+/**
+ * @brief Output levels of one expander as last written (no SPI traffic)
+ */
+uint16_t expander_gpio_outputs(uint8_t expander)
+{
+    if (expander < EXPANDER_A || expander > EXPANDER_C)
+    {
+        return 0;
+    }
+    return gpio_state[expander - EXPANDER_A].out;
+}
+
+/**
+ * @brief Read one pin's input level
+ * @note One GPIODATA read
+ */
+bool expander_gpio_get(uint8_t pin)
+{
+    uint8_t data;
+
+    if (pin >= EXPANDER_GPIO_COUNT)
+    {
+        return false;
+    }
+    data = MAX14830_ReadRegister(EXPANDER_OF_GPIO(pin), UART_OF_GPIO(pin), MAX14830_GPIODATA_REG);
+    return (data & (1 << (GPIO_DATA_IN_SHIFT + BIT_OF_GPIO(pin)))) != 0;
+}
+
+/**
+ * @brief Read all 16 input levels of one expander
+ * @return EXPANDER_GPIO_MASK() bit per pin
+ * @note Four GPIODATA reads, one per UART
+ */
+uint16_t expander_gpio_read(uint8_t expander)
+{
+    uint16_t levels = 0;
+
+    if (expander < EXPANDER_A || expander > EXPANDER_C)
+    {
+        return 0;
+    }
+    MAX14830_BusLock();
+    for (uint8_t uart = MAX14830_UART0; uart <= MAX14830_UART3; uart++)
+    {
+        uint8_t data = MAX14830_ReadRegister(expander, uart, MAX14830_GPIODATA_REG);
+
+        levels |= (uint16_t)((data >> GPIO_DATA_IN_SHIFT) & 0x0F) << (uart * 4);
+    }
+    MAX14830_BusUnlock();
+    return levels;
+}
+
+/**
+ * @brief Call a function whenever an input pin changes
+ * @param pin: Pin number - configure it as an input first
+ * @param callback: Runs in the PC5 interrupt, keep it short
+ * @return false if the pin is out of range or callback is NULL
+ * @note Needs the interrupt engine (expander_irq_enable()) to be running
+ */
+bool expander_gpio_irq_enable(uint8_t pin, expander_gpio_callback_t callback)
+{
+    uint8_t expander = EXPANDER_OF_GPIO(pin);
+    uint8_t uart = UART_OF_GPIO(pin);
+    uint8_t bit = (uint8_t)(1 << BIT_OF_GPIO(pin));
+
+    if (pin >= EXPANDER_GPIO_COUNT || callback == NULL)
+    {
+        return false;
+    }
+
+    MAX14830_BusLock();
+    gpio_callbacks[pin] = callback;
+    gpio_state[expander - EXPANDER_A].irq_mask |= (uint16_t)(1u << (pin % EXPANDER_GPIO_PER_EXPANDER));
+    (void)MAX14830_ReadRegister(expander, uart, MAX14830_STSINT_REG);          // drop anything latched before now
+    MAX14830_UpdateBits(expander, uart, MAX14830_STSINTEN_REG, bit, bit);
+    expander_status_irq(EXPANDER_CHANNEL(expander, uart), true);
+    MAX14830_BusUnlock();
+    return true;
+}
+
+/**
+ * @brief Stop calling back on a pin, and turn the UART's status interrupt off
+ *        once none of its four pins need it
+ */
+void expander_gpio_irq_disable(uint8_t pin)
+{
+    expander_gpio_state_t *gpio;
+    uint8_t expander = EXPANDER_OF_GPIO(pin);
+    uint8_t uart = UART_OF_GPIO(pin);
+    uint8_t bit = (uint8_t)(1 << BIT_OF_GPIO(pin));
+
+    if (pin >= EXPANDER_GPIO_COUNT)
+    {
+        return;
+    }
+    gpio = &gpio_state[expander - EXPANDER_A];
+
+    MAX14830_BusLock();
+    gpio->irq_mask &= (uint16_t)~(1u << (pin % EXPANDER_GPIO_PER_EXPANDER));
+    gpio_callbacks[pin] = NULL;
+    MAX14830_UpdateBits(expander, uart, MAX14830_STSINTEN_REG, bit, 0);
+    if (gpio_nibble(gpio->irq_mask, uart) == 0)
+    {
+        expander_status_irq(EXPANDER_CHANNEL(expander, uart), false);
+    }
+    MAX14830_BusUnlock();
+}
+
+/**
+ * @brief Dispatch a UART's GPI interrupts
+ * @param ch: Channel whose ISR showed STSINT
+ * @param stsint: STSINT as just read (reading cleared it)
+ * @note Called by the interrupt engine. GPIODATA is read once for all four pins.
+ */
+void expander_gpio_service(uint8_t ch, uint8_t stsint)
+{
+    uint8_t expander = EXPANDER_OF_CHANNEL(ch);
+    uint8_t uart = UART_OF_CHANNEL(ch);
+    uint8_t pending = stsint & gpio_nibble(gpio_state[expander - EXPANDER_A].irq_mask, uart) &
+                      (MAX14830_STSINT_GPI0INT | MAX14830_STSINT_GPI1INT | MAX14830_STSINT_GPI2INT | MAX14830_STSINT_GPI3INT);
+    uint8_t data;
+
+    if (pending == 0)
+    {
+        return;
+    }
+    data = MAX14830_ReadRegister(expander, uart, MAX14830_GPIODATA_REG);
+    for (uint8_t bit = 0; bit < 4; bit++)
+    {
+        uint8_t pin = EXPANDER_GPIO(expander, uart, bit);
+
+        if ((pending & (1 << bit)) && gpio_callbacks[pin] != NULL)
+        {
+            gpio_callbacks[pin](pin, (data & (1 << (GPIO_DATA_IN_SHIFT + bit))) != 0);
+        }
+    }
+}
@@ -0,0 +1,74 @@
+/*
+ * expander_gpio.h
+ *
+ * @brief GPIO pins of the three MAX14830 expanders
+ * @description Each MAX14830 UART owns four GPIOs, set up by its GPIOCONFIG
+ *              register (bits 3:0 output enable, bits 7:4 open drain) and
+ *              driven / read through GPIODATA (bits 3:0 outputs, bits 7:4
+ *              inputs). The output levels are cached here, so a set never
+ *              needs a read, and expander_gpio_write() changes any number of
+ *              pins on one expander with at most one GPIODATA write per UART
+ *              whose pins actually change - none at all if nothing does.
+ *
+ *              Input changes can raise STSINT GPIxINT. With the interrupt
+ *              engine running (expander_irq_enable()) those are dispatched to
+ *              per-pin callbacks from the PC5 interrupt.
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: JonathanStorey
+ *    Hardware: EFM32GG11B Microcontroller, 3 x MAX14830 on USART4
+ *     Version: 1.0
+ *
+ * @note Pin numbers are (expander - EXPANDER_A) * 16 + uart * 4 + bit, so 0-15
+ *       are Expander A GPIO0-15, 16-31 Expander B and 32-47 Expander C
+ */
+
+#ifndef EXPANDER_GPIO_H_
+#define EXPANDER_GPIO_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "usart_expanders.h"
+
+#define EXPANDER_GPIO_COUNT             48      ///< 3 expanders x 4 UARTs x 4 pins
+#define EXPANDER_GPIO_PER_EXPANDER      16
+
+#define EXPANDER_GPIO(expander, uart, bit)  ((uint8_t)(((expander) - EXPANDER_A) * 16 + (uart) * 4 + (bit)))
+#define EXPANDER_OF_GPIO(pin)               ((uint8_t)(EXPANDER_A + (pin) / 16))
+#define UART_OF_GPIO(pin)                   ((uint8_t)(((pin) / 4) % 4))
+#define BIT_OF_GPIO(pin)                    ((uint8_t)((pin) % 4))
+#define EXPANDER_GPIO_MASK(uart, bit)       ((uint16_t)(1u << ((uart) * 4 + (bit))))    ///< expander_gpio_write() mask bit
+
+/*==============================================================================
+ * TYPES
+ *============================================================================*/
+typedef enum {
+    EXPANDER_GPIO_INPUT = 0,        ///< Input (reset state)
+    EXPANDER_GPIO_PUSH_PULL,        ///< Output, driven both ways
+    EXPANDER_GPIO_OPEN_DRAIN        ///< Output, pulls low only
+} expander_gpio_mode_t;
+
+/**
+ * @brief Called from the PC5 interrupt when an enabled input changes
+ * @param pin: Pin number (EXPANDER_GPIO())
+ * @param level: Input level read just after the change
+ */
+typedef void (*expander_gpio_callback_t)(uint8_t pin, bool level);
+
+/*==============================================================================
+ * FUNCTION DECLARATIONS
+ *============================================================================*/
+void expander_gpio_init(void);
+
+bool expander_gpio_config(uint8_t pin, expander_gpio_mode_t mode, bool level);
+void expander_gpio_set(uint8_t pin, bool level);
+void expander_gpio_write(uint8_t expander, uint16_t mask, uint16_t levels);
+uint16_t expander_gpio_outputs(uint8_t expander);
+bool expander_gpio_get(uint8_t pin);
+uint16_t expander_gpio_read(uint8_t expander);
+
+bool expander_gpio_irq_enable(uint8_t pin, expander_gpio_callback_t callback);
+void expander_gpio_irq_disable(uint8_t pin);
+void expander_gpio_service(uint8_t ch, uint8_t stsint);
+
+#endif /* EXPANDER_GPIO_H_ */
@@ -0,0 +1,603 @@
+/*
+ * expander_io.c
+ *
+ * @brief Buffered data path for the twelve MAX14830 expander channels
+ * @description See expander_io.h.
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: JonathanStorey
+ *    Hardware: EFM32GG11B Microcontroller, 3 x MAX14830 on USART4
+ *     Version: 1.0
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "em_device.h"
+#include "em_core.h"
+#include "em_emu.h"
+#include "em_gpio.h"
+#include "hw_timer.h"
+#include "ring_buffer.h"
+#include "usart_expanders.h"
+#include "spi_bus.h"
+#include "expander_io.h"
+#include "expander_gpio.h"
+
+
+/*==============================================================================
+ * PER-CHANNEL STATE
+ *============================================================================*/
+typedef struct {
+    ring_buffer_t tx_ring;
+    uint8_t tx_storage[EXPANDER_TX_RING_SIZE];
+    ring_buffer_t rx_ring;          ///< Filled by the interrupt engine
+    uint8_t rx_storage[EXPANDER_RX_RING_SIZE];
+    uint8_t tx_cmd;                 ///< THR write command for tx_burst
+    spi_transaction_t tx_burst[2];  ///< THR refill on the spi_bus queue - two when the ring wraps
+    expander_rx_stats_t stats;
+} expander_channel_t;
+
+static expander_channel_t channels[EXPANDER_CHANNEL_COUNT];
+static bool irq_enabled;
+static uint8_t rx_scratch[MAX14830_FIFO_SIZE];            // one RX FIFO worth, only used with the bus locked
+static uint8_t rx_cmd;                                   // RHR read command for rx_burst
+static spi_transaction_t rx_burst;                       // interrupt engine RHR drain on the spi_bus queue
+static uint32_t irq_count;
+static volatile bool irq_deferred;                       // PC5 fired while the LDMA queue owned the bus
+
+
+/**
+ * @brief Set up the per-channel queues
+ * @note No SPI traffic - the expanders need not be powered yet
+ */
+void expander_io_init(void)
+{
+    for (uint8_t ch = 0; ch < EXPANDER_CHANNEL_COUNT; ch++)
+    {
+        ring_buffer_init(&channels[ch].tx_ring, channels[ch].tx_storage, EXPANDER_TX_RING_SIZE);
+        ring_buffer_init(&channels[ch].rx_ring, channels[ch].rx_storage, EXPANDER_RX_RING_SIZE);
+        channels[ch].tx_cmd = MAX14830_COMMAND(true, UART_OF_CHANNEL(ch), MAX14830_THR_REG);
+    }
+}
+
+/**
+ * @brief Set or clear IRQEN bits on a channel
+ * @note Goes through the register shadow, so an unchanged IRQEN costs no SPI
+ *       and a re-init that zeroes IRQEN is seen by the next update
+ */
+static void expander_set_irqen(uint8_t ch, uint8_t mask, bool enable)
+{
+    (void)MAX14830_UpdateBits(EXPANDER_OF_CHANNEL(ch), UART_OF_CHANNEL(ch), MAX14830_IRQEN_REG, mask, enable ? mask : 0);
+}
+
+/**
+ * @brief true if the TX FIFO empty interrupt is armed on a channel
+ * @note Shadow only - false when IRQEN isn't known, so the caller refills
+ */
+static bool expander_tx_armed(uint8_t ch)
+{
+    uint8_t irqen;
+
+    return MAX14830_ShadowGet(EXPANDER_OF_CHANNEL(ch), UART_OF_CHANNEL(ch), MAX14830_IRQEN_REG, &irqen) &&
+           (irqen & MAX14830_IRQEN_TFIFOEMTYIEN);
+}
+
+/**
+ * @brief Queue bytes for an expander channel and start sending them
+ * @param ch: Channel 0-11 (see EXPANDER_CHANNEL())
+ * @param buf: Bytes to send
+ * @param len: Number of bytes
+ * @return Number of bytes queued - less than len if the queue filled up
+ * @note Without the interrupt engine every call also refills the TX FIFO, so
+ *       a caller retrying on a full queue keeps the channel moving
+ */
+uint16_t expander_write(uint8_t ch, const void *buf, uint16_t len)
+{
+    uint16_t queued;
+
+    if (ch >= EXPANDER_CHANNEL_COUNT)
+    {
+        return 0;
+    }
+    queued = ring_buffer_write(&channels[ch].tx_ring, (const uint8_t *)buf, len);
+    MAX14830_BusLock();                                                 // interrupt engine refills too
+    if (!irq_enabled || !expander_tx_armed(ch))                         // polled, or not already waiting on the FIFO
+    {
+        expander_tx_refill(ch);
+    }
+    MAX14830_BusUnlock();
+    return queued;
+}
+
+/**
+ * @brief Wait until a channel's TX queue has room again
+ * @param ch: Channel 0-11
+ * @note With the interrupt engine the core sleeps until an interrupt (normally
+ *       the TX FIFO empty refill) has run - no SPI traffic from here. Polled,
+ *       it waits for half a FIFO to leave on the line, so the caller's next
+ *       expander_write() refill reads TXFIFOLVL once per half FIFO instead of
+ *       on every retry.
+ */
+void expander_tx_wait(uint8_t ch)
+{
+    uint32_t baud;
+    CORE_DECLARE_IRQ_STATE;
+
+    if (ch >= EXPANDER_CHANNEL_COUNT || !ring_buffer_is_full(&channels[ch].tx_ring))
+    {
+        return;
+    }
+    if (irq_enabled)
+    {
+        CORE_ENTER_CRITICAL();                                          // an interrupt arriving here still wakes the WFI
+        if (ring_buffer_is_full(&channels[ch].tx_ring))
+        {
+            EMU_EnterEM1();
+        }
+        CORE_EXIT_CRITICAL();
+        return;
+    }
+    baud = MAX14830_GetBaud(EXPANDER_OF_CHANNEL(ch), UART_OF_CHANNEL(ch));
+    hw_timer0_us(baud ? (MAX14830_FIFO_SIZE / 2) * 10 * 1000000UL / baud : 1000);   // 10 bits per character
+}
+
+/**
+ * @brief Bytes still queued in software for a channel
+ */
+uint16_t expander_tx_pending(uint8_t ch)
+{
+    return (ch < EXPANDER_CHANNEL_COUNT) ? ring_buffer_count(&channels[ch].tx_ring) : 0;
+}
+
+/**
+ * @brief spi_bus callback - a THR burst is in the FIFO, so its bytes leave the queue
+ */
+static void expander_tx_sent(spi_transaction_t *t)
+{
+    ring_buffer_consume(&channels[(uintptr_t)t->ctx].tx_ring, t->len);
+}
+
+/**
+ * @brief Move queued bytes into a channel's TX FIFO
+ * @param ch: Channel 0-11
+ * @note One TXFIFOLVL read, then at most two THR bursts (the queue may wrap)
+ *       covering exactly the free FIFO space. The bursts go on the spi_bus
+ *       queue and the bytes stay queued until each one completes; the next
+ *       TXFIFOLVL read waits for the queue, so nothing is sent twice.
+ * @note Call on the channel's TX FIFO empty interrupt
+ */
+void expander_tx_refill(uint8_t ch)
+{
+    expander_channel_t *chan;
+    uint8_t expander, uart;
+    uint16_t count, room, n;
+    const uint8_t *data;
+
+    if (ch >= EXPANDER_CHANNEL_COUNT)
+    {
+        return;
+    }
+    chan = &channels[ch];
+    expander = EXPANDER_OF_CHANNEL(ch);
+    uart = UART_OF_CHANNEL(ch);
+
+    room = 0;
+    if (!ring_buffer_is_empty(&chan->tx_ring))
+    {
+        room = MAX14830_FIFO_SIZE - MAX14830_ReadRegister(expander, uart, MAX14830_TXFIFOLVL_REG);
+    }
+    count = ring_buffer_count(&chan->tx_ring);                          // after the read - earlier bursts have completed
+    if (room > count)
+    {
+        room = count;
+    }
+
+    expander_set_irqen(ch, MAX14830_IRQEN_TFIFOEMTYIEN, room != count);  // armed before the bursts go, so the refill doesn't wait on them
+
+    n = ring_buffer_peek_contiguous(&chan->tx_ring, &data);
+    for (uint8_t i = 0; room && i < 2; i++)
+    {
+        spi_transaction_t *t = &chan->tx_burst[i];
+
+        if (n > room)
+        {
+            n = room;
+        }
+        t->cs = SPI_CS_OF_EXPANDER(expander);
+        t->cmd = &chan->tx_cmd;
+        t->cmd_len = 1;
+        t->tx = data;
+        t->rx = NULL;
+        t->len = n;
+        t->callback = expander_tx_sent;
+        t->ctx = (void *)(uintptr_t)ch;
+        if (!spi_bus_submit(t))                                         // no queue yet - write it here and now
+        {
+            MAX14830_WriteBurst(expander, uart, MAX14830_THR_REG, data, n);
+            ring_buffer_consume(&chan->tx_ring, n);
+        }
+        room -= n;
+        data = chan->tx_storage;                                        // a second burst always starts at the wrap
+        n = room;
+    }
+}
+
+/**
+ * @brief Refill every channel that has bytes queued
+ * @note For callers that loop without the expander interrupt line serviced
+ */
+void expander_io_poll(void)
+{
+    for (uint8_t ch = 0; ch < EXPANDER_CHANNEL_COUNT; ch++)
+    {
+        if (!ring_buffer_is_empty(&channels[ch].tx_ring))
+        {
+            MAX14830_BusLock();
+            expander_tx_refill(ch);
+            MAX14830_BusUnlock();
+        }
+    }
+}
+
+
+/*==============================================================================
+ * INTERRUPT ENGINE
+ *============================================================================*/
+
+/**
+ * @brief Bytes waiting in a channel's RX FIFO
+ */
+static uint16_t expander_rx_level(uint8_t ch)
+{
+    uint16_t level = MAX14830_ReadRegister(EXPANDER_OF_CHANNEL(ch), UART_OF_CHANNEL(ch), MAX14830_RXFIFOLVL_REG);
+
+    return (level > MAX14830_FIFO_SIZE) ? MAX14830_FIFO_SIZE : level;
+}
+
+/**
+ * @brief Move an RHR burst from rx_scratch into a channel's ring
+ */
+static void expander_rx_store(uint8_t ch, uint16_t len)
+{
+    expander_channel_t *chan = &channels[ch];
+    uint16_t queued = ring_buffer_write(&chan->rx_ring, rx_scratch, len);
+
+    chan->stats.rx_bytes += queued;
+    chan->stats.rx_dropped += len - queued;
+}
+
+/**
+ * @brief Empty a channel's RX FIFO into its ring before returning
+ * @note RXFIFOLVL is read once and the FIFO is emptied in one RHR burst
+ */
+static void expander_rx_drain(uint8_t ch)
+{
+    uint16_t level = expander_rx_level(ch);
+
+    if (level == 0)
+    {
+        return;
+    }
+    MAX14830_ReadBurst(EXPANDER_OF_CHANNEL(ch), UART_OF_CHANNEL(ch), MAX14830_RHR_REG, rx_scratch, level);
+    expander_rx_store(ch, level);
+}
+
+/**
+ * @brief spi_bus callback - an interrupt engine RHR burst has arrived
+ */
+static void expander_rx_received(spi_transaction_t *t)
+{
+    expander_rx_store((uint8_t)(uintptr_t)t->ctx, t->len);
+}
+
+/**
+ * @brief Empty a channel's RX FIFO with an RHR burst on the spi_bus queue
+ * @note The interrupt engine carries on while it runs. Any later register read
+ *       waits for the queue, so rx_scratch is free again by the next drain.
+ */
+static void expander_rx_drain_queued(uint8_t ch)
+{
+    uint16_t level = expander_rx_level(ch);
+
+    if (level == 0)
+    {
+        return;
+    }
+    rx_cmd = MAX14830_COMMAND(false, UART_OF_CHANNEL(ch), MAX14830_RHR_REG);
+    rx_burst.cs = SPI_CS_OF_EXPANDER(EXPANDER_OF_CHANNEL(ch));
+    rx_burst.cmd = &rx_cmd;
+    rx_burst.cmd_len = 1;
+    rx_burst.tx = NULL;
+    rx_burst.rx = rx_scratch;
+    rx_burst.len = level;
+    rx_burst.callback = expander_rx_received;
+    rx_burst.ctx = (void *)(uintptr_t)ch;
+    if (!spi_bus_submit(&rx_burst))                                     // no queue yet - read it here and now
+    {
+        MAX14830_ReadBurst(EXPANDER_OF_CHANNEL(ch), UART_OF_CHANNEL(ch), MAX14830_RHR_REG, rx_scratch, level);
+        expander_rx_store(ch, level);
+    }
+}
+
+/**
+ * @brief Handle everything one UART has flagged in its ISR
+ */
+static void expander_service_channel(uint8_t ch)
+{
+    uint8_t expander = EXPANDER_OF_CHANNEL(ch);
+    uint8_t uart = UART_OF_CHANNEL(ch);
+    uint8_t isr = MAX14830_ReadRegister(expander, uart, MAX14830_ISR_REG);     // reading clears it
+
+    if (isr & MAX14830_ISR_LSRERRINT)
+    {
+        uint8_t lsr = MAX14830_ReadRegister(expander, uart, MAX14830_LSR_REG);
+
+        if (lsr & MAX14830_LSR_RXOVERRUN)
+        {
+            channels[ch].stats.rx_overruns++;
+        }
+        if (lsr & (MAX14830_LSR_FRAMEERR | MAX14830_LSR_RXPARITYERR | MAX14830_LSR_RXNOISE | MAX14830_LSR_RXBREAK))
+        {
+            channels[ch].stats.rx_errors++;
+        }
+    }
+    if (isr & (MAX14830_ISR_RFIFOTRIGINT | MAX14830_ISR_LSRERRINT))    // RX timeout arrives as an LSR interrupt
+    {
+        expander_rx_drain_queued(ch);
+    }
+    if (isr & MAX14830_ISR_TFIFOEMTYINT)
+    {
+        expander_tx_refill(ch);
+    }
+    if (isr & MAX14830_ISR_STSINT)                                      // GPI changes, see expander_gpio_irq_enable()
+    {
+        expander_gpio_service(ch, MAX14830_ReadRegister(expander, uart, MAX14830_STSINT_REG));
+    }
+}
+
+/**
+ * @brief Serve every UART on every expander until the IRQ line goes high
+ * @note The three IRQ outputs share PC5 (open drain, active low), and the GPIO
+ *       interrupt is edge triggered, so keep going while any expander still
+ *       holds the line low
+ */
+static void expander_irq_service(void)
+{
+    uint8_t passes = 0;
+
+    irq_count++;
+    do
+    {
+        for (uint8_t expander = EXPANDER_A; expander <= EXPANDER_C; expander++)
+        {
+            uint8_t global = MAX14830_ReadRegister(expander, MAX14830_UART0, MAX14830_GLOBALIRQ_REG);
+
+            for (uint8_t uart = 0; uart < 4; uart++)
+            {
+                if (!(global & MAX14830_GLOBALIRQ_IRQ(uart)))
+                {
+                    expander_service_channel(EXPANDER_CHANNEL(expander, uart));
+                }
+            }
+        }
+    } while (!GPIO_PinInGet(EXPANDER_IRQ_PORT, EXPANDER_IRQ_PIN) && ++passes < EXPANDER_IRQ_MAX_PASSES);
+}
+
+/**
+ * @brief spi_bus idle hook - catch up on an interrupt deferred while the queue ran
+ */
+static void expander_irq_resume(void)
+{
+    if (irq_deferred)
+    {
+        NVIC_SetPendingIRQ(GPIO_ODD_IRQn);
+    }
+}
+
+/**
+ * @brief Switch the expanders over to interrupt driven receive
+ * @note Call after MAX14830_UART_Init() on all three expanders. Sets the RX
+ *       trigger level and RX timeout on every channel, enables the RX trigger
+ *       and LSR interrupts, then enables the PC5 falling edge interrupt.
+ */
+void expander_irq_enable(void)
+{
+    MAX14830_BusLock();
+    for (uint8_t ch = 0; ch < EXPANDER_CHANNEL_COUNT; ch++)
+    {
+        uint8_t expander = EXPANDER_OF_CHANNEL(ch);
+        uint8_t uart = UART_OF_CHANNEL(ch);
+
+        MAX14830_WriteRegister(expander, uart, MAX14830_FIFOTRIGLVL_REG,
+                               ((EXPANDER_RX_TRIGGER_LEVEL / 8) << MAX14830_FIFOTRIG_RX_SHIFT) | (1 << MAX14830_FIFOTRIG_TX_SHIFT));
+        MAX14830_WriteRegister(expander, uart, MAX14830_RXIMEOUT_REG, EXPANDER_RX_TIMEOUT_CHARS);
+        MAX14830_WriteRegister(expander, uart, MAX14830_LSRINTEN_REG, MAX14830_LSRINTEN_RTIMEOUTIEN | MAX14830_LSRINTEN_ROVERRIEN);
+        expander_set_irqen(ch, MAX14830_IRQEN_RFIFOTRGIEN | MAX14830_IRQEN_LSRERRIEN, true);
+        (void)MAX14830_ReadRegister(expander, uart, MAX14830_ISR_REG);  // start with nothing latched
+    }
+
+    GPIO_ExtIntConfig(EXPANDER_IRQ_PORT, EXPANDER_IRQ_PIN, EXPANDER_IRQ_PIN, false, true, true);
+    NVIC_ClearPendingIRQ(GPIO_ODD_IRQn);
+    spi_bus_set_idle_hook(expander_irq_resume);
+    irq_enabled = true;
+    MAX14830_BusUnlock();
+    NVIC_EnableIRQ(GPIO_ODD_IRQn);
+    if (!GPIO_PinInGet(EXPANDER_IRQ_PORT, EXPANDER_IRQ_PIN))           // already low - no edge will come
+    {
+        NVIC_SetPendingIRQ(GPIO_ODD_IRQn);
+    }
+}
+
+/**
+ * @brief Return the expanders to polled operation
+ */
+void expander_irq_disable(void)
+{
+    bool was_enabled = irq_enabled;
+
+    GPIO_IntDisable(1 << EXPANDER_IRQ_PIN);
+    NVIC_DisableIRQ(GPIO_ODD_IRQn);
+    spi_bus_set_idle_hook(NULL);
+    irq_deferred = false;
+    irq_enabled = false;
+    for (uint8_t ch = 0; was_enabled && ch < EXPANDER_CHANNEL_COUNT; ch++)
+    {
+        expander_set_irqen(ch, MAX14830_IRQEN_RFIFOTRGIEN | MAX14830_IRQEN_LSRERRIEN, false);
+    }
+}
+
+/**
+ * @brief Arm or disarm a channel's status interrupt (STSINT sources)
+ * @note Used by expander_gpio.c for GPI interrupts
+ */
+void expander_status_irq(uint8_t ch, bool enable)
+{
+    if (ch >= EXPANDER_CHANNEL_COUNT)
+    {
+        return;
+    }
+    MAX14830_BusLock();
+    expander_set_irqen(ch, MAX14830_IRQEN_STSIEN, enable);
+    MAX14830_BusUnlock();
+}
+
+/**
+ * @brief true while expander_irq_enable() is in force
+ */
+bool expander_irq_enabled(void)
+{
+    return irq_enabled;
+}
+
+/**
+ * @brief Receive counters for one channel
+ */
+void expander_get_rx_stats(uint8_t ch, expander_rx_stats_t *stats)
+{
+    if (ch < EXPANDER_CHANNEL_COUNT)
+    {
+        *stats = channels[ch].stats;
+    }
+}
+
+/**
+ * @brief Number of times the PC5 interrupt has run
+ */
+uint32_t expander_irq_count(void)
+{
+    return irq_count;
+}
+
+
+/*==============================================================================
+ * RECEIVE API
+ *============================================================================*/
+
+/**
+ * @brief Empty a channel's RX FIFO when the interrupt engine isn't running
+ * @note An overrun needs the FIFO full, so LSR is only read then
+ */
+static void expander_rx_poll(uint8_t ch)
+{
+    if (irq_enabled)
+    {
+        return;
+    }
+    MAX14830_BusLock();
+    if (MAX14830_ReadRegister(EXPANDER_OF_CHANNEL(ch), UART_OF_CHANNEL(ch), MAX14830_RXFIFOLVL_REG) >= MAX14830_FIFO_SIZE &&
+        (MAX14830_ReadRegister(EXPANDER_OF_CHANNEL(ch), UART_OF_CHANNEL(ch), MAX14830_LSR_REG) & MAX14830_LSR_RXOVERRUN))
+    {
+        channels[ch].stats.rx_overruns++;
+    }
+    expander_rx_drain(ch);
+    MAX14830_BusUnlock();
+}
+
+/**
+ * @brief Read whatever has been received on a channel, without waiting
+ * @param ch: Channel 0-11 (see EXPANDER_CHANNEL())
+ * @param buf: Destination
+ * @param n: Maximum number of bytes
+ * @return Number of bytes read
+ * @note Without the interrupt engine the FIFO is emptied first in one RHR burst
+ */
+uint16_t expander_read(uint8_t ch, void *buf, uint16_t n)
+{
+    if (ch >= EXPANDER_CHANNEL_COUNT)
+    {
+        return 0;
+    }
+    if (ring_buffer_count(&channels[ch].rx_ring) < n)
+    {
+        expander_rx_poll(ch);
+    }
+    return ring_buffer_read(&channels[ch].rx_ring, (uint8_t *)buf, n);
+}
+
+/**
+ * @brief Number of received bytes ready to read on a channel
+ */
+uint16_t expander_available(uint8_t ch)
+{
+    if (ch >= EXPANDER_CHANNEL_COUNT)
+    {
+        return 0;
+    }
+    expander_rx_poll(ch);
+    return ring_buffer_count(&channels[ch].rx_ring);
+}
+
+/**
+ * @brief Mask of channels with received bytes ready (bit n = channel n)
+ * @note Ring state only - no SPI traffic. Only meaningful with the interrupt
+ *       engine on; otherwise use expander_available() per channel.
+ */
+uint16_t expander_rx_ready_mask(void)
+{
+    uint16_t mask = 0;
+
+    for (uint8_t ch = 0; ch < EXPANDER_CHANNEL_COUNT; ch++)
+    {
+        if (!ring_buffer_is_empty(&channels[ch].rx_ring))
+        {
+            mask |= (uint16_t)(1u << ch);
+        }
+    }
+    return mask;
+}
+
+/**
+ * @brief Discard everything received on a channel, including its RX FIFO
+ */
+void expander_rx_clear(uint8_t ch)
+{
+    if (ch >= EXPANDER_CHANNEL_COUNT)
+    {
+        return;
+    }
+    MAX14830_BusLock();
+    expander_rx_drain(ch);                                              // empty the FIFO, then throw it all away
+    ring_buffer_clear(&channels[ch].rx_ring);
+    MAX14830_BusUnlock();
+}
+
+/**
+ * @brief GPIO interrupt for odd pins - PC5 is the expanders' shared IRQ line
+ */
+void GPIO_ODD_IRQHandler(void)
+{
+    uint32_t flags = GPIO_IntGet() & GPIO_IntGetEnabled();
+
+    GPIO_IntClear(flags);
+    if ((flags & (1 << EXPANDER_IRQ_PIN)) || irq_deferred)
+    {
+        if (!spi_bus_idle())                                            // spi_bus idle hook re-raises this interrupt
+        {
+            irq_deferred = true;
+            return;
+        }
+        irq_deferred = false;
+        expander_irq_service();
+    }
+}
@@ -0,0 +1,84 @@
+/*
+ * expander_io.h
+ *
+ * @brief Buffered data path for the twelve MAX14830 expander channels
+ * @description Each expander UART gets a software TX queue in front of its
+ *              128 byte TX FIFO. A refill reads TXFIFOLVL once and burst-writes
+ *              exactly as many queued bytes as the FIFO has room for, so a
+ *              payload never overruns the FIFO and never costs a register read
+ *              per byte. While bytes remain queued the channel's TX FIFO empty
+ *              interrupt is armed, and expander_tx_refill() is the handler.
+ *
+ *              Once expander_irq_enable() is called the shared IRQ line on PC5
+ *              drives everything: GLOBALIRQ says which UARTs need service, each
+ *              one's ISR is read, and its RX FIFO is emptied in a single RHR
+ *              burst into a per-channel ring. Receive costs no SPI traffic
+ *              until data actually arrives.
+ *
+ *              expander_read() and expander_available() are the receive side
+ *              for every channel. Without the interrupt engine they empty the
+ *              channel's FIFO themselves: one RXFIFOLVL read, then one RHR burst.
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: JonathanStorey
+ *    Hardware: EFM32GG11B Microcontroller, 3 x MAX14830 on USART4
+ *     Version: 1.0
+ *
+ * @note Channel numbers are (expander - EXPANDER_A) * 4 + uart, so 0-3 are
+ *       Expander A UART0-3, 4-7 Expander B and 8-11 Expander C
+ */
+
+#ifndef EXPANDER_IO_H_
+#define EXPANDER_IO_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "usart_expanders.h"
+
+#define EXPANDER_CHANNEL_COUNT          12      ///< 3 expanders x 4 UARTs
+#define EXPANDER_TX_RING_SIZE           512     ///< Bytes of TX queue per channel (power of two)
+#define EXPANDER_RX_RING_SIZE           512     ///< Bytes of RX buffering per channel (power of two)
+#define EXPANDER_RX_TRIGGER_LEVEL       32      ///< RX FIFO level that raises an interrupt (multiple of 8)
+#define EXPANDER_RX_TIMEOUT_CHARS       2       ///< Idle character times before a partial FIFO is flagged
+#define EXPANDER_IRQ_PORT               gpioPortC
+#define EXPANDER_IRQ_PIN                5       ///< Shared active-low IRQ from all three expanders
+#define EXPANDER_IRQ_MAX_PASSES         8       ///< Bound on service passes per interrupt
+
+#define EXPANDER_CHANNEL(expander, uart)    ((uint8_t)(((expander) - EXPANDER_A) * 4 + (uart)))
+#define EXPANDER_OF_CHANNEL(ch)             ((uint8_t)(EXPANDER_A + (ch) / 4))
+#define UART_OF_CHANNEL(ch)                 ((uint8_t)((ch) % 4))
+
+/*==============================================================================
+ * TYPES
+ *============================================================================*/
+typedef struct {
+    uint32_t rx_bytes;              ///< Bytes moved into the RX ring
+    uint32_t rx_dropped;            ///< Bytes lost because the RX ring was full
+    uint32_t rx_overruns;           ///< RX FIFO overruns reported by the LSR
+    uint32_t rx_errors;             ///< Framing, parity, noise and break errors
+} expander_rx_stats_t;
+
+/*==============================================================================
+ * FUNCTION DECLARATIONS
+ *============================================================================*/
+void expander_io_init(void);
+
+uint16_t expander_write(uint8_t ch, const void *buf, uint16_t len);
+void expander_tx_wait(uint8_t ch);
+uint16_t expander_tx_pending(uint8_t ch);
+void expander_tx_refill(uint8_t ch);
+void expander_io_poll(void);
+
+uint16_t expander_read(uint8_t ch, void *buf, uint16_t n);
+uint16_t expander_available(uint8_t ch);
+uint16_t expander_rx_ready_mask(void);
+void expander_rx_clear(uint8_t ch);
+
+void expander_irq_enable(void);
+void expander_irq_disable(void);
+bool expander_irq_enabled(void);
+void expander_status_irq(uint8_t ch, bool enable);
+uint32_t expander_irq_count(void);
+void expander_get_rx_stats(uint8_t ch, expander_rx_stats_t *stats);
+
+#endif /* EXPANDER_IO_H_ */
@@ -0,0 +1,299 @@
+/*
+ * frame.c
+ *
+ * @brief COBS + CRC16 binary framing for inter-subsystem links
+ * @description See frame.h. No hardware dependencies.
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: JonathanStorey
+ *     Version: 1.0
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "frame.h"
+
+
+/*==============================================================================
+ * CRC-16/CCITT-FALSE
+ *============================================================================*/
+static const uint16_t crc16_table[256] =
+{
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+    0x1231, 0x0210, 0x3273, 0x2252, 0x52B5, 0x4294, 0x72F7, 0x62D6,
+    0x9339, 0x8318, 0xB37B, 0xA35A, 0xD3BD, 0xC39C, 0xF3FF, 0xE3DE,
+    0x2462, 0x3443, 0x0420, 0x1401, 0x64E6, 0x74C7, 0x44A4, 0x5485,
+    0xA56A, 0xB54B, 0x8528, 0x9509, 0xE5EE, 0xF5CF, 0xC5AC, 0xD58D,
+    0x3653, 0x2672, 0x1611, 0x0630, 0x76D7, 0x66F6, 0x5695, 0x46B4,
+    0xB75B, 0xA77A, 0x9719, 0x8738, 0xF7DF, 0xE7FE, 0xD79D, 0xC7BC,
+    0x48C4, 0x58E5, 0x6886, 0x78A7, 0x0840, 0x1861, 0x2802, 0x3823,
+    0xC9CC, 0xD9ED, 0xE98E, 0xF9AF, 0x8948, 0x9969, 0xA90A, 0xB92B,
+    0x5AF5, 0x4AD4, 0x7AB7, 0x6A96, 0x1A71, 0x0A50, 0x3A33, 0x2A12,
+    0xDBFD, 0xCBDC, 0xFBBF, 0xEB9E, 0x9B79, 0x8B58, 0xBB3B, 0xAB1A,
+    0x6CA6, 0x7C87, 0x4CE4, 0x5CC5, 0x2C22, 0x3C03, 0x0C60, 0x1C41,
+    0xEDAE, 0xFD8F, 0xCDEC, 0xDDCD, 0xAD2A, 0xBD0B, 0x8D68, 0x9D49,
+    0x7E97, 0x6EB6, 0x5ED5, 0x4EF4, 0x3E13, 0x2E32, 0x1E51, 0x0E70,
+    0xFF9F, 0xEFBE, 0xDFDD, 0xCFFC, 0xBF1B, 0xAF3A, 0x9F59, 0x8F78,
+    0x9188, 0x81A9, 0xB1CA, 0xA1EB, 0xD10C, 0xC12D, 0xF14E, 0xE16F,
+    0x1080, 0x00A1, 0x30C2, 0x20E3, 0x5004, 0x4025, 0x7046, 0x6067,
+    0x83B9, 0x9398, 0xA3FB, 0xB3DA, 0xC33D, 0xD31C, 0xE37F, 0xF35E,
+    0x02B1, 0x1290, 0x22F3, 0x32D2, 0x4235, 0x5214, 0x6277, 0x7256,
+    0xB5EA, 0xA5CB, 0x95A8, 0x8589, 0xF56E, 0xE54F, 0xD52C, 0xC50D,
+    0x34E2, 0x24C3, 0x14A0, 0x0481, 0x7466, 0x6447, 0x5424, 0x4405,
+    0xA7DB, 0xB7FA, 0x8799, 0x97B8, 0xE75F, 0xF77E, 0xC71D, 0xD73C,
+    0x26D3, 0x36F2, 0x0691, 0x16B0, 0x6657, 0x7676, 0x4615, 0x5634,
+    0xD94C, 0xC96D, 0xF90E, 0xE92F, 0x99C8, 0x89E9, 0xB98A, 0xA9AB,
+    0x5844, 0x4865, 0x7806, 0x6827, 0x18C0, 0x08E1, 0x3882, 0x28A3,
+    0xCB7D, 0xDB5C, 0xEB3F, 0xFB1E, 0x8BF9, 0x9BD8, 0xABBB, 0xBB9A,
+    0x4A75, 0x5A54, 0x6A37, 0x7A16, 0x0AF1, 0x1AD0, 0x2AB3, 0x3A92,
+    0xFD2E, 0xED0F, 0xDD6C, 0xCD4D, 0xBDAA, 0xAD8B, 0x9DE8, 0x8DC9,
+    0x7C26, 0x6C07, 0x5C64, 0x4C45, 0x3CA2, 0x2C83, 0x1CE0, 0x0CC1,
+    0xEF1F, 0xFF3E, 0xCF5D, 0xDF7C, 0xAF9B, 0xBFBA, 0x8FD9, 0x9FF8,
+    0x6E17, 0x7E36, 0x4E55, 0x5E74, 0x2E93, 0x3EB2, 0x0ED1, 0x1EF0
+};
+
+/**
+ * @brief Update a CRC-16/CCITT-FALSE over a block of bytes
+ * @param crc: Running CRC (0xFFFF to start)
+ * @param data: Bytes to add
+ * @param len: Number of bytes
+ * @return Updated CRC
+ */
+uint16_t frame_crc16(uint16_t crc, const uint8_t *data, uint16_t len)
+{
+    while (len--)
+    {
+        crc = (uint16_t)((crc << 8) ^ crc16_table[(uint8_t)((crc >> 8) ^ *data++)]);
+    }
+    return crc;
+}
+
+
+/*==============================================================================
+ * ENCODER
+ * One pass over the unencoded frame (header, payload, CRC) without building
+ * it in memory. Each COBS code byte is back-patched once its block is known.
+ *============================================================================*/
+typedef void (*frame_put_t)(void *sink, uint16_t offset, uint8_t byte);
+
+typedef struct {
+    frame_put_t put;
+    void *sink;
+    uint16_t out;                   ///< Next output offset
+    uint16_t code_pos;              ///< Offset reserved for the current code byte
+    uint8_t code;                   ///< Current code value (1 + data bytes in block)
+} frame_cobs_t;
+
+static void frame_cobs_byte(frame_cobs_t *e, uint8_t byte)
+{
+    if (byte == 0)
+    {
+        e->put(e->sink, e->code_pos, e->code);
+        e->code_pos = e->out++;
+        e->code = 1;
+        return;
+    }
+
+    e->put(e->sink, e->out++, byte);
+    if (++e->code == 0xFF)                                  // 254 data bytes - block full
+    {
+        e->put(e->sink, e->code_pos, e->code);
+        e->code_pos = e->out++;
+        e->code = 1;
+    }
+}
+
+static uint16_t frame_cobs_frame(frame_put_t put, void *sink, uint8_t seq, uint8_t type, const uint8_t *payload, uint16_t len)
+{
+    frame_cobs_t e = { put, sink, 1, 0, 1 };
+    uint8_t header[2] = { seq, type };
+    uint16_t crc;
+
+    crc = frame_crc16(0xFFFF, header, 2);
+    crc = frame_crc16(crc, payload, len) ^ FRAME_CRC_XOROUT;
+
+    frame_cobs_byte(&e, seq);
+    frame_cobs_byte(&e, type);
+    for (uint16_t i = 0; i < len; i++)
+    {
+        frame_cobs_byte(&e, payload[i]);
+    }
+    frame_cobs_byte(&e, (uint8_t)(crc >> 8));
+    frame_cobs_byte(&e, (uint8_t)crc);
+
+    put(sink, e.code_pos, e.code);                          // close the last block
+    put(sink, e.out++, 0x00);                               // delimiter
+    return e.out;
+}
+
+static void frame_put_buffer(void *sink, uint16_t offset, uint8_t byte)
+{
+    ((uint8_t *)sink)[offset] = byte;
+}
+
+static void frame_put_ring(void *sink, uint16_t offset, uint8_t byte)
+{
+    ring_buffer_poke((ring_buffer_t *)sink, offset, byte);
+}
+
+/**
+ * @brief Encode one frame into a flat buffer
+ * @param out: Destination buffer
+ * @param size: Size of out, at least FRAME_ENCODED_MAX(len)
+ * @param seq: Sequence number
+ * @param type: Message type
+ * @param payload: Payload bytes (may be NULL when len is 0)
+ * @param len: Payload length, at most FRAME_MAX_PAYLOAD
+ * @return Encoded length including the delimiter, 0 if it does not fit
+ */
+uint16_t frame_encode(uint8_t *out, uint16_t size, uint8_t seq, uint8_t type, const uint8_t *payload, uint16_t len)
+{
+    if (len > FRAME_MAX_PAYLOAD || size < FRAME_ENCODED_MAX(len))
+    {
+        return 0;
+    }
+    return frame_cobs_frame(frame_put_buffer, out, seq, type, payload, len);
+}
+
+/**
+ * @brief Encode one frame directly into a ring buffer (producer side)
+ * @param rb: Ring to append to
+ * @param seq: Sequence number
+ * @param type: Message type
+ * @param payload: Payload bytes (may be NULL when len is 0)
+ * @param len: Payload length, at most FRAME_MAX_PAYLOAD
+ * @return Bytes appended, 0 if the ring lacks FRAME_ENCODED_MAX(len) free space
+ * @note The frame is published with a single head update, so a consumer never
+ *       sees half a frame
+ */
+uint16_t frame_encode_ring(ring_buffer_t *rb, uint8_t seq, uint8_t type, const uint8_t *payload, uint16_t len)
+{
+    uint16_t written;
+
+    if (len > FRAME_MAX_PAYLOAD || ring_buffer_space(rb) < FRAME_ENCODED_MAX(len))
+    {
+        return 0;
+    }
+    written = frame_cobs_frame(frame_put_ring, rb, seq, type, payload, len);
+    ring_buffer_commit(rb, written);
+    return written;
+}
+
+
+/*==============================================================================
+ * DECODER
+ *============================================================================*/
+
+/**
+ * @brief Initialise a decoder
+ * @param d: Decoder
+ * @param handler: Called for each good frame
+ * @param ctx: Passed back to the handler
+ */
+void frame_decoder_init(frame_decoder_t *d, frame_handler_t handler, void *ctx)
+{
+    d->handler = handler;
+    d->ctx = ctx;
+    d->frames = 0;
+    d->crc_errors = 0;
+    d->length_errors = 0;
+    frame_decoder_reset(d);
+}
+
+/**
+ * @brief Drop the frame in progress and wait for the next delimiter-started frame
+ */
+void frame_decoder_reset(frame_decoder_t *d)
+{
+    d->len = 0;
+    d->code = 0;
+    d->remaining = 0;
+    d->zero_pending = false;
+    d->overflow = false;
+}
+
+static void frame_decoder_append(frame_decoder_t *d, uint8_t byte)
+{
+    if (d->len >= FRAME_MAX_RAW)
+    {
+        d->overflow = true;
+        return;
+    }
+    d->buf[d->len++] = byte;
+}
+
+static void frame_decoder_finish(frame_decoder_t *d)
+{
+    uint16_t crc;
+
+    if (d->len == 0 && !d->overflow)
+    {
+        return;                                             // back-to-back delimiters
+    }
+    if (d->overflow || d->remaining != 0 || d->len < FRAME_OVERHEAD)
+    {
+        d->length_errors++;                                 // too long, truncated block or too short
+        return;
+    }
+
+    crc = frame_crc16(0xFFFF, d->buf, d->len - 2) ^ FRAME_CRC_XOROUT;
+    if (crc != (uint16_t)((d->buf[d->len - 2] << 8) | d->buf[d->len - 1]))
+    {
+        d->crc_errors++;
+        return;
+    }
+
+    d->frames++;
+    if (d->handler != NULL)
+    {
+        d->handler(d->ctx, d->buf[0], d->buf[1], &d->buf[2], d->len - FRAME_OVERHEAD);
+    }
+}
+
+/**
+ * @brief Feed received bytes into the decoder
+ * @param d: Decoder
+ * @param data: Received bytes (e.g. a span straight out of an RX ring)
+ * @param len: Number of bytes
+ * @note Can be fed any split of the stream - one byte at a time or many
+ *       frames at once. Good frames are handed to the handler as they complete.
+ */
+void frame_decoder_feed(frame_decoder_t *d, const uint8_t *data, uint16_t len)
+{
+    for (uint16_t i = 0; i < len; i++)
+    {
+        uint8_t byte = data[i];
+
+        if (byte == 0)                                      // delimiter - frame complete
+        {
+            frame_decoder_finish(d);
+            frame_decoder_reset(d);
+            continue;
+        }
+
+        if (d->overflow)
+        {
+            continue;
+        }
+
+        if (d->remaining == 0)                              // code byte
+        {
+            if (d->zero_pending)
+            {
+                frame_decoder_append(d, 0);
+            }
+            d->code = byte;
+            d->remaining = byte - 1;
+            d->zero_pending = (d->remaining == 0) && (byte != 0xFF);
+            continue;
+        }
+
+        frame_decoder_append(d, byte);
+        if (--d->remaining == 0)
+        {
+            d->zero_pending = (d->code != 0xFF);
+        }
+    }
+}
@@ -0,0 +1,85 @@
+/*
+ * frame.h
+ *
+ * @brief COBS + CRC16 binary framing for inter-subsystem links
+ * @description Frame layout before encoding:
+ *
+ *                  [seq][type][payload 0..FRAME_MAX_PAYLOAD][crc hi][crc lo]
+ *
+ *              CRC-16/GENIBUS (poly 0x1021, init 0xFFFF, final XOR 0xFFFF)
+ *              covers seq, type and payload. The final XOR is there because a
+ *              bit error that turns the last COBS code byte into a delimiter
+ *              drops a trailing zero, and without it a CRC ending in 0x00 still
+ *              checks on the shortened frame. The whole frame is COBS encoded
+ *              so it contains no zero bytes, then terminated with a single
+ *              0x00 delimiter. A receiver that starts mid-stream (or sees
+ *              corruption) resyncs on the next delimiter.
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: JonathanStorey
+ *    Hardware: None (pure C, no peripheral access - can be built on a host PC)
+ *     Version: 1.0
+ *
+ * @note The encoder writes straight into a ring_buffer_t, the decoder is fed
+ *       spans straight out of one - neither needs an intermediate line buffer
+ */
+
+#ifndef FRAME_H_
+#define FRAME_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ring_buffer.h"
+
+/*==============================================================================
+ * FRAME SIZES
+ *============================================================================*/
+#define FRAME_MAX_PAYLOAD       200                             ///< Largest payload per frame
+#define FRAME_OVERHEAD          4                               ///< seq + type + CRC16
+#define FRAME_CRC_XOROUT        0xFFFF                          ///< Applied to the CRC sent on the wire
+#define FRAME_MAX_RAW           (FRAME_MAX_PAYLOAD + FRAME_OVERHEAD)
+
+/// Worst-case bytes on the wire for a payload of n bytes (COBS codes + delimiter)
+#define FRAME_ENCODED_MAX(n)    ((n) + FRAME_OVERHEAD + (((n) + FRAME_OVERHEAD) / 254) + 2)
+
+/*==============================================================================
+ * DECODER
+ *============================================================================*/
+
+/**
+ * @brief Called for every frame that passes the CRC check
+ * @param ctx: Context given to frame_decoder_init()
+ * @param seq: Sender's sequence number
+ * @param type: Message type
+ * @param payload: Payload bytes - only valid during the call
+ * @param len: Payload length
+ */
+typedef void (*frame_handler_t)(void *ctx, uint8_t seq, uint8_t type, const uint8_t *payload, uint16_t len);
+
+typedef struct {
+    uint8_t buf[FRAME_MAX_RAW];     ///< Decoded bytes of the frame in progress
+    uint16_t len;                   ///< Bytes in buf
+    uint8_t code;                   ///< Current COBS block code
+    uint8_t remaining;              ///< Data bytes left in the current block
+    bool zero_pending;              ///< Block ended - a zero follows unless the frame does
+    bool overflow;                  ///< Frame too long, dropped at the next delimiter
+    frame_handler_t handler;
+    void *ctx;
+    uint32_t frames;                ///< Good frames delivered
+    uint32_t crc_errors;            ///< Frames dropped for a bad CRC
+    uint32_t length_errors;         ///< Frames dropped for being too short or too long
+} frame_decoder_t;
+
+/*==============================================================================
+ * FUNCTION DECLARATIONS
+ *============================================================================*/
+uint16_t frame_crc16(uint16_t crc, const uint8_t *data, uint16_t len);
+
+uint16_t frame_encode(uint8_t *out, uint16_t size, uint8_t seq, uint8_t type, const uint8_t *payload, uint16_t len);
+uint16_t frame_encode_ring(ring_buffer_t *rb, uint8_t seq, uint8_t type, const uint8_t *payload, uint16_t len);
+
+void frame_decoder_init(frame_decoder_t *d, frame_handler_t handler, void *ctx);
+void frame_decoder_reset(frame_decoder_t *d);
+void frame_decoder_feed(frame_decoder_t *d, const uint8_t *data, uint16_t len);
+
+#endif /* FRAME_H_ */
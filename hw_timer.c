@@ -283,3 +283,39 @@ uint32_t hw_timer_get_resolution_ns(uint8_t timer_num)
         return 1000000;  // Approximately 1ms = 1,000,000ns
     }
 }
+
+
+/*==============================================================================
+ * CYCLE COUNTER (DWT)
+ *============================================================================*/
+
+/**
+ * @brief Start the Cortex-M4 DWT cycle counter used for latency measurements
+ * @param None
+ * @return None
+ * @note Safe to call more than once, the counter keeps running
+ */
+void hw_timer_cycles_init(void)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;       // enable trace blocks (DWT)
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+/**
+ * @brief Current core cycle count
+ * @return Free-running 32-bit cycle counter, subtract two readings for an interval
+ */
+uint32_t hw_timer_cycles(void)
+{
+    return DWT->CYCCNT;
+}
+
+/**
+ * @brief Convert a cycle interval to nanoseconds at the current core clock
+ * @param cycles: Interval from two hw_timer_cycles() readings
+ * @return Interval in nanoseconds
+ */
+uint32_t hw_timer_cycles_to_ns(uint32_t cycles)
+{
+    return (uint32_t)(((uint64_t)cycles * 1000000000ULL) / CMU_ClockFreqGet(cmuClock_CORE));
+}
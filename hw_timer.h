@@ -142,6 +142,32 @@ void hw_timer_get_frequencies(uint32_t *timer0_freq, uint32_t *timer1_freq);
  */
 uint32_t hw_timer_get_resolution_ns(uint8_t timer_num);
 
+/*==============================================================================
+ * CYCLE COUNTER FUNCTION DECLARATIONS
+ *============================================================================*/
+
+/**
+ * @brief Start the DWT cycle counter
+ * @param None
+ * @return None
+ * @note Called from usart_init(), needed before hw_timer_cycles() is meaningful
+ */
+void hw_timer_cycles_init(void);
+
+/**
+ * @brief Read the DWT cycle counter
+ * @return Core clock cycles (wraps every 2^32 cycles)
+ * @example uint32_t t0 = hw_timer_cycles(); ... uint32_t dt = hw_timer_cycles() - t0;
+ */
+uint32_t hw_timer_cycles(void);
+
+/**
+ * @brief Convert core clock cycles to nanoseconds
+ * @param cycles: Number of core clock cycles
+ * @return Nanoseconds
+ */
+uint32_t hw_timer_cycles_to_ns(uint32_t cycles);
+
 /*==============================================================================
  * CONVENIENCE MACROS
  *============================================================================*/
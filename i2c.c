@@ -1,6 +1,16 @@
 /*
  * i2c.c
  *
+ * @brief Interrupt driven, queued I2C transfers on I2C0 and I2C1
+ * @description A transfer is a descriptor (bus, priority, address, write
+ *              buffer, read buffer, lengths, callback). Each bus has a queue
+ *              per priority. i2cSubmit() queues a descriptor and, if the bus
+ *              is idle, hands it to emlib's I2C_TransferInit(). The bus
+ *              interrupt steps it with I2C_Transfer(), calls the callback when
+ *              it finishes and starts the next queued transfer straight away.
+ *              The two buses run independently. The interrupts never print
+ *              or wait.
+ *
  *  Created on: 21 May 2025
  *      Author: JonathanStorey
  */
@@ -13,6 +23,7 @@
 #include "em_timer.h"
 #include "em_i2c.h"
 #include "em_emu.h"
+#include "em_core.h"
 #include "EFM32GG11B420F2048GQ100.h"
 //#include "sw_delay.h"
 #include "hw_timer.h"
@@ -24,21 +35,70 @@
 
 
 
-#define I2C             I2C0
-#define I2C_SCL_PORT    gpioPortD
-#define I2C_SCL_PIN     7
-#define I2C_SDA_PORT    gpioPortD
-#define I2C_SDA_PIN     6
-#define I2C_LOCATION    1
+#define I2C0_SCL_PORT   gpioPortD       // Sensor caddy - Compass A, internal pressure
+#define I2C0_SCL_PIN    7
+#define I2C0_SDA_PORT   gpioPortD
+#define I2C0_SDA_PIN    6
+#define I2C1_SCL_PORT   gpioPortB       // Compass B - LOC1, not confirmed against the board (I2C_COMPASS_B_ENABLE)
+#define I2C1_SCL_PIN    12
+#define I2C1_SDA_PORT   gpioPortB
+#define I2C1_SDA_PIN    11
 //#define I2C_SLAVE_ADDR  0x76
 #define I2C_SLAVE_ADDR  0x19      //compass address
 
 #define I2C_REG_ADDR    0x00
+#define I2C_BLOCKING_TIMEOUT_US 10000     // longest write-then-read of a few bytes at 100 kHz is ~1 ms
+
+
+/**
+ * @brief One bus: its peripheral, a queue per priority and the transfer on the wire
+ */
+typedef struct {
+    I2C_TypeDef *i2c;
+    IRQn_Type irq;
+    i2cTransfer_t *volatile active;                 // NULL when idle
+    i2cTransfer_t *head[I2C_PRIORITY_COUNT];
+    i2cTransfer_t *tail[I2C_PRIORITY_COUNT];
+    I2C_TransferSeq_TypeDef seq;                    // emlib's view of active
+    bool running;                                   // i2cRun() in progress - callbacks just queue
+    uint32_t completed;
+    uint32_t failed;
+} i2cBusState_t;
+
+static i2cBusState_t i2cBuses[I2C_BUS_COUNT] =
+{
+    { .i2c = I2C0, .irq = I2C0_IRQn },              // I2C_BUS_CADDY
+    { .i2c = I2C1, .irq = I2C1_IRQn }               // I2C_BUS_COMPASS_B
+};
+
+static i2cTransfer_t legacyTransfer;                      // i2cStartReadByte() / i2cReadRegister()
+static uint8_t legacyReg;
+static uint8_t legacyByte;
 
 
-static volatile I2C_State_t i2cState = I2C_STATE_IDLE;
-static volatile bool i2cTransferComplete = false;
-static volatile uint8_t i2cRxData = 0;
+
+
+/**
+ * @brief Pins, clock and interrupt for one bus
+ */
+static void initI2CBus(I2C_TypeDef *i2c, IRQn_Type irq)
+{
+     I2C_Init_TypeDef init = I2C_INIT_DEFAULT;                                  // Init I2C
+     init.enable = false;
+     I2C_Init(i2c, &init);
+
+     if (i2c->STATE & I2C_STATE_BUSY)                                           // Clear bus
+     {
+         i2c->CMD = I2C_CMD_ABORT;
+     }
+
+     I2C_Enable(i2c, true);
+     i2c->IFC = _I2C_IFC_MASK;                                                  // Clear interrupts - I2C_TransferInit() enables the ones it needs
+     i2c->IEN = 0;
+
+     NVIC_ClearPendingIRQ(irq);
+     NVIC_EnableIRQ(irq);
+}
 
 
 
@@ -49,117 +109,486 @@ void initI2C(void)
      CMU_ClockEnable(cmuClock_GPIO, true);      // Enable clocks
      CMU_ClockEnable(cmuClock_I2C0, true);
 
-     GPIO_PinModeSet(I2C_SCL_PORT, I2C_SCL_PIN, gpioModeWiredAndPullUpFilter, 1); // Configure SDA/SCL as open-drain with pull-up
-     GPIO_PinModeSet(I2C_SDA_PORT, I2C_SDA_PIN, gpioModeWiredAndPullUpFilter, 1);
+     GPIO_PinModeSet(I2C0_SCL_PORT, I2C0_SCL_PIN, gpioModeWiredAndPullUpFilter, 1); // Configure SDA/SCL as open-drain with pull-up
+     GPIO_PinModeSet(I2C0_SDA_PORT, I2C0_SDA_PIN, gpioModeWiredAndPullUpFilter, 1);
 
-     I2C0->ROUTELOC0 = I2C_ROUTELOC0_SCLLOC_LOC1 | I2C_ROUTELOC0_SDALOC_LOC1;   // Route pins
+     I2C0->ROUTELOC0 = I2C_ROUTELOC0_SCLLOC_LOC1 | I2C_ROUTELOC0_SDALOC_LOC1;   // Route pins - I2C0 LOC1 PD6/PD7
      I2C0->ROUTEPEN = I2C_ROUTEPEN_SCLPEN | I2C_ROUTEPEN_SDAPEN;
 
-     I2C_Init_TypeDef init = I2C_INIT_DEFAULT;                                  // Init I2C
-     init.enable = false;
-     I2C_Init(I2C0, &init);
+     initI2CBus(I2C0, I2C0_IRQn);
+
+#if I2C_COMPASS_B_ENABLE
+     CMU_ClockEnable(cmuClock_I2C1, true);
+     GPIO_PinModeSet(I2C1_SCL_PORT, I2C1_SCL_PIN, gpioModeWiredAndPullUpFilter, 1);
+     GPIO_PinModeSet(I2C1_SDA_PORT, I2C1_SDA_PIN, gpioModeWiredAndPullUpFilter, 1);
+     I2C1->ROUTELOC0 = I2C_ROUTELOC0_SCLLOC_LOC1 | I2C_ROUTELOC0_SDALOC_LOC1;   // I2C1 LOC1 PB11/PB12 - unconfirmed
+     I2C1->ROUTEPEN = I2C_ROUTEPEN_SCLPEN | I2C_ROUTEPEN_SDAPEN;
+     initI2CBus(I2C1, I2C1_IRQn);
+#endif
+}
+
 
-     while (I2C0->STATUS & I2C_STATE_BUSY);                                      // Clear bus
 
-     I2C_Enable(I2C0, true);
-     I2C0->IFC = _I2C_IFC_MASK;                                                  // Clear and enable interrupts
-     I2C0->IEN = I2C_IEN_ACK | I2C_IEN_RXDATAV | I2C_IEN_NACK | I2C_IEN_MSTOP;
 
-     NVIC_ClearPendingIRQ(I2C0_IRQn);
-     NVIC_EnableIRQ(I2C0_IRQn);
+/**
+ * @brief true if initI2C() brings the bus up
+ * @note I2C1 only with I2C_COMPASS_B_ENABLE
+ */
+bool i2cBusEnabled(i2cBus_t bus)
+{
+    return bus == I2C_BUS_CADDY || (bus == I2C_BUS_COMPASS_B && I2C_COMPASS_B_ENABLE);
 }
 
 
 
 
+/**
+ * @brief Hand the finished transfer back to its owner
+ * @note Runs with the bus interrupt masked or from the bus interrupt. Does not
+ *       start the next transfer - i2cRun() does that.
+ */
+static void i2cFinish(i2cBusState_t *bus, I2C_TransferReturn_TypeDef ret)
+{
+    i2cTransfer_t *transfer = bus->active;
 
-void i2cStartReadByte(void)
+    bus->active = NULL;
+    if (transfer == NULL)
+    {
+        return;
+    }
+    transfer->result = ret;
+    if (ret == i2cTransferDone)
+    {
+        transfer->status = I2C_TRANSFER_DONE;
+        bus->completed++;
+    }
+    else
+    {
+        transfer->status = I2C_TRANSFER_FAILED;
+        bus->failed++;
+    }
+    if (transfer->callback != NULL)
+    {
+        transfer->callback(transfer);                                           // may submit more
+    }
+}
+
+
+
+
+/**
+ * @brief Take the highest priority waiting transfer off a bus's queues
+ */
+static i2cTransfer_t *i2cDequeue(i2cBusState_t *bus)
 {
-    if (i2cState != I2C_STATE_IDLE) return;
-    i2cTransferComplete = false;            //set flag to false so that transmission loops until complete
-    i2cState = I2C_STATE_SEND_ADDR;         // initilise state to send the address
-    I2C0->CMD = I2C_CMD_ABORT;
-    I2C0->IFC = _I2C_IFC_MASK;                  // Clear flags
-    I2C0->CMD = I2C_CMD_START;                  // send a start bit
-    I2C0->TXDATA = (I2C_SLAVE_ADDR << 1) | 0;  // Write slave address shifted right
+    for (uint8_t priority = 0; priority < I2C_PRIORITY_COUNT; priority++)
+    {
+        i2cTransfer_t *transfer = bus->head[priority];
+
+        if (transfer != NULL)
+        {
+            bus->head[priority] = transfer->next;
+            if (bus->head[priority] == NULL)
+            {
+                bus->tail[priority] = NULL;
+            }
+            transfer->next = NULL;
+            return transfer;
+        }
+    }
+    return NULL;
 }
 
 
 
 
-bool i2cIsTransferDone(void)
+/**
+ * @brief Start queued transfers until one is on the wire or the queues are empty
+ * @note Called with the bus idle from i2cSubmit() and straight after a
+ *       completion in the interrupt, so the next START follows the last STOP
+ *       with no gap. A transfer emlib refuses at once is finished here and the
+ *       next one tried.
+ */
+static void i2cRun(i2cBusState_t *bus)
 {
-    return i2cTransferComplete;
+    if (bus->running)
+    {
+        return;                                                                 // a callback submitting - the loop below picks it up
+    }
+    bus->running = true;
+
+    while (bus->active == NULL)
+    {
+        i2cTransfer_t *transfer = i2cDequeue(bus);
+        I2C_TransferSeq_TypeDef *seq = &bus->seq;
+        I2C_TransferReturn_TypeDef ret;
+
+        if (transfer == NULL)
+        {
+            break;
+        }
+        bus->active = transfer;
+        transfer->status = I2C_TRANSFER_ACTIVE;
+
+        seq->addr = (uint16_t)(transfer->addr << 1);
+        if (transfer->writeLen && transfer->readLen)
+        {
+            seq->flags = I2C_FLAG_WRITE_READ;
+            seq->buf[0].data = (uint8_t *)transfer->writeData;
+            seq->buf[0].len = transfer->writeLen;
+            seq->buf[1].data = transfer->readData;
+            seq->buf[1].len = transfer->readLen;
+        }
+        else if (transfer->readLen)
+        {
+            seq->flags = I2C_FLAG_READ;
+            seq->buf[0].data = transfer->readData;
+            seq->buf[0].len = transfer->readLen;
+        }
+        else
+        {
+            seq->flags = I2C_FLAG_WRITE;
+            seq->buf[0].data = (uint8_t *)transfer->writeData;
+            seq->buf[0].len = transfer->writeLen;
+        }
+
+        ret = I2C_TransferInit(bus->i2c, seq);                                  // enables the interrupts the transfer needs
+        if (ret != i2cTransferInProgress)
+        {
+            i2cFinish(bus, ret);
+        }
+    }
+
+    bus->running = false;
 }
 
 
-uint8_t i2cGetLastByte(void)
+
+
+/**
+ * @brief Queue a transfer on its bus, starting it if the bus is idle
+ * @param transfer: Descriptor with bus and priority filled in - it and its
+ *                  buffers must stay valid until the status is DONE or FAILED
+ *                  (or the callback runs)
+ * @return false if the bus is invalid or not enabled, or the descriptor is
+ *         already queued
+ * @note Write-then-read uses a repeated start. With no write and no read
+ *       bytes only the address is sent, which is enough to probe for a device.
+ *       Higher priority transfers overtake queued lower ones but never the
+ *       one on the wire.
+ */
+bool i2cSubmit(i2cTransfer_t *transfer)
 {
-    return i2cRxData;
+    i2cBusState_t *bus;
+    uint8_t priority;
+    CORE_DECLARE_IRQ_STATE;
+
+    if (!i2cBusEnabled((i2cBus_t)transfer->bus))
+    {
+        return false;
+    }
+    bus = &i2cBuses[transfer->bus];
+    priority = (transfer->priority < I2C_PRIORITY_COUNT) ? transfer->priority : I2C_PRIORITY_LOW;
+
+    CORE_ENTER_ATOMIC();
+    if (transfer->status == I2C_TRANSFER_PENDING || transfer->status == I2C_TRANSFER_ACTIVE)
+    {
+        CORE_EXIT_ATOMIC();
+        return false;
+    }
+    transfer->status = I2C_TRANSFER_PENDING;
+    transfer->next = NULL;
+    if (bus->tail[priority] == NULL)
+    {
+        bus->head[priority] = transfer;
+    }
+    else
+    {
+        bus->tail[priority]->next = transfer;
+    }
+    bus->tail[priority] = transfer;
+    i2cRun(bus);
+    CORE_EXIT_ATOMIC();
+    return true;
 }
 
 
-void I2C0_IRQHandler(void)
+
+
+/**
+ * @brief Take a transfer off its queue before it starts
+ * @return false if it isn't waiting (already on the wire, or finished)
+ */
+bool i2cCancel(i2cTransfer_t *transfer)
 {
-    uint32_t flags = I2C0->IF;              //read all the I2C flags
+    i2cBusState_t *bus;
+    bool removed = false;
+    CORE_DECLARE_IRQ_STATE;
 
-    if (flags & I2C_IF_NACK)              // if we have seen a NACK, then send stop and complete TX
+    if (transfer->bus >= I2C_BUS_COUNT)
     {
-        print_string("NAK\n\r" , Node);
-        i2cState = I2C_STATE_ERROR;
-        I2C0->CMD = I2C_CMD_STOP;
-        I2C0->IFC = I2C_IF_NACK;
-        i2cTransferComplete = true;
-        return;
+        return false;
     }
+    bus = &i2cBuses[transfer->bus];
 
-    switch (i2cState)
+    CORE_ENTER_ATOMIC();
+    if (transfer->status == I2C_TRANSFER_PENDING)
     {
-        case I2C_STATE_SEND_ADDR:
-          put_char('1', Node);
-          if (flags & I2C_IF_ACK)
-          {
-              I2C0->TXDATA = I2C_REG_ADDR;
-              i2cState = I2C_STATE_SEND_REG;
-              I2C0->IFC = I2C_IF_ACK;           // Clear ack flag all handled flags
-          }
-            break;
+        for (uint8_t priority = 0; priority < I2C_PRIORITY_COUNT && !removed; priority++)
+        {
+            i2cTransfer_t *prev = NULL;
 
-        case I2C_STATE_SEND_REG:
-            if (flags & I2C_IF_TXBL)
+            for (i2cTransfer_t *t = bus->head[priority]; t != NULL; prev = t, t = t->next)
             {
-                I2C0->CMD = I2C_CMD_START;                  // repeated start
-                I2C0->TXDATA = (I2C_SLAVE_ADDR << 1) | 1;   // read
-                i2cState = I2C_STATE_READ;
-                I2C0->IFC = I2C_IF_TXBL;                  // Clear ack flag all handled flags
+                if (t == transfer)
+                {
+                    if (prev == NULL)
+                    {
+                        bus->head[priority] = t->next;
+                    }
+                    else
+                    {
+                        prev->next = t->next;
+                    }
+                    if (bus->tail[priority] == t)
+                    {
+                        bus->tail[priority] = prev;
+                    }
+                    t->next = NULL;
+                    t->status = I2C_TRANSFER_IDLE;
+                    removed = true;
+                    break;
+                }
             }
-            break;
+        }
+    }
+    CORE_EXIT_ATOMIC();
+    return removed;
+}
+
+
+
+
+/**
+ * @brief true when nothing is queued or on the wire
+ */
+bool i2cIsIdle(i2cBus_t bus)
+{
+    if (bus >= I2C_BUS_COUNT)
+    {
+        return true;
+    }
+    for (uint8_t priority = 0; priority < I2C_PRIORITY_COUNT; priority++)
+    {
+        if (i2cBuses[bus].head[priority] != NULL)
+        {
+            return false;
+        }
+    }
+    return i2cBuses[bus].active == NULL;
+}
+
 
 
-        case I2C_STATE_READ:
 
-            if (flags & I2C_IF_RXDATAV)
+/**
+ * @brief Transfers completed and failed on a bus since power up
+ */
+void i2cGetStats(i2cBus_t bus, uint32_t *completed, uint32_t *failed)
+{
+    if (bus < I2C_BUS_COUNT)
+    {
+        *completed = i2cBuses[bus].completed;
+        *failed = i2cBuses[bus].failed;
+    }
+}
+
+
+
+
+/**
+ * @brief Give up on the transfer on the wire and move on to the next
+ * @note Sends ABORT, which releases the bus without a STOP. The transfer
+ *       fails with i2cTransferSwFault and its callback runs.
+ */
+void i2cAbort(i2cBus_t bus)
+{
+    i2cBusState_t *state;
+    CORE_DECLARE_IRQ_STATE;
+
+    if (!i2cBusEnabled(bus))
+    {
+        return;
+    }
+    state = &i2cBuses[bus];
+
+    CORE_ENTER_ATOMIC();
+    if (state->active != NULL)
+    {
+        I2C_IntDisable(state->i2c, _I2C_IEN_MASK);
+        state->i2c->CMD = I2C_CMD_ABORT;
+        state->i2c->IFC = _I2C_IFC_MASK;
+        i2cFinish(state, i2cTransferSwFault);
+        i2cRun(state);
+    }
+    CORE_EXIT_ATOMIC();
+}
+
+
+
+
+/**
+ * @brief Run a transfer and wait for it
+ * @param transfer: Descriptor (its callback, if any, still runs)
+ * @param timeoutUs: Give up after this long, counted from submission
+ * @return emlib result - i2cTransferDone on success
+ */
+I2C_TransferReturn_TypeDef i2cTransferBlocking(i2cTransfer_t *transfer, uint32_t timeoutUs)
+{
+    uint32_t start = hw_timer_cycles();
+
+    if (!i2cSubmit(transfer))
+    {
+        return i2cTransferUsageFault;
+    }
+    while (transfer->status == I2C_TRANSFER_PENDING || transfer->status == I2C_TRANSFER_ACTIVE)
+    {
+        if (hw_timer_cycles_to_ns(hw_timer_cycles() - start) / 1000 > timeoutUs)
+        {
+            if (i2cCancel(transfer))
             {
-                i2cRxData = I2C0->RXDATA;
-                I2C0->CMD = I2C_CMD_NACK | I2C_CMD_STOP;
-                i2cState = I2C_STATE_WAITSTOP;
-                I2C0->IFC = I2C_IF_RXDATAV;           // Clear ack flag all handled flags
+                return i2cTransferSwFault;                                      // never got the bus
             }
-            break;
-
-        case I2C_STATE_WAITSTOP:
-            if (flags & I2C_IF_MSTOP)
+            if (i2cBuses[transfer->bus].active == transfer)
             {
-                i2cTransferComplete = true;
-                i2cState = I2C_STATE_IDLE;
-                I2C0->IFC = I2C_IF_MSTOP;
+                i2cAbort((i2cBus_t)transfer->bus);
             }
-            break;
+        }
+    }
+    return transfer->result;
+}
 
-        default:
-          I2C0->IFC = flags;        //The idle state will cause this default to happen clear all flags
-            break;
+
+
+
+/**
+ * @brief Read len consecutive registers in one write-then-read transaction
+ * @param transfer: Descriptor with bus, priority, addr and callback filled in
+ * @param reg: First register
+ * @param autoIncrement: I2C_AUTOINC_MSB for parts that need the register MSB
+ *                       set to step through registers, I2C_AUTOINC_NONE for
+ *                       parts that always do
+ * @param data: Where the len bytes go
+ * @return false if the descriptor is already queued
+ * @note One START / address / register / repeated START / address / len bytes
+ *       / STOP, instead of the whole sequence for every register
+ */
+bool i2cReadBurst(i2cTransfer_t *transfer, uint8_t reg, uint8_t autoIncrement, uint8_t *data, uint16_t len)
+{
+    if (transfer->status == I2C_TRANSFER_PENDING || transfer->status == I2C_TRANSFER_ACTIVE)
+    {
+        return false;
+    }
+    transfer->regAddr = (len > 1) ? (uint8_t)(reg | autoIncrement) : reg;
+    transfer->writeData = &transfer->regAddr;
+    transfer->writeLen = 1;
+    transfer->readData = data;
+    transfer->readLen = len;
+    return i2cSubmit(transfer);
+}
+
+
+
+
+/**
+ * @brief Start reading register I2C_REG_ADDR of I2C_SLAVE_ADDR in the background
+ */
+void i2cStartReadByte(void)
+{
+    if (legacyTransfer.status == I2C_TRANSFER_PENDING || legacyTransfer.status == I2C_TRANSFER_ACTIVE) return;
+    legacyReg = I2C_REG_ADDR;
+    legacyTransfer.bus = I2C_BUS_CADDY;
+    legacyTransfer.priority = I2C_PRIORITY_NORMAL;
+    legacyTransfer.addr = I2C_SLAVE_ADDR;
+    legacyTransfer.writeData = &legacyReg;
+    legacyTransfer.writeLen = 1;
+    legacyTransfer.readData = &legacyByte;
+    legacyTransfer.readLen = 1;
+    legacyTransfer.callback = NULL;
+    i2cSubmit(&legacyTransfer);
+}
+
+
+
+
+bool i2cIsTransferDone(void)
+{
+    return legacyTransfer.status == I2C_TRANSFER_DONE || legacyTransfer.status == I2C_TRANSFER_FAILED;
+}
+
+
+uint8_t i2cGetLastByte(void)
+{
+    return legacyByte;
+}
+
+
+
+
+/**
+ * @brief Read one register of I2C_SLAVE_ADDR, waiting for the result
+ * @return false on NACK, bus error or timeout
+ */
+bool i2cReadRegister(uint8_t reg, uint8_t *value)
+{
+    if (legacyTransfer.status == I2C_TRANSFER_PENDING || legacyTransfer.status == I2C_TRANSFER_ACTIVE) return false;
+    legacyReg = reg;
+    legacyTransfer.bus = I2C_BUS_CADDY;
+    legacyTransfer.priority = I2C_PRIORITY_NORMAL;
+    legacyTransfer.addr = I2C_SLAVE_ADDR;
+    legacyTransfer.writeData = &legacyReg;
+    legacyTransfer.writeLen = 1;
+    legacyTransfer.readData = value;
+    legacyTransfer.readLen = 1;
+    legacyTransfer.callback = NULL;
+    return i2cTransferBlocking(&legacyTransfer, I2C_BLOCKING_TIMEOUT_US) == i2cTransferDone;
+}
+
+
+
+
+/**
+ * @brief Step emlib's state machine on one bus, and start the next transfer
+ *        the moment one finishes - no printing or waiting here
+ */
+static void i2cService(i2cBusState_t *bus)
+{
+    I2C_TransferReturn_TypeDef ret;
+
+    if (bus->active == NULL)                                                    // stray flag with nothing running
+    {
+        I2C_IntDisable(bus->i2c, _I2C_IEN_MASK);
+        bus->i2c->IFC = _I2C_IFC_MASK;
+        return;
     }
+    ret = I2C_Transfer(bus->i2c);
+    if (ret != i2cTransferInProgress)
+    {
+        i2cFinish(bus, ret);
+        i2cRun(bus);
+    }
+}
+
+
+void I2C0_IRQHandler(void)
+{
+    i2cService(&i2cBuses[I2C_BUS_CADDY]);
+}
+
+
+void I2C1_IRQHandler(void)
+{
+    i2cService(&i2cBuses[I2C_BUS_COMPASS_B]);
 }
 
 
@@ -7,13 +7,86 @@
 
 #ifndef I2C_H_
 #define I2C_H_
+#include <stdint.h>
 #include <stdbool.h>
+#include "em_i2c.h"
+
+typedef enum {
+    I2C_BUS_CADDY = 0,                  ///< I2C0 - sensor caddy (Compass A, internal pressure)
+    I2C_BUS_COMPASS_B,                  ///< I2C1 - Compass B
+    I2C_BUS_COUNT
+} i2cBus_t;
+
+typedef enum {
+    I2C_PRIORITY_HIGH = 0,              ///< Served first
+    I2C_PRIORITY_NORMAL,
+    I2C_PRIORITY_LOW,
+    I2C_PRIORITY_COUNT
+} i2cPriority_t;
+
+typedef enum {
+    I2C_TRANSFER_IDLE = 0,              ///< Never submitted, or cancelled
+    I2C_TRANSFER_PENDING,               ///< Queued behind other transfers
+    I2C_TRANSFER_ACTIVE,                ///< On the bus
+    I2C_TRANSFER_DONE,                  ///< Every byte moved
+    I2C_TRANSFER_FAILED                 ///< NACK, bus error, lost arbitration or abort - see result
+} i2cTransferStatus_t;
+
+struct i2cTransfer;
+
+/**
+ * @brief Called from the I2C interrupt when a transfer finishes (keep it short)
+ */
+typedef void (*i2cCallback_t)(struct i2cTransfer *transfer);
+
+/**
+ * @brief One I2C transaction: write writeLen bytes, then (repeated start)
+ *        read readLen bytes. Either length may be zero.
+ */
+typedef struct i2cTransfer {
+    uint8_t bus;                                ///< i2cBus_t
+    uint8_t priority;                           ///< i2cPriority_t
+    uint8_t addr;                               ///< 7-bit device address
+    const uint8_t *writeData;
+    uint16_t writeLen;
+    uint8_t *readData;
+    uint16_t readLen;
+    i2cCallback_t callback;                     ///< May be NULL - poll status instead
+    void *ctx;                                  ///< For the callback
+    volatile i2cTransferStatus_t status;
+    I2C_TransferReturn_TypeDef result;          ///< i2cTransferDone on success
+    struct i2cTransfer *next;                   ///< Queue link - owned by i2c.c
+    uint8_t regAddr;                            ///< Register byte sent by i2cReadBurst() (writeData points here)
+} i2cTransfer_t;
+
+/**
+ * @brief Bring up I2C1 (Compass B) in initI2C()
+ * @note Off until its pins are confirmed against the board pin map - see
+ *       I2C1_SCL_PIN / I2C1_SDA_PIN in i2c.c. While off, transfers on
+ *       I2C_BUS_COMPASS_B are refused and the scan and sampler skip it.
+ */
+#ifndef I2C_COMPASS_B_ENABLE
+#define I2C_COMPASS_B_ENABLE    0
+#endif
+
+#define I2C_AUTOINC_NONE        0x00            ///< Device steps through registers by itself
+#define I2C_AUTOINC_MSB         0x80            ///< Register MSB requests auto-increment (LSM303 / LIS3 style)
+
+bool i2cSubmit(i2cTransfer_t *transfer);
+bool i2cCancel(i2cTransfer_t *transfer);
+bool i2cIsIdle(i2cBus_t bus);
+bool i2cBusEnabled(i2cBus_t bus);
+void i2cAbort(i2cBus_t bus);
+void i2cGetStats(i2cBus_t bus, uint32_t *completed, uint32_t *failed);
+I2C_TransferReturn_TypeDef i2cTransferBlocking(i2cTransfer_t *transfer, uint32_t timeoutUs);
+bool i2cReadBurst(i2cTransfer_t *transfer, uint8_t reg, uint8_t autoIncrement, uint8_t *data, uint16_t len);
 
 void enableI2cSlaveInterrupts(void);
 void disableI2cInterrupts(void);
 void performI2CTransfer(void);
 void receiveI2CData(void);
 void I2C0_IRQHandler(void);
+void I2C1_IRQHandler(void);
 
 bool i2cReadRegister(uint8_t, uint8_t*);
 void initI2C(void);
@@ -0,0 +1,132 @@
+/*
+ * i2c_devices.c
+ *
+ * @brief Descriptors of the I2C sensors and their sample blocks
+ * @description See i2c_devices.h.
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: JonathanStorey
+ *    Hardware: EFM32GG11B Microcontroller, I2C0 sensor caddy, I2C1 Compass B
+ *     Version: 1.0
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "i2c.h"
+#include "i2c_devices.h"
+
+
+/**
+ * @brief LSM303 accelerometer set-up - it powers up in power-down mode
+ * @note CTRL_REG1_A (0x20) = 0x57: 100 Hz, normal mode, X/Y/Z enabled
+ */
+static const i2cRegWrite_t lsm303Init[] =
+{
+    { 0x20, 0x57 },
+};
+
+/**
+ * @brief BMP280 set-up - it powers up in sleep mode
+ * @note ctrl_meas (0xF4) = 0x27: temperature and pressure oversampling x1,
+ *       normal mode
+ */
+static const i2cRegWrite_t bmp280Init[] =
+{
+    { 0xF4, 0x27 },
+};
+
+#define INIT_LIST(list)         (list), (uint8_t)(sizeof(list) / sizeof((list)[0]))
+
+/**
+ * @brief Every sensor on the two buses, indexed by i2cDeviceId_t
+ * @note LSM303 accelerometer: OUT_X_L_A (0x28) to OUT_Z_H_A (0x2D), X/Y/Z
+ *       little endian, and only steps through them with the register MSB set.
+ *       Pressure: BMP280 style block at 0xF7 (pressure then temperature, 20
+ *       bits each, big endian) - check the part fitted to the caddy.
+ */
+static const i2cDevice_t i2cDevices[I2C_DEVICE_COUNT] =
+{
+    /* name         bus                 addr  sampleReg sampleLen autoIncrement      priority             init                  */
+    { "Compass A",  I2C_BUS_CADDY,      0x19, 0x28,     6,        I2C_AUTOINC_MSB,   I2C_PRIORITY_HIGH,   INIT_LIST(lsm303Init) },
+    { "Pressure",   I2C_BUS_CADDY,      0x76, 0xF7,     6,        I2C_AUTOINC_NONE,  I2C_PRIORITY_NORMAL, INIT_LIST(bmp280Init) },
+    { "Compass B",  I2C_BUS_COMPASS_B,  0x19, 0x28,     6,        I2C_AUTOINC_MSB,   I2C_PRIORITY_HIGH,   INIT_LIST(lsm303Init) },
+};
+
+
+/**
+ * @brief Descriptor of one device, NULL if the id is out of range
+ */
+const i2cDevice_t *i2cDeviceGet(i2cDeviceId_t id)
+{
+    if (id >= I2C_DEVICE_COUNT)
+    {
+        return NULL;
+    }
+    return &i2cDevices[id];
+}
+
+/**
+ * @brief Descriptor of the device at an address, NULL if none is described
+ */
+const i2cDevice_t *i2cDeviceFind(uint8_t bus, uint8_t addr)
+{
+    for (uint8_t id = 0; id < I2C_DEVICE_COUNT; id++)
+    {
+        if (i2cDevices[id].bus == bus && i2cDevices[id].addr == addr)
+        {
+            return &i2cDevices[id];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Send a device its set-up writes, in order, waiting for each
+ * @param device: Device to set up
+ * @return false if a write failed (NACK, bus error or timeout) - the rest
+ *         are not sent
+ * @note Blocks, so call it from the main loop with the I2C interrupts running
+ */
+bool i2cDeviceConfigure(const i2cDevice_t *device)
+{
+    for (uint8_t i = 0; i < device->initLen; i++)
+    {
+        i2cTransfer_t transfer = { 0 };
+        uint8_t data[2] = { device->init[i].reg, device->init[i].value };
+
+        transfer.bus = device->bus;
+        transfer.priority = device->priority;
+        transfer.addr = device->addr;
+        transfer.writeData = data;
+        transfer.writeLen = sizeof(data);
+        if (i2cTransferBlocking(&transfer, I2C_DEVICE_INIT_TIMEOUT_US) != i2cTransferDone)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Queue a read of one full sample block
+ * @param device: Device to read
+ * @param transfer: Descriptor to use - must stay valid until the callback
+ * @param sample: device->sampleLen bytes
+ * @param callback: Runs in the I2C interrupt when the sample is in (may be NULL)
+ * @param ctx: Passed back in transfer->ctx
+ * @return false if the transfer is still in use
+ */
+bool i2cReadSample(const i2cDevice_t *device, i2cTransfer_t *transfer, uint8_t *sample, i2cCallback_t callback, void *ctx)
+{
+    if (transfer->status == I2C_TRANSFER_PENDING || transfer->status == I2C_TRANSFER_ACTIVE)
+    {
+        return false;
+    }
+    transfer->bus = device->bus;
+    transfer->priority = device->priority;
+    transfer->addr = device->addr;
+    transfer->callback = callback;
+    transfer->ctx = ctx;
+    return i2cReadBurst(transfer, device->sampleReg, device->autoIncrement, sample, device->sampleLen);
+}
@@ -0,0 +1,68 @@
+/*
+ * i2c_devices.h
+ *
+ * @brief Descriptors of the I2C sensors and their sample blocks
+ * @description Each sensor is described once: which bus and address it is
+ *              on, where its sample block starts, how long it is and how the
+ *              part is told to auto-increment. i2cReadSample() then fetches a
+ *              whole sample with one burst read - for a compass that is one
+ *              transaction instead of six single register reads, roughly a
+ *              fifth of the bus time. A device can also list register writes
+ *              that set it up (i2cDeviceConfigure()), such as taking it out
+ *              of power-down, which have to go out before it is sampled.
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: JonathanStorey
+ *    Hardware: EFM32GG11B Microcontroller, I2C0 sensor caddy, I2C1 Compass B
+ *     Version: 1.0
+ */
+
+#ifndef I2C_DEVICES_H_
+#define I2C_DEVICES_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "i2c.h"
+
+#define I2C_SAMPLE_MAX          8       ///< Longest sample block of any device below
+#define I2C_DEVICE_INIT_TIMEOUT_US 10000 ///< Per init write - a two byte write at 100 kHz is ~0.3 ms
+
+/*==============================================================================
+ * TYPES
+ *============================================================================*/
+typedef enum {
+    I2C_DEVICE_COMPASS_A = 0,           ///< LSM303 accelerometer, sensor caddy
+    I2C_DEVICE_PRESSURE,                ///< Internal pressure / temperature, sensor caddy
+    I2C_DEVICE_COMPASS_B,               ///< LSM303 accelerometer, own bus
+    I2C_DEVICE_COUNT
+} i2cDeviceId_t;
+
+/**
+ * @brief One register write of a device's set-up
+ */
+typedef struct {
+    uint8_t reg;
+    uint8_t value;
+} i2cRegWrite_t;
+
+typedef struct {
+    const char *name;
+    uint8_t bus;                        ///< i2cBus_t
+    uint8_t addr;                       ///< 7-bit address
+    uint8_t sampleReg;                  ///< First register of the sample block
+    uint8_t sampleLen;                  ///< Bytes in one sample (<= I2C_SAMPLE_MAX)
+    uint8_t autoIncrement;              ///< I2C_AUTOINC_MSB or I2C_AUTOINC_NONE
+    uint8_t priority;                   ///< i2cPriority_t for sample reads
+    const i2cRegWrite_t *init;          ///< Written in order by i2cDeviceConfigure() (may be NULL)
+    uint8_t initLen;                    ///< Entries in init
+} i2cDevice_t;
+
+/*==============================================================================
+ * FUNCTION DECLARATIONS
+ *============================================================================*/
+const i2cDevice_t *i2cDeviceGet(i2cDeviceId_t id);
+const i2cDevice_t *i2cDeviceFind(uint8_t bus, uint8_t addr);
+bool i2cDeviceConfigure(const i2cDevice_t *device);
+bool i2cReadSample(const i2cDevice_t *device, i2cTransfer_t *transfer, uint8_t *sample, i2cCallback_t callback, void *ctx);
+
+#endif /* I2C_DEVICES_H_ */
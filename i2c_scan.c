@@ -0,0 +1,184 @@
+/*
+ * i2c_scan.c
+ *
+ * @brief Address scan of I2C0 and I2C1 and the inventory it leaves behind
+ * @description See i2c_scan.h.
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: JonathanStorey
+ *    Hardware: EFM32GG11B Microcontroller, I2C0 sensor caddy, I2C1 Compass B
+ *     Version: 1.0
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "hw_timer.h"
+#include "i2c.h"
+#include "i2c_scan.h"
+
+static i2cInventory_t i2cInventory[I2C_BUS_COUNT];
+static i2cTransfer_t i2cProbe[I2C_BUS_COUNT];            // one probe in flight per bus
+
+
+/**
+ * @brief Microseconds since a hw_timer_cycles() stamp
+ */
+static uint32_t i2cScanElapsedUs(uint32_t since)
+{
+    return hw_timer_cycles_to_ns(hw_timer_cycles() - since) / 1000;
+}
+
+/**
+ * @brief Probe every address on both buses, one address on each at a time
+ * @return Devices found on the two buses together
+ * @note Blocks for the length of the scan (~10 ms). Probes go in at low
+ *       priority, so sample reads already queued go first. The inventory of
+ *       each bus is replaced.
+ */
+uint8_t i2cScan(void)
+{
+    uint32_t scanStart = hw_timer_cycles();
+    uint32_t waitStart[I2C_BUS_COUNT];
+    bool onWire[I2C_BUS_COUNT];
+    bool busy[I2C_BUS_COUNT];
+    uint8_t found = 0;
+
+    for (uint8_t bus = 0; bus < I2C_BUS_COUNT; bus++)
+    {
+        i2cInventory_t *inv = &i2cInventory[bus];
+
+        for (uint8_t i = 0; i < 4; i++)
+        {
+            inv->present[i] = 0;
+        }
+        inv->count = 0;
+        inv->scanned = false;
+        inv->stuck = false;
+        inv->stuckAddr = 0;
+        inv->scanUs = 0;
+    }
+
+    for (uint8_t addr = I2C_SCAN_FIRST; addr <= I2C_SCAN_LAST; addr++)
+    {
+        bool waiting = false;
+
+        for (uint8_t bus = 0; bus < I2C_BUS_COUNT; bus++)
+        {
+            i2cTransfer_t *probe = &i2cProbe[bus];
+
+            busy[bus] = false;
+            if (i2cInventory[bus].stuck || !i2cBusEnabled((i2cBus_t)bus))
+            {
+                continue;
+            }
+            probe->bus = bus;
+            probe->priority = I2C_PRIORITY_LOW;
+            probe->addr = addr;
+            probe->writeData = NULL;
+            probe->writeLen = 0;                                                // address only
+            probe->readData = NULL;
+            probe->readLen = 0;
+            probe->callback = NULL;
+            probe->ctx = NULL;
+            if (i2cSubmit(probe))
+            {
+                busy[bus] = true;
+                onWire[bus] = false;
+                waitStart[bus] = hw_timer_cycles();
+                waiting = true;
+            }
+        }
+
+        while (waiting)
+        {
+            waiting = false;
+            for (uint8_t bus = 0; bus < I2C_BUS_COUNT; bus++)
+            {
+                i2cTransfer_t *probe = &i2cProbe[bus];
+                i2cInventory_t *inv = &i2cInventory[bus];
+
+                if (!busy[bus])
+                {
+                    continue;
+                }
+                switch (probe->status)
+                {
+                    case I2C_TRANSFER_DONE:                                     // ACK
+                        inv->present[addr / 32] |= 1u << (addr % 32);
+                        inv->count++;
+                        found++;
+                        busy[bus] = false;
+                        break;
+
+                    case I2C_TRANSFER_FAILED:                                   // NACK (or aborted below)
+                    case I2C_TRANSFER_IDLE:                                     // cancelled below
+                        busy[bus] = false;
+                        break;
+
+                    case I2C_TRANSFER_ACTIVE:
+                        if (!onWire[bus])
+                        {
+                            onWire[bus] = true;                                 // time the probe itself, not the queue
+                            waitStart[bus] = hw_timer_cycles();
+                        }
+                        else if (i2cScanElapsedUs(waitStart[bus]) > I2C_SCAN_PROBE_US)
+                        {
+                            inv->stuck = true;
+                            inv->stuckAddr = addr;
+                            i2cAbort((i2cBus_t)bus);
+                        }
+                        break;
+
+                    case I2C_TRANSFER_PENDING:
+                    default:
+                        if (i2cScanElapsedUs(waitStart[bus]) > I2C_SCAN_QUEUE_US && i2cCancel(probe))
+                        {
+                            inv->stuck = true;                                  // whatever is ahead of us isn't finishing
+                            inv->stuckAddr = addr;
+                        }
+                        break;
+                }
+                if (busy[bus])
+                {
+                    waiting = true;
+                }
+                else
+                {
+                    inv->scanUs = i2cScanElapsedUs(scanStart);
+                }
+            }
+        }
+    }
+
+    for (uint8_t bus = 0; bus < I2C_BUS_COUNT; bus++)
+    {
+        i2cInventory[bus].scanned = i2cBusEnabled((i2cBus_t)bus);              // a bus that isn't up stays unscanned
+    }
+    return found;
+}
+
+/**
+ * @brief What the last scan found on a bus, NULL if the bus is out of range
+ */
+const i2cInventory_t *i2cGetInventory(i2cBus_t bus)
+{
+    if (bus >= I2C_BUS_COUNT)
+    {
+        return NULL;
+    }
+    return &i2cInventory[bus];
+}
+
+/**
+ * @brief Whether an address ACKed in the last scan (no bus traffic)
+ * @return false if it didn't, or the bus hasn't been scanned yet
+ */
+bool i2cIsPresent(i2cBus_t bus, uint8_t addr)
+{
+    if (bus >= I2C_BUS_COUNT || addr > 0x7F)
+    {
+        return false;
+    }
+    return (i2cInventory[bus].present[addr / 32] & (1u << (addr % 32))) != 0;
+}
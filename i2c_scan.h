@@ -0,0 +1,59 @@
+/*
+ * i2c_scan.h
+ *
+ * @brief Address scan of I2C0 and I2C1 and the inventory it leaves behind
+ * @description i2cScan() probes every non-reserved 7-bit address (0x08 to
+ *              0x77) on both buses with an address-only transaction - START,
+ *              address, STOP, no data - and records which ones ACK. The two
+ *              buses are probed side by side, so at 100 kHz the whole scan
+ *              takes roughly 112 x 0.1 ms, a little over 10 ms.
+ *
+ *              A NACK ends a probe as soon as the ninth clock is in. A probe
+ *              that is on the wire for longer than I2C_SCAN_PROBE_US is
+ *              aborted and the bus is marked stuck (SDA or SCL held low), and
+ *              the rest of that bus is skipped rather than timing out on every
+ *              address.
+ *
+ *              The result stays in an inventory per bus, so drivers can ask
+ *              i2cIsPresent() instead of probing again. A bus initI2C()
+ *              leaves down (see I2C_COMPASS_B_ENABLE) is not probed and stays
+ *              unscanned.
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: JonathanStorey
+ *    Hardware: EFM32GG11B Microcontroller, I2C0 sensor caddy, I2C1 Compass B
+ *     Version: 1.0
+ */
+
+#ifndef I2C_SCAN_H_
+#define I2C_SCAN_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "i2c.h"
+
+#define I2C_SCAN_FIRST          0x08    ///< 0x00-0x07 are reserved (general call, CBUS, HS master code...)
+#define I2C_SCAN_LAST           0x77    ///< 0x78-0x7F are reserved (10-bit addressing, device ID)
+#define I2C_SCAN_PROBE_US       500     ///< Longest a probe may be on the wire (one is ~100 us at 100 kHz)
+#define I2C_SCAN_QUEUE_US       5000    ///< Longest a probe may wait behind other transfers
+
+/*==============================================================================
+ * TYPES
+ *============================================================================*/
+typedef struct {
+    uint32_t present[4];                ///< Bit per 7-bit address, set if it ACKed
+    uint8_t count;                      ///< Addresses that ACKed
+    bool scanned;                       ///< A scan has finished on this bus
+    bool stuck;                         ///< A probe timed out - the rest of the bus was skipped
+    uint8_t stuckAddr;                  ///< ...at this address
+    uint32_t scanUs;                    ///< Scan start to this bus's last probe
+} i2cInventory_t;
+
+/*==============================================================================
+ * FUNCTION DECLARATIONS
+ *============================================================================*/
+uint8_t i2cScan(void);
+const i2cInventory_t *i2cGetInventory(i2cBus_t bus);
+bool i2cIsPresent(i2cBus_t bus, uint8_t addr);
+
+#endif /* I2C_SCAN_H_ */
@@ -43,6 +43,10 @@
 #include "helpers.h"
 #include "menu.h"
 #include "initialisation.h"
+#include "expander_io.h"
+#include "expander_gpio.h"
+#include "spi_bus.h"
+#include "sampler.h"
 
 /**
  * @brief Complete system initialisation for EFM32GG11B node
@@ -139,7 +143,7 @@ void Initialise_Node(void)
     // IMU - USART0 LOC2 with RS485 control
     GPIO_PinModeSet(gpioPortC, 10, gpioModeInput, 0);       // RX
     GPIO_PinModeSet(gpioPortC, 11, gpioModePushPull, 1);    // TX
-    GPIO_PinModeSet(gpioPortC, 8, gpioModePushPull, 1);     // RS485 RTS control
+    GPIO_PinModeSet(gpioPortC, 8, gpioModePushPull, 0);     // RS485 DE, US0_CS #2 under AUTOCS
 
     // PDEM - USART1 LOC1
     GPIO_PinModeSet(gpioPortD, 1, gpioModeInput, 0);        // RX
@@ -148,20 +152,20 @@ void Initialise_Node(void)
     // Node - USART2 LOC5 with RS485 control
     GPIO_PinModeSet(gpioPortF, 1, gpioModeInput, 0);        // RX
     GPIO_PinModeSet(gpioPortF, 0, gpioModePushPull, 1);     // TX
-    GPIO_PinModeSet(gpioPortF, 5, gpioModePushPull, 1);     // RS485 RTS control
+    GPIO_PinModeSet(gpioPortF, 5, gpioModePushPull, 0);     // RS485 DE, driven by the USART TX path
 
     // Thrusters - USART3 LOC1 with RS485 control
     GPIO_PinModeSet(gpioPortE, 7, gpioModeInput, 0);        // RX
     GPIO_PinModeSet(gpioPortE, 6, gpioModePushPull, 1);     // TX
-    GPIO_PinModeSet(gpioPortE, 4, gpioModePushPull, 1);     // RS485 RTS control
+    GPIO_PinModeSet(gpioPortE, 4, gpioModePushPull, 0);     // RS485 DE, US3_CS #1 under AUTOCS
 
     // Expander - USART4 LOC0 (SPI mode)
-    GPIO_PinModeSet(gpioPortB, 8, gpioModeWiredAndAlternatePullUpFilter, 1);        // MISO
+    GPIO_PinModeSet(gpioPortB, 8, gpioModeInputPull, 1);            // MISO - pull-up, no glitch filter (it eats bits at MHz rates)
     GPIO_PinModeSet(gpioPortB, 7, gpioModePushPullAlternate, 1);     // MOSI
     GPIO_PinModeSet(gpioPortC, 4, gpioModePushPullAlternate, 1);     // CLK
 
-    GPIO_DriveStrengthSet(gpioPortC, gpioDriveStrengthWeakAlternateWeak);
-    GPIO_DriveStrengthSet(gpioPortB, gpioDriveStrengthWeakAlternateWeak);
+    GPIO_DriveStrengthSet(gpioPortC, gpioDriveStrengthWeakAlternateStrong);   // strong edges on CLK / MOSI for MAX14830_TuneSpiClock()
+    GPIO_DriveStrengthSet(gpioPortB, gpioDriveStrengthWeakAlternateStrong);
 
     GPIO_PinModeSet(gpioPortA, 10, gpioModePushPull, 1);     // Ethernet SPI CS, active low
     GPIO_PinOutSet(gpioPortA, 10);                           // deselect pin
@@ -295,7 +299,7 @@ void Initialise_Node(void)
 
     /*==========================================================================
      * PAYLOAD AND SENSOR CADDY DIRECT GPIO CONFIGURATION
-     * Configure payload directly connected GPIOs (some GPIO derived from expanders)
+     * Configure payload directly connected GPIOs (the rest are expander GPIOs - see expander_gpio.h)
      *========================================================================*/
     GPIO_PinModeSet(gpioPortB, 10, gpioModePushPull, 1);     // PLA GPIO 0
     GPIO_PinOutClear(gpioPortB, 10);                        // Initialize OFF
@@ -350,7 +354,11 @@ void Initialise_Node(void)
     setupTimer1();          // Hardware timer initialization for mS control
     buzzer_init();
     usart_init();           // All USART/UART interfaces
-   // initI2C();              // I2C interface for sensor communication
+    expander_io_init();     // Expander channel queues (no SPI until the expanders are powered)
+    expander_gpio_init();   // Expander GPIO caches (no SPI)
+    spi_bus_init();         // LDMA transaction queue on the USART4 SPI bus
+    initI2C();              // I2C0 (sensor caddy) and I2C1 (Compass B) transfer queues
+    sampler_init();         // TIMER3 sample tick, left stopped until sampler_start()
  //   MAX14830_Init();
     // System is now ready for operation
 }
@@ -0,0 +1,204 @@
+/*
+ * link.c
+ *
+ * @brief Framed binary link protocol over any destination_t port
+ * @description See link.h.
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: JonathanStorey
+ *    Hardware: EFM32GG11B Microcontroller
+ *     Version: 1.0
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "usart.h"
+#include "frame.h"
+#include "link.h"
+
+
+/*==============================================================================
+ * PER-PORT STATE
+ *============================================================================*/
+typedef struct {
+    bool open;
+    link_handler_t handler;
+    frame_decoder_t decoder;
+    uint8_t tx_seq;                 ///< Sequence number of the next frame sent
+    uint8_t rx_seq;                 ///< Sequence number expected next
+    bool rx_synced;                 ///< rx_seq is valid (a frame has been seen)
+    uint32_t tx_frames;
+    uint32_t tx_dropped;
+    uint32_t rx_lost;
+} link_port_t;
+
+static link_port_t links[USART_PORT_COUNT];
+
+typedef struct {
+    uint8_t seq;
+    uint8_t type;
+    const uint8_t *payload;
+    uint16_t len;
+} link_tx_frame_t;
+
+
+/**
+ * @brief Decoder callback - checks the sequence number and hands the frame on
+ */
+static void link_frame_received(void *ctx, uint8_t seq, uint8_t type, const uint8_t *payload, uint16_t len)
+{
+    destination_t port = (destination_t)(uintptr_t)ctx;
+    link_port_t *link = &links[port];
+
+    if (link->rx_synced && seq != link->rx_seq)
+    {
+        link->rx_lost += (uint8_t)(seq - link->rx_seq);
+    }
+    link->rx_seq = seq + 1;
+    link->rx_synced = true;
+
+    if (link->handler != NULL)
+    {
+        link->handler(port, type, payload, len);
+    }
+}
+
+/**
+ * @brief uart_tx_produce() callback - encodes the frame in place in the TX ring
+ */
+static uint16_t link_frame_producer(ring_buffer_t *ring, void *ctx)
+{
+    const link_tx_frame_t *frame = (const link_tx_frame_t *)ctx;
+
+    return frame_encode_ring(ring, frame->seq, frame->type, frame->payload, frame->len);
+}
+
+
+/*==============================================================================
+ * PUBLIC FUNCTIONS
+ *============================================================================*/
+
+/**
+ * @brief Start framed traffic on a port
+ * @param port: Port to use (any destination_t except Expander)
+ * @param handler: Called from link_poll() for each good frame, or NULL to only send
+ * @return false for an invalid port
+ * @note Anything already waiting in the port's RX ring is discarded
+ */
+bool link_open(destination_t port, link_handler_t handler)
+{
+    link_port_t *link;
+
+    if (port >= USART_PORT_COUNT || port == Expander)
+    {
+        return false;
+    }
+    link = &links[port];
+
+    uart_rx_clear(port);
+    frame_decoder_init(&link->decoder, link_frame_received, (void *)(uintptr_t)port);
+    link->handler = handler;
+    link->tx_seq = 0;
+    link->rx_synced = false;
+    link->tx_frames = 0;
+    link->tx_dropped = 0;
+    link->rx_lost = 0;
+    link->open = true;
+    return true;
+}
+
+/**
+ * @brief Stop framed traffic on a port (the port itself keeps running)
+ */
+void link_close(destination_t port)
+{
+    if (port < USART_PORT_COUNT)
+    {
+        links[port].open = false;
+    }
+}
+
+/**
+ * @brief Send one frame
+ * @param port: Open port
+ * @param type: Message type
+ * @param payload: Payload bytes (may be NULL when len is 0)
+ * @param len: Payload length, at most FRAME_MAX_PAYLOAD
+ * @return true if queued, false if the port is not open, the payload is too
+ *         long, or the port's TX policy dropped it
+ * @note Blocks for ring space under the default UART_TX_BLOCK policy
+ */
+bool link_send(destination_t port, uint8_t type, const void *payload, uint16_t len)
+{
+    link_port_t *link;
+    link_tx_frame_t frame;
+
+    if (port >= USART_PORT_COUNT || !links[port].open || len > FRAME_MAX_PAYLOAD)
+    {
+        return false;
+    }
+    link = &links[port];
+
+    frame.seq = link->tx_seq;
+    frame.type = type;
+    frame.payload = (const uint8_t *)payload;
+    frame.len = len;
+
+    if (uart_tx_produce(port, FRAME_ENCODED_MAX(len), link_frame_producer, &frame) == 0)
+    {
+        link->tx_dropped++;
+        return false;
+    }
+
+    link->tx_seq++;
+    link->tx_frames++;
+    return true;
+}
+
+/**
+ * @brief Decode everything received on a port so far
+ * @param port: Open port
+ * @return Number of bytes consumed from the RX ring
+ * @note Handlers run from here, in the caller's context
+ */
+uint16_t link_poll(destination_t port)
+{
+    const uint8_t *data;
+    uint16_t len;
+    uint16_t total = 0;
+
+    if (port >= USART_PORT_COUNT || !links[port].open)
+    {
+        return 0;
+    }
+
+    while ((len = uart_rx_span(port, &data)) > 0)             // at most two spans when the ring wraps
+    {
+        frame_decoder_feed(&links[port].decoder, data, len);
+        uart_rx_span_release(port, len);
+        total += len;
+    }
+    return total;
+}
+
+/**
+ * @brief Copy a port's link counters
+ */
+void link_get_stats(destination_t port, link_stats_t *stats)
+{
+    const link_port_t *link;
+
+    if (port >= USART_PORT_COUNT || stats == NULL)
+    {
+        return;
+    }
+    link = &links[port];
+
+    stats->tx_frames = link->tx_frames;
+    stats->tx_dropped = link->tx_dropped;
+    stats->rx_frames = link->decoder.frames;
+    stats->rx_crc_errors = link->decoder.crc_errors;
+    stats->rx_length_errors = link->decoder.length_errors;
+    stats->rx_lost = link->rx_lost;
+}
@@ -0,0 +1,52 @@
+/*
+ * link.h
+ *
+ * @brief Framed binary link protocol over any destination_t port
+ * @description Sends and receives COBS + CRC16 frames (see frame.h) with a
+ *              per-port sequence number. Frames are encoded straight into the
+ *              port's TX ring and decoded straight out of its RX ring (or
+ *              circular DMA ring), so no line buffers are needed either side.
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: JonathanStorey
+ *    Hardware: EFM32GG11B Microcontroller
+ *     Version: 1.0
+ *
+ * @note Intended for binary telemetry to the FCPU and PDEM - keep the Node
+ *       console port for the text menu
+ * @note Call link_poll() for each open port from the main loop
+ */
+
+#ifndef LINK_H_
+#define LINK_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "defines.h"
+#include "frame.h"
+
+/**
+ * @brief Called from link_poll() for every good frame received on a port
+ * @param port: Port the frame arrived on
+ * @param type: Message type chosen by the sender
+ * @param payload: Payload bytes - only valid during the call
+ * @param len: Payload length
+ */
+typedef void (*link_handler_t)(destination_t port, uint8_t type, const uint8_t *payload, uint16_t len);
+
+typedef struct {
+    uint32_t tx_frames;             ///< Frames queued
+    uint32_t tx_dropped;            ///< Frames dropped by the port's TX policy
+    uint32_t rx_frames;             ///< Good frames received
+    uint32_t rx_crc_errors;         ///< Frames failing the CRC
+    uint32_t rx_length_errors;      ///< Frames too short or too long
+    uint32_t rx_lost;               ///< Frames missing according to the sequence numbers
+} link_stats_t;
+
+bool link_open(destination_t port, link_handler_t handler);
+void link_close(destination_t port);
+bool link_send(destination_t port, uint8_t type, const void *payload, uint16_t len);
+uint16_t link_poll(destination_t port);
+void link_get_stats(destination_t port, link_stats_t *stats);
+
+#endif /* LINK_H_ */
@@ -0,0 +1,166 @@
+/*
+ * max14830_baud.c
+ *
+ * @brief MAX14830 reference clock and baud rate divisor calculator
+ * @description See max14830_baud.h.
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: JonathanStorey
+ *     Version: 1.0
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "max14830_baud.h"
+
+
+/**
+ * @brief PLL factors and the PLL input range (fXTAL / predivider) each accepts
+ */
+static const struct {
+    uint8_t factor;
+    uint32_t fmin;
+    uint32_t fmax;
+} max14830_pll_factors[4] =
+{
+    {   6,  500000,  800000 },      // PLLCFG factor 0
+    {  48,  850000, 1200000 },      // PLLCFG factor 1
+    {  96,  425000, 1000000 },      // PLLCFG factor 2
+    { 144,  390000,  667000 },      // PLLCFG factor 3
+};
+
+
+/**
+ * @brief Absolute value of a ppm error
+ */
+static uint32_t max14830_abs_ppm(int32_t ppm)
+{
+    return (ppm < 0) ? (uint32_t)(-ppm) : (uint32_t)ppm;
+}
+
+/**
+ * @brief Best BRGCFG / DIV for one rate on a given reference clock
+ * @param fref: Reference clock in Hz
+ * @param baud: Requested rate in Hz
+ * @param out: Register values, achieved rate and error
+ * @return false if the rate can't be produced at all (too fast or too slow)
+ * @note Tries 1x, 2x and 4x mode, each with the divisor either side of the
+ *       exact one, and keeps the smallest error - preferring the lower mode on
+ *       a tie because it samples each bit more often
+ */
+bool max14830_calc_divisor(uint32_t fref, uint32_t baud, max14830_divisor_t *out)
+{
+    static const uint8_t modes[3] = { 1, 2, 4 };
+    bool found = false;
+    uint32_t best_abs = 0;
+
+    if (baud == 0 || fref == 0)
+    {
+        return false;
+    }
+
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        uint64_t clock = (uint64_t)fref * modes[i];
+        uint64_t below = clock / baud;                                  // 16 * DIV + FRACT, rounded down
+
+        for (uint64_t d16 = below; d16 <= below + 1; d16++)             // the rate goes as 1 / d16, so try both neighbours
+        {
+            uint32_t actual;
+            int32_t ppm;
+
+            if (d16 < 16 || d16 > 0xFFFFFULL)                           // DIV must be 1 - 65535
+            {
+                continue;
+            }
+            actual = (uint32_t)((clock + d16 / 2) / d16);
+            ppm = (int32_t)(((int64_t)clock * 1000000 / (int64_t)d16 - (int64_t)baud * 1000000) / (int64_t)baud);
+
+            if (!found || max14830_abs_ppm(ppm) < best_abs)
+            {
+                found = true;
+                best_abs = max14830_abs_ppm(ppm);
+                out->div = (uint16_t)(d16 >> 4);
+                out->brgcfg = (uint8_t)(d16 & MAX14830_BRGCFG_FRACT_MASK) |
+                              (modes[i] == 2 ? MAX14830_BRGCFG_2XMODE : 0) |
+                              (modes[i] == 4 ? MAX14830_BRGCFG_4XMODE : 0);
+                out->actual = actual;
+                out->error_ppm = ppm;
+            }
+        }
+    }
+    return found;
+}
+
+/**
+ * @brief Worst error over a set of rates on one reference clock
+ * @return Worst |ppm|, or UINT32_MAX if any rate can't be produced
+ */
+static uint32_t max14830_worst_ppm(uint32_t fref, const uint32_t *bauds, uint8_t count)
+{
+    uint32_t worst = 0;
+    max14830_divisor_t d;
+
+    for (uint8_t i = 0; i < count; i++)
+    {
+        if (!max14830_calc_divisor(fref, bauds[i], &d))
+        {
+            return UINT32_MAX;
+        }
+        if (max14830_abs_ppm(d.error_ppm) > worst)
+        {
+            worst = max14830_abs_ppm(d.error_ppm);
+        }
+    }
+    return worst;
+}
+
+/**
+ * @brief Best reference clock for a set of rates
+ * @param fxtal: Crystal frequency in Hz (MAX14830_CRYSTAL_FREQ)
+ * @param bauds: Rates the expander's channels should be able to run at
+ * @param count: Number of rates
+ * @param out: PLLCFG / bypass and resulting fREF
+ * @param worst_ppm: Worst |error| over the set (may be NULL)
+ * @return false if no clock can produce every rate
+ * @note Searches PLL bypass and every predivider / factor pair whose PLL input
+ *       is in range. On a tie the lower fREF wins.
+ */
+bool max14830_calc_clock(uint32_t fxtal, const uint32_t *bauds, uint8_t count, max14830_clock_t *out, uint32_t *worst_ppm)
+{
+    uint32_t best = max14830_worst_ppm(fxtal, bauds, count);
+
+    out->bypass = true;
+    out->pllcfg = 0;
+    out->fref = fxtal;
+
+    for (uint8_t f = 0; f < 4; f++)
+    {
+        for (uint8_t prediv = 1; prediv <= MAX14830_PLLCFG_PREDIV_MASK; prediv++)
+        {
+            uint32_t fin = fxtal / prediv;
+            uint32_t fref, worst;
+
+            if (fin < max14830_pll_factors[f].fmin || fin > max14830_pll_factors[f].fmax)
+            {
+                continue;
+            }
+            fref = (uint32_t)((uint64_t)fxtal * max14830_pll_factors[f].factor / prediv);
+            worst = max14830_worst_ppm(fref, bauds, count);
+            if (worst < best || (worst == best && worst != UINT32_MAX && fref < out->fref))
+            {
+                best = worst;
+                out->bypass = false;
+                out->pllcfg = (uint8_t)((f << MAX14830_PLLCFG_FACTOR_SHIFT) | prediv);
+                out->fref = fref;
+            }
+        }
+    }
+
+    if (worst_ppm)
+    {
+        *worst_ppm = best;
+    }
+    return best != UINT32_MAX;
+}
@@ -0,0 +1,60 @@
+/*
+ * max14830_baud.h
+ *
+ * @brief MAX14830 reference clock and baud rate divisor calculator
+ * @description The MAX14830 baud rate is fREF * mode / (16 * DIV + FRACT),
+ *              where mode is 1, 2 or 4 (BRGCFG 2xMode / 4xMode), FRACT is the
+ *              4-bit fraction in BRGCFG and DIV is DIVMSB:DIVLSB. fREF is the
+ *              crystal, optionally through the predivider and PLL, and is shared
+ *              by all four UARTs of an expander.
+ *
+ *              max14830_calc_clock() picks the PLLCFG (or PLL bypass) that
+ *              gives the smallest worst-case error over a set of rates, and
+ *              max14830_calc_divisor() picks the BRGCFG / DIV for one rate on a
+ *              given fREF.
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: JonathanStorey
+ *    Hardware: None (pure C, no peripheral access - can be built on a host PC)
+ *     Version: 1.0
+ *
+ * @note With a 4 MHz crystal the best clock for 9600 - 921600 is predivider 10,
+ *       PLL x144 = 57.6 MHz, on which every standard rate is exact
+ */
+
+#ifndef MAX14830_BAUD_H_
+#define MAX14830_BAUD_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define MAX14830_BRGCFG_FRACT_MASK      0x0F        ///< Fractional divisor, 1/16 steps
+#define MAX14830_BRGCFG_2XMODE          (1 << 4)    ///< Double rate mode
+#define MAX14830_BRGCFG_4XMODE          (1 << 5)    ///< Quadruple rate mode
+
+#define MAX14830_PLLCFG_PREDIV_MASK     0x3F        ///< Predivider, 1 - 63
+#define MAX14830_PLLCFG_FACTOR_SHIFT    6           ///< PLL factor: 0 = x6, 1 = x48, 2 = x96, 3 = x144
+
+/*==============================================================================
+ * TYPES
+ *============================================================================*/
+typedef struct {
+    uint8_t pllcfg;                 ///< PLLCFG value (unused when bypass is set)
+    bool bypass;                    ///< fREF is the crystal itself (CLKSRC PLLBypass)
+    uint32_t fref;                  ///< Resulting reference clock in Hz
+} max14830_clock_t;
+
+typedef struct {
+    uint8_t brgcfg;                 ///< BRGCFG value (FRACT and rate mode)
+    uint16_t div;                   ///< DIVMSB:DIVLSB
+    uint32_t actual;                ///< Rate actually produced, Hz
+    int32_t error_ppm;              ///< (actual - requested) / requested, parts per million
+} max14830_divisor_t;
+
+/*==============================================================================
+ * FUNCTION DECLARATIONS
+ *============================================================================*/
+bool max14830_calc_divisor(uint32_t fref, uint32_t baud, max14830_divisor_t *out);
+bool max14830_calc_clock(uint32_t fxtal, const uint32_t *bauds, uint8_t count, max14830_clock_t *out, uint32_t *worst_ppm);
+
+#endif /* MAX14830_BAUD_H_ */
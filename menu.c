@@ -70,11 +70,18 @@
 #include "defines.h"
 #include "helpers.h"
 #include "usart.h"
+#include "node_printf.h"
 #include "i2c.h"
 #include "menu.h"
 #include "ethernet_switch.h"
 #include "hw_timer.h"
 #include "usart_expanders.h"
+#include "bridge.h"
+#include "expander_io.h"
+#include "expander_gpio.h"
+#include "i2c_devices.h"
+#include "sampler.h"
+#include "i2c_scan.h"
 
 #include <stdio.h>
 #include <stdint.h>
@@ -102,7 +109,8 @@ static const menu_item main_items[] =
     {"USART Functions",        show_usart_menu, NULL  },                          // manually add item here, {description, *function pointer}
     {"Ethernet Functions",     show_ethernet_menu, &NodeConfig} ,                           // update the manu_list details below
     {"Expander Functions",     show_expander_menu, &NodeConfig} ,
-    {"Buzzer Functions",       show_buzzer_menu, NULL}                            // update the manu_list details below
+    {"Buzzer Functions",       show_buzzer_menu, NULL},                           // update the manu_list details below
+    {"I2C Functions",          show_i2c_menu, NULL}
 
 
 };
@@ -113,7 +121,7 @@ static const menu_item main_items[] =
 static const menu_list main_menu =          // this is a MENU_LIST
 {                                           // it tells how mant items are on the list
     main_items,                             // pointer of type menu_items, pointing to array of main items
-    4,                                      // how many items in main menu
+    5,                                      // how many items in main menu
     "Main Menu"                             // list name
 };
 
@@ -132,6 +140,9 @@ static const menu_item usart_items[] =
     {"Enable all the DCDC and LDOS",    usart_function_a,     &NodeConfig},
     {"USART loop all",                  usart_function_b,     &NodeConfig},
     {"Send Hello to PLA1",              usart_function_c,     &NodeConfig},
+    {"Show port line settings",         usart_function_d,     NULL},
+    {"Configure a port",                usart_function_e,     NULL},
+    {"Bridge two ports",                usart_function_f,     NULL},
 
 
 };
@@ -139,7 +150,7 @@ static const menu_item usart_items[] =
 static const menu_list usart_menu =
 {
     usart_items,     // Pointer to menu items array
-    4,              // Number of items in menu
+    6,              // Number of items in menu
     "USART Functions" // Menu title displayed to user
 };
 
@@ -181,6 +192,124 @@ void usart_function_c(void *param)
 }
 
 
+static const char *const usart_port_names[] =                                   // indexed by destination_t
+{
+    "IMU", "PDEM", "Node", "Thrusters", "Expander", "SDAS", "FCPU", "USBL"
+};
+
+static const uint32_t usart_baud_presets[] =
+{
+    9600, 19200, 38400, 57600, 115200, 230400, 460800, 921600
+};
+
+void usart_function_d(void *param)
+{
+  (void)param;
+
+  print_string("\n\r", Node);
+  for (int port = IMU; port <= USBL; port++)
+  {
+      put_char('1' + port, Node);
+      print_string(". ", Node);
+      print_string(usart_port_names[port], Node);
+      print_string("\t", Node);
+      uart_print_config((destination_t)port, Node);
+      print_string("\n\r", Node);
+  }
+  print_string("Press any key...", Node);
+  get_input();
+}
+
+void usart_function_e(void *param)
+{
+  uart_port_config_t config;
+  destination_t port;
+  char input;
+  (void)param;
+
+  print_string("\n\rPort (1-8): ", Node);
+  input = get_input();
+  if (input < '1' || input > '8' || (input - '1') == Expander)
+  {
+      return;
+  }
+  port = (destination_t)(input - '1');
+  uart_get_config(port, &config);
+
+  print_string("\n\rBaud 1=9600 2=19200 3=38400 4=57600 5=115200 6=230400 7=460800 8=921600: ", Node);
+  input = get_input();
+  if (input >= '1' && input <= '8')
+  {
+      config.baudrate = usart_baud_presets[input - '1'];
+  }
+
+  print_string("\n\rParity N/E/O: ", Node);
+  input = get_input();
+  if (input == 'N' || input == 'n') config.parity = usartNoParity;
+  if (input == 'E' || input == 'e') config.parity = usartEvenParity;
+  if (input == 'O' || input == 'o') config.parity = usartOddParity;
+
+  print_string("\n\rStop bits 1/2: ", Node);
+  input = get_input();
+  if (input == '1') config.stopbits = usartStopbits1;
+  if (input == '2') config.stopbits = usartStopbits2;
+
+  print_string("\n\rOversampling 1=16x 2=8x 3=6x 4=4x: ", Node);
+  input = get_input();
+  if (input == '1') config.oversampling = usartOVS16;
+  if (input == '2') config.oversampling = usartOVS8;
+  if (input == '3') config.oversampling = usartOVS6;
+  if (input == '4') config.oversampling = usartOVS4;
+
+  if (port == Node)
+  {
+      print_string("\n\rSwitching the console - reconnect at the new rate", Node);
+  }
+  uart_configure(port, &config);
+
+  print_string("\n\r", Node);
+  print_string(usart_port_names[port], Node);
+  print_string("\t", Node);
+  uart_print_config(port, Node);
+  print_string("\n\rPress any key...", Node);
+  get_input();
+}
+
+
+void usart_function_f(void *param)
+{
+  bridge_endpoint_t a, b;
+  bridge_stats_t stats;
+  (void)param;
+
+  print_string("\n\rPorts 1-8 (not 5), expander channels A-D (A0-3) E-H (B0-3) I-L (C0-3)", Node);
+  print_string("\n\rFirst port: ", Node);
+  if (!bridge_endpoint_from_key(get_input(), &a))
+  {
+      return;
+  }
+  print_string("\n\rSecond port: ", Node);
+  if (!bridge_endpoint_from_key(get_input(), &b))
+  {
+      return;
+  }
+
+  print_string("\n\rBridging - Ctrl-] to return to the menu\n\r", Node);
+  uart_tx_flush(Node);
+  if (!bridge_run(&a, &b, &stats))
+  {
+      print_string("\n\rCannot bridge a port to itself", Node);
+  }
+  else
+  {
+      node_printf(Node, "\n\rFirst->second %lu bytes, %lu overruns", (unsigned long)stats.a_to_b.bytes, (unsigned long)stats.a_to_b.overruns);
+      node_printf(Node, "\n\rSecond->first %lu bytes, %lu overruns", (unsigned long)stats.b_to_a.bytes, (unsigned long)stats.b_to_a.overruns);
+  }
+  print_string("\n\rPress any key...", Node);
+  get_input();
+}
+
+
 //=============================================================================
 // Ethernet Menu Configuration
 //=============================================================================
@@ -244,7 +373,8 @@ void ethernet_function_a(void *param)
 static const menu_item expander_items[] =
 {
     {"Enable expanders  "  , expander_function_a     ,&NodeConfig},
-    {"send hello to PLA1"  , expander_function_b     ,&NodeConfig}
+    {"send hello to PLA1"  , expander_function_b     ,&NodeConfig},
+    {"Set channel baud  "  , expander_function_c     ,&NodeConfig}
 
 };
 
@@ -252,7 +382,7 @@ static const menu_item expander_items[] =
 static const menu_list expander_menu =
 {
     expander_items,                                                             // Pointer to menu items array
-    2,                                                                          // Number of items in menu
+    3,                                                                          // Number of items in menu
     "Expander Functions"                                                 // Menu title displayed to user
 };
 
@@ -270,6 +400,8 @@ void expander_function_a(void *param)
 {
 
   NodeConfiguration *pNodeConfig = (NodeConfiguration*)param;
+  max14830_init_timing_t timing;
+  max14830_spi_tune_t tune;
 
 
   Set_5V_Power_State(On, pNodeConfig);                                            //enable the core LDOs and drivers
@@ -296,11 +428,19 @@ void expander_function_a(void *param)
 
   hw_timer1_ms(100);
 
-  MAX14830_UART_Init(EXPANDER_A);
-  MAX14830_UART_Init(EXPANDER_B);
-  MAX14830_UART_Init(EXPANDER_C);
+  MAX14830_InitExpanders(MAX14830_ALL_EXPANDERS, &timing);                     // returns once every clock is ready
+  expander_gpio_init();                                                         // the reset left every expander GPIO an input
+  node_printf(Node, "\n\rExpanders %s: reset %luus, clock %luus, config %luus, total %luus (%u polls)\n\r",
+              timing.ok ? "ready" : "TIMED OUT", (unsigned long)timing.reset_us, (unsigned long)timing.clock_us,
+              (unsigned long)timing.config_us, (unsigned long)timing.total_us, timing.polls);
 
-  hw_timer1_ms(100);
+  MAX14830_TuneSpiClock(MAX14830_ALL_EXPANDERS, &tune);                        // fastest SPI clock every expander verifies at
+  node_printf(Node, "SPI clock %lu Hz%s (%u steps passed, first fail %lu Hz), REVID A %02X B %02X C %02X\n\r",
+              (unsigned long)tune.bitrate, tune.ok ? "" : " - LINK CHECK FAILED", tune.steps,
+              (unsigned long)tune.failed_at, tune.revid[0], tune.revid[1], tune.revid[2]);
+  node_printf(Node, "Register cache saved %lu SPI transactions so far\n\r", (unsigned long)MAX14830_ShadowSaved());
+
+  expander_irq_enable();                                                        // PC5 interrupt does RX drains and TX refills from here on
 
   while(1)
   {
@@ -318,6 +458,179 @@ void expander_function_b(void *param)
 }
 
 
+void expander_function_c(void *param)
+{
+  max14830_divisor_t divisor = { 0 };
+  uint8_t channel;
+  uint32_t baud;
+  bool ok;
+  char input;
+  (void)param;
+
+  print_string("\n\rChannel (A-L): ", Node);
+  input = get_input();
+  if (input >= 'a' && input <= 'l') input -= 'a' - 'A';
+  if (input < 'A' || input > 'L')
+  {
+      return;
+  }
+  channel = (uint8_t)(input - 'A');
+
+  print_string("\n\rBaud 1=9600 2=19200 3=38400 4=57600 5=115200 6=230400 7=460800 8=921600: ", Node);
+  input = get_input();
+  if (input < '1' || input > '8')
+  {
+      return;
+  }
+  baud = usart_baud_presets[input - '1'];
+
+  ok = MAX14830_SetBaud(EXPANDER_OF_CHANNEL(channel), UART_OF_CHANNEL(channel), baud, &divisor);
+  node_printf(Node, "\n\rChannel %c %s: asked %lu, got %lu (%ld ppm) BRGCFG 0x%02X DIV %u, fREF %lu\n\r",
+              'A' + channel, ok ? "set" : "NOT set", (unsigned long)baud, (unsigned long)divisor.actual,
+              (long)divisor.error_ppm, divisor.brgcfg, divisor.div,
+              (unsigned long)MAX14830_GetReferenceClock(EXPANDER_OF_CHANNEL(channel)));
+}
+
+
+
+
+
+//=============================================================================
+// I2C Menu Configuration
+//=============================================================================
+
+
+static const menu_item i2c_items[] =
+{
+    {"Start/stop sampling"  , i2c_function_a     ,NULL},
+    {"Latest samples     "  , i2c_function_b     ,NULL},
+    {"I2C bus scan       "  , i2c_function_c     ,NULL}
+
+};
+
+
+static const menu_list i2c_menu =
+{
+    i2c_items,                                                                  // Pointer to menu items array
+    3,                                                                          // Number of items in menu
+    "I2C Functions"                                                             // Menu title displayed to user
+};
+
+
+void show_i2c_menu(void)
+{
+    state.current_menu = &i2c_menu;
+    state.selected_index = 0;
+    state.menu_level = 1;
+}
+
+
+
+void i2c_function_a(void *param)
+{
+  (void)param;
+
+  if (sampler_running())
+  {
+      sampler_stop();
+      print_string("\n\rSampling stopped\n\r", Node);
+  }
+  else
+  {
+      sampler_reset_stats();
+      if (sampler_start())
+      {
+          print_string("\n\rSampling started\n\r", Node);
+      }
+      else
+      {
+          print_string("\n\rSampling started - a sensor didn't take its set-up writes\n\r", Node);
+      }
+  }
+}
+
+
+void i2c_function_b(void *param)
+{
+  sampler_sample_t sample;
+  sampler_stats_t stats;
+  (void)param;
+
+  for (uint8_t id = 0; id < I2C_DEVICE_COUNT; id++)
+  {
+      sampler_get_stats((i2cDeviceId_t)id, &stats);
+      node_printf(Node, "\n\r%-10s %3u ms: %lu samples, %lu errors, %lu missed, jitter %lu/%lu ns, latency %lu ns",
+                  i2cDeviceGet((i2cDeviceId_t)id)->name, sampler_get_period((i2cDeviceId_t)id),
+                  (unsigned long)stats.samples, (unsigned long)stats.errors, (unsigned long)stats.missed,
+                  (unsigned long)stats.jitter_last_ns, (unsigned long)stats.jitter_max_ns, (unsigned long)stats.latency_max_ns);
+      if (sampler_latest((i2cDeviceId_t)id, &sample))
+      {
+          node_printf(Node, "\n\r           #%lu @%lu ms:", (unsigned long)sample.sequence, (unsigned long)sample.tick_ms);
+          for (uint8_t i = 0; i < sample.len; i++)
+          {
+              node_printf(Node, " %02X", sample.data[i]);
+          }
+      }
+  }
+  print_string("\n\rPress any key...", Node);
+  get_input();
+}
+
+
+
+
+
+void i2c_function_c(void *param)
+{
+  (void)param;
+
+  i2c_scan_command();
+  print_string("Press any key...", Node);
+  get_input();
+}
+
+
+/**
+ * @brief Scan both I2C buses and print the inventory, one record per line
+ * @note Also bound to the 'I' key so a script can run it from any menu. Like
+ *       the menu item, the key then waits for another key before the menu
+ *       redraws over the records.
+ *       Every line is comma separated and starts with "I2C,":
+ *         I2C,DEV,<bus>,0x<addr>,<name or ?>     one per address that ACKed
+ *         I2C,BUS,<bus>,<found>,<OK|STUCK 0xNN>,<us>
+ *         I2C,END,<total found>
+ */
+void i2c_scan_command(void)
+{
+  uint8_t found = i2cScan();
+
+  print_string("\n\r", Node);
+  for (uint8_t bus = 0; bus < I2C_BUS_COUNT; bus++)
+  {
+      const i2cInventory_t *inv = i2cGetInventory((i2cBus_t)bus);
+
+      for (uint8_t addr = I2C_SCAN_FIRST; addr <= I2C_SCAN_LAST; addr++)
+      {
+          if (i2cIsPresent((i2cBus_t)bus, addr))
+          {
+              const i2cDevice_t *device = i2cDeviceFind(bus, addr);
+
+              node_printf(Node, "I2C,DEV,%u,0x%02X,%s\n\r", bus, addr, device ? device->name : "?");
+          }
+      }
+      if (inv->stuck)
+      {
+          node_printf(Node, "I2C,BUS,%u,%u,STUCK 0x%02X,%lu\n\r", bus, inv->count, inv->stuckAddr, (unsigned long)inv->scanUs);
+      }
+      else
+      {
+          node_printf(Node, "I2C,BUS,%u,%u,OK,%lu\n\r", bus, inv->count, (unsigned long)inv->scanUs);
+      }
+  }
+  node_printf(Node, "I2C,END,%u\n\r", found);
+}
+
+
 
 
 
@@ -390,23 +703,11 @@ void buzzer_function_b(void *param)
 
 
 
-// Print a number (simple helper)
-void print_number(uint8_t num)
-{
-    if (num >= 10)
-    {
-        print_number(num / 10);
-    }
-    put_char('0' + (num % 10), Node);
-}
-
-
-
 // Display current menu
 void print_menu(void)
 {
     print_string("\n\r--- ", Node);
-    print_string(state.current_menu->title, Node);
+    print_string_dma(state.current_menu->title, Node);                       // menu text is const, no copy needed
     print_string(" ---\n\r", Node);
 
     for (uint8_t i = 0; i < state.current_menu->count; i++)
@@ -420,9 +721,8 @@ void print_menu(void)
             print_string("  ", Node);
         }
 
-        print_number(i + 1);
-        print_string(". ", Node);
-        print_string(state.current_menu->items[i].description, Node);
+        node_printf(Node, "%u. ", i + 1);
+        print_string_dma(state.current_menu->items[i].description, Node);
         print_string("\n\r", Node);
     }
 
@@ -442,7 +742,10 @@ void print_menu(void)
 // Get user input
 char get_input(void)
 {
-    return USART_ReceiveChar(USART2);
+    char input = 0;
+
+    uart_read(Node, &input, 1, UART_WAIT_FOREVER);      // sleeps until the Node RX interrupt delivers a key
+    return input;
 }
 
 
@@ -518,6 +821,7 @@ void run_menu_system(void)
             case 'S':  case 's':            menu_down();  break;
             case '\r': case '\n':           menu_select(); break;
             case 'B':  case 'b':            menu_back();  break;
+            case 'I':  case 'i':            i2c_function_c(NULL); break;
 
             case '0':
                 menu_back();
@@ -66,7 +66,6 @@ void menu_select(void);
 void menu_back(void);
 
 // Utility functions
-void print_number(uint8_t num);
 char get_input(void);
 
 
@@ -79,6 +78,9 @@ void show_usart_menu(void);
 void usart_function_a(void *param);
 void usart_function_b(void *param);
 void usart_function_c(void *param);
+void usart_function_d(void *param);
+void usart_function_e(void *param);
+void usart_function_f(void *param);
 
 // Ethernet function prototypes
 void show_ethernet_menu(void);
@@ -89,6 +91,7 @@ void ethernet_function_a(void *param);
 void show_expander_menu(void);
 void expander_function_a(void *param);
 void expander_function_b(void *param);
+void expander_function_c(void *param);
 
 
 // Buzzer function prototypes
@@ -97,6 +100,14 @@ void buzzer_function_a(void *param);
 void buzzer_function_b(void *param);
 
 
+// I2C function prototypes
+void show_i2c_menu(void);
+void i2c_function_a(void *param);
+void i2c_function_b(void *param);
+void i2c_function_c(void *param);
+void i2c_scan_command(void);
+
+
 
 
 extern menu_state state;
@@ -0,0 +1,350 @@
+/*
+ * node_printf.c
+ *
+ * @brief Small allocation-free formatted output for the node firmware
+ * @description See node_printf.h. The formatter core (node_vformat) has no
+ *              hardware dependencies; only node_printf() touches the USART layer.
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: JonathanStorey
+ *     Version: 1.0
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include "node_printf.h"
+
+#ifndef NODE_PRINTF_HOST
+#include "usart.h"
+#endif
+
+
+/*==============================================================================
+ * OUTPUT BUFFERING
+ * Characters are collected in a small stack buffer and handed to the sink in
+ * blocks, so the port sees one ring write per NODE_PRINTF_CHUNK characters.
+ *============================================================================*/
+typedef struct {
+    node_printf_sink_t sink;
+    void *ctx;
+    char buf[NODE_PRINTF_CHUNK];
+    uint16_t len;
+    int total;
+} node_out_t;
+
+static void node_out_flush(node_out_t *out)
+{
+    if (out->len > 0)
+    {
+        out->sink(out->ctx, out->buf, out->len);
+        out->len = 0;
+    }
+}
+
+static void node_out_char(node_out_t *out, char c)
+{
+    if (out->len == NODE_PRINTF_CHUNK)
+    {
+        node_out_flush(out);
+    }
+    out->buf[out->len++] = c;
+    out->total++;
+}
+
+static void node_out_repeat(node_out_t *out, char c, int count)
+{
+    while (count-- > 0)
+    {
+        node_out_char(out, c);
+    }
+}
+
+
+/*==============================================================================
+ * FIELD FORMATTING
+ *============================================================================*/
+typedef struct {
+    bool left;                      ///< '-' flag
+    bool zero;                      ///< '0' flag
+    int width;
+    int precision;                  ///< -1 when not given
+} node_spec_t;
+
+/**
+ * @brief Emit one field with padding
+ * @param prefix: Sign ("-" or ""), zero padding goes after it
+ */
+static void node_out_field(node_out_t *out, const node_spec_t *spec, const char *prefix, const char *body, int body_len)
+{
+    int prefix_len = (prefix[0] != '\0') ? 1 : 0;
+    int pad = spec->width - prefix_len - body_len;
+
+    if (!spec->left && !spec->zero)
+    {
+        node_out_repeat(out, ' ', pad);
+    }
+    if (prefix_len)
+    {
+        node_out_char(out, prefix[0]);
+    }
+    if (!spec->left && spec->zero)
+    {
+        node_out_repeat(out, '0', pad);
+    }
+    for (int i = 0; i < body_len; i++)
+    {
+        node_out_char(out, body[i]);
+    }
+    if (spec->left)
+    {
+        node_out_repeat(out, ' ', pad);
+    }
+}
+
+/**
+ * @brief Convert an unsigned value to digits, filling digits[] from the end
+ * @param point: Digits after the decimal point (0 for a plain integer)
+ * @return Pointer to the first character
+ */
+static char *node_utoa(char *end, uint32_t value, uint32_t base, bool upper, int point)
+{
+    const char *hex = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+    char *p = end;
+    int digits = 0;
+
+    do
+    {
+        if (point > 0 && digits == point)
+        {
+            *--p = '.';
+        }
+        *--p = hex[value % base];
+        value /= base;
+        digits++;
+    } while (value != 0 || (point > 0 && digits <= point));       // keep "0.05" for 5 at %.2q
+
+    return p;
+}
+
+
+/*==============================================================================
+ * FORMATTER CORE
+ *============================================================================*/
+
+/**
+ * @brief Format into a sink
+ * @param sink: Receives the output in blocks
+ * @param ctx: Passed to the sink
+ * @param fmt: Format string (see node_printf.h)
+ * @param args: Arguments
+ * @return Number of characters produced
+ */
+int node_vformat(node_printf_sink_t sink, void *ctx, const char *fmt, va_list args)
+{
+    node_out_t out;
+    char digits[12];                                        // "-2147483648" or "4294967295" or "429496.7295"
+    char *end = &digits[sizeof(digits)];
+
+    out.sink = sink;
+    out.ctx = ctx;
+    out.len = 0;
+    out.total = 0;
+
+    while (*fmt != '\0')
+    {
+        node_spec_t spec = { false, false, 0, -1 };
+        const char *prefix = "";
+        bool is_long = false;
+        char *body;
+        char c;
+
+        if (*fmt != '%')
+        {
+            node_out_char(&out, *fmt++);
+            continue;
+        }
+        fmt++;
+
+        for (;; fmt++)                                      // flags
+        {
+            if (*fmt == '-')      spec.left = true;
+            else if (*fmt == '0') spec.zero = true;
+            else break;
+        }
+        while (*fmt >= '0' && *fmt <= '9')                  // width
+        {
+            spec.width = spec.width * 10 + (*fmt++ - '0');
+        }
+        if (*fmt == '.')                                    // precision
+        {
+            fmt++;
+            spec.precision = 0;
+            while (*fmt >= '0' && *fmt <= '9')
+            {
+                spec.precision = spec.precision * 10 + (*fmt++ - '0');
+            }
+        }
+        if (*fmt == 'l')
+        {
+            is_long = true;
+            fmt++;
+        }
+
+        c = *fmt++;
+        switch (c)
+        {
+          case 'd':
+          case 'i':
+          case 'q':
+          {
+              int32_t value = is_long ? (int32_t)va_arg(args, long) : (int32_t)va_arg(args, int);
+              uint32_t magnitude = (value < 0) ? (uint32_t)0 - (uint32_t)value : (uint32_t)value;
+              int point = (c == 'q' && spec.precision > 0) ? spec.precision : 0;
+
+              if (point > 9)
+              {
+                  point = 9;
+              }
+              prefix = (value < 0) ? "-" : "";
+              body = node_utoa(end, magnitude, 10, false, point);
+              node_out_field(&out, &spec, prefix, body, (int)(end - body));
+              break;
+          }
+
+          case 'u':
+          case 'x':
+          case 'X':
+              body = node_utoa(end, is_long ? (uint32_t)va_arg(args, unsigned long) : (uint32_t)va_arg(args, unsigned int),
+                               (c == 'u') ? 10 : 16, c == 'X', 0);
+              node_out_field(&out, &spec, prefix, body, (int)(end - body));
+              break;
+
+          case 'c':
+              digits[0] = (char)va_arg(args, int);
+              spec.zero = false;
+              node_out_field(&out, &spec, prefix, digits, 1);
+              break;
+
+          case 's':
+          {
+              const char *str = va_arg(args, const char *);
+              int len = 0;
+
+              if (str == 0)
+              {
+                  str = "(null)";
+              }
+              while (str[len] != '\0' && (spec.precision < 0 || len < spec.precision))
+              {
+                  len++;
+              }
+              spec.zero = false;
+              node_out_field(&out, &spec, prefix, str, len);
+              break;
+          }
+
+          case '%':
+              node_out_char(&out, '%');
+              break;
+
+          case '\0':                                        // format ends in a lone '%'
+              fmt--;
+              break;
+
+          default:                                          // unknown conversion - print it as is
+              node_out_char(&out, '%');
+              node_out_char(&out, c);
+              break;
+        }
+    }
+
+    node_out_flush(&out);
+    return out.total;
+}
+
+
+/*==============================================================================
+ * BUFFER OUTPUT
+ *============================================================================*/
+typedef struct {
+    char *buf;
+    uint16_t size;
+    uint16_t used;
+} node_buffer_t;
+
+static void node_buffer_sink(void *ctx, const char *data, uint16_t len)
+{
+    node_buffer_t *b = (node_buffer_t *)ctx;
+
+    while (len-- > 0)
+    {
+        if (b->used + 1 < b->size)                          // always room for the terminator
+        {
+            b->buf[b->used++] = *data;
+        }
+        data++;
+    }
+}
+
+/**
+ * @brief Format into a caller buffer
+ * @param buf: Destination, always null terminated when size > 0
+ * @param size: Size of buf in bytes
+ * @param fmt: Format string
+ * @return Characters that the full output needs (excluding the terminator),
+ *         output is truncated if this is size or more
+ */
+int node_snprintf(char *buf, uint16_t size, const char *fmt, ...)
+{
+    node_buffer_t b = { buf, size, 0 };
+    va_list args;
+    int total;
+
+    va_start(args, fmt);
+    total = node_vformat(node_buffer_sink, &b, fmt, args);
+    va_end(args);
+
+    if (size > 0)
+    {
+        buf[b.used] = '\0';
+    }
+    return total;
+}
+
+
+/*==============================================================================
+ * PORT OUTPUT
+ *============================================================================*/
+#ifndef NODE_PRINTF_HOST
+
+static void node_port_sink(void *ctx, const char *data, uint16_t len)
+{
+    uart_write((destination_t)(intptr_t)ctx, data, len);
+}
+
+/**
+ * @brief Format straight into a port's TX ring
+ * @param destination: Destination device identifier (see put_char())
+ * @param fmt: Format string
+ * @return Number of characters produced
+ * @note Follows the port's TX policy, like print_string()
+ */
+int node_printf(int destination, const char *fmt, ...)
+{
+    va_list args;
+    int total;
+
+    if (destination < IMU || destination > USBL)
+    {
+        destination = Node;
+    }
+
+    va_start(args, fmt);
+    total = node_vformat(node_port_sink, (void *)(intptr_t)destination, fmt, args);
+    va_end(args);
+
+    return total;
+}
+
+#endif
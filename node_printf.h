@@ -0,0 +1,40 @@
+/*
+ * node_printf.h
+ *
+ * @brief Small allocation-free formatted output for the node firmware
+ * @description printf-style formatting straight to a destination_t port or a
+ *              caller buffer. No heap, no floating point, fixed stack use (one
+ *              NODE_PRINTF_CHUNK buffer plus a 12 byte digit buffer).
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: JonathanStorey
+ *    Hardware: None for node_snprintf() (pure C - can be built on a host PC)
+ *     Version: 1.0
+ *
+ * @note Conversions: %d %i %u %x %X %c %s %% and %q (fixed point)
+ * @note Flags/width/precision: %-8s, %08x, %5u, %.3q ... and the 'l' length
+ *       modifier (long is 32 bits on the target, so %ld == %d)
+ * @note %.Nq prints a signed integer scaled by 10^N, e.g. ("%.2q", 1234) -> "12.34"
+ */
+
+#ifndef NODE_PRINTF_H_
+#define NODE_PRINTF_H_
+
+#include <stdint.h>
+#include <stdarg.h>
+
+#define NODE_PRINTF_CHUNK       64      ///< Bytes formatted on the stack before each hand-off to the TX ring
+
+/**
+ * @brief Receives formatted output a block at a time
+ * @param ctx: Context passed to node_vformat()
+ * @param data: Formatted characters (not null terminated)
+ * @param len: Number of characters
+ */
+typedef void (*node_printf_sink_t)(void *ctx, const char *data, uint16_t len);
+
+int node_vformat(node_printf_sink_t sink, void *ctx, const char *fmt, va_list args);
+int node_snprintf(char *buf, uint16_t size, const char *fmt, ...);
+int node_printf(int destination, const char *fmt, ...);
+
+#endif /* NODE_PRINTF_H_ */
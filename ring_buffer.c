@@ -0,0 +1,213 @@
+/*
+ * ring_buffer.c
+ *
+ * @brief Lock-free single-producer / single-consumer byte ring buffer
+ * @description See ring_buffer.h. No hardware dependencies, so this file can be
+ *              compiled unchanged on a host PC for off-target testing.
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: JonathanStorey
+ *     Version: 1.0
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ring_buffer.h"
+
+
+/**
+ * @brief Attach storage to a ring buffer and empty it
+ * @param rb: Ring buffer to initialise
+ * @param storage: Backing array, must stay valid for the life of the ring
+ * @param size: Size of storage in bytes - must be a power of two
+ * @return None
+ */
+void ring_buffer_init(ring_buffer_t *rb, uint8_t *storage, uint16_t size)
+{
+    rb->data = storage;
+    rb->mask = size - 1;
+    rb->head = 0;
+    rb->tail = 0;
+}
+
+/**
+ * @brief Discard everything currently queued
+ * @param rb: Ring buffer to empty
+ * @return None
+ * @note Only safe when neither producer nor consumer is active (e.g. IRQ masked)
+ */
+void ring_buffer_clear(ring_buffer_t *rb)
+{
+    rb->tail = rb->head;
+}
+
+/**
+ * @brief Queue a single byte (producer side)
+ * @param rb: Ring buffer
+ * @param byte: Byte to queue
+ * @return true if queued, false if the ring was full
+ */
+bool ring_buffer_put(ring_buffer_t *rb, uint8_t byte)
+{
+    uint16_t head = rb->head;
+
+    if ((uint16_t)(head - rb->tail) > rb->mask)         // full
+    {
+        return false;
+    }
+    rb->data[head & rb->mask] = byte;
+    rb->head = head + 1;                                // publish after the data is written
+    return true;
+}
+
+/**
+ * @brief Remove a single byte (consumer side)
+ * @param rb: Ring buffer
+ * @param byte: Where to store the byte
+ * @return true if a byte was read, false if the ring was empty
+ */
+bool ring_buffer_get(ring_buffer_t *rb, uint8_t *byte)
+{
+    uint16_t tail = rb->tail;
+
+    if (tail == rb->head)                               // empty
+    {
+        return false;
+    }
+    *byte = rb->data[tail & rb->mask];
+    rb->tail = tail + 1;                                // release the slot after the data is read
+    return true;
+}
+
+/**
+ * @brief Queue as many bytes as will fit (producer side)
+ * @param rb: Ring buffer
+ * @param src: Bytes to queue
+ * @param len: Number of bytes offered
+ * @return Number of bytes actually queued
+ */
+uint16_t ring_buffer_write(ring_buffer_t *rb, const uint8_t *src, uint16_t len)
+{
+    uint16_t head = rb->head;
+    uint16_t space = ring_buffer_space(rb);
+
+    if (len > space)
+    {
+        len = space;
+    }
+    for (uint16_t i = 0; i < len; i++)
+    {
+        rb->data[(uint16_t)(head + i) & rb->mask] = src[i];
+    }
+    rb->head = head + len;
+    return len;
+}
+
+/**
+ * @brief Remove up to len bytes (consumer side)
+ * @param rb: Ring buffer
+ * @param dst: Destination array
+ * @param len: Maximum number of bytes to read
+ * @return Number of bytes actually read
+ */
+uint16_t ring_buffer_read(ring_buffer_t *rb, uint8_t *dst, uint16_t len)
+{
+    uint16_t tail = rb->tail;
+    uint16_t count = ring_buffer_count(rb);
+
+    if (len > count)
+    {
+        len = count;
+    }
+    for (uint16_t i = 0; i < len; i++)
+    {
+        dst[i] = rb->data[(uint16_t)(tail + i) & rb->mask];
+    }
+    rb->tail = tail + len;
+    return len;
+}
+
+/**
+ * @brief Number of bytes currently queued
+ */
+uint16_t ring_buffer_count(const ring_buffer_t *rb)
+{
+    return (uint16_t)(rb->head - rb->tail);
+}
+
+/**
+ * @brief Number of bytes that can be queued before the ring is full
+ */
+uint16_t ring_buffer_space(const ring_buffer_t *rb)
+{
+    return (uint16_t)(rb->mask + 1 - ring_buffer_count(rb));
+}
+
+/**
+ * @brief Total capacity of the ring in bytes
+ */
+uint16_t ring_buffer_size(const ring_buffer_t *rb)
+{
+    return (uint16_t)(rb->mask + 1);
+}
+
+bool ring_buffer_is_empty(const ring_buffer_t *rb)
+{
+    return rb->head == rb->tail;
+}
+
+bool ring_buffer_is_full(const ring_buffer_t *rb)
+{
+    return ring_buffer_count(rb) > rb->mask;
+}
+
+/**
+ * @brief Get a pointer to the oldest queued bytes without copying them
+ * @param rb: Ring buffer
+ * @param ptr: Set to the first readable byte
+ * @return Number of bytes readable at *ptr before the storage wraps
+ * @note Call ring_buffer_consume() once the bytes have been used
+ */
+uint16_t ring_buffer_peek_contiguous(const ring_buffer_t *rb, const uint8_t **ptr)
+{
+    uint16_t tail = rb->tail;
+    uint16_t count = (uint16_t)(rb->head - tail);
+    uint16_t offset = tail & rb->mask;
+    uint16_t to_end = (uint16_t)(rb->mask + 1 - offset);
+
+    *ptr = &rb->data[offset];
+    return (count < to_end) ? count : to_end;
+}
+
+/**
+ * @brief Release bytes previously obtained with ring_buffer_peek_contiguous()
+ * @param rb: Ring buffer
+ * @param len: Number of bytes to release (must not exceed the count)
+ */
+void ring_buffer_consume(ring_buffer_t *rb, uint16_t len)
+{
+    rb->tail = rb->tail + len;
+}
+
+/**
+ * @brief Write a byte past the head without publishing it (producer side)
+ * @param rb: Ring buffer
+ * @param offset: Position after the current head (must be less than the free space)
+ * @param byte: Byte to store
+ * @note Lets a producer build a record in place, back-patching earlier bytes,
+ *       then publish it in one go with ring_buffer_commit()
+ */
+void ring_buffer_poke(ring_buffer_t *rb, uint16_t offset, uint8_t byte)
+{
+    rb->data[(uint16_t)(rb->head + offset) & rb->mask] = byte;
+}
+
+/**
+ * @brief Publish bytes previously stored with ring_buffer_poke()
+ * @param rb: Ring buffer
+ * @param len: Number of bytes to publish (must not exceed the free space)
+ */
+void ring_buffer_commit(ring_buffer_t *rb, uint16_t len)
+{
+    rb->head = rb->head + len;
+}
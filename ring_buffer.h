@@ -0,0 +1,60 @@
+/*
+ * ring_buffer.h
+ *
+ * @brief Lock-free single-producer / single-consumer byte ring buffer
+ * @description Fixed-size circular byte queue used to decouple application code
+ *              from the USART interrupt handlers. One side (e.g. put_char) only
+ *              ever advances the head, the other side (e.g. the TXBL interrupt)
+ *              only ever advances the tail, so no locking is needed as long as
+ *              there is exactly one producer and one consumer.
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: JonathanStorey
+ *    Hardware: None (pure C, no peripheral access - can be built on a host PC)
+ *     Version: 1.0
+ *
+ * @note Storage size MUST be a power of two (16, 32 ... 32768)
+ * @note Head and tail are free-running 16-bit counters, masked on access
+ */
+
+#ifndef RING_BUFFER_H_
+#define RING_BUFFER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*==============================================================================
+ * RING BUFFER STRUCTURE
+ *============================================================================*/
+typedef struct {
+    uint8_t *data;                  ///< Caller supplied storage
+    uint16_t mask;                  ///< size - 1 (size is a power of two)
+    volatile uint16_t head;         ///< Write counter (producer only)
+    volatile uint16_t tail;         ///< Read counter (consumer only)
+} ring_buffer_t;
+
+/*==============================================================================
+ * FUNCTION DECLARATIONS
+ *============================================================================*/
+void ring_buffer_init(ring_buffer_t *rb, uint8_t *storage, uint16_t size);
+void ring_buffer_clear(ring_buffer_t *rb);
+
+bool ring_buffer_put(ring_buffer_t *rb, uint8_t byte);
+bool ring_buffer_get(ring_buffer_t *rb, uint8_t *byte);
+
+uint16_t ring_buffer_write(ring_buffer_t *rb, const uint8_t *src, uint16_t len);
+uint16_t ring_buffer_read(ring_buffer_t *rb, uint8_t *dst, uint16_t len);
+
+uint16_t ring_buffer_count(const ring_buffer_t *rb);
+uint16_t ring_buffer_space(const ring_buffer_t *rb);
+uint16_t ring_buffer_size(const ring_buffer_t *rb);
+bool ring_buffer_is_empty(const ring_buffer_t *rb);
+bool ring_buffer_is_full(const ring_buffer_t *rb);
+
+uint16_t ring_buffer_peek_contiguous(const ring_buffer_t *rb, const uint8_t **ptr);
+void ring_buffer_consume(ring_buffer_t *rb, uint16_t len);
+
+void ring_buffer_poke(ring_buffer_t *rb, uint16_t offset, uint8_t byte);
+void ring_buffer_commit(ring_buffer_t *rb, uint16_t len);
+
+#endif /* RING_BUFFER_H_ */
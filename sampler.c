@@ -0,0 +1,363 @@
+/*
+ * sampler.c
+ *
+ * @brief Timer driven periodic sampling of the I2C sensors
+ * @description See sampler.h.
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: JonathanStorey
+ *    Hardware: EFM32GG11B Microcontroller, TIMER3, I2C0 and I2C1
+ *     Version: 1.0
+ *
+ * @note TIMER3 and the I2C interrupts share the default NVIC priority, so the
+ *       tick never runs in the middle of a completion callback and vice versa
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "em_device.h"
+#include "em_cmu.h"
+#include "em_core.h"
+#include "em_timer.h"
+#include "hw_timer.h"
+#include "i2c.h"
+#include "i2c_devices.h"
+#include "sampler.h"
+
+#define SAMPLER_PRESCALE        64      // 50MHz / 64 = 781.25kHz, 781 counts per tick
+
+/**
+ * @brief Default period of each device in ms, indexed by i2cDeviceId_t (0 = off)
+ */
+static const uint16_t sampler_default_period[I2C_DEVICE_COUNT] =
+{
+    20,         // Compass A, 50 Hz
+    100,        // Pressure, 10 Hz
+    20,         // Compass B, 50 Hz
+};
+
+
+/*==============================================================================
+ * PER-DEVICE STATE
+ *============================================================================*/
+typedef struct {
+    uint16_t period_ms;                 ///< 0 = not sampled
+    uint32_t next_due;                  ///< Tick the next read is due on
+    uint32_t trigger_tick;              ///< Tick the outstanding read was queued on
+    uint32_t trigger_cycles;            ///< ...and the cycle count then
+    uint32_t last_cycles;               ///< Cycle count of the previous sample
+    bool have_last;                     ///< last_cycles is valid
+    i2cTransfer_t transfer;
+    uint8_t raw[I2C_SAMPLE_MAX];        ///< Read lands here, then is published
+
+    volatile sampler_sample_t slot[2];  ///< Double buffer
+    volatile uint8_t published;         ///< Slot readers copy from
+    volatile uint32_t sequence;         ///< Bumped after every publish
+
+    volatile sampler_stats_t stats;
+} sampler_device_t;
+
+static sampler_device_t sampler_devices[I2C_DEVICE_COUNT];
+static volatile uint32_t sampler_tick;
+static volatile bool sampler_enabled = false;
+
+
+/**
+ * @brief Publish a finished read into the slot readers aren't using
+ * @note Only ever called from the I2C interrupt, so there is one writer
+ */
+static void sampler_publish(sampler_device_t *dev, const i2cDevice_t *device, uint32_t now)
+{
+    uint8_t idx = (uint8_t)(dev->published ^ 1);
+    volatile sampler_sample_t *slot = &dev->slot[idx];
+
+    slot->sequence = dev->sequence + 1;
+    slot->tick_ms = dev->trigger_tick;
+    slot->cycles = now;
+    slot->len = device->sampleLen;
+    for (uint8_t i = 0; i < device->sampleLen; i++)
+    {
+        slot->data[i] = dev->raw[i];
+    }
+    dev->published = idx;
+    dev->sequence++;
+}
+
+/**
+ * @brief Completion of a sample read (I2C interrupt)
+ */
+static void sampler_done(i2cTransfer_t *transfer)
+{
+    i2cDeviceId_t id = (i2cDeviceId_t)(uintptr_t)transfer->ctx;
+    sampler_device_t *dev = &sampler_devices[id];
+    uint32_t now = hw_timer_cycles();
+    uint32_t ns;
+
+    if (transfer->status != I2C_TRANSFER_DONE)
+    {
+        dev->stats.errors++;
+        dev->have_last = false;                                 // an interval across a gap is not jitter
+        return;
+    }
+
+    sampler_publish(dev, i2cDeviceGet(id), now);
+    dev->stats.samples++;
+
+    ns = hw_timer_cycles_to_ns(now - dev->trigger_cycles);
+    if (ns > dev->stats.latency_max_ns)
+    {
+        dev->stats.latency_max_ns = ns;
+    }
+
+    if (dev->have_last)
+    {
+        uint32_t interval = hw_timer_cycles_to_ns(now - dev->last_cycles);
+        uint32_t period = (uint32_t)dev->period_ms * 1000000u;
+
+        ns = (interval > period) ? interval - period : period - interval;
+        dev->stats.jitter_last_ns = ns;
+        if (ns > dev->stats.jitter_max_ns)
+        {
+            dev->stats.jitter_max_ns = ns;
+        }
+    }
+    dev->last_cycles = now;
+    dev->have_last = true;
+}
+
+
+/*==============================================================================
+ * TIMER
+ *============================================================================*/
+
+/**
+ * @brief Set up TIMER3 for the sample tick and the default periods
+ * @note The timer is left stopped - call sampler_start(). Devices on a bus
+ *       initI2C() leaves down start off.
+ */
+void sampler_init(void)
+{
+    CMU_ClockEnable(cmuClock_TIMER3, true);
+    TIMER_Init_TypeDef timerInit = TIMER_INIT_DEFAULT;
+    timerInit.enable = false;
+    timerInit.prescale = timerPrescale64;
+
+    TIMER_Init(TIMER3, &timerInit);
+    TIMER_TopSet(TIMER3, CMU_ClockFreqGet(cmuClock_TIMER3) / SAMPLER_PRESCALE / SAMPLER_TICK_HZ - 1);
+    TIMER_IntClear(TIMER3, TIMER_IF_OF);
+    TIMER_IntEnable(TIMER3, TIMER_IEN_OF);
+    NVIC_EnableIRQ(TIMER3_IRQn);
+
+    for (uint8_t id = 0; id < I2C_DEVICE_COUNT; id++)
+    {
+        sampler_devices[id].period_ms = i2cBusEnabled((i2cBus_t)i2cDeviceGet((i2cDeviceId_t)id)->bus) ? sampler_default_period[id] : 0;
+        sampler_devices[id].transfer.status = I2C_TRANSFER_IDLE;
+    }
+    sampler_reset_stats();
+}
+
+/**
+ * @brief Set up the sampled devices, then start sampling - every enabled
+ *        device is read on the next tick
+ * @return false if a device didn't take its set-up writes (counted as an
+ *         error). Sampling starts anyway and its reads show whether it is
+ *         there at all.
+ * @note Blocks for the set-up writes, so call it from the main loop
+ */
+bool sampler_start(void)
+{
+    bool configured = true;
+    CORE_DECLARE_IRQ_STATE;
+
+    for (uint8_t id = 0; id < I2C_DEVICE_COUNT; id++)
+    {
+        if (sampler_devices[id].period_ms != 0 && !i2cDeviceConfigure(i2cDeviceGet((i2cDeviceId_t)id)))
+        {
+            sampler_devices[id].stats.errors++;
+            configured = false;
+        }
+    }
+
+    CORE_ENTER_ATOMIC();
+    for (uint8_t id = 0; id < I2C_DEVICE_COUNT; id++)
+    {
+        sampler_devices[id].next_due = sampler_tick + 1;
+        sampler_devices[id].have_last = false;
+    }
+    sampler_enabled = true;
+    CORE_EXIT_ATOMIC();
+    TIMER_Enable(TIMER3, true);
+    return configured;
+}
+
+/**
+ * @brief Stop triggering reads
+ * @note Reads already queued still complete and are published
+ */
+void sampler_stop(void)
+{
+    TIMER_Enable(TIMER3, false);
+    sampler_enabled = false;
+}
+
+bool sampler_running(void)
+{
+    return sampler_enabled;
+}
+
+/**
+ * @brief Change how often a device is read
+ * @param period_ms: 1 to 65535 ms, or 0 to stop reading the device
+ * @return false if the id is out of range, or the device's bus isn't enabled
+ * @note Takes effect from the next tick
+ */
+bool sampler_set_period(i2cDeviceId_t id, uint16_t period_ms)
+{
+    CORE_DECLARE_IRQ_STATE;
+
+    if (id >= I2C_DEVICE_COUNT || (period_ms != 0 && !i2cBusEnabled((i2cBus_t)i2cDeviceGet(id)->bus)))
+    {
+        return false;
+    }
+    CORE_ENTER_ATOMIC();
+    sampler_devices[id].period_ms = period_ms;
+    sampler_devices[id].next_due = sampler_tick + 1;
+    sampler_devices[id].have_last = false;
+    CORE_EXIT_ATOMIC();
+    return true;
+}
+
+uint16_t sampler_get_period(i2cDeviceId_t id)
+{
+    return (id < I2C_DEVICE_COUNT) ? sampler_devices[id].period_ms : 0;
+}
+
+/**
+ * @brief Sample tick - queue a read for every device that is due
+ * @note A device whose last read hasn't finished yet skips this deadline and
+ *       counts it as missed; its schedule is not pushed back, so one slow
+ *       read doesn't shift every later sample.
+ */
+void TIMER3_IRQHandler(void)
+{
+    uint32_t tick;
+
+    TIMER_IntClear(TIMER3, TIMER_IF_OF);
+    tick = ++sampler_tick;
+
+    if (!sampler_enabled)
+    {
+        return;
+    }
+    for (uint8_t id = 0; id < I2C_DEVICE_COUNT; id++)
+    {
+        sampler_device_t *dev = &sampler_devices[id];
+
+        if (dev->period_ms == 0 || (int32_t)(tick - dev->next_due) < 0)
+        {
+            continue;
+        }
+        dev->next_due += dev->period_ms;
+
+        if (dev->transfer.status == I2C_TRANSFER_PENDING || dev->transfer.status == I2C_TRANSFER_ACTIVE)
+        {
+            dev->stats.missed++;
+            dev->have_last = false;
+            continue;
+        }
+        dev->trigger_tick = tick;
+        dev->trigger_cycles = hw_timer_cycles();
+        if (!i2cReadSample(i2cDeviceGet((i2cDeviceId_t)id), &dev->transfer, dev->raw, sampler_done, (void *)(uintptr_t)id))
+        {
+            dev->stats.errors++;
+        }
+    }
+}
+
+
+/*==============================================================================
+ * READERS
+ *============================================================================*/
+
+/**
+ * @brief Copy out a device's newest sample (no bus traffic, no locking)
+ * @param id: Device
+ * @param sample: Filled in
+ * @return false if the id is out of range or nothing has been sampled yet
+ * @note Safe from the main loop while sampling runs. The copy is retried if a
+ *       new sample was published part way through it.
+ */
+bool sampler_latest(i2cDeviceId_t id, sampler_sample_t *sample)
+{
+    sampler_device_t *dev;
+    uint32_t seq;
+
+    if (id >= I2C_DEVICE_COUNT)
+    {
+        return false;
+    }
+    dev = &sampler_devices[id];
+
+    do
+    {
+        volatile sampler_sample_t *slot;
+
+        seq = dev->sequence;
+        if (seq == 0)
+        {
+            return false;
+        }
+        slot = &dev->slot[dev->published];
+        sample->sequence = slot->sequence;
+        sample->tick_ms = slot->tick_ms;
+        sample->cycles = slot->cycles;
+        sample->len = slot->len;
+        for (uint8_t i = 0; i < I2C_SAMPLE_MAX; i++)
+        {
+            sample->data[i] = slot->data[i];
+        }
+    } while (seq != dev->sequence);
+    return true;
+}
+
+/**
+ * @brief Snapshot of a device's counters
+ */
+void sampler_get_stats(i2cDeviceId_t id, sampler_stats_t *stats)
+{
+    CORE_DECLARE_IRQ_STATE;
+
+    if (id >= I2C_DEVICE_COUNT)
+    {
+        return;
+    }
+    CORE_ENTER_ATOMIC();
+    stats->samples = sampler_devices[id].stats.samples;
+    stats->errors = sampler_devices[id].stats.errors;
+    stats->missed = sampler_devices[id].stats.missed;
+    stats->jitter_last_ns = sampler_devices[id].stats.jitter_last_ns;
+    stats->jitter_max_ns = sampler_devices[id].stats.jitter_max_ns;
+    stats->latency_max_ns = sampler_devices[id].stats.latency_max_ns;
+    CORE_EXIT_ATOMIC();
+}
+
+/**
+ * @brief Zero every device's counters (samples already published are kept)
+ */
+void sampler_reset_stats(void)
+{
+    CORE_DECLARE_IRQ_STATE;
+
+    CORE_ENTER_ATOMIC();
+    for (uint8_t id = 0; id < I2C_DEVICE_COUNT; id++)
+    {
+        sampler_devices[id].stats.samples = 0;
+        sampler_devices[id].stats.errors = 0;
+        sampler_devices[id].stats.missed = 0;
+        sampler_devices[id].stats.jitter_last_ns = 0;
+        sampler_devices[id].stats.jitter_max_ns = 0;
+        sampler_devices[id].stats.latency_max_ns = 0;
+    }
+    CORE_EXIT_ATOMIC();
+}
@@ -0,0 +1,81 @@
+/*
+ * sampler.h
+ *
+ * @brief Timer driven periodic sampling of the I2C sensors
+ * @description TIMER3 ticks at SAMPLER_TICK_HZ. Each tick, every device in
+ *              i2c_devices.h whose period has come round gets one burst read
+ *              of its sample block queued on its bus. The I2C interrupt
+ *              publishes the finished sample into that device's double
+ *              buffer, so sampler_latest() hands back the newest sample with
+ *              no bus traffic and no locking.
+ *
+ *              The store is a seqlock over two slots: the writer fills the
+ *              slot readers aren't pointed at, then flips the index and bumps
+ *              the sequence. A reader copies the published slot and retries
+ *              if the sequence moved while it copied.
+ *
+ *              sampler_start() first sends every sampled device its set-up
+ *              writes from i2c_devices.c, since the LSM303 and BMP280 power up
+ *              asleep and would otherwise return the same sample forever.
+ *
+ *              Per device the sampler counts samples, failed reads and missed
+ *              deadlines (the previous read was still queued or on the bus
+ *              when the next was due), and tracks how far the interval between
+ *              consecutive samples strays from the period (jitter) and the
+ *              longest trigger-to-sample latency.
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: JonathanStorey
+ *    Hardware: EFM32GG11B Microcontroller, TIMER3, I2C0 and I2C1
+ *     Version: 1.0
+ *
+ * @note TIMER0 and TIMER1 are the delay timers and TIMER2 drives the buzzer
+ */
+
+#ifndef SAMPLER_H_
+#define SAMPLER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "i2c_devices.h"
+
+#define SAMPLER_TICK_HZ         1000    ///< TIMER3 rate - periods are whole ticks (ms)
+
+/*==============================================================================
+ * TYPES
+ *============================================================================*/
+typedef struct {
+    uint32_t sequence;              ///< Samples published so far, 1 for the first
+    uint32_t tick_ms;               ///< Sampler tick the read was triggered on
+    uint32_t cycles;                ///< hw_timer_cycles() when the sample came in
+    uint8_t len;                    ///< Valid bytes in data
+    uint8_t data[I2C_SAMPLE_MAX];   ///< Raw sample block, device byte order
+} sampler_sample_t;
+
+typedef struct {
+    uint32_t samples;               ///< Reads completed
+    uint32_t errors;                ///< Reads that failed (NACK, bus error)
+    uint32_t missed;                ///< Deadlines skipped because the last read was still outstanding
+    uint32_t jitter_last_ns;        ///< |sample interval - period| of the latest sample
+    uint32_t jitter_max_ns;
+    uint32_t latency_max_ns;        ///< Longest trigger to sample time
+} sampler_stats_t;
+
+/*==============================================================================
+ * FUNCTION DECLARATIONS
+ *============================================================================*/
+void sampler_init(void);
+bool sampler_start(void);
+void sampler_stop(void);
+bool sampler_running(void);
+
+bool sampler_set_period(i2cDeviceId_t id, uint16_t period_ms);
+uint16_t sampler_get_period(i2cDeviceId_t id);
+
+bool sampler_latest(i2cDeviceId_t id, sampler_sample_t *sample);
+void sampler_get_stats(i2cDeviceId_t id, sampler_stats_t *stats);
+void sampler_reset_stats(void);
+
+void TIMER3_IRQHandler(void);
+
+#endif /* SAMPLER_H_ */
@@ -0,0 +1,216 @@
+/*
+ * spi_bus.c
+ *
+ * @brief LDMA driven transaction queue on the USART4 SPI bus
+ * @description See spi_bus.h. This file is the hardware backend for
+ *              spi_queue.c: chip select GPIOs and the two LDMA channels.
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: JonathanStorey
+ *    Hardware: EFM32GG11B Microcontroller, USART4 LOC0 SPI
+ *     Version: 1.0
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "em_device.h"
+#include "em_core.h"
+#include "em_gpio.h"
+#include "em_usart.h"
+#include "em_ldma.h"
+#include "defines.h"
+#include "helpers.h"
+#include "dma.h"
+#include "spi_bus.h"
+
+
+static spi_queue_t spi_queue;
+static spi_bus_idle_hook_t idle_hook;
+static bool spi_bus_initialised = false;
+
+static LDMA_Descriptor_t spi_tx_desc;
+static LDMA_Descriptor_t spi_rx_desc;
+static const uint8_t spi_tx_dummy = 0x00;       // clocked out when a transaction has no tx buffer
+static uint8_t spi_rx_dummy;                    // sink for bytes nobody wants
+
+
+/**
+ * @brief spi_queue select op - drive one chip select
+ */
+static void spi_bus_select(uint8_t cs, bool selected, void *ctx)
+{
+    (void)ctx;
+
+    switch (cs)
+    {
+      case SPI_CS_EXPANDER_A: Set_Expander_A_CS_State(selected ? Selected : Deselected); break;
+      case SPI_CS_EXPANDER_B: Set_Expander_B_CS_State(selected ? Selected : Deselected); break;
+      case SPI_CS_EXPANDER_C: Set_Expander_C_CS_State(selected ? Selected : Deselected); break;
+      case SPI_CS_ETHERNET:
+          if (selected)
+          {
+              GPIO_PinOutClear(gpioPortA, 10);
+          }
+          else
+          {
+              GPIO_PinOutSet(gpioPortA, 10);
+          }
+          break;
+    }
+}
+
+/**
+ * @brief spi_queue transfer op - start len bytes each way on the LDMA
+ * @note RX is armed before TX so no received byte can be missed. With no
+ *       buffer the address stays put on a dummy byte.
+ */
+static void spi_bus_transfer(const uint8_t *tx, uint8_t *rx, uint16_t len, void *ctx)
+{
+    LDMA_TransferCfg_t tx_cfg = LDMA_TRANSFER_CFG_PERIPHERAL(ldmaPeripheralSignal_USART4_TXBL);
+    LDMA_TransferCfg_t rx_cfg = LDMA_TRANSFER_CFG_PERIPHERAL(ldmaPeripheralSignal_USART4_RXDATAV);
+    LDMA_Descriptor_t tx_desc = LDMA_DESCRIPTOR_SINGLE_M2P_BYTE(tx ? tx : &spi_tx_dummy, &USART4->TXDATA, len);
+    LDMA_Descriptor_t rx_desc = LDMA_DESCRIPTOR_SINGLE_P2M_BYTE(&USART4->RXDATA, rx ? rx : &spi_rx_dummy, len);
+    (void)ctx;
+
+    if (tx == NULL)
+    {
+        tx_desc.xfer.srcInc = ldmaCtrlSrcIncNone;
+    }
+    if (rx == NULL)
+    {
+        rx_desc.xfer.dstInc = ldmaCtrlDstIncNone;
+    }
+    tx_desc.xfer.doneIfs = 0;                                           // completion is taken from RX only
+    spi_tx_desc = tx_desc;
+    spi_rx_desc = rx_desc;
+
+    USART4->CMD = USART_CMD_CLEARRX;                                    // nothing stale in front of our bytes
+    LDMA_StartTransfer(DMA_CH_SPI_RX, &rx_cfg, &spi_rx_desc);
+    LDMA_StartTransfer(DMA_CH_SPI_TX, &tx_cfg, &spi_tx_desc);
+}
+
+static const spi_bus_ops_t spi_bus_ops =
+{
+    spi_bus_select,
+    spi_bus_transfer,
+    NULL
+};
+
+/**
+ * @brief RX channel done - the last byte has been clocked in
+ */
+static void spi_bus_dma_done(unsigned int channel, void *ctx)
+{
+    (void)channel;
+    (void)ctx;
+
+    spi_queue_transfer_done(&spi_queue);
+    if (spi_queue_is_idle(&spi_queue) && idle_hook != NULL)
+    {
+        idle_hook();
+    }
+}
+
+/**
+ * @brief Set up the queue and claim the SPI LDMA channels (safe to call more than once)
+ * @note usart_init() must already have put USART4 in SPI mode
+ */
+void spi_bus_init(void)
+{
+    if (spi_bus_initialised)
+    {
+        return;
+    }
+    dma_init();
+    spi_queue_init(&spi_queue, &spi_bus_ops);
+    dma_set_callback(DMA_CH_SPI_RX, spi_bus_dma_done, NULL);
+    spi_bus_initialised = true;
+}
+
+/**
+ * @brief Queue a transaction, starting it straight away if the bus is free
+ * @param t: Descriptor - it and its buffers must stay valid until the callback
+ * @return false if already queued, or a phase is longer than one LDMA descriptor
+ * @note While spi_bus_claim() is in force the transaction waits for spi_bus_release()
+ */
+bool spi_bus_submit(spi_transaction_t *t)
+{
+    bool queued;
+    CORE_DECLARE_IRQ_STATE;
+
+    if (!spi_bus_initialised || t->cmd_len > DMA_MAX_XFER || t->len > DMA_MAX_XFER)
+    {
+        return false;
+    }
+    CORE_ENTER_ATOMIC();
+    queued = spi_queue_submit(&spi_queue, t);
+    CORE_EXIT_ATOMIC();
+    return queued;
+}
+
+/**
+ * @brief true when nothing is queued or on the bus
+ */
+bool spi_bus_idle(void)
+{
+    return !spi_bus_initialised || spi_queue_is_idle(&spi_queue);
+}
+
+/**
+ * @brief Take the bus for a synchronous, CPU driven transfer
+ * @return false while a queued transaction is still outstanding - wait for
+ *         spi_bus_idle() and try again
+ * @note Until spi_bus_release() new submits are queued but not started, so
+ *       nothing reaches USART4 under the caller's chip select. Doesn't nest.
+ */
+bool spi_bus_claim(void)
+{
+    bool claimed;
+    CORE_DECLARE_IRQ_STATE;
+
+    if (!spi_bus_initialised)
+    {
+        return true;
+    }
+    CORE_ENTER_ATOMIC();
+    claimed = spi_queue_is_idle(&spi_queue);
+    if (claimed)
+    {
+        spi_queue_hold(&spi_queue, true);
+    }
+    CORE_EXIT_ATOMIC();
+    return claimed;
+}
+
+/**
+ * @brief Hand the bus back after spi_bus_claim(), starting anything queued meanwhile
+ */
+void spi_bus_release(void)
+{
+    CORE_DECLARE_IRQ_STATE;
+
+    if (!spi_bus_initialised)
+    {
+        return;
+    }
+    CORE_ENTER_ATOMIC();
+    spi_queue_hold(&spi_queue, false);
+    CORE_EXIT_ATOMIC();
+}
+
+/**
+ * @brief Number of transactions completed since spi_bus_init()
+ */
+uint32_t spi_bus_completed(void)
+{
+    return spi_queue_completed(&spi_queue);
+}
+
+/**
+ * @brief Register a function to run each time the queue drains (interrupt context)
+ */
+void spi_bus_set_idle_hook(spi_bus_idle_hook_t hook)
+{
+    idle_hook = hook;
+}
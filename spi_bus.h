@@ -0,0 +1,55 @@
+/*
+ * spi_bus.h
+ *
+ * @brief LDMA driven transaction queue on the USART4 SPI bus
+ * @description Runs spi_queue.h transactions on USART4 with one LDMA channel
+ *              feeding TXDATA and one draining RXDATA, so the CPU doesn't wait
+ *              on each byte. Completion comes from the RX channel's done
+ *              interrupt, which deselects the device, calls the transaction's
+ *              callback and starts the next one.
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: JonathanStorey
+ *    Hardware: EFM32GG11B Microcontroller, USART4 LOC0 SPI
+ *     Version: 1.0
+ *
+ * @note The synchronous MAX14830_* register helpers wait for the queue to go
+ *       idle and claim the bus for each chip select cycle, so a transaction
+ *       submitted meanwhile waits for the deselect instead of cutting in. The
+ *       expander interrupt engine defers itself until the queue is idle.
+ */
+
+#ifndef SPI_BUS_H_
+#define SPI_BUS_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "spi_queue.h"
+
+/*==============================================================================
+ * CHIP SELECT TARGETS (spi_transaction_t.cs)
+ *============================================================================*/
+#define SPI_CS_EXPANDER_A       0       ///< MAX14830 A (PA9)
+#define SPI_CS_EXPANDER_B       1       ///< MAX14830 B (PA8)
+#define SPI_CS_EXPANDER_C       2       ///< MAX14830 C (PA7)
+#define SPI_CS_ETHERNET         3       ///< Ethernet switch (PA10, active low)
+
+#define SPI_CS_OF_EXPANDER(expander)    ((uint8_t)((expander) - EXPANDER_A + SPI_CS_EXPANDER_A))
+
+/**
+ * @brief Called from the RX done interrupt each time the queue drains
+ */
+typedef void (*spi_bus_idle_hook_t)(void);
+
+/*==============================================================================
+ * FUNCTION DECLARATIONS
+ *============================================================================*/
+void spi_bus_init(void);
+bool spi_bus_submit(spi_transaction_t *t);
+bool spi_bus_idle(void);
+bool spi_bus_claim(void);
+void spi_bus_release(void);
+uint32_t spi_bus_completed(void);
+void spi_bus_set_idle_hook(spi_bus_idle_hook_t hook);
+
+#endif /* SPI_BUS_H_ */
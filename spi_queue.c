@@ -0,0 +1,194 @@
+/*
+ * spi_queue.c
+ *
+ * @brief Queue of SPI transactions for a shared bus with several chip selects
+ * @description See spi_queue.h.
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: JonathanStorey
+ *     Version: 1.0
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "spi_queue.h"
+
+enum {
+    SPI_PHASE_IDLE = 0,             ///< Nothing selected
+    SPI_PHASE_CMD,                  ///< Command bytes on the bus
+    SPI_PHASE_DATA                  ///< Data bytes on the bus
+};
+
+
+/**
+ * @brief Attach a queue to its bus backend and empty it
+ * @param q: Queue to initialise
+ * @param ops: Backend - must stay valid for the life of the queue
+ */
+void spi_queue_init(spi_queue_t *q, const spi_bus_ops_t *ops)
+{
+    q->ops = ops;
+    q->head = NULL;
+    q->tail = NULL;
+    q->phase = SPI_PHASE_IDLE;
+    q->stepping = false;
+    q->held = false;
+    q->kick = false;
+    q->completed = 0;
+}
+
+/**
+ * @brief Advance the head transaction by one phase
+ * @note Falls through phases with nothing to send, so a transaction with no
+ *       command and no data still selects, deselects and calls back
+ */
+static void spi_queue_step(spi_queue_t *q)
+{
+    spi_transaction_t *t = q->head;
+
+    if (t == NULL)
+    {
+        return;
+    }
+
+    switch (q->phase)
+    {
+      case SPI_PHASE_IDLE:
+          t->status = SPI_STATUS_ACTIVE;
+          q->ops->select(t->cs, true, q->ops->ctx);
+          q->phase = SPI_PHASE_CMD;
+          if (t->cmd_len)
+          {
+              q->ops->transfer(t->cmd, NULL, t->cmd_len, q->ops->ctx);
+              return;
+          }
+          /* fall through */
+
+      case SPI_PHASE_CMD:
+          q->phase = SPI_PHASE_DATA;
+          if (t->len)
+          {
+              q->ops->transfer(t->tx, t->rx, t->len, q->ops->ctx);
+              return;
+          }
+          /* fall through */
+
+      default:
+          q->ops->select(t->cs, false, q->ops->ctx);
+          q->head = t->next;
+          if (q->head == NULL)
+          {
+              q->tail = NULL;
+          }
+          q->phase = SPI_PHASE_IDLE;
+          q->completed++;
+          t->next = NULL;
+          t->status = SPI_STATUS_DONE;
+          if (t->callback)
+          {
+              t->callback(t);                                   // may submit the next transaction
+          }
+          if (q->head != NULL && !q->held)
+          {
+              q->kick = true;                                   // start the next one
+          }
+          break;
+    }
+}
+
+/**
+ * @brief Run steps until the bus is waiting on a transfer (or the queue is empty)
+ * @note Re-entrant calls (a mock transfer completing immediately, a callback
+ *       submitting) just set kick, so the stack depth stays constant
+ */
+static void spi_queue_run(spi_queue_t *q)
+{
+    if (q->stepping)
+    {
+        return;
+    }
+    q->stepping = true;
+    while (q->kick)
+    {
+        q->kick = false;
+        spi_queue_step(q);
+    }
+    q->stepping = false;
+}
+
+/**
+ * @brief Add a transaction to the end of the queue, starting it if the bus is free
+ * @param q: Queue
+ * @param t: Filled in descriptor (status and next are set here)
+ * @return false if the descriptor is already queued
+ */
+bool spi_queue_submit(spi_queue_t *q, spi_transaction_t *t)
+{
+    if (t->status == SPI_STATUS_PENDING || t->status == SPI_STATUS_ACTIVE)
+    {
+        return false;
+    }
+    t->next = NULL;
+    t->status = SPI_STATUS_PENDING;
+
+    if (q->tail == NULL)
+    {
+        q->head = t;
+        q->tail = t;
+        if (q->phase == SPI_PHASE_IDLE && !q->held)
+        {
+            q->kick = true;
+            spi_queue_run(q);
+        }
+    }
+    else
+    {
+        q->tail->next = t;
+        q->tail = t;
+    }
+    return true;
+}
+
+/**
+ * @brief Backend signal that the last transfer() has finished
+ * @note Called from the backend's completion interrupt
+ */
+void spi_queue_transfer_done(spi_queue_t *q)
+{
+    q->kick = true;
+    spi_queue_run(q);
+}
+
+/**
+ * @brief Stop the queue starting transactions, or let it carry on
+ * @param q: Queue
+ * @param hold: true while something outside the queue drives the bus
+ * @note A transaction already on the bus still runs to completion. Submits
+ *       while held are queued and start when the hold is lifted.
+ */
+void spi_queue_hold(spi_queue_t *q, bool hold)
+{
+    q->held = hold;
+    if (!hold && q->head != NULL && q->phase == SPI_PHASE_IDLE)
+    {
+        q->kick = true;
+        spi_queue_run(q);
+    }
+}
+
+/**
+ * @brief true when nothing is queued or on the bus
+ */
+bool spi_queue_is_idle(const spi_queue_t *q)
+{
+    return q->head == NULL;
+}
+
+/**
+ * @brief Number of transactions completed since spi_queue_init()
+ */
+uint32_t spi_queue_completed(const spi_queue_t *q)
+{
+    return q->completed;
+}
@@ -0,0 +1,87 @@
+/*
+ * spi_queue.h
+ *
+ * @brief Queue of SPI transactions for a shared bus with several chip selects
+ * @description Book-keeping for spi_bus.c: callers build a transaction
+ *              descriptor (chip select, command bytes, data buffers and a
+ *              completion callback) and queue it. The queue selects the device,
+ *              runs the command phase then the data phase through the bus ops,
+ *              deselects, calls back and moves on to the next transaction.
+ *              The bus ops are a pair of function pointers, so the same queue
+ *              runs on the LDMA backend or on a mock SPI on a host PC.
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: JonathanStorey
+ *    Hardware: None (pure C, no peripheral access - can be built on a host PC)
+ *     Version: 1.0
+ *
+ * @note Descriptors are owned by the caller and linked in place - nothing is
+ *       copied, so a descriptor and its buffers must stay valid until its
+ *       callback has run
+ * @note Submit with the bus interrupt masked. A mock transfer may call
+ *       spi_queue_transfer_done() before it returns.
+ */
+
+#ifndef SPI_QUEUE_H_
+#define SPI_QUEUE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef enum {
+    SPI_STATUS_IDLE = 0,            ///< Never queued, or completed and reused
+    SPI_STATUS_PENDING,             ///< Waiting behind another transaction
+    SPI_STATUS_ACTIVE,              ///< On the bus now
+    SPI_STATUS_DONE                 ///< Finished - buffers may be reused
+} spi_status_t;
+
+struct spi_transaction;
+
+/**
+ * @brief Transaction completion callback (interrupt context on the target)
+ */
+typedef void (*spi_callback_t)(struct spi_transaction *t);
+
+typedef struct spi_transaction {
+    uint8_t cs;                     ///< Chip select target (see spi_bus.h)
+    const uint8_t *cmd;             ///< Command bytes, clocked out first (read data discarded)
+    uint16_t cmd_len;
+    const uint8_t *tx;              ///< Data phase bytes out, NULL to clock out zeros
+    uint8_t *rx;                    ///< Data phase bytes in, NULL to discard
+    uint16_t len;                   ///< Data phase length
+    spi_callback_t callback;        ///< Optional
+    void *ctx;                      ///< For the callback's use
+    volatile spi_status_t status;
+    struct spi_transaction *next;   ///< Queue link - owned by the queue
+} spi_transaction_t;
+
+/**
+ * @brief Bus backend
+ * @note transfer() starts a full duplex transfer and returns; the backend calls
+ *       spi_queue_transfer_done() when the last byte has been clocked in
+ */
+typedef struct {
+    void (*select)(uint8_t cs, bool selected, void *ctx);
+    void (*transfer)(const uint8_t *tx, uint8_t *rx, uint16_t len, void *ctx);
+    void *ctx;
+} spi_bus_ops_t;
+
+typedef struct {
+    const spi_bus_ops_t *ops;
+    spi_transaction_t *head;        ///< Transaction on the bus (or next to start)
+    spi_transaction_t *tail;
+    uint8_t phase;
+    bool stepping;                  ///< Inside spi_queue_run() - stops recursion
+    bool held;                      ///< Another user owns the bus - queue, but start nothing
+    bool kick;                      ///< Another step is due
+    uint32_t completed;
+} spi_queue_t;
+
+void spi_queue_init(spi_queue_t *q, const spi_bus_ops_t *ops);
+bool spi_queue_submit(spi_queue_t *q, spi_transaction_t *t);
+void spi_queue_transfer_done(spi_queue_t *q);
+void spi_queue_hold(spi_queue_t *q, bool hold);
+bool spi_queue_is_idle(const spi_queue_t *q);
+uint32_t spi_queue_completed(const spi_queue_t *q);
+
+#endif /* SPI_QUEUE_H_ */
@@ -0,0 +1,172 @@
+/*
+ * bench_node_printf.c
+ *
+ * @brief Host check and benchmark of node_snprintf() against the hand
+ *        written converters
+ * @description Built with NODE_PRINTF_HOST, so only the formatter is linked.
+ *              Checks the conversions, then compares the cost per field of
+ *              node_snprintf("%02X") and ("%u") with binaryToAsciiHex() and
+ *              binaryToAsciiString() - copied below from helpers.c, which
+ *              needs the whole board to build. All 256 byte values must give
+ *              the same text both ways.
+ *
+ *              Timings are host ns per field, plus TSC ticks per field on
+ *              x86. Only the ratio carries over to the Cortex-M4.
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: JonathanStorey
+ *    Hardware: None (host build only)
+ *     Version: 1.0
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include "test.h"
+#include "node_printf.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_TICKS()   __rdtsc()
+#else
+#define BENCH_TICKS()   0
+#endif
+
+#define BENCH_FIELDS    2000000u
+
+static volatile uint32_t sink;
+
+
+/*==============================================================================
+ * REFERENCE CONVERTERS (copies of helpers.c)
+ *============================================================================*/
+static void ref_binaryToAsciiHex(uint8_t value, char *asciiStr)
+{
+    const char hexDigits[] = "0123456789ABCDEF";
+    asciiStr[0] = hexDigits[(value >> 4) & 0x0F];     // High nibble
+    asciiStr[1] = hexDigits[value & 0x0F];            // Low nibble
+    asciiStr[2] = '\0';                               // Null terminator
+}
+
+static void ref_binaryToAsciiString(uint8_t value, char *asciiStr)
+{
+    char buffer[4]; // Max 3 digits for uint8_t + null terminator
+    int i = 0;
+
+    if (value == 0)
+    {
+        asciiStr[0] = '0';
+        asciiStr[1] = '\0';
+        return;
+    }
+
+    while (value > 0 && i < 3)                // Extract digits from the end
+    {
+        buffer[i++] = (value % 10) + '0';
+        value /= 10;
+    }
+
+    // Reverse the string into output
+    for (int j = 0; j < i; j++)
+    {
+        asciiStr[j] = buffer[i - j - 1];
+    }
+    asciiStr[i] = '\0';
+}
+
+
+/*==============================================================================
+ * CONVERSIONS
+ *============================================================================*/
+#define FORMATS(expect, ...)                                                    \
+    do {                                                                        \
+        char out[64];                                                           \
+        node_snprintf(out, sizeof(out), __VA_ARGS__);                           \
+        CHECK(strcmp(out, expect) == 0);                                        \
+    } while (0)
+
+static void test_conversions(void)
+{
+    char small[8];
+    char a[8];
+    char b[8];
+    bool same = true;
+
+    FORMATS("123", "%d", 123);
+    FORMATS("-5", "%d", -5);
+    FORMATS("-2147483648", "%d", (int32_t)0x80000000);
+    FORMATS("4294967295", "%u", 0xFFFFFFFFu);
+    FORMATS("00ff", "%04x", 255);
+    FORMATS("  FF", "%4X", 255);
+    FORMATS("ab   |", "%-5s|", "ab");
+    FORMATS("hel", "%.3s", "hello");
+    FORMATS("c=Z", "c=%c", 'Z');
+    FORMATS("x%y", "x%%y");
+    FORMATS("7", "%ld", 7L);
+    FORMATS("12.34", "%.2q", 1234);
+    FORMATS("-0.05", "%.2q", -5);
+    FORMATS("0.005", "%.3q", 5);
+    FORMATS("   -1.5", "%7.1q", -15);
+    FORMATS("-001.5", "%06.1q", -15);
+    FORMATS("100", "%.0q", 100);
+
+    CHECK(node_snprintf(small, sizeof(small), "%s", "0123456789") == 10);       // length it wanted
+    CHECK(strcmp(small, "0123456") == 0);                                       // truncated, terminated
+
+    for (unsigned int v = 0; v < 256; v++)
+    {
+        ref_binaryToAsciiHex((uint8_t)v, a);
+        node_snprintf(b, sizeof(b), "%02X", v);
+        same &= strcmp(a, b) == 0;
+        ref_binaryToAsciiString((uint8_t)v, a);
+        node_snprintf(b, sizeof(b), "%u", v);
+        same &= strcmp(a, b) == 0;
+    }
+    CHECK(same);
+}
+
+
+/*==============================================================================
+ * BENCHMARK
+ *============================================================================*/
+typedef void (*bench_fn_t)(uint8_t value, char *out);
+
+static void fmt_hex(uint8_t value, char *out)     { node_snprintf(out, 3, "%02X", value); }
+static void fmt_dec(uint8_t value, char *out)     { node_snprintf(out, 4, "%u", value); }
+
+static void bench(const char *name, bench_fn_t fn)
+{
+    char out[8];
+    clock_t start = clock();
+    uint64_t ticks = BENCH_TICKS();
+    double ns;
+
+    for (uint32_t i = 0; i < BENCH_FIELDS; i++)
+    {
+        fn((uint8_t)i, out);
+        sink += (uint8_t)out[0];
+    }
+    ticks = BENCH_TICKS() - ticks;
+    ns = (double)(clock() - start) / CLOCKS_PER_SEC * 1e9 / BENCH_FIELDS;
+
+    printf("  %-28s %6.1f ns/field", name, ns);
+    if (ticks != 0)
+    {
+        printf("  %6.1f ticks/field", (double)ticks / BENCH_FIELDS);
+    }
+    printf("\n");
+}
+
+
+int main(void)
+{
+    test_conversions();
+
+    printf("node_printf per field (host):\n");
+    bench("binaryToAsciiHex",       ref_binaryToAsciiHex);
+    bench("node_snprintf \"%02X\"", fmt_hex);
+    bench("binaryToAsciiString",    ref_binaryToAsciiString);
+    bench("node_snprintf \"%u\"", fmt_dec);
+    return TEST_DONE();
+}
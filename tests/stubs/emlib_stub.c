@@ -0,0 +1,529 @@
+/*
+ * emlib_stub.c
+ *
+ * @brief Host stand-ins for the emlib calls and registers the firmware uses
+ * @description See emlib_stub.h. Most calls only record what they were given.
+ *              The ones a test can observe are modelled:
+ *
+ *              - USART TX: a byte written to TXDATA is taken by the "wire" the
+ *                next time anybody tests STATUS.TXBL, so code that polls TXBL
+ *                before each write (the TX interrupt, usart_tx_poll()) sends
+ *                bytes in order. sim_txbl_budget limits how many times TXBL
+ *                reads as set, to model a slow line. RXDATAV works the same
+ *                way with sim_rxdatav_budget.
+ *              - LDMA: a memory to TXDATA transfer finishes inside
+ *                LDMA_StartTransfer() and raises the channel's IF bit. On USART4
+ *                each byte goes through sim_spi_hook and the answer is written
+ *                where the matching RXDATA transfer points.
+ *              - Interrupts: CORE_ENTER_ATOMIC() masks everything. When the
+ *                outermost atomic section ends, sim_irq_hook runs - a test uses
+ *                it to call the handlers whose interrupt would be pending.
+ *                While it runs, every IRQ reads as blocked (equal priorities).
+ *              - I2C: I2C_TransferInit()/I2C_Transfer() ask sim_i2c_hook.
+ *              - IFC: a write to an IFC register can't be trapped, so it is
+ *                applied to IF by sim_sync(), which runs at every atomic
+ *                section edge, TXBL test and LDMA start, and before the
+ *                interrupt model.
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: JonathanStorey
+ *    Hardware: None (host build only)
+ *     Version: 1.0
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include "emlib_stub.h"
+#include "hw_timer.h"
+
+#define SIM_TXBL_BIT            (1u << 6)
+#define SIM_RXDATAV_BIT         (1u << 7)
+
+USART_TypeDef USART0_s, USART1_s, USART2_s, USART3_s, USART4_s, USART5_s, UART0_s, UART1_s;
+LDMA_TypeDef LDMA_s;
+I2C_TypeDef I2C0_s, I2C1_s;
+TIMER_TypeDef TIMER0_s, TIMER1_s, TIMER2_s, TIMER3_s;
+GPIO_TypeDef GPIO_s;
+CoreDebug_Type CoreDebug_s;
+DWT_Type DWT_s;
+uint32_t SystemCoreClock = 50000000;
+
+uint32_t sim_txbl_budget;
+uint32_t sim_rxdatav_budget;
+bool sim_irq_blocked[SIM_IRQ_COUNT];
+bool sim_irq_enabled[SIM_IRQ_COUNT];
+bool sim_irq_pending[SIM_IRQ_COUNT];
+void (*sim_irq_hook)(void);
+uint8_t (*sim_spi_hook)(uint8_t tx);
+sim_i2c_hook_t sim_i2c_hook;
+uint32_t sim_cycles;
+uint32_t sim_cycles_step;
+
+static USART_TypeDef *const sim_ports[] =
+{
+    USART0, USART1, USART2, USART3, USART4, USART5, UART0, UART1
+};
+#define SIM_PORT_COUNT          (sizeof(sim_ports) / sizeof(sim_ports[0]))
+
+static sim_wire_t sim_wires[SIM_PORT_COUNT];
+static uint32_t sim_atomic_depth;
+static bool sim_irq_running;
+static I2C_TransferSeq_TypeDef *sim_i2c_seq[2];
+static uint8_t *sim_spi_rx_dst;                 // where the USART4 RXDATA transfer writes
+static bool sim_spi_rx_inc;
+static int sim_spi_rx_ch = -1;
+static uint8_t sim_gpio_out[6];
+
+
+/*==============================================================================
+ * SIMULATION CONTROL
+ *============================================================================*/
+
+/**
+ * @brief Move anything waiting in a TXDATA register onto its wire
+ */
+static void sim_usart_collect(void)
+{
+    for (size_t i = 0; i < SIM_PORT_COUNT; i++)
+    {
+        USART_TypeDef *usart = sim_ports[i];
+
+        if (usart->TXDATA != SIM_TXDATA_EMPTY)
+        {
+            if (sim_wires[i].len < SIM_WIRE_SIZE)
+            {
+                sim_wires[i].data[sim_wires[i].len++] = (uint8_t)usart->TXDATA;
+            }
+            usart->TXDATA = SIM_TXDATA_EMPTY;
+        }
+    }
+}
+
+/**
+ * @brief Apply the write-1-to-clear registers (IFC) written since the last look
+ */
+void sim_sync(void)
+{
+    for (size_t i = 0; i < SIM_PORT_COUNT; i++)
+    {
+        sim_ports[i]->IF &= ~sim_ports[i]->IFC;
+        sim_ports[i]->IFC = 0;
+    }
+    LDMA->IF &= ~LDMA->IFC;
+    LDMA->IFC = 0;
+    GPIO->IF &= ~GPIO->IFC;
+    GPIO->IFC = 0;
+}
+
+uint32_t sim_usart_txbl(void)
+{
+    sim_sync();
+    sim_usart_collect();
+    if (sim_txbl_budget == 0)
+    {
+        return 0;
+    }
+    sim_txbl_budget--;
+    return SIM_TXBL_BIT;
+}
+
+uint32_t sim_usart_rxdatav(void)
+{
+    if (sim_rxdatav_budget == 0)
+    {
+        return 0;
+    }
+    sim_rxdatav_budget--;
+    return SIM_RXDATAV_BIT;
+}
+
+sim_wire_t *sim_wire(USART_TypeDef *usart)
+{
+    sim_usart_collect();
+    for (size_t i = 0; i < SIM_PORT_COUNT; i++)
+    {
+        if (sim_ports[i] == usart)
+        {
+            return &sim_wires[i];
+        }
+    }
+    return NULL;
+}
+
+bool sim_in_irq(void)
+{
+    return sim_irq_running;
+}
+
+/**
+ * @brief Put every register and hook back to power-on state
+ * @note NVIC enables are kept - drivers that initialise once (dma_init())
+ *       would not enable them again
+ */
+void sim_reset(void)
+{
+    for (size_t i = 0; i < SIM_PORT_COUNT; i++)
+    {
+        memset(sim_ports[i], 0, sizeof(USART_TypeDef));
+        sim_ports[i]->TXDATA = SIM_TXDATA_EMPTY;
+        sim_ports[i]->STATUS = SIM_TXBL_BIT | SIM_RXDATAV_BIT | USART_STATUS_TXC | USART_STATUS_TXIDLE;
+        sim_wires[i].len = 0;
+    }
+    memset(&LDMA_s, 0, sizeof(LDMA_s));
+    memset(&I2C0_s, 0, sizeof(I2C0_s));
+    memset(&I2C1_s, 0, sizeof(I2C1_s));
+    memset(sim_irq_blocked, 0, sizeof(sim_irq_blocked));
+    memset(sim_irq_pending, 0, sizeof(sim_irq_pending));
+    sim_txbl_budget = UINT32_MAX;
+    sim_rxdatav_budget = 0;
+    sim_irq_hook = NULL;
+    sim_spi_hook = NULL;
+    sim_i2c_hook = NULL;
+    sim_atomic_depth = 0;
+    sim_irq_running = false;
+    sim_spi_rx_dst = NULL;
+    sim_spi_rx_ch = -1;
+    sim_cycles = 0;
+    sim_cycles_step = 50;                       // 1 us per reading
+}
+
+/**
+ * @brief Run the test's interrupt model, as if interrupts had just been unmasked
+ */
+static void sim_irq_service(void)
+{
+    if (sim_irq_hook == NULL || sim_irq_running || sim_atomic_depth != 0)
+    {
+        return;
+    }
+    sim_sync();
+    sim_irq_running = true;
+    sim_irq_hook();
+    sim_irq_running = false;
+}
+
+
+/*==============================================================================
+ * CORE / NVIC
+ *============================================================================*/
+CORE_irqState_t CORE_EnterAtomic(void)
+{
+    sim_sync();
+    sim_atomic_depth++;
+    return 0;
+}
+
+void CORE_ExitAtomic(CORE_irqState_t state)
+{
+    (void)state;
+    sim_sync();
+    if (sim_atomic_depth > 0)
+    {
+        sim_atomic_depth--;
+    }
+    sim_irq_service();
+}
+
+CORE_irqState_t CORE_EnterCritical(void)
+{
+    return CORE_EnterAtomic();
+}
+
+void CORE_ExitCritical(CORE_irqState_t state)
+{
+    CORE_ExitAtomic(state);
+}
+
+bool CORE_InIrqContext(void)
+{
+    return sim_irq_running;
+}
+
+bool CORE_IrqIsBlocked(IRQn_Type irq)
+{
+    return sim_irq_blocked[irq] || sim_atomic_depth != 0 || sim_irq_running;
+}
+
+void NVIC_EnableIRQ(IRQn_Type irq)              { sim_irq_enabled[irq] = true; }
+void NVIC_DisableIRQ(IRQn_Type irq)             { sim_irq_enabled[irq] = false; }
+uint32_t NVIC_GetEnableIRQ(IRQn_Type irq)       { return sim_irq_enabled[irq]; }
+void NVIC_ClearPendingIRQ(IRQn_Type irq)        { sim_irq_pending[irq] = false; }
+void NVIC_SetPendingIRQ(IRQn_Type irq)          { sim_irq_pending[irq] = true; sim_irq_service(); }
+void NVIC_SetPriority(IRQn_Type irq, uint32_t priority) { (void)irq; (void)priority; }
+void __disable_irq(void)                        { sim_atomic_depth++; }
+void __enable_irq(void)                         { CORE_ExitAtomic(0); }
+void __WFI(void)                                { sim_irq_service(); }
+uint32_t __get_IPSR(void)                       { return sim_irq_running ? 16 : 0; }
+
+
+/*==============================================================================
+ * USART
+ *============================================================================*/
+void USART_InitAsync(USART_TypeDef *usart, const USART_InitAsync_TypeDef *init)
+{
+    usart->CLKDIV = init->baudrate;
+}
+
+void USART_InitSync(USART_TypeDef *usart, const USART_InitSync_TypeDef *init)
+{
+    usart->CLKDIV = init->baudrate;
+}
+
+void USART_Enable(USART_TypeDef *usart, USART_Enable_TypeDef enable)
+{
+    (void)usart;
+    (void)enable;
+}
+
+uint8_t USART_SpiTransfer(USART_TypeDef *usart, uint8_t data)
+{
+    if (usart == USART4 && sim_spi_hook != NULL)
+    {
+        return sim_spi_hook(data);
+    }
+    return 0;
+}
+
+void USART_Tx(USART_TypeDef *usart, uint8_t data)
+{
+    if (usart == USART4)
+    {
+        (void)USART_SpiTransfer(usart, data);
+        return;
+    }
+    usart->TXDATA = data;
+    sim_usart_collect();
+}
+
+void USART_TxExt(USART_TypeDef *usart, uint16_t data)
+{
+    USART_Tx(usart, (uint8_t)data);
+}
+
+uint8_t USART_Rx(USART_TypeDef *usart)
+{
+    return (uint8_t)usart->RXDATA;
+}
+
+uint16_t USART_RxDataXGet(USART_TypeDef *usart)
+{
+    return (uint16_t)usart->RXDATAX;
+}
+
+void USART_IntEnable(USART_TypeDef *usart, uint32_t flags)      { usart->IEN |= flags; }
+void USART_IntDisable(USART_TypeDef *usart, uint32_t flags)     { usart->IEN &= ~flags; }
+void USART_IntClear(USART_TypeDef *usart, uint32_t flags)       { usart->IF &= ~flags; }
+uint32_t USART_IntGet(USART_TypeDef *usart)                     { return usart->IF; }
+uint32_t USART_IntGetEnabled(USART_TypeDef *usart)              { return usart->IF & usart->IEN; }
+
+void USART_BaudrateAsyncSet(USART_TypeDef *usart, uint32_t refFreq, uint32_t baudrate, USART_OVS_TypeDef ovs)
+{
+    (void)refFreq;
+    (void)ovs;
+    usart->CLKDIV = baudrate;
+}
+
+void USART_BaudrateSyncSet(USART_TypeDef *usart, uint32_t refFreq, uint32_t baudrate)
+{
+    (void)refFreq;
+    usart->CLKDIV = baudrate;
+}
+
+uint32_t USART_BaudrateGet(USART_TypeDef *usart)
+{
+    return usart->CLKDIV;
+}
+
+uint32_t USART_BaudrateCalc(uint32_t refFreq, uint32_t clkdiv, bool syncmode, USART_OVS_TypeDef ovs)
+{
+    static const uint32_t oversample[] = { 16, 8, 6, 4 };
+
+    if (syncmode)
+    {
+        return (uint32_t)(((uint64_t)refFreq * 128) / (2 * (256 + (uint64_t)clkdiv)));
+    }
+    return (uint32_t)(((uint64_t)refFreq * 256) / (oversample[ovs] * (256 + (uint64_t)clkdiv)));
+}
+
+
+/*==============================================================================
+ * LDMA
+ *============================================================================*/
+void LDMA_Init(const LDMA_Init_t *init)
+{
+    (void)init;
+    sim_irq_enabled[LDMA_IRQn] = true;
+}
+
+/**
+ * @brief Run a transfer to completion: only memory to USART TXDATA moves
+ *        data, a USART4 RXDATA transfer is remembered for the SPI exchange
+ */
+void LDMA_StartTransfer(int ch, const LDMA_TransferCfg_t *cfg, const LDMA_Descriptor_t *desc)
+{
+    uint32_t count = desc->xfer.xferCnt + 1u;
+    const uint8_t *src = (const uint8_t *)(uintptr_t)desc->xfer.srcAddr;
+    (void)cfg;
+
+    sim_sync();
+    LDMA->CHDONE &= ~(1u << ch);
+    if (desc->xfer.doneIfs)
+    {
+        LDMA->IEN |= 1u << ch;
+    }
+
+    if (desc->xfer.srcAddr == (uint32_t)(uintptr_t)&USART4->RXDATA)
+    {
+        sim_spi_rx_dst = (uint8_t *)(uintptr_t)desc->xfer.dstAddr;
+        sim_spi_rx_inc = desc->xfer.dstInc != ldmaCtrlDstIncNone;
+        sim_spi_rx_ch = ch;
+        return;                                 // finishes with the TX side
+    }
+
+    if (desc->xfer.dstAddr == (uint32_t)(uintptr_t)&USART4->TXDATA)
+    {
+        for (uint32_t i = 0; i < count; i++)
+        {
+            uint8_t rx = USART_SpiTransfer(USART4, src[desc->xfer.srcInc != ldmaCtrlSrcIncNone ? i : 0]);
+
+            if (sim_spi_rx_dst != NULL)
+            {
+                sim_spi_rx_dst[sim_spi_rx_inc ? i : 0] = rx;
+            }
+        }
+        if (sim_spi_rx_ch >= 0)
+        {
+            LDMA->CHDONE |= 1u << sim_spi_rx_ch;
+            LDMA->IF |= 1u << sim_spi_rx_ch;
+            sim_spi_rx_ch = -1;
+            sim_spi_rx_dst = NULL;
+        }
+        LDMA->CHDONE |= 1u << ch;
+        LDMA->IF |= 1u << ch;
+        return;
+    }
+
+    for (size_t i = 0; i < SIM_PORT_COUNT; i++)
+    {
+        if (desc->xfer.dstAddr == (uint32_t)(uintptr_t)&sim_ports[i]->TXDATA)
+        {
+            sim_usart_collect();                // whatever the CPU wrote went first
+            for (uint32_t n = 0; n < count && sim_wires[i].len < SIM_WIRE_SIZE; n++)
+            {
+                sim_wires[i].data[sim_wires[i].len++] = src[n];
+            }
+            LDMA->CHDONE |= 1u << ch;
+            LDMA->IF |= 1u << ch;
+            return;
+        }
+    }
+}
+
+void LDMA_StopTransfer(int ch)                  { LDMA->CHDONE |= 1u << ch; }
+bool LDMA_TransferDone(int ch)                  { return (LDMA->CHDONE & (1u << ch)) != 0; }
+uint32_t LDMA_TransferRemainingCount(int ch)    { return LDMA_TransferDone(ch) ? 0 : 1; }
+void LDMA_IntClear(uint32_t flags)              { LDMA->IF &= ~flags; }
+void LDMA_IntEnable(uint32_t flags)             { LDMA->IEN |= flags; }
+uint32_t LDMA_IntGetEnabled(void)               { return LDMA->IF & LDMA->IEN; }
+
+
+/*==============================================================================
+ * I2C
+ *============================================================================*/
+void I2C_Init(I2C_TypeDef *i2c, const I2C_Init_TypeDef *init)   { (void)i2c; (void)init; }
+void I2C_Enable(I2C_TypeDef *i2c, bool enable)                  { (void)i2c; (void)enable; }
+void I2C_IntDisable(I2C_TypeDef *i2c, uint32_t flags)           { i2c->IEN &= ~flags; }
+void I2C_IntClear(I2C_TypeDef *i2c, uint32_t flags)             { i2c->IF &= ~flags; }
+
+void I2C_BusFreqSet(I2C_TypeDef *i2c, uint32_t refFreq, uint32_t freq, I2C_ClockHLR_TypeDef clhr)
+{
+    (void)refFreq;
+    (void)clhr;
+    i2c->CLKDIV = freq;
+}
+
+I2C_TransferReturn_TypeDef I2C_TransferInit(I2C_TypeDef *i2c, I2C_TransferSeq_TypeDef *seq)
+{
+    sim_i2c_seq[i2c == I2C1] = seq;
+    return sim_i2c_hook ? sim_i2c_hook(i2c, seq, true) : i2cTransferDone;
+}
+
+I2C_TransferReturn_TypeDef I2C_Transfer(I2C_TypeDef *i2c)
+{
+    return sim_i2c_hook ? sim_i2c_hook(i2c, sim_i2c_seq[i2c == I2C1], false) : i2cTransferDone;
+}
+
+
+/*==============================================================================
+ * TIMER, CMU, GPIO, EMU, CHIP
+ *============================================================================*/
+void TIMER_Init(TIMER_TypeDef *timer, const TIMER_Init_TypeDef *init)  { timer->CTRL = init->enable; }
+void TIMER_TopSet(TIMER_TypeDef *timer, uint32_t top)          { timer->TOP = top; }
+void TIMER_Enable(TIMER_TypeDef *timer, bool enable)           { timer->CTRL = enable; }
+void TIMER_IntEnable(TIMER_TypeDef *timer, uint32_t flags)     { timer->IEN |= flags; }
+void TIMER_IntClear(TIMER_TypeDef *timer, uint32_t flags)      { timer->IF &= ~flags; }
+void TIMER_CounterSet(TIMER_TypeDef *timer, uint32_t count)    { timer->CNT = count; }
+uint32_t TIMER_CounterGet(TIMER_TypeDef *timer)                { return timer->CNT; }
+
+void CMU_ClockEnable(CMU_Clock_TypeDef clock, bool enable)     { (void)clock; (void)enable; }
+uint32_t CMU_ClockFreqGet(CMU_Clock_TypeDef clock)             { (void)clock; return 50000000; }
+void CMU_HFXOInit(const CMU_HFXOInit_TypeDef *init)            { (void)init; }
+void CMU_OscillatorEnable(int osc, bool enable, bool wait)     { (void)osc; (void)enable; (void)wait; }
+void CMU_ClockSelectSet(int clock, int ref)                    { (void)clock; (void)ref; }
+void SystemHFXOClockSet(uint32_t freq)                         { (void)freq; }
+
+void GPIO_PinModeSet(GPIO_Port_TypeDef port, unsigned int pin, GPIO_Mode_TypeDef mode, unsigned int out)
+{
+    (void)mode;
+    if (out)
+    {
+        GPIO_PinOutSet(port, pin);
+    }
+    else
+    {
+        GPIO_PinOutClear(port, pin);
+    }
+}
+
+void GPIO_PinOutSet(GPIO_Port_TypeDef port, unsigned int pin)      { sim_gpio_out[port] |= (uint8_t)(1u << (pin & 7)); }
+void GPIO_PinOutClear(GPIO_Port_TypeDef port, unsigned int pin)    { sim_gpio_out[port] &= (uint8_t)~(1u << (pin & 7)); }
+void GPIO_PinOutToggle(GPIO_Port_TypeDef port, unsigned int pin)   { sim_gpio_out[port] ^= (uint8_t)(1u << (pin & 7)); }
+unsigned int GPIO_PinOutGet(GPIO_Port_TypeDef port, unsigned int pin) { return (sim_gpio_out[port] >> (pin & 7)) & 1u; }
+unsigned int GPIO_PinInGet(GPIO_Port_TypeDef port, unsigned int pin)  { return GPIO_PinOutGet(port, pin); }
+void GPIO_DriveStrengthSet(GPIO_Port_TypeDef port, GPIO_DriveStrength_TypeDef strength) { (void)port; (void)strength; }
+void GPIO_ExtIntConfig(GPIO_Port_TypeDef port, unsigned int pin, unsigned int intNo, bool risingEdge, bool fallingEdge, bool enable)
+{
+    (void)port;
+    (void)pin;
+    (void)risingEdge;
+    (void)fallingEdge;
+    if (enable)
+    {
+        GPIO->IEN |= 1u << intNo;
+    }
+}
+uint32_t GPIO_IntGet(void)                      { return GPIO->IF; }
+uint32_t GPIO_IntGetEnabled(void)               { return GPIO->IF & GPIO->IEN; }
+void GPIO_IntClear(uint32_t flags)              { GPIO->IF &= ~flags; }
+void GPIO_IntEnable(uint32_t flags)             { GPIO->IEN |= flags; }
+void GPIO_IntDisable(uint32_t flags)            { GPIO->IEN &= ~flags; }
+
+void EMU_EnterEM1(void)                         { sim_irq_service(); }
+void CHIP_Init(void)                            { }
+
+
+/*==============================================================================
+ * HW_TIMER
+ * Time only moves when somebody looks at it: every hw_timer_cycles() call is
+ * sim_cycles_step cycles later, and the delays jump straight to their end.
+ *============================================================================*/
+void hw_timer_cycles_init(void)                 { }
+uint32_t hw_timer_cycles(void)                  { return sim_cycles += sim_cycles_step; }
+uint32_t hw_timer_cycles_to_ns(uint32_t cycles) { return cycles * 20; }
+void hw_timer0_us(uint32_t delay_us)            { sim_cycles += delay_us * 50; }
+void hw_timer0_us_short(uint32_t delay_us)      { sim_cycles += delay_us * 50; }
+void hw_timer1_ms(uint32_t delay_ms)            { sim_cycles += delay_ms * 50000; }
+void hw_timer1_single_ms(void)                  { hw_timer1_ms(1); }
+void hw_timer1_second(void)                     { hw_timer1_ms(1000); }
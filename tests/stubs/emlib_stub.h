@@ -0,0 +1,568 @@
+/*
+ * emlib_stub.h
+ *
+ * @brief Just enough of the EFM32GG11B device headers and emlib to build the
+ *        firmware modules on a host PC
+ * @description Every em_*.h in this directory includes this file. Registers
+ *              are plain structs in RAM (emlib_stub.c defines them), so code
+ *              under test reads and writes them as usual and the test looks
+ *              at them afterwards. A few hooks (sim_*) let a test stand in for
+ *              the hardware: the USART transmit buffer, the LDMA, the I2C
+ *              state machine, the SPI bus and the interrupt mask.
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: JonathanStorey
+ *    Hardware: None (host build only)
+ *     Version: 1.0
+ */
+
+#ifndef EMLIB_STUB_H_
+#define EMLIB_STUB_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*==============================================================================
+ * INTERRUPTS
+ *============================================================================*/
+typedef enum {
+    USART0_RX_IRQn = 0, USART0_TX_IRQn, USART1_RX_IRQn, USART1_TX_IRQn,
+    USART2_RX_IRQn, USART2_TX_IRQn, USART3_RX_IRQn, USART3_TX_IRQn,
+    USART4_RX_IRQn, USART4_TX_IRQn, USART5_RX_IRQn, USART5_TX_IRQn,
+    UART0_RX_IRQn, UART0_TX_IRQn, UART1_RX_IRQn, UART1_TX_IRQn,
+    I2C0_IRQn, I2C1_IRQn, LDMA_IRQn, GPIO_ODD_IRQn, GPIO_EVEN_IRQn,
+    TIMER0_IRQn, TIMER1_IRQn, TIMER2_IRQn, TIMER3_IRQn,
+    SIM_IRQ_COUNT
+} IRQn_Type;
+
+void NVIC_EnableIRQ(IRQn_Type irq);
+void NVIC_DisableIRQ(IRQn_Type irq);
+uint32_t NVIC_GetEnableIRQ(IRQn_Type irq);
+void NVIC_ClearPendingIRQ(IRQn_Type irq);
+void NVIC_SetPendingIRQ(IRQn_Type irq);
+void NVIC_SetPriority(IRQn_Type irq, uint32_t priority);
+void __disable_irq(void);
+void __enable_irq(void);
+void __WFI(void);
+uint32_t __get_IPSR(void);
+
+typedef uint32_t CORE_irqState_t;
+#define CORE_DECLARE_IRQ_STATE          CORE_irqState_t irqState
+#define CORE_ENTER_ATOMIC()             irqState = CORE_EnterAtomic()
+#define CORE_EXIT_ATOMIC()              CORE_ExitAtomic(irqState)
+#define CORE_ENTER_CRITICAL()           irqState = CORE_EnterCritical()
+#define CORE_EXIT_CRITICAL()            CORE_ExitCritical(irqState)
+#define CORE_ATOMIC_SECTION(yourcode)   { CORE_DECLARE_IRQ_STATE; CORE_ENTER_ATOMIC(); { yourcode } CORE_EXIT_ATOMIC(); }
+CORE_irqState_t CORE_EnterAtomic(void);
+void CORE_ExitAtomic(CORE_irqState_t state);
+CORE_irqState_t CORE_EnterCritical(void);
+void CORE_ExitCritical(CORE_irqState_t state);
+bool CORE_InIrqContext(void);
+bool CORE_IrqIsBlocked(IRQn_Type irq);
+
+/*==============================================================================
+ * USART
+ *============================================================================*/
+typedef struct {
+    volatile uint32_t CTRL, FRAME, TRIGCTRL, CMD, STATUS, CLKDIV;
+    volatile uint32_t RXDATAX, RXDATA, RXDOUBLEX, RXDOUBLE, RXDATAXP, RXDOUBLEXP;
+    volatile uint32_t TXDATAX, TXDATA, TXDOUBLEX, TXDOUBLE;
+    volatile uint32_t IF, IFS, IFC, IEN, IRCTRL, INPUT, I2SCTRL, TIMING, CTRLX;
+    volatile uint32_t TIMECMP0, TIMECMP1, TIMECMP2, ROUTEPEN, ROUTELOC0, ROUTELOC1;
+} USART_TypeDef;
+
+extern USART_TypeDef USART0_s, USART1_s, USART2_s, USART3_s, USART4_s, USART5_s, UART0_s, UART1_s;
+#define USART0                  (&USART0_s)
+#define USART1                  (&USART1_s)
+#define USART2                  (&USART2_s)
+#define USART3                  (&USART3_s)
+#define USART4                  (&USART4_s)
+#define USART5                  (&USART5_s)
+#define UART0                   (&UART0_s)
+#define UART1                   (&UART1_s)
+
+#define SIM_TXDATA_EMPTY        0xFFFFFFFFu     ///< TXDATA holds nothing the wire hasn't taken
+
+/**
+ * @brief Simulated TX buffer: each test of STATUS.TXBL first moves whatever
+ *        was written to TXDATA onto that port's wire log, then reports room
+ *        while sim_txbl_budget lasts
+ */
+uint32_t sim_usart_txbl(void);
+#define USART_STATUS_TXBL       (sim_usart_txbl())
+
+/**
+ * @brief Simulated receiver: STATUS.RXDATAV reads as set sim_rxdatav_budget
+ *        times - a test loads RXDATA, sets the budget to 1 and runs the RX
+ *        interrupt handler
+ */
+uint32_t sim_usart_rxdatav(void);
+#define USART_STATUS_RXDATAV    (sim_usart_rxdatav())
+#define USART_STATUS_TXC        (1u << 5)
+#define USART_STATUS_RXFULL     (1u << 8)
+#define USART_STATUS_TXIDLE     (1u << 13)
+
+#define USART_IEN_TXC           (1u << 0)
+#define USART_IEN_TXBL          (1u << 1)
+#define USART_IEN_RXDATAV       (1u << 2)
+#define USART_IEN_RXFULL        (1u << 3)
+#define USART_IEN_RXOF          (1u << 4)
+#define USART_IEN_PERR          (1u << 8)
+#define USART_IEN_FERR          (1u << 9)
+#define USART_IEN_MPAF          (1u << 10)
+#define USART_IEN_TCMP0         (1u << 14)
+#define USART_IEN_TCMP1         (1u << 15)
+#define USART_IF_TXC            USART_IEN_TXC
+#define USART_IF_TXBL           USART_IEN_TXBL
+#define USART_IF_RXDATAV        USART_IEN_RXDATAV
+#define USART_IF_RXOF           USART_IEN_RXOF
+#define USART_IF_PERR           USART_IEN_PERR
+#define USART_IF_FERR           USART_IEN_FERR
+#define USART_IF_MPAF           USART_IEN_MPAF
+#define USART_IF_TCMP0          USART_IEN_TCMP0
+#define USART_IFC_TCMP0         USART_IEN_TCMP0
+#define USART_IF_TCMP1          USART_IEN_TCMP1
+#define USART_IFC_TCMP1         USART_IEN_TCMP1
+#define _USART_IFC_MASK         0xFFFFFFFFu
+
+#define USART_CMD_RXEN          (1u << 0)
+#define USART_CMD_TXEN          (1u << 2)
+#define USART_CMD_RXBLOCKEN     (1u << 3)
+#define USART_CMD_RXBLOCKDIS    (1u << 4)
+#define USART_CMD_TXTRIEN       (1u << 8)
+#define USART_CMD_TXTRIDIS      (1u << 9)
+#define USART_CMD_CLEARTX       (1u << 10)
+#define USART_CMD_CLEARRX       (1u << 11)
+#define USART_CTRL_MPM          (1u << 3)
+#define USART_CTRL_MPAB         (1u << 4)
+#define _USART_CTRL_OVS_SHIFT   5
+#define _USART_CTRL_OVS_MASK    (3u << 5)
+#define USART_CTRL_TXBIL        (1u << 14)
+#define USART_CTRL_CSINV        (1u << 15)
+#define USART_CTRL_AUTOCS       (1u << 16)
+#define USART_CTRL_AUTOTRI      (1u << 17)
+#define USART_CTRL_BIT8DV       (1u << 29)
+#define USART_CTRL_AUTOTX       (1u << 31)
+#define USART_FRAME_DATABITS_EIGHT  5u
+#define USART_FRAME_DATABITS_NINE   6u
+#define _USART_FRAME_DATABITS_MASK  0xFu
+#define _USART_FRAME_PARITY_SHIFT   8
+#define _USART_FRAME_PARITY_MASK    (3u << 8)
+#define _USART_FRAME_STOPBITS_SHIFT 12
+#define _USART_FRAME_STOPBITS_MASK  (3u << 12)
+#define USART_TXDATAX_UBRXAT    (1u << 11)
+#define _USART_RXDATAX_RXDATA_SHIFT 0
+#define _USART_RXDATAX_RXDATA_MASK  0x1FFu
+#define USART_RXDATAX_PERR      (1u << 14)
+#define USART_RXDATAX_FERR      (1u << 15)
+#define USART_TIMECMP0_TSTART_RXEOF (1u << 16)
+#define USART_TIMECMP0_TSTOP_RXACT  (1u << 21)
+#define USART_TIMECMP0_RESTARTEN    (1u << 24)
+#define _USART_TIMECMP0_TCMPVAL_SHIFT 0
+#define _USART_TIMECMP0_TCMPVAL_MASK  0xFFu
+#define USART_TIMECMP1_TSTART_TXEOF (1u << 16)
+#define USART_TIMECMP1_TSTOP_TXST   (1u << 20)
+#define USART_TIMECMP1_RESTARTEN    (1u << 24)
+#define _USART_TIMECMP1_TCMPVAL_SHIFT 0
+#define USART_ROUTELOC0_RXLOC_LOC0  0
+#define USART_ROUTELOC0_RXLOC_LOC1  1
+#define USART_ROUTELOC0_RXLOC_LOC2  2
+#define USART_ROUTELOC0_RXLOC_LOC3  3
+#define USART_ROUTELOC0_RXLOC_LOC5  5
+#define USART_ROUTELOC0_TXLOC_LOC0  0
+#define USART_ROUTELOC0_TXLOC_LOC1  1
+#define USART_ROUTELOC0_TXLOC_LOC2  2
+#define USART_ROUTELOC0_TXLOC_LOC3  3
+#define USART_ROUTELOC0_TXLOC_LOC5  5
+#define USART_ROUTELOC0_CLKLOC_LOC0 0
+#define _USART_ROUTELOC0_CSLOC_SHIFT 16
+#define _USART_ROUTELOC0_CSLOC_MASK  (0x3Fu << 16)
+#define USART_ROUTEPEN_TXPEN    1u
+#define USART_ROUTEPEN_RXPEN    2u
+#define USART_ROUTEPEN_CLKPEN   4u
+#define USART_ROUTEPEN_CSPEN    8u
+
+typedef enum { usartDisable, usartEnableRx, usartEnableTx, usartEnable } USART_Enable_TypeDef;
+typedef enum { usartOVS16, usartOVS8, usartOVS6, usartOVS4 } USART_OVS_TypeDef;
+typedef enum { usartDatabits7 = 7, usartDatabits8 = 8, usartDatabits9 = 9 } USART_Databits_TypeDef;
+typedef enum { usartNoParity, usartEvenParity, usartOddParity } USART_Parity_TypeDef;
+typedef enum { usartStopbits0p5, usartStopbits1, usartStopbits1p5, usartStopbits2 } USART_Stopbits_TypeDef;
+typedef enum { usartHwFlowControlNone } USART_HwFlowControl_TypeDef;
+typedef enum { usartClockMode0 } USART_ClockMode_TypeDef;
+typedef enum { usartPrsRxCh0 } USART_PRS_Channel_t;
+
+typedef struct {
+    USART_Enable_TypeDef enable;
+    uint32_t refFreq;
+    uint32_t baudrate;
+    USART_OVS_TypeDef oversampling;
+    USART_Databits_TypeDef databits;
+    USART_Parity_TypeDef parity;
+    USART_Stopbits_TypeDef stopbits;
+    bool mvdis;
+    bool prsRxEnable;
+    USART_PRS_Channel_t prsRxCh;
+    bool autoCsEnable;
+    bool csInv;
+    uint8_t autoCsHold;
+    uint8_t autoCsSetup;
+    USART_HwFlowControl_TypeDef hwFlowControl;
+} USART_InitAsync_TypeDef;
+
+typedef struct {
+    USART_Enable_TypeDef enable;
+    uint32_t refFreq;
+    uint32_t baudrate;
+    USART_Databits_TypeDef databits;
+    bool master;
+    bool msbf;
+    USART_ClockMode_TypeDef clockMode;
+    bool prsRxEnable;
+    USART_PRS_Channel_t prsRxCh;
+    bool autoTx;
+    bool autoCsEnable;
+    bool csInv;
+    uint8_t autoCsHold;
+    uint8_t autoCsSetup;
+} USART_InitSync_TypeDef;
+
+void USART_InitAsync(USART_TypeDef *usart, const USART_InitAsync_TypeDef *init);
+void USART_InitSync(USART_TypeDef *usart, const USART_InitSync_TypeDef *init);
+void USART_Enable(USART_TypeDef *usart, USART_Enable_TypeDef enable);
+void USART_Tx(USART_TypeDef *usart, uint8_t data);
+void USART_TxExt(USART_TypeDef *usart, uint16_t data);
+uint8_t USART_Rx(USART_TypeDef *usart);
+uint16_t USART_RxDataXGet(USART_TypeDef *usart);
+uint8_t USART_SpiTransfer(USART_TypeDef *usart, uint8_t data);
+void USART_IntEnable(USART_TypeDef *usart, uint32_t flags);
+void USART_IntDisable(USART_TypeDef *usart, uint32_t flags);
+void USART_IntClear(USART_TypeDef *usart, uint32_t flags);
+uint32_t USART_IntGet(USART_TypeDef *usart);
+uint32_t USART_IntGetEnabled(USART_TypeDef *usart);
+void USART_BaudrateAsyncSet(USART_TypeDef *usart, uint32_t refFreq, uint32_t baudrate, USART_OVS_TypeDef ovs);
+void USART_BaudrateSyncSet(USART_TypeDef *usart, uint32_t refFreq, uint32_t baudrate);
+uint32_t USART_BaudrateGet(USART_TypeDef *usart);
+uint32_t USART_BaudrateCalc(uint32_t refFreq, uint32_t clkdiv, bool syncmode, USART_OVS_TypeDef ovs);
+
+/*==============================================================================
+ * LDMA
+ *============================================================================*/
+#define DMA_CHAN_COUNT          24
+
+typedef struct {
+    volatile uint32_t REQSEL, CFG, LOOP, CTRL, SRC, DST, LINK;
+} LDMA_CH_TypeDef;
+
+typedef struct {
+    volatile uint32_t CTRL, STATUS, SYNC, CHEN, CHBUSY, CHDONE, DBGHALT, SWREQ;
+    volatile uint32_t REQDIS, REQPEND, LINKLOAD, REQCLEAR, IF, IFS, IFC, IEN;
+    LDMA_CH_TypeDef CH[DMA_CHAN_COUNT];
+} LDMA_TypeDef;
+
+extern LDMA_TypeDef LDMA_s;
+#define LDMA                    (&LDMA_s)
+#define _LDMA_CH_CTRL_XFERCNT_SHIFT 4
+#define _LDMA_CH_CTRL_XFERCNT_MASK  (0x7FFu << 4)
+#define LDMA_IF_ERROR           (1u << 31)
+
+typedef enum {
+    ldmaPeripheralSignal_NONE,
+    ldmaPeripheralSignal_USART0_TXBL, ldmaPeripheralSignal_USART0_RXDATAV,
+    ldmaPeripheralSignal_USART1_TXBL, ldmaPeripheralSignal_USART1_RXDATAV,
+    ldmaPeripheralSignal_USART2_TXBL, ldmaPeripheralSignal_USART2_RXDATAV,
+    ldmaPeripheralSignal_USART3_TXBL, ldmaPeripheralSignal_USART3_RXDATAV,
+    ldmaPeripheralSignal_USART4_TXBL, ldmaPeripheralSignal_USART4_RXDATAV,
+    ldmaPeripheralSignal_USART5_TXBL, ldmaPeripheralSignal_USART5_RXDATAV,
+    ldmaPeripheralSignal_UART0_TXBL, ldmaPeripheralSignal_UART0_RXDATAV,
+    ldmaPeripheralSignal_UART1_TXBL, ldmaPeripheralSignal_UART1_RXDATAV
+} LDMA_PeripheralSignal_t;
+
+enum { ldmaCtrlSrcIncOne = 0, ldmaCtrlSrcIncNone = 3, ldmaCtrlDstIncOne = 0, ldmaCtrlDstIncNone = 3 };
+
+typedef union {
+    struct {
+        uint32_t structType : 2;
+        uint32_t reserved0 : 1;
+        uint32_t structReq : 1;
+        uint32_t xferCnt : 11;
+        uint32_t byteSwap : 1;
+        uint32_t blockSize : 4;
+        uint32_t doneIfs : 1;
+        uint32_t reqMode : 1;
+        uint32_t decLoopCnt : 1;
+        uint32_t ignoreSrec : 1;
+        uint32_t srcInc : 2;
+        uint32_t size : 2;
+        uint32_t dstInc : 2;
+        uint32_t srcAddrMode : 1;
+        uint32_t dstAddrMode : 1;
+        uint32_t srcAddr;
+        uint32_t dstAddr;
+        uint32_t linkMode : 1;
+        uint32_t link : 1;
+        int32_t linkAddr : 30;
+    } xfer;
+} LDMA_Descriptor_t;
+
+typedef struct {
+    uint32_t ldmaReqSel;
+    uint8_t ldmaCtrlSyncPrsClrOff, ldmaCtrlSyncPrsClrOn, ldmaCtrlSyncPrsSetOff, ldmaCtrlSyncPrsSetOn;
+    bool ldmaReqDis;
+    bool ldmaDbgHalt;
+    uint8_t ldmaCfgArbSlots, ldmaCfgSrcIncSign, ldmaCfgDstIncSign, ldmaLoopCnt;
+} LDMA_TransferCfg_t;
+
+typedef struct {
+    uint8_t ldmaInitCtrlNumFixed, ldmaInitCtrlSyncPrsClrEn, ldmaInitCtrlSyncPrsSetEn, ldmaInitIrqPriority;
+} LDMA_Init_t;
+
+#define LDMA_INIT_DEFAULT       { 0, 0, 0, 3 }
+#define LDMA_TRANSFER_CFG_PERIPHERAL(signal) \
+    { (uint32_t)(signal), 0, 0, 0, 0, false, false, 0, 0, 0, 0 }
+#define LDMA_DESCRIPTOR_SINGLE_M2P_BYTE(src, dest, count) \
+    { .xfer = { .xferCnt = (count) - 1, .doneIfs = 1, .dstInc = ldmaCtrlDstIncNone, \
+                .srcAddr = (uint32_t)(uintptr_t)(src), .dstAddr = (uint32_t)(uintptr_t)(dest) } }
+#define LDMA_DESCRIPTOR_SINGLE_P2M_BYTE(src, dest, count) \
+    { .xfer = { .xferCnt = (count) - 1, .doneIfs = 1, .srcInc = ldmaCtrlSrcIncNone, \
+                .srcAddr = (uint32_t)(uintptr_t)(src), .dstAddr = (uint32_t)(uintptr_t)(dest) } }
+#define LDMA_DESCRIPTOR_LINKREL_M2P_BYTE(src, dest, count, linkjmp) \
+    { .xfer = { .xferCnt = (count) - 1, .dstInc = ldmaCtrlDstIncNone, \
+                .srcAddr = (uint32_t)(uintptr_t)(src), .dstAddr = (uint32_t)(uintptr_t)(dest), \
+                .link = 1, .linkAddr = (linkjmp) * 4 } }
+#define LDMA_DESCRIPTOR_LINKREL_P2M_BYTE(src, dest, count, linkjmp) \
+    { .xfer = { .xferCnt = (count) - 1, .srcInc = ldmaCtrlSrcIncNone, \
+                .srcAddr = (uint32_t)(uintptr_t)(src), .dstAddr = (uint32_t)(uintptr_t)(dest), \
+                .link = 1, .linkAddr = (linkjmp) * 4 } }
+
+void LDMA_Init(const LDMA_Init_t *init);
+void LDMA_StartTransfer(int ch, const LDMA_TransferCfg_t *cfg, const LDMA_Descriptor_t *desc);
+void LDMA_StopTransfer(int ch);
+bool LDMA_TransferDone(int ch);
+uint32_t LDMA_TransferRemainingCount(int ch);
+void LDMA_IntClear(uint32_t flags);
+void LDMA_IntEnable(uint32_t flags);
+uint32_t LDMA_IntGetEnabled(void);
+
+/*==============================================================================
+ * I2C
+ *============================================================================*/
+typedef struct {
+    volatile uint32_t CTRL, CMD, STATE, STATUS, CLKDIV, SADDR, SADDRMASK;
+    volatile uint32_t RXDATA, RXDOUBLE, RXDATAP, RXDOUBLEP, TXDATA, TXDOUBLE;
+    volatile uint32_t IF, IFS, IFC, IEN, ROUTEPEN, ROUTELOC0;
+} I2C_TypeDef;
+
+extern I2C_TypeDef I2C0_s, I2C1_s;
+#define I2C0                    (&I2C0_s)
+#define I2C1                    (&I2C1_s)
+#define I2C_STATE_BUSY          1u
+#define I2C_STATUS_PSTOP        1u
+#define I2C_CMD_ABORT           1u
+#define I2C_CMD_START           2u
+#define I2C_CMD_STOP            4u
+#define I2C_CMD_NACK            8u
+#define _I2C_IFC_MASK           0xFFFFFFFFu
+#define _I2C_IEN_MASK           0xFFFFFFFFu
+#define I2C_IF_ACK              1u
+#define I2C_IF_RXDATAV          2u
+#define I2C_IF_NACK             4u
+#define I2C_IF_MSTOP            8u
+#define I2C_IF_TXBL             16u
+#define I2C_IF_ARBLOST          (1u << 9)
+#define I2C_IF_BUSERR           (1u << 10)
+#define I2C_IF_CLTO             (1u << 16)
+#define I2C_IF_BUSHOLD          (1u << 17)
+#define I2C_IEN_ACK             I2C_IF_ACK
+#define I2C_IEN_RXDATAV         I2C_IF_RXDATAV
+#define I2C_IEN_NACK            I2C_IF_NACK
+#define I2C_IEN_MSTOP           I2C_IF_MSTOP
+#define I2C_CTRL_CLTO_1024PCC   (5u << 16)
+#define _I2C_CTRL_CLTO_MASK     (7u << 16)
+#define I2C_ROUTELOC0_SCLLOC_LOC1 1u
+#define I2C_ROUTELOC0_SDALOC_LOC1 1u
+#define I2C_ROUTEPEN_SCLPEN     1u
+#define I2C_ROUTEPEN_SDAPEN     2u
+#define I2C_FLAG_WRITE          1u
+#define I2C_FLAG_READ           2u
+#define I2C_FLAG_WRITE_READ     4u
+#define I2C_FLAG_WRITE_WRITE    8u
+#define I2C_FREQ_STANDARD_MAX   100000
+#define I2C_FREQ_FAST_MAX       392157
+
+typedef enum {
+    i2cTransferInProgress = 1,
+    i2cTransferDone = 0,
+    i2cTransferNack = -1,
+    i2cTransferBusErr = -2,
+    i2cTransferArbLost = -3,
+    i2cTransferUsageFault = -4,
+    i2cTransferSwFault = -5
+} I2C_TransferReturn_TypeDef;
+
+typedef struct {
+    uint16_t addr;
+    uint16_t flags;
+    struct {
+        uint8_t *data;
+        uint16_t len;
+    } buf[2];
+} I2C_TransferSeq_TypeDef;
+
+typedef enum { i2cClockHLRStandard, i2cClockHLRAsymetric, i2cClockHLRFast } I2C_ClockHLR_TypeDef;
+
+typedef struct {
+    bool enable;
+    bool master;
+    uint32_t refFreq;
+    uint32_t freq;
+    I2C_ClockHLR_TypeDef clhr;
+} I2C_Init_TypeDef;
+
+#define I2C_INIT_DEFAULT        { true, true, 0, I2C_FREQ_STANDARD_MAX, i2cClockHLRStandard }
+
+void I2C_Init(I2C_TypeDef *i2c, const I2C_Init_TypeDef *init);
+void I2C_Enable(I2C_TypeDef *i2c, bool enable);
+void I2C_BusFreqSet(I2C_TypeDef *i2c, uint32_t refFreq, uint32_t freq, I2C_ClockHLR_TypeDef clhr);
+void I2C_IntDisable(I2C_TypeDef *i2c, uint32_t flags);
+void I2C_IntClear(I2C_TypeDef *i2c, uint32_t flags);
+I2C_TransferReturn_TypeDef I2C_TransferInit(I2C_TypeDef *i2c, I2C_TransferSeq_TypeDef *seq);
+I2C_TransferReturn_TypeDef I2C_Transfer(I2C_TypeDef *i2c);
+
+/*==============================================================================
+ * TIMER, CMU, GPIO, EMU, CHIP
+ *============================================================================*/
+typedef struct {
+    volatile uint32_t CTRL, CMD, STATUS, TOP, CNT, IF, IFC, IEN, ROUTELOC0, ROUTEPEN;
+} TIMER_TypeDef;
+
+extern TIMER_TypeDef TIMER0_s, TIMER1_s, TIMER2_s, TIMER3_s;
+#define TIMER0                  (&TIMER0_s)
+#define TIMER1                  (&TIMER1_s)
+#define TIMER2                  (&TIMER2_s)
+#define TIMER3                  (&TIMER3_s)
+#define TIMER_IF_OF             1u
+#define TIMER_IEN_OF            1u
+
+typedef enum { timerPrescale1, timerPrescale64, timerPrescale1024 } TIMER_Prescale_TypeDef;
+
+typedef struct {
+    bool enable;
+    TIMER_Prescale_TypeDef prescale;
+} TIMER_Init_TypeDef;
+
+#define TIMER_INIT_DEFAULT      { true, timerPrescale1 }
+
+void TIMER_Init(TIMER_TypeDef *timer, const TIMER_Init_TypeDef *init);
+void TIMER_TopSet(TIMER_TypeDef *timer, uint32_t top);
+void TIMER_Enable(TIMER_TypeDef *timer, bool enable);
+void TIMER_IntEnable(TIMER_TypeDef *timer, uint32_t flags);
+void TIMER_IntClear(TIMER_TypeDef *timer, uint32_t flags);
+void TIMER_CounterSet(TIMER_TypeDef *timer, uint32_t count);
+uint32_t TIMER_CounterGet(TIMER_TypeDef *timer);
+
+typedef enum {
+    cmuClock_HF, cmuClock_CORE, cmuClock_HFPER, cmuClock_GPIO, cmuClock_LDMA,
+    cmuClock_I2C0, cmuClock_I2C1, cmuClock_TIMER0, cmuClock_TIMER1, cmuClock_TIMER2, cmuClock_TIMER3,
+    cmuClock_USART0, cmuClock_USART1, cmuClock_USART2, cmuClock_USART3, cmuClock_USART4, cmuClock_USART5,
+    cmuClock_UART0, cmuClock_UART1
+} CMU_Clock_TypeDef;
+
+void CMU_ClockEnable(CMU_Clock_TypeDef clock, bool enable);
+uint32_t CMU_ClockFreqGet(CMU_Clock_TypeDef clock);
+
+typedef enum { gpioPortA, gpioPortB, gpioPortC, gpioPortD, gpioPortE, gpioPortF } GPIO_Port_TypeDef;
+typedef enum {
+    gpioModeDisabled, gpioModeInput, gpioModeInputPull, gpioModePushPull, gpioModePushPullAlternate,
+    gpioModeWiredAndPullUpFilter, gpioModeWiredAndAlternatePullUpFilter
+} GPIO_Mode_TypeDef;
+typedef enum {
+    gpioDriveStrengthWeakAlternateWeak, gpioDriveStrengthWeakAlternateStrong,
+    gpioDriveStrengthStrongAlternateStrong, gpioDriveStrengthStrongAlternateWeak
+} GPIO_DriveStrength_TypeDef;
+
+void GPIO_PinModeSet(GPIO_Port_TypeDef port, unsigned int pin, GPIO_Mode_TypeDef mode, unsigned int out);
+void GPIO_PinOutSet(GPIO_Port_TypeDef port, unsigned int pin);
+void GPIO_PinOutClear(GPIO_Port_TypeDef port, unsigned int pin);
+void GPIO_PinOutToggle(GPIO_Port_TypeDef port, unsigned int pin);
+unsigned int GPIO_PinInGet(GPIO_Port_TypeDef port, unsigned int pin);
+unsigned int GPIO_PinOutGet(GPIO_Port_TypeDef port, unsigned int pin);
+void GPIO_DriveStrengthSet(GPIO_Port_TypeDef port, GPIO_DriveStrength_TypeDef strength);
+void GPIO_ExtIntConfig(GPIO_Port_TypeDef port, unsigned int pin, unsigned int intNo, bool risingEdge, bool fallingEdge, bool enable);
+uint32_t GPIO_IntGet(void);
+uint32_t GPIO_IntGetEnabled(void);
+void GPIO_IntClear(uint32_t flags);
+void GPIO_IntEnable(uint32_t flags);
+void GPIO_IntDisable(uint32_t flags);
+
+typedef struct {
+    int ctuneStartup, ctuneSteadyState;
+} CMU_HFXOInit_TypeDef;
+
+#define CMU_HFXOINIT_DEFAULT    { 0, 0 }
+enum { cmuOsc_HFXO, cmuSelect_HFXO };
+
+void CMU_HFXOInit(const CMU_HFXOInit_TypeDef *init);
+void CMU_OscillatorEnable(int osc, bool enable, bool wait);
+void CMU_ClockSelectSet(int clock, int ref);
+void SystemHFXOClockSet(uint32_t freq);
+extern uint32_t SystemCoreClock;
+
+typedef struct {
+    volatile uint32_t IF, IFC, IEN, EXTIPSELL, EXTIRISE, EXTIFALL;
+} GPIO_TypeDef;
+
+extern GPIO_TypeDef GPIO_s;
+#define GPIO                    (&GPIO_s)
+
+typedef struct {
+    volatile uint32_t DEMCR;
+} CoreDebug_Type;
+
+typedef struct {
+    volatile uint32_t CTRL, CYCCNT;
+} DWT_Type;
+
+extern CoreDebug_Type CoreDebug_s;
+extern DWT_Type DWT_s;
+#define CoreDebug               (&CoreDebug_s)
+#define DWT                     (&DWT_s)
+#define CoreDebug_DEMCR_TRCENA_Msk  (1u << 24)
+#define DWT_CTRL_CYCCNTENA_Msk      1u
+
+void EMU_EnterEM1(void);
+void CHIP_Init(void);
+
+/*==============================================================================
+ * SIMULATION HOOKS (emlib_stub.c)
+ *============================================================================*/
+#define SIM_WIRE_SIZE           8192
+
+typedef struct {
+    uint8_t data[SIM_WIRE_SIZE];
+    uint32_t len;
+} sim_wire_t;
+
+/**
+ * @brief I2C bus model, called by I2C_TransferInit() (start = true) and by
+ *        every I2C_Transfer() after it (start = false) - return the emlib status
+ */
+typedef I2C_TransferReturn_TypeDef (*sim_i2c_hook_t)(I2C_TypeDef *i2c, I2C_TransferSeq_TypeDef *seq, bool start);
+
+extern uint32_t sim_txbl_budget;                ///< TXBL checks that still report room
+extern uint32_t sim_rxdatav_budget;             ///< RXDATAV checks that still report a byte
+extern bool sim_irq_blocked[SIM_IRQ_COUNT];     ///< Forces CORE_IrqIsBlocked() true for an IRQ
+extern bool sim_irq_enabled[SIM_IRQ_COUNT];     ///< Set by NVIC_EnableIRQ()
+extern bool sim_irq_pending[SIM_IRQ_COUNT];     ///< Set by NVIC_SetPendingIRQ(), for the interrupt model to clear
+extern void (*sim_irq_hook)(void);              ///< Runs "pending interrupts" whenever interrupts are unmasked
+extern uint8_t (*sim_spi_hook)(uint8_t tx);     ///< USART4 byte exchange (NULL: reads 0)
+extern sim_i2c_hook_t sim_i2c_hook;             ///< NULL: every transfer ACKs at once
+extern uint32_t sim_cycles;                     ///< hw_timer_cycles(), 50 MHz
+extern uint32_t sim_cycles_step;                ///< Added to sim_cycles by every hw_timer_cycles() call
+
+sim_wire_t *sim_wire(USART_TypeDef *usart);
+void sim_sync(void);
+bool sim_in_irq(void);
+void sim_reset(void);
+
+#endif /* EMLIB_STUB_H_ */
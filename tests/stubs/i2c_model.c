@@ -0,0 +1,159 @@
+/*
+ * i2c_model.c
+ *
+ * @brief Register-file I2C devices behind the stubbed I2C0 and I2C1
+ * @description See i2c_model.h.
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: JonathanStorey
+ *    Hardware: None (host build only)
+ *     Version: 1.0
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "em_device.h"
+#include "em_i2c.h"
+#include "i2c_model.h"
+
+i2c_model_device_t i2c_model_devices[I2C_MODEL_BUSES][128];
+bool i2c_model_irq_pending[I2C_MODEL_BUSES];
+uint32_t i2c_model_starts[I2C_MODEL_BUSES];
+i2c_model_hook_t i2c_model_hook;
+
+
+/*==============================================================================
+ * DEVICES
+ *============================================================================*/
+static void device_step(i2c_model_device_t *dev)
+{
+    if (dev->autoinc)
+    {
+        dev->reg = (uint8_t)(dev->reg + 1);
+        if (dev->msb_autoinc)
+        {
+            dev->reg &= 0x7F;
+        }
+    }
+}
+
+/**
+ * @brief First byte sets the register pointer, the rest are written from it
+ */
+static void device_write(i2c_model_device_t *dev, const uint8_t *data, uint16_t len)
+{
+    if (len == 0)
+    {
+        return;
+    }
+    dev->reg = dev->msb_autoinc ? (data[0] & 0x7F) : data[0];
+    dev->autoinc = !dev->msb_autoinc || (data[0] & 0x80);
+    for (uint16_t i = 1; i < len; i++)
+    {
+        dev->regs[dev->reg] = data[i];
+        dev->writes++;
+        device_step(dev);
+    }
+}
+
+static void device_read(i2c_model_device_t *dev, uint8_t *data, uint16_t len)
+{
+    dev->reads++;
+    if (dev->writes == 0)
+    {
+        dev->reads_before_setup++;
+    }
+    for (uint16_t i = 0; i < len; i++)
+    {
+        data[i] = dev->regs[dev->reg];
+        device_step(dev);
+    }
+}
+
+
+/*==============================================================================
+ * BUS
+ *============================================================================*/
+
+/**
+ * @brief Every device absent, nothing pending, no test hook, and the model
+ *        installed as sim_i2c_hook
+ * @note Call after sim_reset()
+ */
+void i2c_model_reset(void)
+{
+    memset(i2c_model_devices, 0, sizeof(i2c_model_devices));
+    memset(i2c_model_irq_pending, 0, sizeof(i2c_model_irq_pending));
+    memset(i2c_model_starts, 0, sizeof(i2c_model_starts));
+    i2c_model_hook = NULL;
+    sim_i2c_hook = i2c_model_step;
+}
+
+/**
+ * @brief The node's sensors: Compass A (0x19) and pressure (0x76) on I2C0,
+ *        Compass B (0x19) on I2C1
+ * @note Registers hold 0x40 + reg, 0x80 + reg and 0xC0 + reg respectively
+ */
+void i2c_model_add_sensors(void)
+{
+    i2c_model_devices[0][0x19].present = true;
+    i2c_model_devices[0][0x19].msb_autoinc = true;
+    i2c_model_devices[0][0x76].present = true;
+    i2c_model_devices[1][0x19].present = true;
+    i2c_model_devices[1][0x19].msb_autoinc = true;
+    for (int r = 0; r < 256; r++)
+    {
+        i2c_model_devices[0][0x19].regs[r] = (uint8_t)(0x40 + r);
+        i2c_model_devices[0][0x76].regs[r] = (uint8_t)(0x80 + r);
+        i2c_model_devices[1][0x19].regs[r] = (uint8_t)(0xC0 + r);
+    }
+}
+
+/**
+ * @brief sim_i2c_hook - start or step one transfer
+ */
+I2C_TransferReturn_TypeDef i2c_model_step(I2C_TypeDef *i2c, I2C_TransferSeq_TypeDef *seq, bool start)
+{
+    int b = (i2c == I2C1) ? 1 : 0;
+    i2c_model_device_t *dev = &i2c_model_devices[b][(seq->addr >> 1) & 0x7F];
+    I2C_TransferReturn_TypeDef ret;
+
+    if (start)
+    {
+        i2c_model_starts[b]++;
+        if (seq->flags == I2C_FLAG_WRITE && seq->buf[0].len == 0)
+        {
+            dev->probes++;
+        }
+    }
+    if (i2c_model_hook != NULL && i2c_model_hook(b, seq, start, &ret))
+    {
+        i2c_model_irq_pending[b] = (ret == i2cTransferInProgress);
+        return ret;
+    }
+    if (dev->present && dev->stuck)
+    {
+        i2c_model_irq_pending[b] = true;
+        return i2cTransferInProgress;
+    }
+    i2c_model_irq_pending[b] = false;
+    if (!dev->present)
+    {
+        return i2cTransferNack;
+    }
+    switch (seq->flags)
+    {
+      case I2C_FLAG_WRITE:
+        device_write(dev, seq->buf[0].data, seq->buf[0].len);
+        break;
+      case I2C_FLAG_READ:
+        device_read(dev, seq->buf[0].data, seq->buf[0].len);
+        break;
+      case I2C_FLAG_WRITE_READ:
+        device_write(dev, seq->buf[0].data, seq->buf[0].len);                   // repeated start between the two
+        device_read(dev, seq->buf[1].data, seq->buf[1].len);
+        break;
+    }
+    return i2cTransferDone;
+}
@@ -0,0 +1,60 @@
+/*
+ * i2c_model.h
+ *
+ * @brief Register-file I2C devices behind the stubbed I2C0 and I2C1
+ * @description i2c_model_step() is a sim_i2c_hook: it answers each transfer
+ *              from a device model per bus and 7-bit address. A device has a
+ *              256 byte register file and a register pointer set by the first
+ *              byte written, which auto-increments (LSM303 style, only with
+ *              the register MSB set, or always). Absent addresses NACK, and a
+ *              "stuck" device holds the bus until it is aborted.
+ *
+ *              A transfer still in progress leaves i2c_model_irq_pending set
+ *              for the test to deliver the bus interrupt. Each test adds its
+ *              own behaviour (latency, a held bus, a refused start) through
+ *              i2c_model_hook.
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: JonathanStorey
+ *    Hardware: None (host build only)
+ *     Version: 1.0
+ */
+
+#ifndef I2C_MODEL_H_
+#define I2C_MODEL_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "em_i2c.h"
+
+#define I2C_MODEL_BUSES         2       ///< 0 = I2C0, 1 = I2C1 (i2cBus_t order)
+
+typedef struct {
+    bool present;
+    bool msb_autoinc;                   ///< Register MSB asks for auto-increment
+    bool stuck;                         ///< Never finishes - only an abort frees the bus
+    uint8_t regs[256];
+    uint8_t reg;                        ///< Register pointer
+    bool autoinc;                       ///< Pointer steps after each byte
+    uint32_t writes;                    ///< Register bytes written
+    uint32_t reads;                     ///< Read transactions
+    uint32_t reads_before_setup;        ///< ... before the first register write
+    uint32_t probes;                    ///< Address-only transfers started
+} i2c_model_device_t;
+
+/**
+ * @brief Test hook, run first on every step
+ * @return true to answer the step with *ret instead of the device
+ */
+typedef bool (*i2c_model_hook_t)(int bus, I2C_TransferSeq_TypeDef *seq, bool start, I2C_TransferReturn_TypeDef *ret);
+
+extern i2c_model_device_t i2c_model_devices[I2C_MODEL_BUSES][128];
+extern bool i2c_model_irq_pending[I2C_MODEL_BUSES];    ///< A transfer is waiting for its interrupt
+extern uint32_t i2c_model_starts[I2C_MODEL_BUSES];     ///< Transfers started
+extern i2c_model_hook_t i2c_model_hook;
+
+void i2c_model_reset(void);
+void i2c_model_add_sensors(void);
+I2C_TransferReturn_TypeDef i2c_model_step(I2C_TypeDef *i2c, I2C_TransferSeq_TypeDef *seq, bool start);
+
+#endif /* I2C_MODEL_H_ */
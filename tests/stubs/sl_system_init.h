@@ -0,0 +1 @@
+#include "emlib_stub.h"
@@ -0,0 +1,37 @@
+/*
+ * test.h
+ *
+ * @brief Minimal check macros shared by the host tests
+ * @description CHECK() records a failure and carries on, so one run reports
+ *              every broken expectation. TEST_DONE() prints the summary and
+ *              gives main() its exit status for make.
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: JonathanStorey
+ *    Hardware: None (host build only)
+ *     Version: 1.0
+ */
+
+#ifndef TEST_H_
+#define TEST_H_
+
+#include <stdio.h>
+
+static int test_checks;
+static int test_failures;
+
+#define CHECK(cond)                                                             \
+    do {                                                                        \
+        test_checks++;                                                          \
+        if (!(cond))                                                            \
+        {                                                                       \
+            test_failures++;                                                    \
+            printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond);     \
+        }                                                                       \
+    } while (0)
+
+#define TEST_DONE()                                                             \
+    (printf("%s: %d checks, %d failed\n", __FILE__, test_checks, test_failures), \
+     test_failures ? 1 : 0)
+
+#endif /* TEST_H_ */
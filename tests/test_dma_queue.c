@@ -0,0 +1,120 @@
+/*
+ * test_dma_queue.c
+ *
+ * @brief Host test of the uart_write_dma() job queue and chunking
+ * @description dma_queue.c has no hardware access, so it is tested on its own:
+ *              capacity and FIFO order, index wrap-around, rejected pushes,
+ *              and a long job split into DMA_MAX_XFER pieces.
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: JonathanStorey
+ *    Hardware: None (host build only)
+ *     Version: 1.0
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "test.h"
+#include "dma.h"
+#include "dma_queue.h"
+
+static uint8_t buffer[5000];
+
+static void callback(int port, const void *buf, size_t len)
+{
+    (void)port;
+    (void)buf;
+    (void)len;
+}
+
+
+static void test_fifo(void)
+{
+    dma_queue_t q;
+
+    dma_queue_init(&q);
+    CHECK(dma_queue_is_empty(&q) && dma_queue_front(&q) == NULL);
+    CHECK(!dma_queue_push(&q, buffer, 0, 0, NULL));                             // zero length is refused
+
+    for (uint16_t i = 0; i < DMA_QUEUE_DEPTH; i++)
+    {
+        CHECK(dma_queue_push(&q, &buffer[i], i + 1, (uint16_t)(100 + i), callback));
+    }
+    CHECK(dma_queue_count(&q) == DMA_QUEUE_DEPTH);
+    CHECK(!dma_queue_push(&q, buffer, 1, 0, NULL));                             // full
+
+    for (uint16_t i = 0; i < DMA_QUEUE_DEPTH; i++)
+    {
+        dma_job_t *job = dma_queue_front(&q);
+
+        CHECK(job != NULL && job->buf == &buffer[i] && job->len == i + 1u);
+        CHECK(job != NULL && job->mark == 100 + i && job->sent == 0 && job->callback == callback);
+        dma_queue_pop(&q);
+    }
+    CHECK(dma_queue_is_empty(&q));
+    dma_queue_pop(&q);                                                          // popping an empty queue is harmless
+    CHECK(dma_queue_count(&q) == 0);
+}
+
+static void test_wrap(void)
+{
+    dma_queue_t q;
+    uint16_t next = 0;
+
+    dma_queue_init(&q);
+    for (int round = 0; round < 300; round++)                                   // head and tail wrap their uint8_t
+    {
+        CHECK(dma_queue_push(&q, buffer, 1, (uint16_t)round, NULL));
+        if (round % 3 != 0)
+        {
+            CHECK(dma_queue_front(&q)->mark == next);
+            dma_queue_pop(&q);
+            next++;
+        }
+        if (dma_queue_count(&q) == DMA_QUEUE_DEPTH)
+        {
+            while (!dma_queue_is_empty(&q))
+            {
+                CHECK(dma_queue_front(&q)->mark == next);
+                dma_queue_pop(&q);
+                next++;
+            }
+        }
+    }
+}
+
+static void test_chunks(void)
+{
+    dma_queue_t q;
+    dma_job_t *job;
+    const uint8_t *src;
+    size_t chunk;
+    size_t total = 0;
+    int pieces = 0;
+
+    dma_queue_init(&q);
+    CHECK(dma_queue_push(&q, buffer, sizeof(buffer), 0, NULL));
+    job = dma_queue_front(&q);
+
+    do
+    {
+        chunk = dma_job_next_chunk(job, DMA_MAX_XFER, &src);
+        CHECK(src == &buffer[total]);
+        CHECK(chunk == (sizeof(buffer) - total < DMA_MAX_XFER ? sizeof(buffer) - total : DMA_MAX_XFER));
+        total += chunk;
+        pieces++;
+    } while (!dma_job_advance(job, chunk));
+
+    CHECK(pieces == 3 && total == sizeof(buffer));
+    CHECK(dma_job_next_chunk(job, DMA_MAX_XFER, &src) == 0);
+}
+
+
+int main(void)
+{
+    test_fifo();
+    test_wrap();
+    test_chunks();
+    return TEST_DONE();
+}
@@ -0,0 +1,314 @@
+/*
+ * test_frame.c
+ *
+ * @brief Host test and throughput measurement of the COBS + CRC16 framing
+ * @description frame.c on its own: encode/decode round trips of random
+ *              payloads fed in random splits, frames built in a ring buffer,
+ *              and a fuzz pass of line garbage and corrupted frames, which
+ *              must never crash the decoder or reach the handler. link.c is
+ *              then run over the simulated FCPU port (UART0), wire looped
+ *              back into its RX interrupt, to check sequence loss counting.
+ *              Last, encode and decode speed are printed in bytes/s.
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: JonathanStorey
+ *    Hardware: None (host build only)
+ *     Version: 1.0
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include "test.h"
+#include "em_device.h"
+#include "defines.h"
+#include "ring_buffer.h"
+#include "usart.h"
+#include "frame.h"
+#include "link.h"
+
+void UART0_RX_IRQHandler(void);
+
+static uint8_t expect[FRAME_MAX_PAYLOAD];
+static uint16_t expect_len;
+static uint8_t expect_seq;
+static uint8_t expect_type;
+static uint32_t delivered;
+static uint32_t mismatched;
+static uint32_t rng = 0x12345678;
+
+
+/**
+ * @brief xorshift32 - the same sequence on every host, unlike rand()
+ */
+static uint32_t random32(void)
+{
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+static void frame_handler(void *ctx, uint8_t seq, uint8_t type, const uint8_t *payload, uint16_t len)
+{
+    (void)ctx;
+    delivered++;
+    if (seq != expect_seq || type != expect_type || len != expect_len || memcmp(payload, expect, len) != 0)
+    {
+        mismatched++;
+    }
+}
+
+/**
+ * @brief Random payload: all zeros, no zeros, or anything, to exercise COBS
+ */
+static void make_payload(uint16_t len)
+{
+    uint32_t mode = random32() % 3;
+
+    expect_len = len;
+    for (uint16_t i = 0; i < len; i++)
+    {
+        expect[i] = (mode == 0) ? 0 : (mode == 1) ? (uint8_t)(random32() % 255 + 1) : (uint8_t)random32();
+    }
+    expect_seq = (uint8_t)random32();
+    expect_type = (uint8_t)random32();
+}
+
+
+/*==============================================================================
+ * FRAMING
+ *============================================================================*/
+static void test_round_trip(void)
+{
+    frame_decoder_t decoder;
+    uint8_t encoded[FRAME_ENCODED_MAX(FRAME_MAX_PAYLOAD)];
+    uint32_t frames = 20000;
+    bool no_zero = true;
+
+    frame_decoder_init(&decoder, frame_handler, NULL);
+    delivered = mismatched = 0;
+    for (uint32_t i = 0; i < frames; i++)
+    {
+        uint16_t n;
+        uint16_t pos = 0;
+
+        make_payload((uint16_t)(random32() % (FRAME_MAX_PAYLOAD + 1)));
+        n = frame_encode(encoded, sizeof(encoded), expect_seq, expect_type, expect, expect_len);
+        CHECK(n > 0 && n <= FRAME_ENCODED_MAX(expect_len) && encoded[n - 1] == 0);
+        for (uint16_t k = 0; k + 1 < n; k++)
+        {
+            no_zero &= encoded[k] != 0;                                         // only the delimiter is zero
+        }
+        while (pos < n)                                                         // arrives in random pieces
+        {
+            uint16_t piece = (uint16_t)(1 + random32() % (n - pos));
+
+            frame_decoder_feed(&decoder, &encoded[pos], piece);
+            pos += piece;
+        }
+    }
+    CHECK(no_zero);
+    CHECK(delivered == frames && mismatched == 0);
+    CHECK(decoder.frames == frames && decoder.crc_errors == 0 && decoder.length_errors == 0);
+
+    CHECK(frame_encode(encoded, 10, 0, 0, expect, 100) == 0);                   // no room
+    CHECK(frame_encode(encoded, sizeof(encoded), 0, 0, expect, FRAME_MAX_PAYLOAD + 1) == 0);
+}
+
+static void test_ring_encode(void)
+{
+    static uint8_t storage[256];
+    ring_buffer_t ring;
+    frame_decoder_t decoder;
+    const uint8_t *span;
+    uint16_t n;
+
+    ring_buffer_init(&ring, storage, sizeof(storage));
+    frame_decoder_init(&decoder, frame_handler, NULL);
+    delivered = mismatched = 0;
+    for (uint32_t i = 0; i < 5000; i++)                                         // wraps the ring many times
+    {
+        make_payload((uint16_t)(random32() % (FRAME_MAX_PAYLOAD + 1)));
+        CHECK(frame_encode_ring(&ring, expect_seq, expect_type, expect, expect_len) > 0);
+        while ((n = ring_buffer_peek_contiguous(&ring, &span)) > 0)
+        {
+            frame_decoder_feed(&decoder, span, n);
+            ring_buffer_consume(&ring, n);
+        }
+    }
+    CHECK(delivered == 5000 && mismatched == 0);
+
+    ring_buffer_write(&ring, expect, 200);                                      // too little room is refused, not cut
+    CHECK(frame_encode_ring(&ring, 0, 0, expect, 100) == 0);
+    CHECK(ring_buffer_count(&ring) == 200);
+}
+
+/**
+ * @brief Garbage, then a resync delimiter, then a frame that is either intact
+ *        (must come out) or has one bit flipped (must not)
+ */
+static void test_fuzz(void)
+{
+    frame_decoder_t decoder;
+    uint8_t encoded[FRAME_ENCODED_MAX(FRAME_MAX_PAYLOAD)];
+    uint8_t junk[64];
+    uint32_t intact = 0;
+    uint32_t intact_out = 0;
+    uint32_t corrupt_out = 0;
+    const uint8_t delimiter = 0;
+
+    frame_decoder_init(&decoder, frame_handler, NULL);
+    for (uint32_t i = 0; i < 50000; i++)
+    {
+        uint16_t junk_len = (uint16_t)(random32() % sizeof(junk));
+        bool corrupt = random32() & 1;
+        uint32_t before;
+        uint16_t n;
+
+        for (uint16_t k = 0; k < junk_len; k++)
+        {
+            junk[k] = (uint8_t)random32();
+        }
+        frame_decoder_feed(&decoder, junk, junk_len);                           // may itself pass as a frame, rarely
+        frame_decoder_feed(&decoder, &delimiter, 1);
+
+        make_payload((uint16_t)(random32() % 50));
+        n = frame_encode(encoded, sizeof(encoded), expect_seq, expect_type, expect, expect_len);
+        if (corrupt)
+        {
+            encoded[random32() % (n - 1)] ^= (uint8_t)(1u << (random32() % 8));
+        }
+
+        delivered = mismatched = 0;
+        before = decoder.frames;
+        frame_decoder_feed(&decoder, encoded, n);
+        if (corrupt)
+        {
+            corrupt_out += decoder.frames - before;
+        }
+        else
+        {
+            intact++;
+            intact_out += (delivered == 1 && mismatched == 0) ? 1 : 0;
+        }
+    }
+    CHECK(intact_out == intact);
+    CHECK(corrupt_out == 0);
+    CHECK(decoder.crc_errors > 0 && decoder.length_errors > 0);
+}
+
+
+/*==============================================================================
+ * LINK
+ *============================================================================*/
+static uint32_t link_frames;
+
+static void link_handler(destination_t port, uint8_t type, const uint8_t *payload, uint16_t len)
+{
+    link_frames += (port == FCPU && type == 0x42 && len == 3 && memcmp(payload, "abc", 3) == 0) ? 1 : 0;
+}
+
+/**
+ * @brief Loop the FCPU wire back into its receiver, skipping one whole frame
+ */
+static void loop_back(uint32_t skip_frame)
+{
+    sim_wire_t *wire = sim_wire(UART0);
+    uint32_t frame = 0;
+
+    for (uint32_t i = 0; i < wire->len; i++)
+    {
+        if (frame != skip_frame)
+        {
+            UART0->RXDATA = wire->data[i];
+            sim_rxdatav_budget = 1;
+            UART0_RX_IRQHandler();
+        }
+        if (wire->data[i] == 0)
+        {
+            frame++;
+        }
+    }
+    wire->len = 0;
+}
+
+static void test_link(void)
+{
+    link_stats_t stats;
+
+    sim_reset();
+    usart_init();
+    sim_irq_blocked[UART0_TX_IRQn] = true;                                      // TX drained by polling
+    CHECK(link_open(FCPU, link_handler));
+
+    for (int i = 0; i < 10; i++)
+    {
+        CHECK(link_send(FCPU, 0x42, "abc", 3));
+    }
+    uart_tx_flush(FCPU);
+    loop_back(4);                                                               // fifth frame lost on the line
+    link_poll(FCPU);
+
+    link_get_stats(FCPU, &stats);
+    CHECK(link_frames == 9);
+    CHECK(stats.tx_frames == 10 && stats.rx_frames == 9 && stats.rx_lost == 1);
+    CHECK(stats.rx_crc_errors == 0 && stats.rx_length_errors == 0);
+    CHECK(!link_send(FCPU, 0x42, expect, FRAME_MAX_PAYLOAD + 1));
+    link_close(FCPU);
+}
+
+
+/*==============================================================================
+ * THROUGHPUT
+ *============================================================================*/
+static void measure_throughput(void)
+{
+    static uint8_t stream[FRAME_ENCODED_MAX(FRAME_MAX_PAYLOAD) * 64];
+    frame_decoder_t decoder;
+    uint32_t rounds = 5000;
+    uint32_t bytes = 0;
+    uint32_t n = 0;
+    clock_t start;
+    double encode_s;
+    double decode_s;
+
+    make_payload(FRAME_MAX_PAYLOAD);
+    start = clock();
+    for (uint32_t r = 0; r < rounds; r++)
+    {
+        n = 0;
+        for (int f = 0; f < 64; f++)
+        {
+            n += frame_encode(&stream[n], (uint16_t)(sizeof(stream) - n), expect_seq, expect_type, expect, expect_len);
+        }
+        bytes += n;
+    }
+    encode_s = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    frame_decoder_init(&decoder, frame_handler, NULL);
+    delivered = mismatched = 0;
+    start = clock();
+    for (uint32_t r = 0; r < rounds; r++)
+    {
+        frame_decoder_feed(&decoder, stream, (uint16_t)n);
+    }
+    decode_s = (double)(clock() - start) / CLOCKS_PER_SEC;
+    CHECK(delivered == rounds * 64 && mismatched == 0);
+
+    printf("frame encode %.1f Mbytes/s, decode %.1f Mbytes/s (%u-byte payloads, host)\n",
+           encode_s > 0 ? bytes / encode_s / 1e6 : 0.0,
+           decode_s > 0 ? (double)n * rounds / decode_s / 1e6 : 0.0, FRAME_MAX_PAYLOAD);
+}
+
+
+int main(void)
+{
+    test_round_trip();
+    test_ring_encode();
+    test_fuzz();
+    test_link();
+    measure_throughput();
+    return TEST_DONE();
+}
@@ -0,0 +1,477 @@
+/*
+ * test_i2c.c
+ *
+ * @brief Host test of the queued I2C transfer engine on a simulated bus
+ * @description i2c.c runs on the stubbed I2C_TransferInit() / I2C_Transfer()
+ *              with the register-file devices of stubs/i2c_model.c standing
+ *              in for the hardware. This test's hook can refuse the next
+ *              start, and makes each transfer take a set number of
+ *              interrupts, which the test delivers by calling the bus IRQ
+ *              handlers. That lets the queue
+ *              be inspected mid-flight: priority order, back-to-back starts
+ *              from the completion interrupt, cancel, abort, blocking
+ *              timeouts and the two buses running independently.
+ *
+ *              i2c_devices.c is checked on the same model: each device's
+ *              set-up writes land in its registers, and a whole sample block
+ *              comes back in one transaction.
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: JonathanStorey
+ *    Hardware: None (host build only)
+ *     Version: 1.0
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "test.h"
+#include "em_device.h"
+#include "em_i2c.h"
+#include "i2c.h"
+#include "i2c_devices.h"
+#include "i2c_model.h"
+
+static uint8_t latency;                 // interrupts per transfer, 0 = done inside I2C_TransferInit()
+static uint8_t remaining[I2C_BUS_COUNT];
+static I2C_TransferReturn_TypeDef refuse;  // I2C_TransferInit() result forced for the next start, 0 = none
+static char done_log[64];
+
+
+/*==============================================================================
+ * BUS MODEL
+ *============================================================================*/
+
+/**
+ * @brief i2c_model hook: a refused start, then latency interrupts per transfer
+ */
+static bool bus_hook(int b, I2C_TransferSeq_TypeDef *seq, bool start, I2C_TransferReturn_TypeDef *ret)
+{
+    (void)seq;
+
+    if (start)
+    {
+        remaining[b] = latency;
+        if (refuse != 0)
+        {
+            *ret = refuse;
+            refuse = 0;
+            return true;
+        }
+    }
+    if (remaining[b] > 0)
+    {
+        remaining[b]--;
+        *ret = i2cTransferInProgress;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Deliver one interrupt to a bus, if it has one pending
+ */
+static bool irq(i2cBus_t bus)
+{
+    if (!i2c_model_irq_pending[bus])
+    {
+        return false;
+    }
+    i2c_model_irq_pending[bus] = false;
+    if (bus == I2C_BUS_CADDY)
+    {
+        I2C0_IRQHandler();
+    }
+    else
+    {
+        I2C1_IRQHandler();
+    }
+    return true;
+}
+
+/**
+ * @brief Deliver interrupts until both buses go quiet (bounded, for stuck devices)
+ */
+static void run_buses(void)
+{
+    for (int i = 0; i < 1000 && (irq(I2C_BUS_CADDY) | irq(I2C_BUS_COMPASS_B)); i++);
+}
+
+static void record_done(i2cTransfer_t *transfer)
+{
+    char id[2] = { *(const char *)transfer->ctx, '\0' };
+
+    strncat(done_log, id, sizeof(done_log) - strlen(done_log) - 1);
+}
+
+static void setup(uint8_t interrupts)
+{
+    sim_reset();
+    i2c_model_reset();
+    i2c_model_hook = bus_hook;
+    latency = interrupts;
+    refuse = 0;
+    done_log[0] = '\0';
+    initI2C();
+    i2c_model_add_sensors();
+}
+
+static void transfer_init(i2cTransfer_t *t, i2cBus_t bus, i2cPriority_t priority, uint8_t addr, const char *id)
+{
+    memset(t, 0, sizeof(*t));
+    t->bus = bus;
+    t->priority = priority;
+    t->addr = addr;
+    t->callback = record_done;
+    t->ctx = (void *)id;
+}
+
+
+/*==============================================================================
+ * TRANSFERS
+ *============================================================================*/
+static void test_shapes(void)
+{
+    static const uint8_t config[2] = { 0x20, 0x57 };
+    i2cTransfer_t t;
+    uint8_t sample[6];
+    uint8_t one;
+    uint32_t completed, failed;
+
+    setup(3);
+    transfer_init(&t, I2C_BUS_CADDY, I2C_PRIORITY_NORMAL, 0x19, "b");
+    CHECK(i2cReadBurst(&t, 0x28, I2C_AUTOINC_MSB, sample, 6));                  // one write-then-read for six registers
+    CHECK(t.status == I2C_TRANSFER_ACTIVE && !i2cIsIdle(I2C_BUS_CADDY));
+    CHECK(!i2cReadBurst(&t, 0x28, I2C_AUTOINC_MSB, sample, 6));                 // still on the wire
+    run_buses();
+    CHECK(t.status == I2C_TRANSFER_DONE && t.result == i2cTransferDone);
+    CHECK(t.regAddr == 0xA8 && sample[0] == 0x68 && sample[5] == 0x6D);
+    CHECK(strcmp(done_log, "b") == 0 && i2cIsIdle(I2C_BUS_CADDY));
+
+    transfer_init(&t, I2C_BUS_CADDY, I2C_PRIORITY_NORMAL, 0x19, "w");           // write only
+    t.writeData = config;
+    t.writeLen = 2;
+    CHECK(i2cSubmit(&t));
+    run_buses();
+    CHECK(t.status == I2C_TRANSFER_DONE && i2c_model_devices[I2C_BUS_CADDY][0x19].regs[0x20] == 0x57);
+
+    transfer_init(&t, I2C_BUS_CADDY, I2C_PRIORITY_NORMAL, 0x19, "r");           // read only, from the pointer left behind
+    t.readData = &one;
+    t.readLen = 1;
+    CHECK(i2cSubmit(&t));
+    run_buses();
+    CHECK(t.status == I2C_TRANSFER_DONE && one == 0x57);                        // no MSB on the write, so the pointer stayed
+
+    transfer_init(&t, I2C_BUS_CADDY, I2C_PRIORITY_NORMAL, 0x50, "p");           // address only, nobody there
+    CHECK(i2cSubmit(&t));
+    run_buses();
+    CHECK(t.status == I2C_TRANSFER_FAILED && t.result == i2cTransferNack);
+
+    i2cGetStats(I2C_BUS_CADDY, &completed, &failed);
+    CHECK(completed == 3 && failed == 1);
+    t.bus = I2C_BUS_COUNT;
+    CHECK(!i2cSubmit(&t) && !i2cCancel(&t));
+}
+
+/**
+ * @brief Submitted while the bus is busy: higher priorities first, FIFO within
+ *        one, and each next START issued from the interrupt that finished the last
+ */
+static void test_priority(void)
+{
+    i2cTransfer_t t[5];
+    uint8_t data[5];
+
+    setup(2);
+    transfer_init(&t[0], I2C_BUS_CADDY, I2C_PRIORITY_LOW, 0x76, "0");
+    transfer_init(&t[1], I2C_BUS_CADDY, I2C_PRIORITY_LOW, 0x76, "L");
+    transfer_init(&t[2], I2C_BUS_CADDY, I2C_PRIORITY_NORMAL, 0x76, "N");
+    transfer_init(&t[3], I2C_BUS_CADDY, I2C_PRIORITY_HIGH, 0x19, "H");
+    transfer_init(&t[4], I2C_BUS_CADDY, I2C_PRIORITY_NORMAL, 0x19, "n");
+    for (int i = 0; i < 5; i++)
+    {
+        t[i].readData = &data[i];
+        t[i].readLen = 1;
+        CHECK(i2cSubmit(&t[i]));
+    }
+    CHECK(t[0].status == I2C_TRANSFER_ACTIVE && t[3].status == I2C_TRANSFER_PENDING);
+    CHECK(!i2cSubmit(&t[2]));                                                   // already queued
+
+    run_buses();
+    CHECK(strcmp(done_log, "0HNnL") == 0);
+
+    setup(2);                                                                   // no gap: the finishing interrupt starts the next
+    transfer_init(&t[0], I2C_BUS_CADDY, I2C_PRIORITY_NORMAL, 0x76, "a");
+    transfer_init(&t[1], I2C_BUS_CADDY, I2C_PRIORITY_NORMAL, 0x76, "b");
+    CHECK(i2cSubmit(&t[0]) && i2cSubmit(&t[1]));
+    i2c_model_starts[I2C_BUS_CADDY] = 0;
+    irq(I2C_BUS_CADDY);
+    irq(I2C_BUS_CADDY);                                                         // t[0] finishes here
+    CHECK(t[0].status == I2C_TRANSFER_DONE && t[1].status == I2C_TRANSFER_ACTIVE);
+    CHECK(i2c_model_starts[I2C_BUS_CADDY] == 1);
+    run_buses();
+}
+
+/**
+ * @brief Caddy and Compass B polled together: both buses on the wire at
+ *        once, each emptying its own queue from its own interrupt
+ */
+static void test_two_buses(void)
+{
+    i2cTransfer_t caddy[4], compass[4];
+    uint8_t caddy_data[4][6], compass_data[4][6];
+    uint32_t caddy_starts, compass_starts;
+
+    setup(3);
+    CHECK(i2cBusEnabled(I2C_BUS_CADDY) && i2cBusEnabled(I2C_BUS_COMPASS_B));   // built with I2C_COMPASS_B_ENABLE
+    CHECK(!i2cBusEnabled(I2C_BUS_COUNT));
+    for (int i = 0; i < 4; i++)
+    {
+        transfer_init(&caddy[i], I2C_BUS_CADDY, I2C_PRIORITY_NORMAL, (i & 1) ? 0x76 : 0x19, "a");
+        transfer_init(&compass[i], I2C_BUS_COMPASS_B, I2C_PRIORITY_NORMAL, 0x19, "b");
+        CHECK(i2cReadBurst(&caddy[i], (i & 1) ? 0x7A : 0x28, (i & 1) ? I2C_AUTOINC_NONE : I2C_AUTOINC_MSB, caddy_data[i], 6));
+        CHECK(i2cReadBurst(&compass[i], 0x28, I2C_AUTOINC_MSB, compass_data[i], 6));
+    }
+    CHECK(caddy[0].status == I2C_TRANSFER_ACTIVE && compass[0].status == I2C_TRANSFER_ACTIVE);
+
+    for (int step = 0; step < 3; step++)                                        // each bus moves only on its own interrupt
+    {
+        irq(I2C_BUS_CADDY);
+    }
+    CHECK(caddy[0].status == I2C_TRANSFER_DONE && caddy[1].status == I2C_TRANSFER_ACTIVE);
+    CHECK(compass[0].status == I2C_TRANSFER_ACTIVE);
+
+    caddy_starts = i2c_model_starts[I2C_BUS_CADDY];                             // caddy[1] already started
+    compass_starts = i2c_model_starts[I2C_BUS_COMPASS_B];
+    run_buses();
+    CHECK(i2c_model_starts[I2C_BUS_CADDY] - caddy_starts == 2 && i2c_model_starts[I2C_BUS_COMPASS_B] - compass_starts == 3);
+    CHECK(strlen(done_log) == 8 && i2cIsIdle(I2C_BUS_CADDY) && i2cIsIdle(I2C_BUS_COMPASS_B));
+    for (int i = 0; i < 4; i++)
+    {
+        CHECK(caddy_data[i][0] == ((i & 1) ? 0xFA : 0x68) && caddy_data[i][5] == ((i & 1) ? 0xFF : 0x6D));
+        CHECK(compass_data[i][0] == 0xE8 && compass_data[i][5] == 0xED);
+    }
+}
+
+static int chain_left;
+
+static void chain_again(i2cTransfer_t *transfer)
+{
+    record_done(transfer);
+    if (--chain_left > 0)
+    {
+        CHECK(i2cSubmit(transfer));                                             // from its own completion callback
+    }
+}
+
+static void test_callback_submits(void)
+{
+    i2cTransfer_t t;
+    uint8_t data;
+
+    for (uint8_t interrupts = 0; interrupts < 2; interrupts++)                  // finishing in TransferInit, or later
+    {
+        setup(interrupts);
+        transfer_init(&t, I2C_BUS_CADDY, I2C_PRIORITY_NORMAL, 0x76, "c");
+        t.readData = &data;
+        t.readLen = 1;
+        t.callback = chain_again;
+        chain_left = 4;
+        CHECK(i2cSubmit(&t));
+        run_buses();
+        CHECK(strcmp(done_log, "cccc") == 0 && i2cIsIdle(I2C_BUS_CADDY));
+    }
+}
+
+
+/*==============================================================================
+ * CANCEL, ABORT, FAULTS
+ *============================================================================*/
+static void test_cancel(void)
+{
+    static const char *const ids[3] = { "0", "1", "2" };
+    i2cTransfer_t t[3];
+    uint8_t data[3];
+
+    setup(2);
+    for (int i = 0; i < 3; i++)
+    {
+        transfer_init(&t[i], I2C_BUS_CADDY, I2C_PRIORITY_NORMAL, 0x76, ids[i]);
+        t[i].readData = &data[i];
+        t[i].readLen = 1;
+        CHECK(i2cSubmit(&t[i]));
+    }
+    CHECK(!i2cCancel(&t[0]));                                                   // on the wire
+    CHECK(i2cCancel(&t[1]) && t[1].status == I2C_TRANSFER_IDLE);
+    CHECK(!i2cCancel(&t[1]));
+    run_buses();
+    CHECK(strcmp(done_log, "02") == 0);
+    CHECK(!i2cCancel(&t[2]));                                                   // finished
+
+    CHECK(i2cSubmit(&t[1]));                                                    // a cancelled descriptor can go again
+    run_buses();
+    CHECK(t[1].status == I2C_TRANSFER_DONE);
+
+    for (int i = 0; i < 3; i++)                                                 // cancelling the tail keeps the queue linked
+    {
+        CHECK(i2cSubmit(&t[i]));
+    }
+    CHECK(i2cCancel(&t[2]));
+    CHECK(i2cSubmit(&t[2]));
+    done_log[0] = '\0';
+    run_buses();
+    CHECK(strcmp(done_log, "012") == 0);
+}
+
+static void test_abort(void)
+{
+    i2cTransfer_t stuck, next, other;
+    uint8_t data[2];
+    uint8_t value = 0;
+
+    setup(1);
+    i2c_model_devices[I2C_BUS_CADDY][0x76].stuck = true;
+    transfer_init(&stuck, I2C_BUS_CADDY, I2C_PRIORITY_NORMAL, 0x76, "s");
+    transfer_init(&next, I2C_BUS_CADDY, I2C_PRIORITY_NORMAL, 0x19, "n");
+    transfer_init(&other, I2C_BUS_COMPASS_B, I2C_PRIORITY_NORMAL, 0x19, "o");
+    stuck.readData = &data[0];
+    stuck.readLen = 1;
+    next.readData = &data[1];
+    next.readLen = 1;
+    other.readData = &value;
+    other.readLen = 1;
+
+    CHECK(i2cSubmit(&stuck) && i2cSubmit(&next) && i2cSubmit(&other));
+    run_buses();
+    CHECK(other.status == I2C_TRANSFER_DONE && value == 0xC0);                  // I2C1 isn't held up by I2C0
+    CHECK(stuck.status == I2C_TRANSFER_ACTIVE && next.status == I2C_TRANSFER_PENDING);
+
+    i2cAbort(I2C_BUS_CADDY);
+    CHECK(stuck.status == I2C_TRANSFER_FAILED && stuck.result == i2cTransferSwFault);
+    CHECK(I2C0->CMD & I2C_CMD_ABORT);
+    run_buses();
+    CHECK(next.status == I2C_TRANSFER_DONE);
+    CHECK(strcmp(done_log, "osn") == 0);
+
+    i2cAbort(I2C_BUS_CADDY);                                                    // nothing on the wire - harmless
+    CHECK(i2cIsIdle(I2C_BUS_CADDY));
+}
+
+static void test_blocking(void)
+{
+    i2cTransfer_t stuck, waiting;
+    uint8_t value = 0;
+
+    setup(0);                                                                   // finishes inside I2C_TransferInit()
+    CHECK(i2cReadRegister(0x2A, &value) && value == 0x40 + 0x2A);               // legacy helper: Compass A, one register
+
+    i2c_model_devices[I2C_BUS_CADDY][0x76].stuck = true;
+    transfer_init(&stuck, I2C_BUS_CADDY, I2C_PRIORITY_NORMAL, 0x76, "s");
+    CHECK(i2cTransferBlocking(&stuck, 200) == i2cTransferSwFault);              // aborted once the time ran out
+    CHECK(stuck.status == I2C_TRANSFER_FAILED);
+
+    CHECK(i2cSubmit(&stuck));
+    transfer_init(&waiting, I2C_BUS_CADDY, I2C_PRIORITY_NORMAL, 0x19, "w");
+    waiting.readData = &value;
+    waiting.readLen = 1;
+    CHECK(i2cTransferBlocking(&waiting, 200) == i2cTransferSwFault);            // stuck behind it, never got the bus
+    CHECK(waiting.status == I2C_TRANSFER_IDLE && stuck.status == I2C_TRANSFER_ACTIVE);
+    i2cAbort(I2C_BUS_CADDY);
+    CHECK(i2cIsIdle(I2C_BUS_CADDY));
+}
+
+/**
+ * @brief A transfer emlib refuses at I2C_TransferInit() fails at once and the
+ *        next one still starts
+ */
+static void test_refused(void)
+{
+    i2cTransfer_t t[2];
+    uint8_t data[2];
+
+    setup(1);
+    transfer_init(&t[0], I2C_BUS_COMPASS_B, I2C_PRIORITY_NORMAL, 0x19, "u");
+    transfer_init(&t[1], I2C_BUS_COMPASS_B, I2C_PRIORITY_NORMAL, 0x19, "v");
+    t[0].readData = &data[0];
+    t[0].readLen = 1;
+    t[1].readData = &data[1];
+    t[1].readLen = 1;
+
+    refuse = i2cTransferUsageFault;
+    CHECK(i2cSubmit(&t[0]));
+    CHECK(t[0].status == I2C_TRANSFER_FAILED && t[0].result == i2cTransferUsageFault);
+    CHECK(i2cIsIdle(I2C_BUS_COMPASS_B));
+    CHECK(i2cSubmit(&t[1]));
+    run_buses();
+    CHECK(t[1].status == I2C_TRANSFER_DONE && strcmp(done_log, "uv") == 0);
+}
+
+
+/*==============================================================================
+ * DEVICES
+ *============================================================================*/
+static void test_device_configure(void)
+{
+    setup(0);                                                                   // i2cTransferBlocking() needs no interrupts
+    for (uint8_t id = 0; id < I2C_DEVICE_COUNT; id++)
+    {
+        CHECK(i2cDeviceConfigure(i2cDeviceGet((i2cDeviceId_t)id)));
+    }
+    CHECK(i2c_model_devices[I2C_BUS_CADDY][0x19].regs[0x20] == 0x57 && i2c_model_devices[I2C_BUS_CADDY][0x19].writes == 1);
+    CHECK(i2c_model_devices[I2C_BUS_CADDY][0x76].regs[0xF4] == 0x27 && i2c_model_devices[I2C_BUS_CADDY][0x76].writes == 1);
+    CHECK(i2c_model_devices[I2C_BUS_COMPASS_B][0x19].regs[0x20] == 0x57 && i2c_model_devices[I2C_BUS_COMPASS_B][0x19].writes == 1);
+    CHECK(i2c_model_devices[I2C_BUS_CADDY][0x19].regs[0x21] == 0x40 + 0x21);    // nothing written past the one register
+
+    i2c_model_devices[I2C_BUS_COMPASS_B][0x19].present = false;
+    CHECK(!i2cDeviceConfigure(i2cDeviceGet(I2C_DEVICE_COMPASS_B)));
+    CHECK(i2cIsIdle(I2C_BUS_COMPASS_B));
+}
+
+static void test_device_sample(void)
+{
+    i2cTransfer_t t[I2C_DEVICE_COUNT];
+    uint8_t sample[I2C_DEVICE_COUNT][I2C_SAMPLE_MAX];
+    static const uint8_t first[I2C_DEVICE_COUNT] = { 0x68, 0x77, 0xE8 };       // register value at each sample block
+
+    CHECK(i2cDeviceGet(I2C_DEVICE_COUNT) == NULL);
+    CHECK(i2cDeviceFind(I2C_BUS_CADDY, 0x76) == i2cDeviceGet(I2C_DEVICE_PRESSURE));
+    CHECK(i2cDeviceFind(I2C_BUS_COMPASS_B, 0x19) == i2cDeviceGet(I2C_DEVICE_COMPASS_B));
+    CHECK(i2cDeviceFind(I2C_BUS_CADDY, 0x50) == NULL);
+
+    setup(2);
+    memset(t, 0, sizeof(t));
+    for (uint8_t id = 0; id < I2C_DEVICE_COUNT; id++)
+    {
+        CHECK(i2cReadSample(i2cDeviceGet((i2cDeviceId_t)id), &t[id], sample[id], record_done, "s"));
+    }
+    CHECK(!i2cReadSample(i2cDeviceGet(I2C_DEVICE_COMPASS_A), &t[0], sample[0], record_done, "s"));
+    run_buses();
+    CHECK(i2c_model_starts[I2C_BUS_CADDY] == 2 && i2c_model_starts[I2C_BUS_COMPASS_B] == 1); // one transaction per sample
+    CHECK(strcmp(done_log, "sss") == 0);
+    for (uint8_t id = 0; id < I2C_DEVICE_COUNT; id++)
+    {
+        const i2cDevice_t *device = i2cDeviceGet((i2cDeviceId_t)id);
+
+        CHECK(t[id].status == I2C_TRANSFER_DONE && t[id].addr == device->addr);
+        for (uint8_t i = 0; i < device->sampleLen; i++)
+        {
+            CHECK(sample[id][i] == (uint8_t)(first[id] + i));
+        }
+    }
+}
+
+
+int main(void)
+{
+    test_shapes();
+    test_priority();
+    test_two_buses();
+    test_callback_submits();
+    test_cancel();
+    test_abort();
+    test_blocking();
+    test_refused();
+    test_device_configure();
+    test_device_sample();
+    return TEST_DONE();
+}
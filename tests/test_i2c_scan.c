@@ -0,0 +1,155 @@
+/*
+ * test_i2c_scan.c
+ *
+ * @brief Host test of the I2C address scan and its inventory
+ * @description i2c_scan.c and i2c.c run on the stubbed I2C with the devices
+ *              of stubs/i2c_model.c. Each address on each bus either ACKs or
+ *              NACKs the address-only probe at once, or holds the bus so the
+ *              probe never finishes, standing in for SDA or SCL held low.
+ *
+ *              Checks the inventory after a clean scan, a bus that sticks part
+ *              way through, and a bus held by a transfer queued before the
+ *              scan. The other bus must always be scanned in full, and both
+ *              buses must be free afterwards.
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: JonathanStorey
+ *    Hardware: None (host build only)
+ *     Version: 1.0
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "test.h"
+#include "em_device.h"
+#include "em_i2c.h"
+#include "i2c.h"
+#include "i2c_scan.h"
+#include "i2c_model.h"
+
+static void setup(void)
+{
+    sim_reset();
+    i2c_model_reset();
+    initI2C();
+
+    i2c_model_devices[I2C_BUS_CADDY][0x19].present = true;                      // Compass A
+    i2c_model_devices[I2C_BUS_CADDY][0x76].present = true;                      // pressure
+    i2c_model_devices[I2C_BUS_COMPASS_B][0x19].present = true;                  // Compass B
+    i2c_model_devices[I2C_BUS_COMPASS_B][0x1E].present = true;                  // LSM303 magnetometer
+}
+
+/**
+ * @brief Every scanned address probed exactly once, nothing reserved touched
+ */
+static bool probed_once(i2cBus_t bus, uint8_t last)
+{
+    for (uint8_t addr = 0; addr < 128; addr++)
+    {
+        uint32_t expect = (addr >= I2C_SCAN_FIRST && addr <= last) ? 1 : 0;
+
+        if (i2c_model_devices[bus][addr].probes != expect)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+/*==============================================================================
+ * SCAN
+ *============================================================================*/
+static void test_clean(void)
+{
+    const i2cInventory_t *inv;
+
+    setup();
+    CHECK(!i2cGetInventory(I2C_BUS_CADDY)->scanned && !i2cIsPresent(I2C_BUS_CADDY, 0x19));
+    i2c_model_devices[I2C_BUS_CADDY][0x00].present = true;                      // general call - never probed
+    i2c_model_devices[I2C_BUS_COMPASS_B][0x7C].present = true;                  // device ID - never probed
+    CHECK(i2cScan() == 4);
+
+    inv = i2cGetInventory(I2C_BUS_CADDY);
+    CHECK(inv->scanned && !inv->stuck && inv->count == 2);
+    CHECK(inv->scanUs < 2000);                                                  // far under one probe timeout per address
+    CHECK(i2cIsPresent(I2C_BUS_CADDY, 0x19) && i2cIsPresent(I2C_BUS_CADDY, 0x76));
+    CHECK(!i2cIsPresent(I2C_BUS_CADDY, 0x00) && !i2cIsPresent(I2C_BUS_CADDY, 0x1E));
+    inv = i2cGetInventory(I2C_BUS_COMPASS_B);
+    CHECK(inv->scanned && !inv->stuck && inv->count == 2);
+    CHECK(i2cIsPresent(I2C_BUS_COMPASS_B, 0x19) && i2cIsPresent(I2C_BUS_COMPASS_B, 0x1E));
+    CHECK(!i2cIsPresent(I2C_BUS_COMPASS_B, 0x7C));
+    CHECK(probed_once(I2C_BUS_CADDY, I2C_SCAN_LAST) && probed_once(I2C_BUS_COMPASS_B, I2C_SCAN_LAST));
+
+    CHECK(i2cGetInventory(I2C_BUS_COUNT) == NULL);
+    CHECK(!i2cIsPresent(I2C_BUS_COUNT, 0x19) && !i2cIsPresent(I2C_BUS_CADDY, 0x80));
+
+    i2c_model_devices[I2C_BUS_CADDY][0x76].present = false;                     // a rescan replaces the inventory
+    CHECK(i2cScan() == 3);
+    CHECK(!i2cIsPresent(I2C_BUS_CADDY, 0x76) && i2cGetInventory(I2C_BUS_CADDY)->count == 1);
+}
+
+/**
+ * @brief Compass B bus sticks at 0x40: aborted once, the rest of it skipped,
+ *        the caddy still scanned in full
+ */
+static void test_stuck(void)
+{
+    const i2cInventory_t *inv;
+
+    setup();
+    i2c_model_devices[I2C_BUS_COMPASS_B][0x40].present = true;                  // holds the bus
+    i2c_model_devices[I2C_BUS_COMPASS_B][0x40].stuck = true;
+    i2c_model_devices[I2C_BUS_COMPASS_B][0x50].present = true;                  // past the stuck address
+    CHECK(i2cScan() == 4);
+
+    inv = i2cGetInventory(I2C_BUS_COMPASS_B);
+    CHECK(inv->scanned && inv->stuck && inv->stuckAddr == 0x40);
+    CHECK(inv->count == 2 && !i2cIsPresent(I2C_BUS_COMPASS_B, 0x50));
+    CHECK(probed_once(I2C_BUS_COMPASS_B, 0x40));
+    CHECK(I2C1->CMD & I2C_CMD_ABORT);
+    CHECK(inv->scanUs >= I2C_SCAN_PROBE_US && inv->scanUs < 2 * I2C_SCAN_PROBE_US);
+
+    inv = i2cGetInventory(I2C_BUS_CADDY);
+    CHECK(!inv->stuck && inv->count == 2 && probed_once(I2C_BUS_CADDY, I2C_SCAN_LAST));
+    CHECK(i2cIsIdle(I2C_BUS_CADDY) && i2cIsIdle(I2C_BUS_COMPASS_B));
+}
+
+/**
+ * @brief A transfer queued before the scan never finishes: the first probe on
+ *        that bus gives up waiting for it and the bus is marked stuck
+ */
+static void test_held_by_queue(void)
+{
+    i2cTransfer_t sample = { 0 };
+    uint8_t data[6];
+    const i2cInventory_t *inv;
+
+    setup();
+    i2c_model_devices[I2C_BUS_CADDY][0x19].stuck = true;
+    sample.bus = I2C_BUS_CADDY;
+    sample.priority = I2C_PRIORITY_HIGH;
+    sample.addr = 0x19;
+    CHECK(i2cReadBurst(&sample, 0x28, I2C_AUTOINC_MSB, data, sizeof(data)));
+
+    CHECK(i2cScan() == 2);
+    inv = i2cGetInventory(I2C_BUS_CADDY);
+    CHECK(inv->stuck && inv->stuckAddr == I2C_SCAN_FIRST && inv->count == 0);
+    CHECK(inv->scanUs >= I2C_SCAN_QUEUE_US);
+    CHECK(probed_once(I2C_BUS_CADDY, I2C_SCAN_FIRST - 1));                      // the probe never reached the wire
+    CHECK(sample.status == I2C_TRANSFER_ACTIVE);                                // the scan doesn't abort other people's transfers
+    CHECK(i2cGetInventory(I2C_BUS_COMPASS_B)->count == 2);
+
+    i2cAbort(I2C_BUS_CADDY);
+    CHECK(sample.status == I2C_TRANSFER_FAILED && i2cIsIdle(I2C_BUS_CADDY));
+}
+
+
+int main(void)
+{
+    test_clean();
+    test_stuck();
+    test_held_by_queue();
+    return TEST_DONE();
+}
@@ -0,0 +1,674 @@
+/*
+ * test_max14830.c
+ *
+ * @brief Host test of the MAX14830 data path against a simulated expander
+ * @description usart_expanders.c and expander_io.c talk to a model of three
+ *              MAX14830s on the simulated USART4. The model decodes each
+ *              chip-select cycle (command byte, then data), keeps a 128 byte TX
+ *              FIFO per UART, counts overruns and moves FIFO bytes onto a line
+ *              log at a set number of SPI bytes (or core cycles) per
+ *              character, standing in for the UART line rate. ISR, IRQEN and
+ *              GLOBALIRQ drive PC5, and the interrupt model takes the PC5
+ *              interrupt.
+ *
+ *              Checks that MAX14830_SendString() and MAX14830_SendChar() never
+ *              overrun the FIFO, keep byte order and work both without the
+ *              interrupt engine and with it, where the TX FIFO empty interrupt
+ *              does the refills. With the engine on, received characters
+ *              must reach the RX ring through the RX trigger and RX timeout
+ *              interrupts with no polling reads from main context. THR
+ *              refills and engine RHR drains run on the spi_bus LDMA queue.
+ *              Interrupts zeroed by a channel re-init must be armed again. It also prints the SPI cost per payload byte
+ *              of a 64 byte message, burst against one register write per
+ *              character.
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: JonathanStorey
+ *    Hardware: None (host build only)
+ *     Version: 1.0
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "test.h"
+#include "em_device.h"
+#include "em_core.h"
+#include "em_gpio.h"
+#include "defines.h"
+#include "helpers.h"
+#include "hw_timer.h"
+#include "usart_expanders.h"
+#include "expander_io.h"
+#include "spi_bus.h"
+
+#define MODEL_LINE_SIZE         4096
+
+void GPIO_ODD_IRQHandler(void);
+void LDMA_IRQHandler(void);
+
+typedef struct {
+    uint8_t regs[4][0x20];
+    uint8_t isr[4];                         // ISR bits latched, cleared by reading ISR
+    uint8_t lsr[4];
+    uint8_t rx[4][MAX14830_FIFO_SIZE];
+    uint16_t rx_level[4];
+    uint8_t fifo[4][MAX14830_FIFO_SIZE];
+    uint16_t level[4];
+    uint32_t overruns[4];
+    uint8_t line[4][MODEL_LINE_SIZE];
+    uint32_t line_len[4];
+} max14830_model_t;
+
+static max14830_model_t chips[3];
+static int selected = -1;                   // chip under chip select, -1 for none
+static uint32_t spi_pos;                    // bytes since chip select
+static uint8_t command;
+static uint32_t spi_bytes;
+static uint32_t cs_cycles;
+static uint32_t txlvl_reads;
+static uint32_t txlvl_main_reads;           // ... of them outside interrupt context
+static uint32_t rx_main_reads;              // RXFIFOLVL, RHR and LSR reads outside interrupt context
+static uint32_t line_div;                   // SPI bytes per character on the line, 0 = line stalled
+static uint32_t line_cycles;                // or core cycles per character, 0 = not paced by time
+static uint32_t line_last;
+static bool irq_low;                        // PC5, the shared IRQ line
+static char text[2001];
+static char message[2001];
+
+
+/*==============================================================================
+ * EXPANDER MODEL
+ *============================================================================*/
+
+/**
+ * @brief Send one character from every non-empty TX FIFO onto its line
+ */
+static void model_line_tick(void)
+{
+    for (int c = 0; c < 3; c++)
+    {
+        for (int u = 0; u < 4; u++)
+        {
+            max14830_model_t *chip = &chips[c];
+
+            if (chip->level[u])
+            {
+                if (chip->line_len[u] < MODEL_LINE_SIZE)
+                {
+                    chip->line[u][chip->line_len[u]++] = chip->fifo[u][0];
+                }
+                memmove(chip->fifo[u], &chip->fifo[u][1], --chip->level[u]);
+                if (chip->level[u] == 0)
+                {
+                    chip->isr[u] |= MAX14830_ISR_TFIFOEMTYINT;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Let the lines run until every TX FIFO is empty
+ */
+static void model_line_flush(void)
+{
+    for (int i = 0; i < MAX14830_FIFO_SIZE; i++)
+    {
+        model_line_tick();
+    }
+}
+
+/**
+ * @brief Send the characters due since the last look when the line is paced by time
+ */
+static void model_line_run(void)
+{
+    while (line_cycles && sim_cycles - line_last >= line_cycles)
+    {
+        line_last += line_cycles;
+        model_line_tick();
+    }
+}
+
+/**
+ * @brief Drive PC5 low while any enabled interrupt is latched, latching the
+ *        GPIO interrupt flag on a falling edge
+ */
+static void model_irq_line(void)
+{
+    bool low = false;
+
+    for (int c = 0; c < 3; c++)
+    {
+        for (int u = 0; u < 4; u++)
+        {
+            low |= (chips[c].isr[u] & chips[c].regs[u][MAX14830_IRQEN_REG]) != 0;
+        }
+    }
+    if (low && !irq_low)
+    {
+        GPIO->IF |= GPIO->IEN & (1u << EXPANDER_IRQ_PIN);
+    }
+    irq_low = low;
+    if (low)
+    {
+        GPIO_PinOutClear(EXPANDER_IRQ_PORT, EXPANDER_IRQ_PIN);
+    }
+    else
+    {
+        GPIO_PinOutSet(EXPANDER_IRQ_PORT, EXPANDER_IRQ_PIN);
+    }
+}
+
+/**
+ * @brief GLOBALIRQ: bit n low while UART n has an enabled interrupt latched
+ */
+static uint8_t model_globalirq(const max14830_model_t *chip)
+{
+    uint8_t global = 0x0F;
+
+    for (int u = 0; u < 4; u++)
+    {
+        if (chip->isr[u] & chip->regs[u][MAX14830_IRQEN_REG])
+        {
+            global &= (uint8_t)~MAX14830_GLOBALIRQ_IRQ(u);
+        }
+    }
+    return global;
+}
+
+static uint8_t model_spi(uint8_t tx)
+{
+    max14830_model_t *chip;
+    uint8_t uart, reg;
+
+    spi_bytes++;
+    if (line_div && spi_bytes % line_div == 0)
+    {
+        model_line_tick();
+    }
+    model_line_run();
+    if (selected < 0)
+    {
+        return 0;
+    }
+    if (spi_pos++ == 0)
+    {
+        command = tx;
+        return 0;
+    }
+    chip = &chips[selected];
+    uart = (command >> 5) & 0x03;
+    reg = command & 0x1F;
+    if (reg != MAX14830_THR_REG)
+    {
+        reg = (uint8_t)((reg + spi_pos - 2) & 0x1F);                            // bursts auto-increment, except through THR/RHR
+    }
+
+    if (command & 0x80)
+    {
+        if (reg != MAX14830_THR_REG)
+        {
+            chip->regs[uart][reg] = tx;
+        }
+        else if (chip->level[uart] < MAX14830_FIFO_SIZE)
+        {
+            chip->fifo[uart][chip->level[uart]++] = tx;
+        }
+        else
+        {
+            chip->overruns[uart]++;
+        }
+        return 0;
+    }
+    switch (reg)
+    {
+      case MAX14830_TXFIFOLVL_REG:
+        txlvl_reads++;
+        txlvl_main_reads += !CORE_InIrqContext();
+        return (uint8_t)chip->level[uart];
+      case MAX14830_RXFIFOLVL_REG:
+        rx_main_reads += !CORE_InIrqContext();
+        return (uint8_t)chip->rx_level[uart];
+      case MAX14830_RHR_REG:
+        rx_main_reads += !CORE_InIrqContext();
+        if (chip->rx_level[uart] == 0)
+        {
+            return 0;
+        }
+        tx = chip->rx[uart][0];
+        memmove(chip->rx[uart], &chip->rx[uart][1], --chip->rx_level[uart]);
+        return tx;
+      case MAX14830_LSR_REG:
+        rx_main_reads += !CORE_InIrqContext();
+        tx = chip->lsr[uart];
+        chip->lsr[uart] &= (uint8_t)~(MAX14830_LSR_RTIMEOUT | MAX14830_LSR_RXOVERRUN);
+        return tx;
+      case MAX14830_ISR_REG:
+        tx = chip->isr[uart];
+        chip->isr[uart] = 0;
+        return tx;
+      case MAX14830_GLOBALIRQ_REG:
+        return model_globalirq(chip);
+      default:
+        return chip->regs[uart][reg];
+    }
+}
+
+/**
+ * @brief Characters arriving on a UART's RX line
+ * @note The RX trigger interrupt latches once the level reaches FIFOTRIGLVL
+ */
+static void model_rx(uint8_t expander, uint8_t uart, const void *data, uint16_t len)
+{
+    max14830_model_t *chip = &chips[expander - EXPANDER_A];
+    uint16_t trigger = ((chip->regs[uart][MAX14830_FIFOTRIGLVL_REG] & MAX14830_FIFOTRIG_RX_MASK) >> MAX14830_FIFOTRIG_RX_SHIFT) * 8;
+
+    for (uint16_t i = 0; i < len; i++)
+    {
+        if (chip->rx_level[uart] < MAX14830_FIFO_SIZE)
+        {
+            chip->rx[uart][chip->rx_level[uart]++] = ((const uint8_t *)data)[i];
+        }
+        else
+        {
+            chip->lsr[uart] |= MAX14830_LSR_RXOVERRUN;
+        }
+    }
+    if (trigger && chip->rx_level[uart] >= trigger)
+    {
+        chip->isr[uart] |= MAX14830_ISR_RFIFOTRIGINT;
+    }
+    model_irq_line();
+}
+
+/**
+ * @brief The RX lines go quiet: every UART holding characters flags an RX timeout
+ */
+static void model_rx_idle(void)
+{
+    for (int c = 0; c < 3; c++)
+    {
+        for (int u = 0; u < 4; u++)
+        {
+            if (chips[c].rx_level[u] && (chips[c].regs[u][MAX14830_LSRINTEN_REG] & MAX14830_LSRINTEN_RTIMEOUTIEN))
+            {
+                chips[c].lsr[u] |= MAX14830_LSR_RTIMEOUT;
+                chips[c].isr[u] |= MAX14830_ISR_LSRERRINT;
+            }
+        }
+    }
+    model_irq_line();
+}
+
+static void model_select(int chip, char state)
+{
+    if (state == Selected)
+    {
+        selected = chip;
+        spi_pos = 0;
+        cs_cycles++;
+    }
+    else
+    {
+        selected = -1;
+        model_irq_line();
+    }
+}
+
+void Set_Expander_A_CS_State(char CS_state)     { model_select(0, CS_state); }
+void Set_Expander_B_CS_State(char CS_state)     { model_select(1, CS_state); }
+void Set_Expander_C_CS_State(char CS_state)     { model_select(2, CS_state); }
+
+/**
+ * @brief Interrupt model: time passes, the lines run, and the LDMA and PC5
+ *        interrupts are taken while their flags (or a software pend) are set
+ */
+static void irq_model(void)
+{
+    bool again = true;
+
+    (void)hw_timer_cycles();
+    model_line_run();
+    model_irq_line();
+    while (again)
+    {
+        again = false;
+        sim_sync();
+        if (sim_irq_enabled[LDMA_IRQn] && !sim_irq_blocked[LDMA_IRQn] && (LDMA->IF & LDMA->IEN))
+        {
+            LDMA_IRQHandler();
+            again = true;
+        }
+        sim_sync();
+        if (sim_irq_enabled[GPIO_ODD_IRQn] && !sim_irq_blocked[GPIO_ODD_IRQn] &&
+            ((GPIO->IF & GPIO->IEN) || sim_irq_pending[GPIO_ODD_IRQn]))
+        {
+            sim_irq_pending[GPIO_ODD_IRQn] = false;
+            GPIO_ODD_IRQHandler();
+            again = true;
+        }
+    }
+}
+
+static void setup(void)
+{
+    expander_irq_disable();                                                     // back to polled from the last test
+    sim_reset();
+    memset(chips, 0, sizeof(chips));
+    spi_bytes = cs_cycles = txlvl_reads = txlvl_main_reads = rx_main_reads = 0;
+    line_div = line_cycles = line_last = 0;
+    irq_low = false;
+    sim_spi_hook = model_spi;
+    sim_irq_hook = irq_model;
+    spi_bus_init();
+    MAX14830_ShadowInvalidate(MAX14830_ALL_EXPANDERS);
+    for (uint8_t ch = 0; ch < EXPANDER_CHANNEL_COUNT; ch++)                     // as MAX14830_UART_Init() leaves it
+    {
+        MAX14830_WriteRegister(EXPANDER_OF_CHANNEL(ch), UART_OF_CHANNEL(ch), MAX14830_IRQEN_REG, 0x00);
+    }
+    expander_io_init();
+    model_irq_line();
+    spi_bytes = cs_cycles = 0;
+}
+
+/**
+ * @brief Let time pass with interrupts unmasked
+ */
+static void wait_us(uint32_t us)
+{
+    CORE_DECLARE_IRQ_STATE;
+
+    hw_timer0_us(us);
+    CORE_ENTER_ATOMIC();
+    CORE_EXIT_ATOMIC();
+}
+
+/**
+ * @brief The first len characters of text, terminated
+ */
+static const char *first(uint16_t len)
+{
+    memcpy(message, text, len);
+    message[len] = '\0';
+    return message;
+}
+
+static bool line_is(uint8_t expander, uint8_t uart, const void *expect, uint32_t len)
+{
+    max14830_model_t *chip = &chips[expander - EXPANDER_A];
+
+    return chip->line_len[uart] == len && memcmp(chip->line[uart], expect, len) == 0;
+}
+
+static uint32_t total_overruns(void)
+{
+    uint32_t n = 0;
+
+    for (int c = 0; c < 3; c++)
+    {
+        for (int u = 0; u < 4; u++)
+        {
+            n += chips[c].overruns[u];
+        }
+    }
+    return n;
+}
+
+
+/*==============================================================================
+ * TRANSMIT
+ *============================================================================*/
+
+/**
+ * @brief A string that fits the FIFO: one TXFIFOLVL read and one burst
+ */
+static void test_short_string(void)
+{
+    setup();
+    MAX14830_SendString(EXPANDER_A, MAX14830_UART0, first(64));
+    CHECK(cs_cycles == 2 && txlvl_reads == 1);
+    CHECK(spi_bytes == 2 + 1 + 64);
+    CHECK(chips[0].level[0] == 64 && total_overruns() == 0);
+    model_line_flush();
+    CHECK(line_is(EXPANDER_A, 0, text, 64));
+}
+
+/**
+ * @brief A register burst auto-increments through consecutive registers
+ */
+static void test_register_burst(void)
+{
+    static const uint8_t xon[4] = { 0x11, 0x13, 0x12, 0x14 };
+
+    setup();
+    MAX14830_WriteBurst(EXPANDER_B, 1, MAX14830_XON1_REG, xon, sizeof(xon));
+    CHECK(cs_cycles == 1 && spi_bytes == 1 + 4);
+    CHECK(memcmp(&chips[1].regs[1][MAX14830_XON1_REG], xon, sizeof(xon)) == 0);
+    CHECK(chips[1].level[1] == 0);
+}
+
+/**
+ * @brief Stalled line: the FIFO is filled exactly, the rest waits in the queue
+ *        with the FIFO empty interrupt armed, then drains in order
+ */
+static void test_fifo_full(void)
+{
+    uint8_t ch = EXPANDER_CHANNEL(EXPANDER_B, 2);
+
+    setup();
+    MAX14830_SendString(EXPANDER_B, 2, first(300));
+    CHECK(chips[1].level[2] == MAX14830_FIFO_SIZE && total_overruns() == 0);
+    CHECK(expander_tx_pending(ch) == 300 - MAX14830_FIFO_SIZE);
+    CHECK(chips[1].regs[2][MAX14830_IRQEN_REG] & MAX14830_IRQEN_TFIFOEMTYIEN);
+
+    line_div = 4;
+    while (expander_tx_pending(ch))
+    {
+        expander_io_poll();
+    }
+    model_line_flush();
+    CHECK(line_is(EXPANDER_B, 2, text, 300));
+    CHECK(total_overruns() == 0);
+    CHECK(!(chips[1].regs[2][MAX14830_IRQEN_REG] & MAX14830_IRQEN_TFIFOEMTYIEN));
+}
+
+/**
+ * @brief More than the TX queue holds: SendString waits for room, polling
+ *        the FIFO itself as the interrupt engine is off
+ */
+static void test_long_string(void)
+{
+    setup();
+    line_div = 8;
+    MAX14830_SendString(EXPANDER_C, 3, text);
+    CHECK(expander_tx_pending(EXPANDER_CHANNEL(EXPANDER_C, 3)) <= EXPANDER_TX_RING_SIZE);
+    while (expander_tx_pending(EXPANDER_CHANNEL(EXPANDER_C, 3)))
+    {
+        expander_io_poll();
+    }
+    model_line_flush();
+    CHECK(line_is(EXPANDER_C, 3, text, sizeof(text) - 1));
+    CHECK(total_overruns() == 0);
+    CHECK(chips[0].line_len[0] == 0 && chips[1].line_len[3] == 0);              // nothing on the wrong chip
+}
+
+static void test_send_char(void)
+{
+    setup();
+    line_div = 8;
+    for (int i = 0; i < 1000; i++)
+    {
+        MAX14830_SendChar(EXPANDER_A, 1, text[i]);
+    }
+    while (expander_tx_pending(EXPANDER_CHANNEL(EXPANDER_A, 1)))
+    {
+        expander_io_poll();
+    }
+    model_line_flush();
+    CHECK(line_is(EXPANDER_A, 1, text, 1000));
+    CHECK(total_overruns() == 0);
+}
+
+
+/**
+ * @brief Interrupt engine on: after the first refill every refill comes from
+ *        the TX FIFO empty interrupt, and a sender held up by a full queue
+ *        sleeps instead of polling TXFIFOLVL. The THR bursts go through the
+ *        spi_bus LDMA queue.
+ */
+static void test_irq_refill(void)
+{
+    uint8_t ch = EXPANDER_CHANNEL(EXPANDER_B, 2);
+    uint32_t queued;
+
+    setup();
+    line_cycles = 500;                                                          // 10 us per character
+    expander_irq_enable();
+    CHECK(expander_irq_enabled() && irq_low == false);
+    txlvl_reads = txlvl_main_reads = 0;
+    queued = spi_bus_completed();
+
+    MAX14830_SendString(EXPANDER_B, 2, text);                                   // 2000 bytes, four times queue and FIFO
+    CHECK(txlvl_main_reads == 1);                                               // only the first, unarmed, write
+    CHECK(txlvl_reads > 1 && expander_irq_count() > 0);
+    for (int i = 0; i < 1000 && expander_tx_pending(ch); i++)
+    {
+        wait_us(100);
+    }
+    model_line_flush();
+    CHECK(line_is(EXPANDER_B, 2, text, sizeof(text) - 1));
+    CHECK(total_overruns() == 0 && txlvl_main_reads == 1);
+    CHECK(!(chips[1].regs[2][MAX14830_IRQEN_REG] & MAX14830_IRQEN_TFIFOEMTYIEN));   // disarmed once the queue ran dry
+    CHECK(chips[0].line_len[0] == 0 && chips[1].line_len[1] == 0);
+    CHECK(spi_bus_completed() - queued >= (sizeof(text) - 1) / MAX14830_FIFO_SIZE);   // at least a burst per FIFO load
+    CHECK(spi_bus_idle());
+
+    expander_irq_disable();
+    CHECK(!expander_irq_enabled());
+}
+
+
+/*==============================================================================
+ * RECEIVE
+ *============================================================================*/
+
+/**
+ * @brief Interrupt engine on: the RX trigger and RX timeout interrupts empty
+ *        the FIFO into the ring through RHR bursts on the spi_bus queue, and
+ *        reading it costs no SPI at all
+ */
+static void test_irq_receive(void)
+{
+    uint8_t ch = EXPANDER_CHANNEL(EXPANDER_C, 1);
+    uint8_t got[64];
+    expander_rx_stats_t stats;
+    uint32_t queued;
+
+    setup();
+    expander_irq_enable();
+    CHECK(chips[2].regs[1][MAX14830_IRQEN_REG] & MAX14830_IRQEN_RFIFOTRGIEN);
+    rx_main_reads = 0;
+    queued = spi_bus_completed();
+
+    model_rx(EXPANDER_C, 1, text, 40);                                          // over the 32 byte trigger
+    wait_us(10);
+    CHECK(chips[2].rx_level[1] == 0 && expander_rx_ready_mask() == (1u << ch));
+
+    model_rx(EXPANDER_C, 1, &text[40], 5);                                      // under it - waits for the RX timeout
+    wait_us(10);
+    CHECK(chips[2].rx_level[1] == 5);
+    model_rx_idle();
+    wait_us(10);
+    CHECK(chips[2].rx_level[1] == 0 && !irq_low);
+
+    CHECK(expander_available(ch) == 45);
+    CHECK(expander_read(ch, got, sizeof(got)) == 45 && memcmp(got, text, 45) == 0);
+    CHECK(rx_main_reads == 0);                                                  // every FIFO access came from the interrupt
+    expander_get_rx_stats(ch, &stats);
+    CHECK(stats.rx_bytes == 45 && stats.rx_dropped == 0 && stats.rx_errors == 0);
+    CHECK(expander_rx_ready_mask() == 0 && expander_irq_count() >= 2);
+    CHECK(spi_bus_completed() - queued == 2);                                   // one RHR burst each drain
+}
+
+/**
+ * @brief A channel re-init writes IRQEN = 0 under the engine: the next enable
+ *        and the next write arm the interrupts again
+ */
+static void test_irq_rearm(void)
+{
+    uint8_t ch = EXPANDER_CHANNEL(EXPANDER_A, 3);
+    const uint8_t rx_irqs = MAX14830_IRQEN_RFIFOTRGIEN | MAX14830_IRQEN_LSRERRIEN;
+
+    setup();
+    expander_irq_enable();
+    CHECK((chips[0].regs[3][MAX14830_IRQEN_REG] & rx_irqs) == rx_irqs);
+
+    MAX14830_WriteRegister(EXPANDER_A, 3, MAX14830_IRQEN_REG, 0x00);           // what MAX14830_ApplyChannelConfig() does
+    CHECK(chips[0].regs[3][MAX14830_IRQEN_REG] == 0);
+    expander_irq_enable();
+    CHECK((chips[0].regs[3][MAX14830_IRQEN_REG] & rx_irqs) == rx_irqs);
+
+    MAX14830_SendString(EXPANDER_A, 3, first(200));                             // line stalled - the FIFO empty interrupt is armed
+    CHECK(chips[0].regs[3][MAX14830_IRQEN_REG] & MAX14830_IRQEN_TFIFOEMTYIEN);
+    MAX14830_WriteRegister(EXPANDER_A, 3, MAX14830_IRQEN_REG, 0x00);
+    txlvl_reads = 0;
+    CHECK(expander_write(ch, "!", 1) == 1);                                     // not armed any more, so this write refills
+    CHECK(txlvl_reads == 1);
+    CHECK(chips[0].regs[3][MAX14830_IRQEN_REG] & MAX14830_IRQEN_TFIFOEMTYIEN);
+
+    line_cycles = 500;
+    for (int i = 0; i < 1000 && expander_tx_pending(ch); i++)
+    {
+        wait_us(100);
+    }
+    model_line_flush();
+    CHECK(chips[0].line_len[3] == 201 && total_overruns() == 0);
+    expander_irq_disable();
+    CHECK((chips[0].regs[3][MAX14830_IRQEN_REG] & rx_irqs) == 0);
+}
+
+
+/*==============================================================================
+ * SPI COST
+ *============================================================================*/
+static void measure_spi_cost(void)
+{
+    uint32_t burst_bytes, burst_cs;
+
+    setup();
+    MAX14830_SendString(EXPANDER_A, MAX14830_UART0, first(64));
+    burst_bytes = spi_bytes;
+    burst_cs = cs_cycles;
+
+    setup();
+    for (int i = 0; i < 64; i++)                                                // the old path: one register write per character
+    {
+        MAX14830_WriteRegister(EXPANDER_A, MAX14830_UART0, MAX14830_THR_REG, text[i]);
+    }
+    CHECK(spi_bytes == 128 && cs_cycles == 64);
+
+    printf("64 byte message: %.2f SPI bytes/payload byte, %u CS cycles (per character: %.2f, %u)\n",
+           burst_bytes / 64.0, (unsigned)burst_cs, spi_bytes / 64.0, (unsigned)cs_cycles);
+}
+
+
+int main(void)
+{
+    for (size_t i = 0; i + 1 < sizeof(text); i++)
+    {
+        text[i] = (char)('!' + i % 90);
+    }
+
+    test_short_string();
+    test_register_burst();
+    test_fifo_full();
+    test_long_string();
+    test_send_char();
+    test_irq_refill();
+    test_irq_receive();
+    test_irq_rearm();
+    measure_spi_cost();
+    return TEST_DONE();
+}
@@ -0,0 +1,175 @@
+/*
+ * test_max14830_baud.c
+ *
+ * @brief Host test of the MAX14830 baud rate calculator
+ * @description max14830_baud.c is pure arithmetic, so it is tested on its
+ *              own. Every divisor is checked against the data sheet formula
+ *              fREF * mode / (16 * DIV + FRACT), its reported error and its
+ *              neighbouring divisors, over a sweep of rates on several clocks.
+ *              Then the clock search has to find the PLL setting that makes
+ *              every standard rate exact from the 4 MHz crystal.
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: JonathanStorey
+ *    Hardware: None (host build only)
+ *     Version: 1.0
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+#include "test.h"
+#include "max14830_baud.h"
+
+static const uint32_t standard_rates[] =
+{
+    9600, 19200, 38400, 57600, 115200, 230400, 460800, 921600
+};
+
+#define RATE_COUNT      (sizeof(standard_rates) / sizeof(standard_rates[0]))
+
+
+/**
+ * @brief Rate the registers produce, straight from the data sheet formula
+ */
+static double rate_of(uint32_t fref, const max14830_divisor_t *d)
+{
+    uint32_t mode = (d->brgcfg & MAX14830_BRGCFG_4XMODE) ? 4 : (d->brgcfg & MAX14830_BRGCFG_2XMODE) ? 2 : 1;
+    uint32_t d16 = (uint32_t)d->div * 16 + (d->brgcfg & MAX14830_BRGCFG_FRACT_MASK);
+
+    return (double)fref * mode / d16;
+}
+
+static double ppm_of(double rate, uint32_t baud)
+{
+    return (rate - baud) / baud * 1e6;
+}
+
+/**
+ * @brief No other mode, and no divisor one step either side, gets closer
+ */
+static bool is_best(uint32_t fref, uint32_t baud, const max14830_divisor_t *d)
+{
+    double best = fabs(ppm_of(rate_of(fref, d), baud));
+
+    for (uint32_t mode = 1; mode <= 4; mode *= 2)
+    {
+        double clock = (double)fref * mode;
+        uint32_t d16 = (uint32_t)(clock / baud);
+
+        for (uint32_t k = (d16 > 16 ? d16 - 1 : 16); k <= d16 + 1; k++)
+        {
+            if (k <= 0xFFFFF && fabs(ppm_of(clock / k, baud)) < best - 1.0)    // the calculator works in whole ppm
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+
+/*==============================================================================
+ * DIVISOR
+ *============================================================================*/
+static void test_exact_rates(void)
+{
+    max14830_divisor_t d;
+    bool exact = true;
+
+    for (uint8_t i = 0; i < RATE_COUNT; i++)
+    {
+        exact &= max14830_calc_divisor(57600000, standard_rates[i], &d);
+        exact &= d.error_ppm == 0 && d.actual == standard_rates[i];
+        exact &= rate_of(57600000, &d) == standard_rates[i];
+    }
+    CHECK(exact);
+
+    CHECK(max14830_calc_divisor(57600000, 921600, &d));                         // 62.5 in 1x mode, exact in 2x
+    CHECK((d.brgcfg & MAX14830_BRGCFG_2XMODE) && !(d.brgcfg & MAX14830_BRGCFG_4XMODE));
+    CHECK(d.div == 7 && (d.brgcfg & MAX14830_BRGCFG_FRACT_MASK) == 13);
+
+    CHECK(max14830_calc_divisor(4000000, 115200, &d));                          // the old fixed 4 MHz clock
+    CHECK(d.error_ppm > -1000 && d.error_ppm < 1000);                           // the fraction brings 8% down under 0.1%
+}
+
+static void test_sweep(void)
+{
+    static const uint32_t clocks[] = { 1843200, 4000000, 14745600, 24000000, 57600000, 96000000 };
+    max14830_divisor_t d;
+    bool consistent = true;
+    bool best = true;
+
+    for (uint8_t c = 0; c < sizeof(clocks) / sizeof(clocks[0]); c++)
+    {
+        for (uint32_t baud = 300; baud <= 3000000; baud += baud / 97 + 1)
+        {
+            double produced;
+
+            if (!max14830_calc_divisor(clocks[c], baud, &d))
+            {
+                consistent &= baud > clocks[c] / 4;                             // only beyond 4x mode with DIV 1
+                continue;
+            }
+            produced = rate_of(clocks[c], &d);
+            consistent &= d.div >= 1;
+            consistent &= fabs(produced - d.actual) <= 0.5;
+            consistent &= fabs(ppm_of(produced, baud) - d.error_ppm) <= 1.0;
+            best &= is_best(clocks[c], baud, &d);
+        }
+    }
+    CHECK(consistent);
+    CHECK(best);
+}
+
+static void test_limits(void)
+{
+    max14830_divisor_t d;
+
+    CHECK(!max14830_calc_divisor(4000000, 0, &d));
+    CHECK(!max14830_calc_divisor(0, 9600, &d));
+    CHECK(max14830_calc_divisor(4000000, 1000000, &d));                         // 4x mode, DIV 1
+    CHECK((d.brgcfg & MAX14830_BRGCFG_4XMODE) && d.div == 1 && d.error_ppm == 0);
+    CHECK(!max14830_calc_divisor(4000000, 1100000, &d));                        // nothing is fast enough
+    CHECK(max14830_calc_divisor(57600000, 60, &d) && d.div > 0xFFF);            // slow rates need the 16 bit DIV
+}
+
+
+/*==============================================================================
+ * CLOCK
+ *============================================================================*/
+static void test_clock(void)
+{
+    max14830_clock_t clock;
+    uint32_t worst;
+    uint32_t bypass_worst = 0;
+    max14830_divisor_t d;
+
+    CHECK(max14830_calc_clock(4000000, standard_rates, RATE_COUNT, &clock, &worst));
+    CHECK(worst == 0 && !clock.bypass && clock.fref == 57600000);
+    CHECK(clock.pllcfg == ((3 << MAX14830_PLLCFG_FACTOR_SHIFT) | 10));          // predivider 10, x144
+
+    for (uint8_t i = 0; i < RATE_COUNT; i++)                                    // never worse than the crystal alone
+    {
+        CHECK(max14830_calc_divisor(4000000, standard_rates[i], &d));
+        if ((uint32_t)(d.error_ppm < 0 ? -d.error_ppm : d.error_ppm) > bypass_worst)
+        {
+            bypass_worst = (uint32_t)(d.error_ppm < 0 ? -d.error_ppm : d.error_ppm);
+        }
+    }
+    CHECK(bypass_worst > 0 && worst <= bypass_worst);
+
+    CHECK(max14830_calc_clock(4000000, standard_rates, 1, &clock, &worst) && worst == 0);
+    CHECK(!max14830_calc_clock(4000000, (const uint32_t[]){ 50000000 }, 1, &clock, &worst));
+    CHECK(worst == UINT32_MAX);
+}
+
+
+int main(void)
+{
+    test_exact_rates();
+    test_sweep();
+    test_limits();
+    test_clock();
+    return TEST_DONE();
+}
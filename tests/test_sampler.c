@@ -0,0 +1,247 @@
+/*
+ * test_sampler.c
+ *
+ * @brief Host test of the periodic I2C sampler
+ * @description sampler.c, i2c_devices.c and i2c.c run on the stubbed TIMER3
+ *              and I2C. The test calls TIMER3_IRQHandler() once per simulated
+ *              millisecond, then delivers the bus interrupts. The devices of
+ *              stubs/i2c_model.c answer writes and burst reads and can be
+ *              unplugged. This test's hook holds a bus so its reads never
+ *              finish.
+ *
+ *              Checks that sampler_start() sends the set-up writes before the
+ *              first read and that each device is read at its own period.
+ *              sampler_latest() must return the newest sample without bus
+ *              traffic. Held and unplugged buses must show up as missed
+ *              deadlines and errors without disturbing the other bus.
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: JonathanStorey
+ *    Hardware: None (host build only)
+ *     Version: 1.0
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "test.h"
+#include "em_device.h"
+#include "em_i2c.h"
+#include "i2c.h"
+#include "i2c_devices.h"
+#include "sampler.h"
+#include "i2c_model.h"
+
+#define CYCLES_PER_MS           50000   // hw_timer_cycles() runs at 50 MHz
+#define CYCLES_ON_WIRE          10000   // tick to bus interrupt, ~200 us
+
+static bool held[I2C_BUS_COUNT];        // bus stalled - transfers never finish
+
+
+/*==============================================================================
+ * BUS MODEL
+ *============================================================================*/
+
+/**
+ * @brief i2c_model hook: transfers finish on the interrupt after they start,
+ *        or never on a held bus
+ * @note Blocking transfers (the set-up writes) can't wait for an interrupt
+ *       here, so writes finish inside I2C_TransferInit()
+ */
+static bool bus_hook(int b, I2C_TransferSeq_TypeDef *seq, bool start, I2C_TransferReturn_TypeDef *ret)
+{
+    if (held[b] || (start && seq->flags != I2C_FLAG_WRITE))
+    {
+        *ret = i2cTransferInProgress;
+        return true;
+    }
+    return false;
+}
+
+static uint32_t bus_transfers(void)
+{
+    return i2c_model_starts[I2C_BUS_CADDY] + i2c_model_starts[I2C_BUS_COMPASS_B];
+}
+
+/**
+ * @brief Let ms milliseconds pass: one sampler tick each, then the bus interrupts
+ */
+static void run_ms(uint32_t ms)
+{
+    while (ms--)
+    {
+        sim_cycles += CYCLES_PER_MS - CYCLES_ON_WIRE;
+        TIMER3->IF |= TIMER_IF_OF;
+        TIMER3_IRQHandler();
+        CHECK(!(TIMER3->IF & TIMER_IF_OF));
+        sim_cycles += CYCLES_ON_WIRE;
+        for (int b = 0; b < I2C_BUS_COUNT; b++)
+        {
+            if (i2c_model_irq_pending[b] && !held[b])
+            {
+                i2c_model_irq_pending[b] = false;
+                (b == I2C_BUS_CADDY) ? I2C0_IRQHandler() : I2C1_IRQHandler();
+            }
+        }
+    }
+}
+
+static void setup(void)
+{
+    sim_reset();
+    i2c_model_reset();
+    i2c_model_hook = bus_hook;
+    memset(held, 0, sizeof(held));
+    initI2C();
+    sampler_init();
+    i2c_model_add_sensors();
+}
+
+static sampler_stats_t stats_of(i2cDeviceId_t id)
+{
+    sampler_stats_t stats;
+
+    sampler_get_stats(id, &stats);
+    return stats;
+}
+
+
+/*==============================================================================
+ * SAMPLING
+ *============================================================================*/
+
+/**
+ * @brief Set-up writes first, then every device at its own period
+ */
+static void test_periods(void)
+{
+    sampler_sample_t sample;
+    uint32_t transfers;
+
+    setup();
+    CHECK(!sampler_running());
+    CHECK(!sampler_latest(I2C_DEVICE_COMPASS_A, &sample));                      // nothing yet
+    CHECK(sampler_start() && sampler_running());
+    CHECK(bus_transfers() == 3);                                                // one set-up write each, no reads yet
+    CHECK(i2c_model_devices[I2C_BUS_CADDY][0x19].regs[0x20] == 0x57);
+    CHECK(i2c_model_devices[I2C_BUS_CADDY][0x76].regs[0xF4] == 0x27);
+    CHECK(i2c_model_devices[I2C_BUS_COMPASS_B][0x19].regs[0x20] == 0x57);
+
+    run_ms(100);
+    CHECK(stats_of(I2C_DEVICE_COMPASS_A).samples == 5);                         // ticks 1, 21, 41, 61, 81
+    CHECK(stats_of(I2C_DEVICE_PRESSURE).samples == 1);                          // tick 1
+    CHECK(stats_of(I2C_DEVICE_COMPASS_B).samples == 5);
+    CHECK(i2c_model_devices[I2C_BUS_CADDY][0x19].reads == 5 && i2c_model_devices[I2C_BUS_CADDY][0x19].reads_before_setup == 0);
+    CHECK(i2c_model_devices[I2C_BUS_CADDY][0x76].reads_before_setup == 0);
+    CHECK(stats_of(I2C_DEVICE_COMPASS_A).errors == 0 && stats_of(I2C_DEVICE_COMPASS_A).missed == 0);
+    CHECK(stats_of(I2C_DEVICE_COMPASS_A).jitter_max_ns < 10000);                // every tick exactly 1 ms apart
+    CHECK(stats_of(I2C_DEVICE_COMPASS_A).latency_max_ns < 1000000);
+
+    CHECK(sampler_latest(I2C_DEVICE_COMPASS_A, &sample));
+    CHECK(sample.sequence == 5 && sample.tick_ms == 81 && sample.len == 6);
+    CHECK(sample.data[0] == 0x68 && sample.data[5] == 0x6D);                    // OUT_X_L_A .. OUT_Z_H_A
+    CHECK(sampler_latest(I2C_DEVICE_PRESSURE, &sample));
+    CHECK(sample.sequence == 1 && sample.data[0] == 0x77 && sample.data[5] == 0x7C);
+    CHECK(sampler_latest(I2C_DEVICE_COMPASS_B, &sample) && sample.data[0] == 0xE8);
+
+    transfers = bus_transfers();                                                // readers never touch the bus
+    CHECK(sampler_latest(I2C_DEVICE_COMPASS_A, &sample) && bus_transfers() == transfers);
+
+    i2c_model_devices[I2C_BUS_CADDY][0x19].regs[0x28] = 0x11;
+    run_ms(20);
+    CHECK(sampler_latest(I2C_DEVICE_COMPASS_A, &sample));
+    CHECK(sample.sequence == 6 && sample.tick_ms == 101 && sample.data[0] == 0x11);
+    CHECK(sampler_latest(I2C_DEVICE_PRESSURE, &sample) && sample.tick_ms == 101);
+
+    sampler_stop();
+    run_ms(100);
+    CHECK(!sampler_running() && stats_of(I2C_DEVICE_COMPASS_A).samples == 6);
+}
+
+static void test_periods_change(void)
+{
+    setup();
+    CHECK(!sampler_set_period(I2C_DEVICE_COUNT, 10));
+    CHECK(sampler_get_period(I2C_DEVICE_COUNT) == 0);
+    CHECK(sampler_set_period(I2C_DEVICE_COMPASS_A, 5) && sampler_get_period(I2C_DEVICE_COMPASS_A) == 5);
+    CHECK(sampler_set_period(I2C_DEVICE_PRESSURE, 0));                          // off
+    CHECK(sampler_start());
+    CHECK(i2c_model_devices[I2C_BUS_CADDY][0x76].writes == 0);                  // not sampled, not set up
+
+    run_ms(50);
+    CHECK(stats_of(I2C_DEVICE_COMPASS_A).samples == 10);
+    CHECK(stats_of(I2C_DEVICE_PRESSURE).samples == 0 && i2c_model_devices[I2C_BUS_CADDY][0x76].reads == 0);
+    CHECK(stats_of(I2C_DEVICE_COMPASS_B).samples == 3);
+    sampler_stop();
+}
+
+
+/*==============================================================================
+ * FAULTS
+ *============================================================================*/
+
+/**
+ * @brief A held caddy bus: its deadlines are missed, Compass B carries on
+ */
+static void test_missed(void)
+{
+    sampler_stats_t stats;
+
+    setup();
+    CHECK(sampler_start());
+    run_ms(20);
+    held[I2C_BUS_CADDY] = true;
+    run_ms(100);                                                                // ticks 21 - 120
+    stats = stats_of(I2C_DEVICE_COMPASS_A);
+    CHECK(stats.samples == 1 && stats.missed == 4 && stats.errors == 0);        // 21 queued and stuck, 41 - 101 missed
+    CHECK(stats_of(I2C_DEVICE_PRESSURE).missed == 0);                           // 101 queued behind Compass A, not yet late
+    CHECK(stats_of(I2C_DEVICE_COMPASS_B).samples == 6 && stats_of(I2C_DEVICE_COMPASS_B).missed == 0);
+
+    held[I2C_BUS_CADDY] = false;
+    run_ms(40);                                                                 // ticks 121 - 160
+    stats = stats_of(I2C_DEVICE_COMPASS_A);
+    CHECK(stats.samples == 3 && stats.missed == 5);                             // 21 lands after 121 was missed, then 141
+    CHECK(stats_of(I2C_DEVICE_PRESSURE).samples == 2 && stats_of(I2C_DEVICE_PRESSURE).missed == 0);
+
+    sampler_reset_stats();
+    CHECK(stats_of(I2C_DEVICE_COMPASS_A).samples == 0 && stats_of(I2C_DEVICE_COMPASS_A).missed == 0);
+    sampler_stop();
+}
+
+/**
+ * @brief Compass B unplugged: set-up reported, reads counted as errors, the
+ *        last good sample kept
+ */
+static void test_unplugged(void)
+{
+    sampler_sample_t sample;
+    uint32_t sequence;
+
+    setup();
+    CHECK(sampler_start());
+    run_ms(30);
+    CHECK(sampler_latest(I2C_DEVICE_COMPASS_B, &sample));
+    sequence = sample.sequence;
+    sampler_stop();
+
+    i2c_model_devices[I2C_BUS_COMPASS_B][0x19].present = false;
+    sampler_reset_stats();
+    CHECK(!sampler_start());                                                    // its set-up write NACKed
+    CHECK(stats_of(I2C_DEVICE_COMPASS_B).errors == 1);
+    CHECK(sampler_running());                                                   // the others still sample
+    run_ms(60);
+    CHECK(stats_of(I2C_DEVICE_COMPASS_B).errors == 1 + 3 && stats_of(I2C_DEVICE_COMPASS_B).samples == 0);
+    CHECK(stats_of(I2C_DEVICE_COMPASS_A).samples == 3 && stats_of(I2C_DEVICE_COMPASS_A).errors == 0);
+    CHECK(sampler_latest(I2C_DEVICE_COMPASS_B, &sample) && sample.sequence == sequence);
+    sampler_stop();
+}
+
+
+int main(void)
+{
+    test_periods();
+    test_periods_change();
+    test_missed();
+    test_unplugged();
+    return TEST_DONE();
+}
@@ -0,0 +1,282 @@
+/*
+ * test_spi_queue.c
+ *
+ * @brief Host test of the SPI transaction queue and its LDMA backend
+ * @description spi_queue.c runs first on a mock bus that logs every select
+ *              and transfer, both completing at once and completing later as
+ *              the LDMA does. That covers phase order, callbacks that queue
+ *              more work, rejected double submits, and a held queue that
+ *              starts nothing until it is released.
+ *
+ *              spi_bus.c then runs on the simulated LDMA and USART4. The last
+ *              check has the LDMA interrupt blocked with a transaction still
+ *              outstanding. A synchronous MAX14830 register read must then
+ *              collect the completion itself instead of spinning forever. A claimed
+ *              bus must keep new transactions off the wire until released.
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: JonathanStorey
+ *    Hardware: None (host build only)
+ *     Version: 1.0
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "test.h"
+#include "em_device.h"
+#include "em_core.h"
+#include "defines.h"
+#include "helpers.h"
+#include "dma.h"
+#include "spi_queue.h"
+#include "spi_bus.h"
+#include "usart_expanders.h"
+
+static spi_queue_t queue;
+static char bus_log[512];
+static bool deferred;                       // mock transfer() leaves completion to the test
+static bool transfer_due;
+static int callbacks;
+static spi_transaction_t t[4];
+static char cs_log[64];
+
+
+/*==============================================================================
+ * MOCK BUS
+ *============================================================================*/
+static void log_event(char *log, size_t size, const char *event)
+{
+    strncat(log, event, size - strlen(log) - 1);
+}
+
+static void mock_select(uint8_t cs, bool selected, void *ctx)
+{
+    char event[8];
+    (void)ctx;
+
+    event[0] = selected ? 'S' : 'D';
+    event[1] = (char)('0' + cs);
+    event[2] = ' ';
+    event[3] = '\0';
+    log_event(bus_log, sizeof(bus_log), event);
+}
+
+/**
+ * @brief Full duplex: each byte comes back inverted
+ */
+static void mock_transfer(const uint8_t *tx, uint8_t *rx, uint16_t len, void *ctx)
+{
+    char event[8];
+    (void)ctx;
+
+    event[0] = 'X';
+    event[1] = (char)('0' + len);
+    event[2] = ' ';
+    event[3] = '\0';
+    log_event(bus_log, sizeof(bus_log), event);
+    for (uint16_t i = 0; i < len; i++)
+    {
+        if (rx)
+        {
+            rx[i] = (uint8_t)~(tx ? tx[i] : 0);
+        }
+    }
+    if (deferred)
+    {
+        transfer_due = true;
+    }
+    else
+    {
+        spi_queue_transfer_done(&queue);
+    }
+}
+
+static const spi_bus_ops_t mock_ops = { mock_select, mock_transfer, NULL };
+
+/**
+ * @brief Counts completions - the first one queues t[3] behind the others
+ */
+static void queue_callback(spi_transaction_t *done)
+{
+    callbacks++;
+    if (done == &t[0])
+    {
+        CHECK(spi_queue_submit(&queue, &t[3]));
+    }
+}
+
+
+/*==============================================================================
+ * QUEUE
+ *============================================================================*/
+static void test_queue(void)
+{
+    static const uint8_t cmd = 0x81;
+    static const uint8_t data[4] = { 1, 2, 3, 4 };
+    static uint8_t rx[4];
+    static uint8_t rx3[2];
+    static const char *const expect[2] =
+    {
+        "S0 X1 X4 D0 S2 X2 D2 S1 X1 D1 S3 D3 ",                                  // t[0] done before t[1] was queued
+        "S0 X1 X4 D0 S1 X1 D1 S3 D3 S2 X2 D2 "
+    };
+
+    for (int late = 0; late < 2; late++)
+    {
+        memset(t, 0, sizeof(t));
+        memset(rx, 0, sizeof(rx));
+        bus_log[0] = '\0';
+        callbacks = 0;
+        deferred = late;
+        transfer_due = false;
+        spi_queue_init(&queue, &mock_ops);
+
+        t[0] = (spi_transaction_t){ .cs = 0, .cmd = &cmd, .cmd_len = 1, .tx = data, .rx = rx, .len = 4, .callback = queue_callback };
+        t[1] = (spi_transaction_t){ .cs = 1, .cmd = &cmd, .cmd_len = 1, .callback = queue_callback };
+        t[2] = (spi_transaction_t){ .cs = 3, .callback = queue_callback };                      // select / deselect only
+        t[3] = (spi_transaction_t){ .cs = 2, .rx = rx3, .len = 2, .callback = queue_callback };  // clocks out zeros
+
+        CHECK(spi_queue_submit(&queue, &t[0]));
+        CHECK(spi_queue_submit(&queue, &t[1]));
+        CHECK(spi_queue_submit(&queue, &t[2]));
+        if (late)
+        {
+            CHECK(t[0].status == SPI_STATUS_ACTIVE && t[1].status == SPI_STATUS_PENDING);
+            CHECK(!spi_queue_submit(&queue, &t[1]));                            // already queued
+            CHECK(!spi_queue_is_idle(&queue));
+        }
+        while (transfer_due)
+        {
+            transfer_due = false;
+            spi_queue_transfer_done(&queue);
+        }
+
+        CHECK(strcmp(bus_log, expect[late]) == 0);
+        CHECK(callbacks == 4 && spi_queue_is_idle(&queue) && spi_queue_completed(&queue) == 4);
+        CHECK(rx[0] == 0xFE && rx[3] == 0xFB && rx3[0] == 0xFF && rx3[1] == 0xFF);
+        CHECK(t[0].status == SPI_STATUS_DONE && t[3].status == SPI_STATUS_DONE);
+    }
+
+    CHECK(spi_queue_submit(&queue, &t[2]));                                     // a finished descriptor can go again
+    CHECK(spi_queue_completed(&queue) == 5);
+}
+
+/**
+ * @brief A held queue takes submits but starts nothing until released, and a
+ *        hold taken mid-transaction lets that one finish
+ */
+static void test_hold(void)
+{
+    bus_log[0] = '\0';
+    callbacks = 0;
+    deferred = true;
+    transfer_due = false;
+    spi_queue_init(&queue, &mock_ops);
+    t[0] = (spi_transaction_t){ .cs = 0, .len = 1 };
+    t[1] = (spi_transaction_t){ .cs = 1, .len = 1, .callback = queue_callback };
+    t[2] = (spi_transaction_t){ .cs = 2, .len = 1 };
+
+    spi_queue_hold(&queue, true);
+    CHECK(spi_queue_submit(&queue, &t[1]));
+    CHECK(bus_log[0] == '\0' && t[1].status == SPI_STATUS_PENDING && !spi_queue_is_idle(&queue));
+    spi_queue_hold(&queue, false);                                              // starts t[1]
+    CHECK(strcmp(bus_log, "S1 X1 ") == 0 && t[1].status == SPI_STATUS_ACTIVE);
+
+    CHECK(spi_queue_submit(&queue, &t[2]));
+    spi_queue_hold(&queue, true);
+    transfer_due = false;
+    spi_queue_transfer_done(&queue);                                            // t[1] finishes, t[2] stays put
+    CHECK(strcmp(bus_log, "S1 X1 D1 ") == 0 && callbacks == 1);
+    CHECK(t[1].status == SPI_STATUS_DONE && t[2].status == SPI_STATUS_PENDING);
+    spi_queue_hold(&queue, false);
+    transfer_due = false;
+    spi_queue_transfer_done(&queue);
+    CHECK(strcmp(bus_log, "S1 X1 D1 S2 X1 D2 ") == 0 && spi_queue_is_idle(&queue));
+    deferred = false;
+}
+
+
+/*==============================================================================
+ * LDMA BACKEND
+ *============================================================================*/
+static uint8_t spi_echo(uint8_t tx)
+{
+    return (uint8_t)~tx;
+}
+
+static void irq_model(void)
+{
+    sim_sync();
+    while (sim_irq_enabled[LDMA_IRQn] && !sim_irq_blocked[LDMA_IRQn] && (LDMA->IF & LDMA->IEN))
+    {
+        LDMA_IRQHandler();
+        sim_sync();
+    }
+}
+
+static void bus_callback(spi_transaction_t *done)
+{
+    (void)done;
+    callbacks++;
+}
+
+void Set_Expander_A_CS_State(char CS_state)     { log_event(cs_log, sizeof(cs_log), CS_state == Selected ? "A+" : "A-"); }
+void Set_Expander_B_CS_State(char CS_state)     { log_event(cs_log, sizeof(cs_log), CS_state == Selected ? "B+" : "B-"); }
+void Set_Expander_C_CS_State(char CS_state)     { log_event(cs_log, sizeof(cs_log), CS_state == Selected ? "C+" : "C-"); }
+
+static void test_bus(void)
+{
+    static const uint8_t cmd[2] = { 0x05, 0x06 };
+    static uint8_t rx[3];
+    spi_transaction_t tr = { .cs = SPI_CS_EXPANDER_B, .cmd = cmd, .cmd_len = 2, .rx = rx, .len = 3, .callback = bus_callback };
+
+    sim_reset();
+    sim_spi_hook = spi_echo;
+    sim_irq_hook = irq_model;
+    spi_bus_init();
+    callbacks = 0;
+    cs_log[0] = '\0';
+
+    CHECK(spi_bus_submit(&tr));                                                 // runs to completion on the interrupt
+    CHECK(spi_bus_idle() && callbacks == 1 && tr.status == SPI_STATUS_DONE);
+    CHECK(rx[0] == 0xFF && rx[2] == 0xFF);
+    CHECK(strcmp(cs_log, "B+B-") == 0);
+    CHECK(spi_bus_completed() == 1);
+
+    tr.len = DMA_MAX_XFER + 1;
+    CHECK(!spi_bus_submit(&tr));                                                // longer than one descriptor
+    tr.len = 3;
+
+    /* LDMA interrupt blocked, e.g. a register read from a higher priority ISR */
+    sim_irq_blocked[LDMA_IRQn] = true;
+    cs_log[0] = '\0';
+    CHECK(spi_bus_submit(&tr));
+    CHECK(!spi_bus_idle() && tr.status == SPI_STATUS_ACTIVE);                   // done flag raised, nobody to take it
+    MAX14830_ReadRegister(EXPANDER_A, MAX14830_UART0, MAX14830_LSR_REG);
+    CHECK(spi_bus_idle() && callbacks == 2 && tr.status == SPI_STATUS_DONE);
+    CHECK(strcmp(cs_log, "B+B-A+A-") == 0);                                     // queued transaction first, then the read
+    sim_irq_blocked[LDMA_IRQn] = false;
+
+    /* a claimed bus - a synchronous chip select cycle - defers new work */
+    sim_irq_blocked[LDMA_IRQn] = true;
+    CHECK(spi_bus_submit(&tr));
+    CHECK(!spi_bus_claim());                                                    // still outstanding
+    sim_irq_blocked[LDMA_IRQn] = false;
+    CORE_ATOMIC_SECTION()                                                       // unmasked - the completion is taken
+    CHECK(spi_bus_idle() && spi_bus_claim());
+    cs_log[0] = '\0';
+    CHECK(spi_bus_submit(&tr));
+    CHECK(tr.status == SPI_STATUS_PENDING && cs_log[0] == '\0' && !spi_bus_idle());   // never reached the bus
+    spi_bus_release();
+    CHECK(spi_bus_idle() && tr.status == SPI_STATUS_DONE && strcmp(cs_log, "B+B-") == 0);
+}
+
+
+int main(void)
+{
+    test_queue();
+    test_hold();
+    test_bus();
+    return TEST_DONE();
+}
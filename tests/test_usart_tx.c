@@ -0,0 +1,323 @@
+/*
+ * test_usart_tx.c
+ *
+ * @brief Host test of the USART TX rings: byte order and the full-ring policies
+ * @description usart.c runs against the simulated USART in stubs/. The Node
+ *              port (USART2) is used throughout. The interrupt model runs the
+ *              TXBL handler whenever interrupts are unmasked and the line has
+ *              room; a stalled line (sim_txbl_budget = 0) lets the ring fill
+ *              so UART_TX_BLOCK, UART_TX_DROP and UART_TX_OVERWRITE can be
+ *              driven into their full-ring paths. The RS485 checks cover
+ *              DE on AUTOCS and the software DE turnaround flag.
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: JonathanStorey
+ *    Hardware: None (host build only)
+ *     Version: 1.0
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "test.h"
+#include "em_device.h"
+#include "em_core.h"
+#include "defines.h"
+#include "ring_buffer.h"
+#include "usart.h"
+#include "dma.h"
+
+void USART2_TX_IRQHandler(void);
+
+static uint8_t pattern[1000];
+static uint16_t produce_len;
+static int dma_callbacks;
+
+
+/**
+ * @brief Interrupt model: the Node TX interrupt and the LDMA interrupt
+ */
+static void irq_model(void)
+{
+    bool again = true;
+
+    while (again)
+    {
+        again = false;
+        if (sim_irq_enabled[USART2_TX_IRQn] && !sim_irq_blocked[USART2_TX_IRQn] &&
+            (USART2->IEN & USART_IEN_TXBL) && sim_txbl_budget > 0)
+        {
+            USART2_TX_IRQHandler();
+            again = true;
+        }
+        sim_sync();
+        if (sim_irq_enabled[LDMA_IRQn] && !sim_irq_blocked[LDMA_IRQn] && (LDMA->IF & LDMA->IEN))
+        {
+            LDMA_IRQHandler();
+            again = true;
+        }
+    }
+}
+
+/**
+ * @brief Let a stalled line run again and give pending interrupts their turn
+ */
+static void line_resume(void)
+{
+    CORE_DECLARE_IRQ_STATE;
+
+    sim_txbl_budget = UINT32_MAX;
+    CORE_ENTER_ATOMIC();
+    CORE_EXIT_ATOMIC();
+}
+
+static void setup(void)
+{
+    sim_reset();
+    usart_init();
+    sim_irq_hook = irq_model;
+}
+
+static void dma_done(int port, const void *buf, size_t len)
+{
+    (void)port;
+    (void)buf;
+    (void)len;
+    dma_callbacks++;
+}
+
+static bool wire_is(const void *expect, uint32_t len)
+{
+    sim_wire_t *wire = sim_wire(USART2);
+
+    return wire->len == len && memcmp(wire->data, expect, len) == 0;
+}
+
+static uint16_t producer(ring_buffer_t *ring, void *ctx)
+{
+    (void)ctx;
+    for (uint16_t i = 0; i < produce_len; i++)
+    {
+        ring_buffer_poke(ring, i, (uint8_t)('A' + i % 26));
+    }
+    ring_buffer_commit(ring, produce_len);
+    return produce_len;
+}
+
+
+/*==============================================================================
+ * RING BUFFER
+ *============================================================================*/
+static void test_ring_buffer(void)
+{
+    static uint8_t storage[16];
+    ring_buffer_t rb;
+    const uint8_t *span;
+    uint8_t out[16];
+    uint8_t c;
+
+    ring_buffer_init(&rb, storage, sizeof(storage));
+    CHECK(ring_buffer_is_empty(&rb) && ring_buffer_space(&rb) == 16);
+    CHECK(ring_buffer_write(&rb, pattern, 20) == 16);
+    CHECK(ring_buffer_is_full(&rb) && !ring_buffer_put(&rb, 0));
+    CHECK(ring_buffer_read(&rb, out, 10) == 10 && memcmp(out, pattern, 10) == 0);
+
+    CHECK(ring_buffer_write(&rb, &pattern[16], 8) == 8);                       // wraps
+    CHECK(ring_buffer_peek_contiguous(&rb, &span) == 6 && span[0] == pattern[10]);
+    ring_buffer_consume(&rb, 6);
+    CHECK(ring_buffer_peek_contiguous(&rb, &span) == 8 && span[0] == pattern[16]);
+    CHECK(ring_buffer_count(&rb) == 8);
+
+    ring_buffer_poke(&rb, 0, 0xAA);                                             // invisible until committed
+    CHECK(ring_buffer_count(&rb) == 8);
+    ring_buffer_commit(&rb, 1);
+    ring_buffer_consume(&rb, 8);
+    CHECK(ring_buffer_get(&rb, &c) && c == 0xAA && ring_buffer_is_empty(&rb));
+}
+
+
+/*==============================================================================
+ * ORDERING
+ *============================================================================*/
+static void test_order(void)
+{
+    setup();
+    print_string("hello ", Node);
+    uart_write(Node, "world", 5);
+    put_char('!', Node);
+    CHECK(wire_is("hello world!", 12));
+    CHECK(uart_tx_pending(Node) == 0);
+    CHECK((USART2->IEN & USART_IEN_TXBL) == 0);                                 // switched off once the ring ran dry
+
+    setup();
+    CHECK(uart_write(Node, pattern, sizeof(pattern)) == sizeof(pattern));      // more than one ring's worth
+    CHECK(wire_is(pattern, sizeof(pattern)));
+    CHECK(uart_tx_dropped(Node) == 0);
+}
+
+static void test_order_with_dma(void)
+{
+    static const char dma_text[] = "CDE";
+
+    setup();
+    sim_txbl_budget = 0;                                                        // hold everything in the queues
+    print_string("ab", Node);
+    CHECK(uart_write_dma(Node, dma_text, 3, NULL));
+    print_string("fg", Node);
+    CHECK(sim_wire(USART2)->len == 0);
+    line_resume();
+    CHECK(wire_is("abCDEfg", 7));
+}
+
+
+/*==============================================================================
+ * FULL-RING POLICIES
+ *============================================================================*/
+static void test_block_polled(void)
+{
+    setup();
+    sim_irq_blocked[USART2_TX_IRQn] = true;                                     // e.g. printing from an ISR
+    CHECK(uart_write(Node, pattern, sizeof(pattern)) == sizeof(pattern));
+    uart_tx_flush(Node);
+    CHECK(wire_is(pattern, sizeof(pattern)));
+    CHECK(uart_tx_dropped(Node) == 0);
+}
+
+/**
+ * @brief UART_TX_BLOCK with a DMA job in the queue and the TX interrupt blocked:
+ *        polling has to start the job at its mark, and collect its completion
+ *        too when the LDMA interrupt is also blocked
+ */
+static void test_block_polled_dma(void)
+{
+    static const char dma_text[] = "0123456789";
+    static uint8_t expect[2 + 10 + 600];
+
+    memcpy(expect, "ab", 2);
+    memcpy(&expect[2], dma_text, 10);
+    memcpy(&expect[12], pattern, 600);
+
+    for (int ldma_blocked = 0; ldma_blocked < 2; ldma_blocked++)
+    {
+        setup();
+        dma_callbacks = 0;
+        sim_irq_blocked[USART2_TX_IRQn] = true;
+        sim_irq_blocked[LDMA_IRQn] = ldma_blocked;
+        print_string("ab", Node);
+        CHECK(uart_write_dma(Node, dma_text, 10, dma_done));
+        CHECK(uart_write(Node, pattern, 600) == 600);
+        uart_tx_flush(Node);
+        CHECK(wire_is(expect, sizeof(expect)));
+        CHECK(dma_callbacks == 1);
+    }
+}
+
+static void test_drop(void)
+{
+    setup();
+    uart_set_tx_policy(Node, UART_TX_DROP);
+    sim_txbl_budget = 0;
+    CHECK(uart_write(Node, pattern, 300) == USART_TX_RING_SIZE);
+    CHECK(uart_tx_dropped(Node) == 300 - USART_TX_RING_SIZE);
+    CHECK(uart_tx_pending(Node) == USART_TX_RING_SIZE);
+    line_resume();
+    CHECK(wire_is(pattern, USART_TX_RING_SIZE));                                // newest bytes lost
+}
+
+static void test_overwrite(void)
+{
+    setup();
+    uart_set_tx_policy(Node, UART_TX_OVERWRITE);
+    sim_txbl_budget = 0;
+    CHECK(uart_write(Node, pattern, 300) == 300);
+    CHECK(uart_tx_dropped(Node) == 300 - USART_TX_RING_SIZE);
+    line_resume();
+    CHECK(wire_is(&pattern[300 - USART_TX_RING_SIZE], USART_TX_RING_SIZE));    // oldest bytes lost
+}
+
+static void test_produce(void)
+{
+    setup();
+    uart_set_tx_policy(Node, UART_TX_DROP);
+    sim_txbl_budget = 0;
+    produce_len = USART_TX_RING_SIZE - 10;
+    CHECK(uart_tx_produce(Node, produce_len, producer, NULL) == produce_len);
+    produce_len = 20;
+    CHECK(uart_tx_produce(Node, produce_len, producer, NULL) == 0);             // dropped whole, not cut short
+    CHECK(uart_tx_dropped(Node) == 20);
+    CHECK(uart_tx_pending(Node) == USART_TX_RING_SIZE - 10);
+
+    setup();
+    sim_irq_blocked[USART2_TX_IRQn] = true;                                     // UART_TX_BLOCK waits for room by polling
+    produce_len = 200;
+    CHECK(uart_tx_produce(Node, produce_len, producer, NULL) == 200);
+    CHECK(uart_tx_produce(Node, produce_len, producer, NULL) == 200);
+    uart_tx_flush(Node);
+    CHECK(sim_wire(USART2)->len == 400 && sim_wire(USART2)->data[399] == 'A' + 199 % 26);
+}
+
+
+/*==============================================================================
+ * RS485 DRIVER ENABLE
+ *============================================================================*/
+/**
+ * @brief IMU and Thrusters DE on AUTOCS, Node DE a GPIO released by TXC and
+ *        flagged late by TIMECMP1 running from the end of the stop bit
+ */
+static void test_rs485(void)
+{
+    uint32_t released, late;
+
+    setup();
+    CHECK((USART0->CTRL & (USART_CTRL_AUTOCS | USART_CTRL_CSINV | USART_CTRL_AUTOTRI)) ==
+          (USART_CTRL_AUTOCS | USART_CTRL_CSINV | USART_CTRL_AUTOTRI));
+    CHECK((USART0->ROUTEPEN & USART_ROUTEPEN_CSPEN) && ((USART0->ROUTELOC0 & _USART_ROUTELOC0_CSLOC_MASK) >> _USART_ROUTELOC0_CSLOC_SHIFT) == 2);
+    CHECK((USART3->ROUTEPEN & USART_ROUTEPEN_CSPEN) && ((USART3->ROUTELOC0 & _USART_ROUTELOC0_CSLOC_MASK) >> _USART_ROUTELOC0_CSLOC_SHIFT) == 1);
+    CHECK(!(USART2->CTRL & USART_CTRL_AUTOCS) && !(USART2->ROUTEPEN & USART_ROUTEPEN_CSPEN));
+    CHECK(USART2->TIMECMP1 & USART_TIMECMP1_TSTART_TXEOF);
+    CHECK(!(USART1->CTRL & (USART_CTRL_AUTOCS | USART_CTRL_AUTOTRI)) && USART1->TIMECMP1 == 0);
+
+    CHECK(uart_write(Thrusters, "abc", 3) == 3);                                // hardware DE - nothing for software to do
+    CHECK(!(USART3->IEN & USART_IEN_TXC) && GPIO_PinOutGet(gpioPortE, 4) == 0);
+
+    CHECK(uart_write(Node, "abc", 3) == 3);
+    CHECK(GPIO_PinOutGet(gpioPortF, 5) == 1 && (USART2->IEN & USART_IEN_TXC));
+    CHECK(wire_is("abc", 3));
+    USART2->IF |= USART_IF_TXC;                                                 // released within a bit of the stop bit
+    USART2_TX_IRQHandler();
+    uart_rs485_turnaround(Node, &released, &late);
+    CHECK(GPIO_PinOutGet(gpioPortF, 5) == 0 && !(USART2->IEN & USART_IEN_TXC));
+    CHECK(released == 1 && late == 0);
+
+    USART2->IF |= USART_IF_TCMP1;                                               // an idle gap before the next burst doesn't count
+    CHECK(uart_write(Node, "de", 2) == 2);
+    sim_sync();
+    CHECK(!(USART2->IF & USART_IF_TCMP1));
+    USART2->IF |= USART_IF_TXC | USART_IF_TCMP1;                                // TXC serviced after the comparator fired
+    USART2_TX_IRQHandler();
+    uart_rs485_turnaround(Node, &released, &late);
+    CHECK(GPIO_PinOutGet(gpioPortF, 5) == 0 && released == 2 && late == 1);
+
+    uart_rs485_turnaround(Thrusters, &released, &late);
+    CHECK(released == 0 && late == 0);
+}
+
+
+int main(void)
+{
+    for (size_t i = 0; i < sizeof(pattern); i++)
+    {
+        pattern[i] = (uint8_t)(i * 7 + i / 256);
+    }
+
+    test_ring_buffer();
+    test_order();
+    test_order_with_dma();
+    test_block_polled();
+    test_block_polled_dma();
+    test_drop();
+    test_overwrite();
+    test_produce();
+    test_rs485();
+    return TEST_DONE();
+}
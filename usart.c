@@ -10,12 +10,20 @@
 #include "em_gpio.h"
 #include "em_usart.h"
 #include "em_chip.h"
+#include "em_core.h"
+#include "em_emu.h"
+#include "em_ldma.h"
 #include "EFM32GG11B420F2048GQ100.h"
 //#include "sw_delay.h"
 #include "em_timer.h"
 #include "hw_timer.h"
 #include "usart.h"
 #include "defines.h"
+#include "ring_buffer.h"
+#include "node_printf.h"
+#include "dma.h"
+#include "dma_queue.h"
+#include <string.h>
 
 
 
@@ -43,7 +51,7 @@
   {                                                                             \
     usartEnable,     /* Enable RX/TX when initialization is complete. */                     \
     0,               /* Use current configured reference clock for configuring baud rate. */ \
-    500000,         /* 1 Mbits/s. */                                                        \
+    500000,          /* 500 kbit/s bring-up rate - raised by MAX14830_TuneSpiClock(). */     \
     usartDatabits8,  /* 8 databits. */                                                       \
     true,            /* Master mode. */                                                      \
     true,           /* Send least significant bit first. */                                 \
@@ -59,28 +67,201 @@
 
 
 
+/*==============================================================================
+ * PORT LINE CONFIGURATION
+ * Applied by usart_init() and changed at runtime with uart_configure().
+ * Expander (USART4) is the SPI bus and is configured by SPI_MODE instead.
+ *============================================================================*/
+static uart_port_config_t usart_config[USART_PORT_COUNT] =
+{
+    [IMU]       = { 115200, usartNoParity, usartStopbits1, usartOVS16, true,  gpioPortC, 8, 2 },                 // PC8 = US0_CS #2
+    [PDEM]      = { 115200, usartNoParity, usartStopbits1, usartOVS16, false, gpioPortA, 0, UART_DE_SOFTWARE },
+    [Node]      = { 115200, usartNoParity, usartStopbits1, usartOVS16, true,  gpioPortF, 5, UART_DE_SOFTWARE },  // PF5 is no US2_CS location
+    [Thrusters] = { 115200, usartNoParity, usartStopbits1, usartOVS16, true,  gpioPortE, 4, 1 },                 // PE4 = US3_CS #1
+    [Expander]  = { 0,      usartNoParity, usartStopbits1, usartOVS16, false, gpioPortA, 0, UART_DE_SOFTWARE },
+    [SDAS]      = { 115200, usartNoParity, usartStopbits1, usartOVS16, false, gpioPortA, 0, UART_DE_SOFTWARE },
+    [FCPU]      = { 115200, usartNoParity, usartStopbits1, usartOVS16, false, gpioPortA, 0, UART_DE_SOFTWARE },
+    [USBL]      = { 115200, usartNoParity, usartStopbits1, usartOVS16, false, gpioPortA, 0, UART_DE_SOFTWARE },
+};
 
-void usart_init(void)
+
+
+
+/*==============================================================================
+ * PORT TABLES
+ * Indexed by destination_t - order must match the enum in defines.h
+ *============================================================================*/
+static USART_TypeDef *const usart_ports[USART_PORT_COUNT] =
+{
+    USART0,                         // IMU
+    USART1,                         // PDEM
+    USART2,                         // Node
+    USART3,                         // Thrusters
+    USART4,                         // Expander (SPI - never interrupt driven)
+    USART5,                         // SDAS
+    UART0,                          // FCPU
+    UART1                           // USBL
+};
+
+static const IRQn_Type usart_tx_irqs[USART_PORT_COUNT] =
+{
+    USART0_TX_IRQn, USART1_TX_IRQn, USART2_TX_IRQn, USART3_TX_IRQn,
+    USART4_TX_IRQn, USART5_TX_IRQn, UART0_TX_IRQn,  UART1_TX_IRQn
+};
+
+static const IRQn_Type usart_rx_irqs[USART_PORT_COUNT] =
+{
+    USART0_RX_IRQn, USART1_RX_IRQn, USART2_RX_IRQn, USART3_RX_IRQn,
+    USART4_RX_IRQn, USART5_RX_IRQn, UART0_RX_IRQn,  UART1_RX_IRQn
+};
+
+
+/*==============================================================================
+ * TX RING BUFFERS
+ *============================================================================*/
+static uint8_t tx_storage[USART_PORT_COUNT][USART_TX_RING_SIZE];
+static ring_buffer_t tx_ring[USART_PORT_COUNT];
+static volatile uart_tx_policy_t tx_policy[USART_PORT_COUNT];
+static volatile uint32_t tx_dropped[USART_PORT_COUNT];
+
+
+/*==============================================================================
+ * LDMA TRANSMIT QUEUES
+ * A queued DMA job carries the TX ring head at the time it was queued (its
+ * mark). The TXBL interrupt stops draining the ring when it reaches the mark
+ * and hands the port to the LDMA, so ring and DMA output stay in call order.
+ *============================================================================*/
+static const LDMA_PeripheralSignal_t usart_tx_dma_signals[USART_PORT_COUNT] =
+{
+    ldmaPeripheralSignal_USART0_TXBL, ldmaPeripheralSignal_USART1_TXBL,
+    ldmaPeripheralSignal_USART2_TXBL, ldmaPeripheralSignal_USART3_TXBL,
+    ldmaPeripheralSignal_USART4_TXBL, ldmaPeripheralSignal_USART5_TXBL,
+    ldmaPeripheralSignal_UART0_TXBL,  ldmaPeripheralSignal_UART1_TXBL
+};
+
+static dma_queue_t tx_dma_queue[USART_PORT_COUNT];
+static LDMA_Descriptor_t tx_dma_desc[USART_PORT_COUNT];
+static volatile uint16_t tx_dma_chunk[USART_PORT_COUNT];      ///< Bytes in the transfer in flight
+static volatile bool tx_dma_active[USART_PORT_COUNT];         ///< LDMA currently owns TXDATA
+
+
+/*==============================================================================
+ * RX RING BUFFERS
+ *============================================================================*/
+static uint8_t rx_storage[USART_PORT_COUNT][USART_RX_RING_SIZE];
+static ring_buffer_t rx_ring[USART_PORT_COUNT];
+static volatile uint32_t rx_overruns[USART_PORT_COUNT];     ///< Bytes lost - ring full or hardware RXOF
+
+
+/*==============================================================================
+ * CIRCULAR LDMA RECEIVE
+ * The LDMA writes straight into rx_ring's storage through two linked half-
+ * buffer descriptors that loop forever. The ring head is recovered from the
+ * channel's destination address on the half/full DONE interrupts, on the
+ * USART idle timeout (TIMECMP0) and whenever the application looks at the
+ * ring, so uart_read()/uart_available() work unchanged on these ports.
+ *============================================================================*/
+static const LDMA_PeripheralSignal_t usart_rx_dma_signals[USART_PORT_COUNT] =
 {
+    ldmaPeripheralSignal_USART0_RXDATAV, ldmaPeripheralSignal_USART1_RXDATAV,
+    ldmaPeripheralSignal_USART2_RXDATAV, ldmaPeripheralSignal_USART3_RXDATAV,
+    ldmaPeripheralSignal_USART4_RXDATAV, ldmaPeripheralSignal_USART5_RXDATAV,
+    ldmaPeripheralSignal_UART0_RXDATAV,  ldmaPeripheralSignal_UART1_RXDATAV
+};
+
+static uint8_t imu_rx_dma_storage[USART_RX_DMA_RING_SIZE];
+static uint8_t sdas_rx_dma_storage[USART_RX_DMA_RING_SIZE];
+static uint8_t usbl_rx_dma_storage[USART_RX_DMA_RING_SIZE];
+
+static LDMA_Descriptor_t rx_dma_desc[USART_PORT_COUNT][2];
+static volatile bool rx_dma_enabled[USART_PORT_COUNT];
+static uart_rx_span_callback_t rx_dma_callback[USART_PORT_COUNT];
+static volatile uint32_t rx_bursts[USART_PORT_COUNT];       ///< Idle-line timeouts seen
+
+
+
+
+/*==============================================================================
+ * RS485 DRIVER ENABLE
+ * Where DE sits on one of the USART's CS locations (de_csloc) AUTOCS drives it
+ * in hardware: on one bit before the start bit, off as the last stop bit ends,
+ * with CSINV making it active high. Otherwise DE is a GPIO asserted by the TX
+ * path before the first byte is written and released from the TXC interrupt
+ * once the ring, the DMA queue and the shift register are all empty.
+ * TIMECMP1 starts at the end of every frame and stops on the next start bit,
+ * so TCMP1 being set when the GPIO is released means DE outlived the last stop
+ * bit by more than USART_RS485_TURN_BITS. AUTOTRI tri-states the TX pin
+ * whenever the transmitter idles.
+ *============================================================================*/
+static volatile bool rs485_de_on[USART_PORT_COUNT];
+static volatile uint32_t rs485_released[USART_PORT_COUNT];    ///< Software DE releases
+static volatile uint32_t rs485_late[USART_PORT_COUNT];        ///< ... of which came later than USART_RS485_TURN_BITS
+
+
+
+
+/*==============================================================================
+ * 9-BIT MULTIDROP
+ * Address frames have the 9th bit set (MPAB = 1). The receiver runs with
+ * RXBLOCK on, so data frames on the shared bus never reach RXDATA; address
+ * frames still do, and the RX handler lifts RXBLOCK only for our address or
+ * the broadcast address. Series 1 has no hardware address comparator, so the
+ * compare is one instruction per address frame in the RX interrupt.
+ *============================================================================*/
+#define MULTIDROP_ADDRESS_BIT   0x100                                           // 9th bit of RXDATAX / TXDATAX
+
+static volatile bool mp_enabled[USART_PORT_COUNT];
+static volatile bool mp_selected[USART_PORT_COUNT];         ///< Last address frame was ours
+static uint8_t mp_address[USART_PORT_COUNT];
+static volatile uint32_t mp_matched[USART_PORT_COUNT];      ///< Address frames for us (or broadcast)
+static volatile uint32_t mp_ignored[USART_PORT_COUNT];      ///< Address frames for other nodes
+
 
+
+
+static void usart_de_setup(destination_t destination);
+static void usart_tx_dma_done(unsigned int channel, void *ctx);
+static void usart_rx_dma_event(unsigned int channel, void *ctx);
+
+
+/**
+ * @brief Reset and initialise one asynchronous port from its usart_config[] entry
+ * @param destination: Port to initialise (never Expander)
+ */
+static void usart_init_async(destination_t destination)
+{
   USART_InitAsync_TypeDef init = MODE;
+  const uart_port_config_t *config = &usart_config[destination];
+
+  init.baudrate = config->baudrate;
+  init.parity = config->parity;
+  init.stopbits = config->stopbits;
+  init.oversampling = config->oversampling;
+
+  USART_InitAsync(usart_ports[destination], &init);
+}
+
+
+void usart_init(void)
+{
+
   USART_InitSync_TypeDef spiInit = SPI_MODE;  // SPI configuration
 
 
   //Initialize USART/UART asynchronous mode and route pins
-  USART_InitAsync(USART0, &init);
+  usart_init_async(IMU);
   USART0->ROUTELOC0 = USART_ROUTELOC0_RXLOC_LOC2 | USART_ROUTELOC0_TXLOC_LOC2;      //USART 0 - LOCATION 2 - IMU
   USART0->ROUTEPEN |= USART_ROUTEPEN_TXPEN | USART_ROUTEPEN_RXPEN;
 
-  USART_InitAsync(USART1, &init);
+  usart_init_async(PDEM);
   USART1->ROUTELOC0 = USART_ROUTELOC0_RXLOC_LOC1 | USART_ROUTELOC0_TXLOC_LOC1;      //USART 1 - LOCATION 1 - PDEM  - checked correct
   USART1->ROUTEPEN |= USART_ROUTEPEN_TXPEN | USART_ROUTEPEN_RXPEN;
 
-  USART_InitAsync(USART2, &init);
+  usart_init_async(Node);
   USART2->ROUTELOC0 = USART_ROUTELOC0_RXLOC_LOC5 | USART_ROUTELOC0_TXLOC_LOC5;      //USART 2 - LOCATION 5 - NODE - checked correct
   USART2->ROUTEPEN |= USART_ROUTEPEN_TXPEN | USART_ROUTEPEN_RXPEN;
 
-  USART_InitAsync(USART3, &init);
+  usart_init_async(Thrusters);
   USART3->ROUTELOC0 = USART_ROUTELOC0_RXLOC_LOC1 | USART_ROUTELOC0_TXLOC_LOC1;      //USART 3 - LOCATION 1 - THRUSTERS
   USART3->ROUTEPEN |= USART_ROUTEPEN_TXPEN | USART_ROUTEPEN_RXPEN;
 
@@ -88,15 +269,15 @@ void usart_init(void)
   USART4->ROUTELOC0 = USART_ROUTELOC0_RXLOC_LOC0 | USART_ROUTELOC0_TXLOC_LOC0 | USART_ROUTELOC0_CLKLOC_LOC0;      //USART 4 - LOCATION 0 - 3 USART EXPANDER -> payload A, B,C,D, E, Antenna, Ext pressure
   USART4->ROUTEPEN |= USART_ROUTEPEN_TXPEN | USART_ROUTEPEN_RXPEN | USART_ROUTEPEN_CLKPEN;       //SPI. INCLUDES CLOCK LOCATION AND ROUTING.
 
-  USART_InitAsync(USART5, &init);
+  usart_init_async(SDAS);
   USART5->ROUTELOC0 = USART_ROUTELOC0_RXLOC_LOC2 | USART_ROUTELOC0_TXLOC_LOC1;      //USART 5 - LOCATION 2/1 - SDAS - checked working
   USART5->ROUTEPEN |= USART_ROUTEPEN_TXPEN | USART_ROUTEPEN_RXPEN;
 
-  USART_InitAsync(UART0, &init);
+  usart_init_async(FCPU);
   UART0->ROUTELOC0 = (USART_ROUTELOC0_TXLOC_LOC1 | USART_ROUTELOC0_RXLOC_LOC1);       //UART 0 - LOCATION 1 - USBL
   UART0->ROUTEPEN = USART_ROUTEPEN_RXPEN | USART_ROUTEPEN_TXPEN;
 
-  USART_InitAsync(UART1, &init);
+  usart_init_async(USBL);
   UART1->ROUTELOC0 = (USART_ROUTELOC0_TXLOC_LOC3 | USART_ROUTELOC0_RXLOC_LOC3);       //UART 1 - LOCATION 3 - FCPU
   UART1->ROUTEPEN = USART_ROUTEPEN_RXPEN | USART_ROUTEPEN_TXPEN;
 
@@ -105,6 +286,424 @@ void usart_init(void)
   USART_Enable(USART4, usartEnable);
   //Sensor caddy    I2C0 (Compass A, Internal pressure)
   //Compass B       I2C1
+
+
+  dma_init();
+  hw_timer_cycles_init();                                                       // cycle counter for the I2C, sampler and expander timing
+
+  for (int port = 0; port < USART_PORT_COUNT; port++)                           // TX rings drained by TXBL, RX rings fed by RXDATAV
+  {
+      dma_queue_init(&tx_dma_queue[port]);
+      tx_dma_active[port] = false;
+
+      ring_buffer_init(&tx_ring[port], tx_storage[port], USART_TX_RING_SIZE);
+      ring_buffer_init(&rx_ring[port], rx_storage[port], USART_RX_RING_SIZE);
+      tx_policy[port] = UART_TX_BLOCK;
+      tx_dropped[port] = 0;
+      rx_overruns[port] = 0;
+      rs485_de_on[port] = false;
+      rs485_released[port] = 0;
+      rs485_late[port] = 0;
+
+      if (port != Expander)
+      {
+          usart_de_setup((destination_t)port);
+      }
+
+      if (port != Expander)                                                     // SPI bus is shared with the expander register accesses
+      {
+          dma_set_callback(DMA_CH_UART_TX(port), usart_tx_dma_done, (void *)(uintptr_t)port);
+
+          USART_IntClear(usart_ports[port], _USART_IFC_MASK);
+          USART_IntEnable(usart_ports[port], USART_IEN_RXDATAV | USART_IEN_RXOF);
+
+          NVIC_ClearPendingIRQ(usart_tx_irqs[port]);
+          NVIC_EnableIRQ(usart_tx_irqs[port]);
+          NVIC_ClearPendingIRQ(usart_rx_irqs[port]);
+          NVIC_EnableIRQ(usart_rx_irqs[port]);
+      }
+  }
+
+  uart_rx_dma_enable(IMU,  imu_rx_dma_storage,  USART_RX_DMA_RING_SIZE, NULL);   // continuous streams - no per-byte interrupts
+  uart_rx_dma_enable(SDAS, sdas_rx_dma_storage, USART_RX_DMA_RING_SIZE, NULL);
+  uart_rx_dma_enable(USBL, usbl_rx_dma_storage, USART_RX_DMA_RING_SIZE, NULL);
+}
+
+
+
+
+/*==============================================================================
+ * RX DMA HELPERS
+ *============================================================================*/
+
+/**
+ * @brief Bring a DMA port's ring head up to the LDMA write position
+ * @param destination: Port in circular DMA mode
+ * @note If the application has fallen more than a whole ring behind, the
+ *       oldest bytes have been overwritten: they are counted as overruns and
+ *       skipped. Half-buffer interrupts guarantee this runs at least twice per lap.
+ */
+static void usart_rx_dma_sync(destination_t destination)
+{
+  ring_buffer_t *ring = &rx_ring[destination];
+  uint16_t size = ring_buffer_size(ring);
+  uint16_t pos;
+  uint16_t head;
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_ATOMIC();
+  pos = (uint16_t)(LDMA->CH[DMA_CH_UART_RX(destination)].DST - (uint32_t)(uintptr_t)ring->data) & ring->mask;
+  head = ring->head + (uint16_t)((pos - ring->head) & ring->mask);
+
+  if ((uint16_t)(head - ring->tail) > size)
+  {
+      rx_overruns[destination] += (uint16_t)(head - ring->tail) - size;
+      ring->tail = head - size;
+  }
+  ring->head = head;
+  CORE_EXIT_ATOMIC();
+}
+
+
+/**
+ * @brief Sync the ring and hand everything new to the span callback, if any
+ * @param destination: Port in circular DMA mode
+ * @note Interrupt context. A wrapped burst is delivered as two spans.
+ */
+static void usart_rx_dma_deliver(destination_t destination)
+{
+  uart_rx_span_callback_t callback = rx_dma_callback[destination];
+  const uint8_t *data;
+  uint16_t len;
+
+  usart_rx_dma_sync(destination);
+
+  if (callback == NULL)
+  {
+      return;                                                                   // application polls with uart_read()/uart_rx_span()
+  }
+
+  while ((len = ring_buffer_peek_contiguous(&rx_ring[destination], &data)) > 0)
+  {
+      callback(destination, data, len);
+      ring_buffer_consume(&rx_ring[destination], len);
+  }
+}
+
+
+/**
+ * @brief LDMA half/full buffer DONE for a port's RX channel
+ */
+static void usart_rx_dma_event(unsigned int channel, void *ctx)
+{
+  (void)channel;
+  usart_rx_dma_deliver((destination_t)(uintptr_t)ctx);
+}
+
+
+/**
+ * @brief Handle the USART idle timeout (TIMECMP0) that marks the end of a burst
+ * @param destination: Port whose TX or RX interrupt fired
+ * @note Checked from both the TX and RX handlers so it does not matter which
+ *       line the timer compare flag is routed to
+ */
+static void usart_rx_idle_isr(destination_t destination)
+{
+  USART_TypeDef *usart = usart_ports[destination];
+
+  if (usart->IF & usart->IEN & USART_IF_TCMP0)
+  {
+      usart->IFC = USART_IFC_TCMP0;
+      rx_bursts[destination]++;
+      usart_rx_dma_deliver(destination);
+  }
+}
+
+
+
+
+/*==============================================================================
+ * TX RING HELPERS
+ *============================================================================*/
+
+/**
+ * @brief Route DE for a port's current line configuration
+ * @param destination: Asynchronous port, with the USART disabled or idle
+ * @note AUTOCS ports get the CS pin routed, active high. Software DE ports get
+ *       TIMECMP1 timing the gap from the end of the last stop bit.
+ */
+static void usart_de_setup(destination_t destination)
+{
+  USART_TypeDef *usart = usart_ports[destination];
+  const uart_port_config_t *config = &usart_config[destination];
+
+  usart->CTRL &= ~(USART_CTRL_AUTOTRI | USART_CTRL_AUTOCS | USART_CTRL_CSINV);
+  usart->ROUTEPEN &= ~USART_ROUTEPEN_CSPEN;
+  usart->TIMECMP1 = 0;
+
+  if (!config->rs485)
+  {
+      return;
+  }
+
+  usart->CTRL |= USART_CTRL_AUTOTRI;
+  if (config->de_csloc != UART_DE_SOFTWARE)
+  {
+      usart->ROUTELOC0 = (usart->ROUTELOC0 & ~_USART_ROUTELOC0_CSLOC_MASK)
+                       | ((uint32_t)config->de_csloc << _USART_ROUTELOC0_CSLOC_SHIFT);
+      usart->ROUTEPEN |= USART_ROUTEPEN_CSPEN;
+      usart->CTRL |= USART_CTRL_AUTOCS | USART_CTRL_CSINV;
+  }
+  else
+  {
+      GPIO_PinOutClear(config->de_port, config->de_pin);                      // receive until there is something to send
+      usart->TIMECMP1 = ((uint32_t)USART_RS485_TURN_BITS << _USART_TIMECMP1_TCMPVAL_SHIFT)
+                      | USART_TIMECMP1_TSTART_TXEOF                             // start as each stop bit ends,
+                      | USART_TIMECMP1_TSTOP_TXST                               // stop on the next start bit
+                      | USART_TIMECMP1_RESTARTEN;
+      usart->IFC = USART_IFC_TCMP1;
+  }
+}
+
+
+/**
+ * @brief Turn on an RS485 port's line driver and arm the TXC interrupt that turns it off
+ * @param destination: Port about to transmit
+ * @note Call with interrupts masked or from the port's TX / LDMA interrupt, before
+ *       the first byte reaches TXDATA. Does nothing on non-RS485 ports or where
+ *       AUTOCS drives DE.
+ */
+static void usart_de_assert(destination_t destination)
+{
+  USART_TypeDef *usart = usart_ports[destination];
+  const uart_port_config_t *config = &usart_config[destination];
+
+  if (!config->rs485 || config->de_csloc != UART_DE_SOFTWARE)                 // none, or AUTOCS
+  {
+      return;
+  }
+  if (rs485_de_on[destination])
+  {
+      usart->IFC = USART_IFC_TCMP1;                                             // the line is busy again - a gap so far isn't turnaround
+      return;
+  }
+
+  GPIO_PinOutSet(config->de_port, config->de_pin);
+  rs485_de_on[destination] = true;
+  usart->IFC = USART_IF_TXC | USART_IFC_TCMP1;                                  // stale TXC and idle time from the last burst
+  usart->IEN |= USART_IEN_TXC;
+}
+
+
+/**
+ * @brief Enable the TXBL interrupt so the ISR starts draining the ring
+ * @param destination: Port to start (never Expander)
+ */
+static void usart_tx_start(destination_t destination)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_ATOMIC();                                                          // IEN is also modified from the ISR
+  usart_de_assert(destination);
+  if (!tx_dma_active[destination])                                              // DMA completion restarts the ring itself
+  {
+      usart_ports[destination]->IEN |= USART_IEN_TXBL;
+  }
+  CORE_EXIT_ATOMIC();
+}
+
+
+/**
+ * @brief True when the ring has been drained up to the oldest pending DMA job
+ * @param destination: Port to check
+ * @note Comparison is signed so an OVERWRITE discard that skips past the mark still counts
+ */
+static bool usart_tx_at_dma_mark(destination_t destination)
+{
+  dma_job_t *job = dma_queue_front(&tx_dma_queue[destination]);
+
+  return (job != NULL) && ((int16_t)(job->mark - tx_ring[destination].tail) <= 0);
+}
+
+
+/**
+ * @brief Hand the oldest pending job (or the next chunk of it) to the LDMA
+ * @param destination: Port to start
+ * @note Call with interrupts masked or from the port's TX / LDMA interrupt
+ */
+static void usart_tx_dma_start(destination_t destination)
+{
+  dma_job_t *job = dma_queue_front(&tx_dma_queue[destination]);
+  const uint8_t *src;
+  size_t chunk;
+
+  if (job == NULL)
+  {
+      return;
+  }
+
+  chunk = dma_job_next_chunk(job, DMA_MAX_XFER, &src);
+
+  LDMA_TransferCfg_t cfg = LDMA_TRANSFER_CFG_PERIPHERAL(usart_tx_dma_signals[destination]);
+  LDMA_Descriptor_t desc = LDMA_DESCRIPTOR_SINGLE_M2P_BYTE(src, &usart_ports[destination]->TXDATA, chunk);
+
+  tx_dma_desc[destination] = desc;
+  tx_dma_chunk[destination] = (uint16_t)chunk;
+  tx_dma_active[destination] = true;
+  usart_de_assert(destination);
+  LDMA_StartTransfer(DMA_CH_UART_TX(destination), &cfg, &tx_dma_desc[destination]);
+}
+
+
+/**
+ * @brief LDMA completion for a port's TX channel (interrupt context)
+ * @param channel: LDMA channel (unused - port comes from ctx)
+ * @param ctx: destination_t of the port
+ * @note Finishes or continues the current job, then gives the port back to the
+ *       ring if ring bytes were queued before the next job, otherwise starts it
+ */
+static void usart_tx_dma_done(unsigned int channel, void *ctx)
+{
+  destination_t destination = (destination_t)(uintptr_t)ctx;
+  dma_queue_t *queue = &tx_dma_queue[destination];
+  dma_job_t *job = dma_queue_front(queue);
+  (void)channel;
+
+  tx_dma_active[destination] = false;
+
+  if (job != NULL && !dma_job_advance(job, tx_dma_chunk[destination]))
+  {
+      usart_tx_dma_start(destination);                                          // next chunk of a long buffer
+      return;
+  }
+
+  if (job != NULL)
+  {
+      dma_callback_t callback = job->callback;
+      const void *buf = job->buf;
+      size_t len = job->len;
+
+      dma_queue_pop(queue);
+      if (callback != NULL)
+      {
+          callback(destination, buf, len);
+      }
+  }
+
+  if (tx_dma_active[destination])                                               // the callback's own output got the port going again
+  {
+      return;
+  }
+  if (usart_tx_at_dma_mark(destination))
+  {
+      usart_tx_dma_start(destination);
+  }
+  else if (!ring_buffer_is_empty(&tx_ring[destination]))
+  {
+      usart_tx_start(destination);
+  }
+}
+
+
+/**
+ * @brief Move one byte from the ring to the USART by hand
+ * @param destination: Port to service
+ * @note Used when the TX interrupt cannot run (called from an ISR of equal or
+ *       higher priority, or with interrupts masked) so a blocking put_char()
+ *       still makes progress instead of dead-locking
+ * @note Also does the TX interrupt's DMA work: starts a queued job when the
+ *       ring reaches its mark and, if the LDMA interrupt is blocked as well,
+ *       collects the job's completion itself
+ */
+static void usart_tx_poll(destination_t destination)
+{
+  USART_TypeDef *usart = usart_ports[destination];
+  uint8_t c;
+  CORE_DECLARE_IRQ_STATE;
+
+  if (tx_dma_active[destination])                                               // LDMA owns TXDATA
+  {
+      if (CORE_IrqIsBlocked(LDMA_IRQn))
+      {
+          dma_poll_channel(DMA_CH_UART_TX(destination));
+      }
+      return;
+  }
+
+  if (usart_tx_at_dma_mark(destination))                                        // a DMA job is next in line
+  {
+      CORE_ENTER_ATOMIC();
+      if (!tx_dma_active[destination] && usart_tx_at_dma_mark(destination))
+      {
+          usart->IEN &= ~USART_IEN_TXBL;                                        // as usart_tx_isr() does at the mark
+          usart_tx_dma_start(destination);
+      }
+      CORE_EXIT_ATOMIC();
+      return;
+  }
+
+  if ((usart->STATUS & USART_STATUS_TXBL) && ring_buffer_get(&tx_ring[destination], &c))
+  {
+      usart_de_assert(destination);
+      usart->TXDATA = c;
+  }
+}
+
+
+/**
+ * @brief Queue bytes on a port's TX ring, applying the port's full-ring policy
+ * @param destination: Port to queue on (never Expander)
+ * @param buf: Bytes to send
+ * @param len: Number of bytes
+ * @return Number of bytes queued (less than len only under UART_TX_DROP)
+ */
+static uint16_t usart_tx_queue(destination_t destination, const uint8_t *buf, uint16_t len)
+{
+  ring_buffer_t *ring = &tx_ring[destination];
+  uint16_t queued = 0;
+  uint8_t discard;
+  CORE_DECLARE_IRQ_STATE;
+
+  while (queued < len)
+  {
+      queued += ring_buffer_write(ring, &buf[queued], len - queued);
+      usart_tx_start(destination);
+
+      if (queued == len)
+      {
+          break;
+      }
+
+      switch (tx_policy[destination])                                           // ring is full
+      {
+        case UART_TX_DROP:
+          tx_dropped[destination] += len - queued;
+          return queued;
+
+        case UART_TX_OVERWRITE:
+          CORE_ENTER_ATOMIC();                                                  // tail normally belongs to the ISR
+          if (ring_buffer_get(ring, &discard))
+          {
+              tx_dropped[destination]++;
+          }
+          if (ring_buffer_put(ring, buf[queued]))
+          {
+              queued++;
+          }
+          CORE_EXIT_ATOMIC();
+          break;
+
+        case UART_TX_BLOCK:
+        default:
+          if (CORE_IrqIsBlocked(usart_tx_irqs[destination]))
+          {
+              usart_tx_poll(destination);
+          }
+          break;
+      }
+  }
+
+  return queued;
 }
 
 
@@ -130,13 +729,14 @@ void usart_init(void)
  *                    - FCPU:       Flight Computer (UART0)
  *                    - USBL:       Ultra-Short Baseline positioning (UART1)
  *
- * @note This function is blocking and will wait until the character is transmitted
+ * @note The character is queued on the destination's TX ring and sent by the
+ *       TXBL interrupt - the call only waits if the ring is full and the port
+ *       policy is UART_TX_BLOCK (see uart_set_tx_policy())
+ * @note Expander (USART4) is in SPI mode and is still written directly
  * @note Invalid destination values default to Node (USART2)
  * @note Ensure the target USART/UART peripheral is properly initialized before use
  *
- * @warning No error checking is performed on the destination parameter
- *
- * @see USART_Tx() for low-level transmission details
+ * @see usart_tx_isr() for the interrupt side of the transmission
  * @see Communication interface definitions in system header files
  *
  * Example usage:
@@ -148,48 +748,1105 @@ void usart_init(void)
  */
 void put_char(char c, int destination)
 {
-  switch (destination)
+  if (destination < IMU || destination > USBL)
   {
-    case IMU:         USART_Tx(USART0, c);  break;
-    case PDEM:        USART_Tx(USART1, c);  break;
-    case Node:        USART_Tx(USART2, c);  break;
-    case Thrusters:   USART_Tx(USART3, c);  break;
-    case Expander:    USART_Tx(USART4, c);  break;
-    case SDAS:        USART_Tx(USART5, c);  break;
-    case FCPU:        USART_Tx (UART0, c);  break;
-    case USBL:        USART_Tx (UART1, c);  break;
+      destination = Node;
+  }
 
-    default:          USART_Tx(USART2, c);
+  if (destination == Expander)
+  {
+      USART_Tx(USART4, c);
+      return;
   }
+
+  usart_tx_queue((destination_t)destination, (const uint8_t *)&c, 1);
 }
 
 
 
 
+/**
+ * @brief Queues a null-terminated string on the destination's TX ring
+ * @param str: String to send
+ * @param destination: Destination device identifier (see put_char())
+ * @note Returns as soon as the whole string is queued
+ */
 void print_string(const char *str, int destination)
 {
-  while (*str)
+  const char *end = str;
+
+  while (*end)
+  {
+      end++;
+  }
+
+  if (destination < IMU || destination > USBL)
   {
-      put_char(*str, destination);  // Print each character
-      str++;                        // Move to next character
+      destination = Node;
   }
+  uart_write((destination_t)destination, str, (uint16_t)(end - str));
 }
 
 
 
 
-char USART_ReceiveChar(USART_TypeDef *usart)
+/**
+ * @brief Queues a block of bytes on the destination's TX ring
+ * @param destination: Destination device identifier (see put_char())
+ * @param buf: Bytes to send (may contain zeros)
+ * @param len: Number of bytes
+ * @return Number of bytes queued - less than len only if the port policy is UART_TX_DROP
+ */
+uint16_t uart_write(destination_t destination, const void *buf, uint16_t len)
 {
-  char input = 0;
+  const uint8_t *bytes = (const uint8_t *)buf;
 
-    while (!(usart->STATUS & USART_STATUS_RXDATAV))     // Wait until data is available
-    {
-        // Wait for RX buffer to have data
-    }
-    input = USART_Rx(usart);
+  if (destination >= USART_PORT_COUNT)
+  {
+      destination = Node;
+  }
 
-    return input;     // Read and return the received byte
+  if (destination == Expander)
+  {
+      for (uint16_t i = 0; i < len; i++)
+      {
+          USART_Tx(USART4, bytes[i]);
+      }
+      return len;
+  }
+
+  return usart_tx_queue(destination, bytes, len);
+}
+
+
+
+
+/**
+ * @brief Selects what happens when a port's TX ring is full
+ * @param destination: Port to configure
+ * @param policy: UART_TX_BLOCK, UART_TX_DROP or UART_TX_OVERWRITE
+ */
+void uart_set_tx_policy(destination_t destination, uart_tx_policy_t policy)
+{
+  if (destination < USART_PORT_COUNT)
+  {
+      tx_policy[destination] = policy;
+  }
 }
 
 
 
+
+/**
+ * @brief Lets a producer (e.g. a frame encoder) build a record directly in a port's TX ring
+ * @param destination: Port to send on (any destination_t except Expander)
+ * @param need: Worst-case bytes the producer will write
+ * @param producer: Writes the record with ring_buffer_poke()/ring_buffer_commit()
+ *                  and returns the number of bytes committed
+ * @param ctx: Passed to the producer
+ * @return Bytes committed, 0 if the record was dropped
+ * @note Under UART_TX_BLOCK waits for need bytes of room. Under UART_TX_DROP
+ *       and UART_TX_OVERWRITE a record that does not fit is dropped whole, so
+ *       the wire never carries half a record.
+ */
+uint16_t uart_tx_produce(destination_t destination, uint16_t need, uart_tx_producer_t producer, void *ctx)
+{
+  ring_buffer_t *ring;
+  uint16_t written;
+
+  if (destination >= USART_PORT_COUNT || destination == Expander || need > USART_TX_RING_SIZE)
+  {
+      return 0;
+  }
+  ring = &tx_ring[destination];
+
+  while (ring_buffer_space(ring) < need)
+  {
+      if (tx_policy[destination] != UART_TX_BLOCK)
+      {
+          tx_dropped[destination] += need;
+          return 0;
+      }
+      if (CORE_IrqIsBlocked(usart_tx_irqs[destination]))
+      {
+          usart_tx_poll(destination);
+      }
+  }
+
+  written = producer(ring, ctx);
+  if (written > 0)
+  {
+      usart_tx_start(destination);
+  }
+  return written;
+}
+
+
+
+
+/**
+ * @brief Waits until everything queued for a port has left the shift register
+ * @param destination: Port to flush
+ * @note Use before reconfiguring a port or turning off its line driver
+ * @note Also waits for queued uart_write_dma() jobs - do not call from an ISR
+ */
+void uart_tx_flush(destination_t destination)
+{
+  USART_TypeDef *usart;
+
+  if (destination >= USART_PORT_COUNT)
+  {
+      destination = Node;
+  }
+  usart = usart_ports[destination];
+
+  while (!ring_buffer_is_empty(&tx_ring[destination]) || !dma_queue_is_empty(&tx_dma_queue[destination]))
+  {
+      if (CORE_IrqIsBlocked(usart_tx_irqs[destination]))
+      {
+          usart_tx_poll(destination);
+      }
+  }
+
+  while (!(usart->STATUS & USART_STATUS_TXIDLE))                                // last stop bit out
+  {
+  }
+}
+
+
+
+
+/**
+ * @brief Number of bytes still waiting in a port's TX ring
+ */
+uint16_t uart_tx_pending(destination_t destination)
+{
+  return (destination < USART_PORT_COUNT) ? ring_buffer_count(&tx_ring[destination]) : 0;
+}
+
+
+
+
+/**
+ * @brief Queues a caller buffer for transmission by the LDMA without copying it
+ * @param destination: Destination port (any destination_t except Expander)
+ * @param buf: Bytes to send - RAM or flash (string literals are fine). Must
+ *             stay valid and unchanged until the callback runs
+ * @param len: Number of bytes (any length, long buffers are sent in chunks)
+ * @param callback: Called from interrupt context when the LDMA has finished
+ *                  reading buf, or NULL
+ * @return true if queued, false if the port's job queue is full or the port
+ *         cannot use DMA
+ * @note Output stays in call order with put_char()/print_string() on the same port
+ * @note The CPU does no per-byte work while the job is being sent
+ */
+bool uart_write_dma(destination_t destination, const void *buf, size_t len, uart_dma_callback_t callback)
+{
+  bool queued;
+  CORE_DECLARE_IRQ_STATE;
+
+  if (destination >= USART_PORT_COUNT || destination == Expander)
+  {
+      return false;
+  }
+
+  CORE_ENTER_ATOMIC();                                                          // callbacks may queue from the LDMA interrupt
+  queued = dma_queue_push(&tx_dma_queue[destination], buf, len, tx_ring[destination].head, callback);
+  if (queued && !tx_dma_active[destination] && usart_tx_at_dma_mark(destination))
+  {
+      usart_tx_dma_start(destination);                                          // otherwise the TXBL interrupt starts it at the mark
+  }
+  CORE_EXIT_ATOMIC();
+
+  return queued;
+}
+
+
+
+
+/**
+ * @brief Sends a string with static lifetime (e.g. a literal in flash) by DMA
+ * @param str: Null-terminated string that is never modified or freed
+ * @param destination: Destination device identifier (see put_char())
+ * @note Falls back to print_string() if the port's DMA queue is full
+ */
+void print_string_dma(const char *str, int destination)
+{
+  if (destination < IMU || destination > USBL)
+  {
+      destination = Node;
+  }
+
+  if (!uart_write_dma((destination_t)destination, str, strlen(str), NULL))
+  {
+      print_string(str, destination);
+  }
+}
+
+
+
+
+/**
+ * @brief Number of bytes discarded by the UART_TX_DROP / UART_TX_OVERWRITE policies
+ */
+uint32_t uart_tx_dropped(destination_t destination)
+{
+  return (destination < USART_PORT_COUNT) ? tx_dropped[destination] : 0;
+}
+
+
+
+
+/**
+ * @brief Changes a port's line settings at runtime
+ * @param destination: Port to change (any destination_t except Expander)
+ * @param config: New settings, copied into the port table
+ * @return true if applied, false for an invalid port or baud rate of 0
+ * @note Waits for queued TX to finish first. Only the receiver/transmitter are
+ *       toggled, so routing, interrupts and DMA set up by usart_init() are kept.
+ * @note Reconfiguring Node drops the console onto the new rate immediately
+ */
+bool uart_configure(destination_t destination, const uart_port_config_t *config)
+{
+  USART_TypeDef *usart;
+  CORE_DECLARE_IRQ_STATE;
+
+  if (destination >= USART_PORT_COUNT || destination == Expander || config == NULL || config->baudrate == 0)
+  {
+      return false;
+  }
+  usart = usart_ports[destination];
+
+  uart_tx_flush(destination);
+
+  CORE_ENTER_ATOMIC();                                                          // line is idle - release the old DE pin now
+  if (rs485_de_on[destination])
+  {
+      GPIO_PinOutClear(usart_config[destination].de_port, usart_config[destination].de_pin);
+      usart->IEN &= ~USART_IEN_TXC;
+      rs485_de_on[destination] = false;
+  }
+  usart_config[destination] = *config;
+  CORE_EXIT_ATOMIC();
+
+  USART_Enable(usart, usartDisable);
+  if (config->rs485)
+  {
+      GPIO_PinModeSet(config->de_port, config->de_pin, gpioModePushPull, 0);   // receive until there is something to send
+  }
+  usart_de_setup(destination);
+  usart->FRAME = (usart->FRAME & ~(_USART_FRAME_PARITY_MASK | _USART_FRAME_STOPBITS_MASK))
+               | (uint32_t)config->parity
+               | (uint32_t)config->stopbits;
+  USART_BaudrateAsyncSet(usart, 0, config->baudrate, config->oversampling);   // 0 = current HFPER clock
+  USART_Enable(usart, usartEnable);
+
+  return true;
+}
+
+
+
+
+/**
+ * @brief Copies a port's current line settings
+ * @return false for an invalid port
+ */
+bool uart_get_config(destination_t destination, uart_port_config_t *config)
+{
+  if (destination >= USART_PORT_COUNT || config == NULL)
+  {
+      return false;
+  }
+  *config = usart_config[destination];
+  return true;
+}
+
+
+
+
+/**
+ * @brief Bit rate the hardware is really running at
+ * @return Baud rate computed by emlib from the HFPER clock frequency, CLKDIV and oversampling
+ */
+uint32_t uart_actual_baudrate(destination_t destination)
+{
+  if (destination >= USART_PORT_COUNT)
+  {
+      return 0;
+  }
+  return USART_BaudrateGet(usart_ports[destination]);
+}
+
+
+
+
+/**
+ * @brief Error of the achieved baud rate against the requested one
+ * @return Parts per million, positive when the port runs fast. Keep within
+ *         about +/-20000 (2%) for reliable links at both ends.
+ */
+int32_t uart_baud_error_ppm(destination_t destination)
+{
+  uint32_t requested;
+  int64_t diff;
+
+  if (destination >= USART_PORT_COUNT || destination == Expander)
+  {
+      return 0;
+  }
+  requested = usart_config[destination].baudrate;
+  if (requested == 0)
+  {
+      return 0;
+  }
+  diff = (int64_t)uart_actual_baudrate(destination) - (int64_t)requested;
+  return (int32_t)((diff * 1000000) / (int64_t)requested);
+}
+
+
+
+
+/**
+ * @brief Sets the expander SPI (USART4) bit rate
+ * @param bitrate: Requested rate in Hz - capped at HFPERCLK / 2, the fastest
+ *                 a synchronous USART can clock
+ * @return Rate actually achieved (the clock divider rounds it down)
+ * @note Only change the rate with no chip select asserted and nothing on the
+ *       spi_bus queue
+ */
+uint32_t uart_spi_set_bitrate(uint32_t bitrate)
+{
+  uint32_t max = CMU_ClockFreqGet(cmuClock_HFPER) / 2;
+
+  if (bitrate > max)
+  {
+      bitrate = max;
+  }
+  USART_BaudrateSyncSet(USART4, 0, bitrate);
+  return USART_BaudrateGet(USART4);
+}
+
+
+/**
+ * @brief Current expander SPI (USART4) bit rate in Hz
+ */
+uint32_t uart_spi_bitrate(void)
+{
+  return USART_BaudrateGet(USART4);
+}
+
+
+
+
+/**
+ * @brief Prints one port's settings and achieved baud error as a single line
+ * @param destination: Port to report
+ * @param output: Where to print it (usually Node)
+ * @note Format: "<baud> <N|E|O><1|2> OVS<n> actual <baud> err <+/-ppm> ppm[ RS485 turn <ns> ns max]"
+ */
+void uart_print_config(destination_t destination, int output)
+{
+  static const char parity_char[] = {'N', '?', 'E', 'O'};                       // FRAME PARITY field values
+  const uart_port_config_t *config;
+  int32_t error;
+
+  if (destination >= USART_PORT_COUNT || destination == Expander)
+  {
+      print_string("SPI", output);
+      return;
+  }
+  config = &usart_config[destination];
+  error = uart_baud_error_ppm(destination);
+
+  node_printf(output, "%lu %c%c OVS%u actual %lu err %c%ld ppm",
+              (unsigned long)config->baudrate,
+              parity_char[((uint32_t)config->parity >> 8) & 0x3],
+              (config->stopbits == usartStopbits2) ? '2' : '1',
+              (config->oversampling == usartOVS16) ? 16u :
+              (config->oversampling == usartOVS8) ? 8u :
+              (config->oversampling == usartOVS6) ? 6u : 4u,
+              (unsigned long)uart_actual_baudrate(destination),
+              (error < 0) ? '-' : '+',
+              (long)((error < 0) ? -error : error));
+  if (config->rs485 && config->de_csloc != UART_DE_SOFTWARE)
+  {
+      node_printf(output, " RS485 DE AUTOCS");
+  }
+  else if (config->rs485)
+  {
+      node_printf(output, " RS485 DE late %lu of %lu (> %u bit)",
+                  (unsigned long)rs485_late[destination], (unsigned long)rs485_released[destination],
+                  (unsigned)USART_RS485_TURN_BITS);
+  }
+}
+
+
+
+
+/**
+ * @brief RS485 turnaround of a software DE port, against the port's bit time
+ * @param destination: RS485 port
+ * @param released: Set to the number of times DE was released (may be NULL)
+ * @param late: Set to how many of those came more than USART_RS485_TURN_BITS
+ *        bit periods after the end of the last stop bit (may be NULL)
+ * @note Both stay 0 where AUTOCS drives DE - it drops as the stop bit ends
+ */
+void uart_rs485_turnaround(destination_t destination, uint32_t *released, uint32_t *late)
+{
+  if (destination >= USART_PORT_COUNT)
+  {
+      return;
+  }
+  if (released != NULL)
+  {
+      *released = rs485_released[destination];
+  }
+  if (late != NULL)
+  {
+      *late = rs485_late[destination];
+  }
+}
+
+
+
+
+/**
+ * @brief Switches a port to 9-bit multidrop framing with address filtering
+ * @param destination: Port on a shared bus (any destination_t except Expander)
+ * @param own_address: This node's address; UART_MULTIDROP_BROADCAST is always accepted
+ * @return false for an invalid port or one in circular DMA receive mode
+ * @note Every device on the bus must use 9-bit frames once this is enabled.
+ *       Bytes sent with put_char()/uart_write() go out as data frames.
+ */
+bool uart_multidrop_enable(destination_t destination, uint8_t own_address)
+{
+  USART_TypeDef *usart;
+  CORE_DECLARE_IRQ_STATE;
+
+  if (destination >= USART_PORT_COUNT || destination == Expander || rx_dma_enabled[destination])
+  {
+      return false;
+  }
+  usart = usart_ports[destination];
+
+  uart_tx_flush(destination);
+
+  CORE_ENTER_ATOMIC();
+  USART_Enable(usart, usartDisable);
+  usart->FRAME = (usart->FRAME & ~_USART_FRAME_DATABITS_MASK) | USART_FRAME_DATABITS_NINE;
+  usart->CTRL = (usart->CTRL & ~USART_CTRL_BIT8DV)                              // TXDATA writes are data frames
+              | USART_CTRL_MPM | USART_CTRL_MPAB;                               // 9th bit set = address frame
+  mp_address[destination] = own_address;
+  mp_selected[destination] = false;
+  mp_enabled[destination] = true;
+  USART_Enable(usart, usartEnable);
+  usart->CMD = USART_CMD_RXBLOCKEN;                                             // ignore data until we are addressed
+  CORE_EXIT_ATOMIC();
+
+  return true;
+}
+
+
+
+
+/**
+ * @brief Returns a port to plain 8-bit framing
+ */
+void uart_multidrop_disable(destination_t destination)
+{
+  USART_TypeDef *usart;
+  CORE_DECLARE_IRQ_STATE;
+
+  if (destination >= USART_PORT_COUNT || !mp_enabled[destination])
+  {
+      return;
+  }
+  usart = usart_ports[destination];
+
+  uart_tx_flush(destination);
+
+  CORE_ENTER_ATOMIC();
+  USART_Enable(usart, usartDisable);
+  usart->FRAME = (usart->FRAME & ~_USART_FRAME_DATABITS_MASK) | USART_FRAME_DATABITS_EIGHT;
+  usart->CTRL &= ~(USART_CTRL_MPM | USART_CTRL_MPAB);
+  mp_enabled[destination] = false;
+  USART_Enable(usart, usartEnable);
+  usart->CMD = USART_CMD_RXBLOCKDIS;
+  CORE_EXIT_ATOMIC();
+}
+
+
+
+
+/**
+ * @brief Sends an address frame followed by a payload on a multidrop port
+ * @param destination: Port in multidrop mode
+ * @param address: Device to address (UART_MULTIDROP_BROADCAST for all)
+ * @param payload: Data frames to send after the address
+ * @param len: Number of payload bytes
+ * @return Number of payload bytes queued (see uart_write()), 0 if not in multidrop mode
+ * @note Waits for earlier output on the port to reach the USART so the address
+ *       frame cannot overtake it, the payload then goes through the TX ring
+ */
+uint16_t uart_write_addressed(destination_t destination, uint8_t address, const void *payload, uint16_t len)
+{
+  USART_TypeDef *usart;
+  CORE_DECLARE_IRQ_STATE;
+
+  if (destination >= USART_PORT_COUNT || !mp_enabled[destination])
+  {
+      return 0;
+  }
+  usart = usart_ports[destination];
+
+  while (!ring_buffer_is_empty(&tx_ring[destination]) || !dma_queue_is_empty(&tx_dma_queue[destination]))
+  {
+      if (CORE_IrqIsBlocked(usart_tx_irqs[destination]))
+      {
+          usart_tx_poll(destination);
+      }
+  }
+
+  CORE_ENTER_ATOMIC();
+  usart_de_assert(destination);
+  while (!(usart->STATUS & USART_STATUS_TXBL))
+  {
+  }
+  usart->TXDATAX = MULTIDROP_ADDRESS_BIT | address;
+  CORE_EXIT_ATOMIC();
+
+  return (len > 0) ? uart_write(destination, payload, len) : 0;
+}
+
+
+
+
+/**
+ * @brief Address frame counters for a multidrop port
+ * @param matched: Set to the number of frames for this node or broadcast (may be NULL)
+ * @param ignored: Set to the number of frames for other nodes (may be NULL)
+ */
+void uart_multidrop_stats(destination_t destination, uint32_t *matched, uint32_t *ignored)
+{
+  if (destination >= USART_PORT_COUNT)
+  {
+      return;
+  }
+  if (matched != NULL)
+  {
+      *matched = mp_matched[destination];
+  }
+  if (ignored != NULL)
+  {
+      *ignored = mp_ignored[destination];
+  }
+}
+
+
+
+
+/*==============================================================================
+ * THRUSTER BUS
+ *============================================================================*/
+
+/**
+ * @brief Puts the Thruster RS485 bus (USART3) into 9-bit multidrop mode
+ * @param None
+ * @return None
+ * @note The node answers to THRUSTER_NODE_ADDRESS, replies addressed elsewhere
+ *       never reach the RX ring
+ */
+void thruster_bus_init(void)
+{
+  uart_multidrop_enable(Thrusters, THRUSTER_NODE_ADDRESS);
+}
+
+
+
+
+/**
+ * @brief Sends one addressed message to a thruster
+ * @param addr: Thruster address (THRUSTER_BROADCAST for all of them)
+ * @param payload: Message bytes
+ * @param len: Number of bytes
+ * @return Number of payload bytes queued
+ * @note Call thruster_bus_init() first. DE is raised and released automatically.
+ */
+uint16_t thruster_send(uint8_t addr, const void *payload, uint16_t len)
+{
+  return uart_write_addressed(Thrusters, addr, payload, len);
+}
+
+
+
+
+/**
+ * @brief Reads up to n received bytes from a port's RX ring
+ * @param destination: Port to read (any destination_t except Expander)
+ * @param buf: Where to store the bytes
+ * @param n: Maximum number of bytes to read
+ * @param timeout_ms: 0 = return immediately with whatever is queued,
+ *                    UART_WAIT_FOREVER = wait until n bytes have arrived,
+ *                    otherwise wait at most this many milliseconds
+ * @return Number of bytes read
+ * @note While waiting forever the core sleeps in EM1 between interrupts
+ *       instead of spinning, every other port keeps receiving in the background
+ */
+uint16_t uart_read(destination_t destination, void *buf, uint16_t n, uint32_t timeout_ms)
+{
+  uint8_t *dst = (uint8_t *)buf;
+  uint16_t got = 0;
+  uint32_t waited = 0;
+  ring_buffer_t *ring;
+  CORE_DECLARE_IRQ_STATE;
+
+  if (destination >= USART_PORT_COUNT || destination == Expander)
+  {
+      return 0;
+  }
+  ring = &rx_ring[destination];
+
+  while (1)
+  {
+      if (rx_dma_enabled[destination])
+      {
+          usart_rx_dma_sync(destination);
+      }
+      got += ring_buffer_read(ring, &dst[got], n - got);
+
+      if (got == n || (timeout_ms != UART_WAIT_FOREVER && waited >= timeout_ms))
+      {
+          break;
+      }
+
+      if (timeout_ms == UART_WAIT_FOREVER)
+      {
+          CORE_ENTER_CRITICAL();                                                // a byte arriving here still wakes the WFI
+          if (rx_dma_enabled[destination])
+          {
+              usart_rx_dma_sync(destination);                                   // DMA ports wake on half-buffer or idle timeout
+          }
+          if (ring_buffer_is_empty(ring))
+          {
+              EMU_EnterEM1();
+          }
+          CORE_EXIT_CRITICAL();
+      }
+      else
+      {
+          hw_timer1_ms(1);
+          waited++;
+      }
+  }
+
+  return got;
+}
+
+
+
+
+/**
+ * @brief Number of received bytes waiting in a port's RX ring
+ */
+uint16_t uart_available(destination_t destination)
+{
+  if (destination >= USART_PORT_COUNT || destination == Expander)
+  {
+      return 0;
+  }
+  if (rx_dma_enabled[destination])
+  {
+      usart_rx_dma_sync(destination);
+  }
+  return ring_buffer_count(&rx_ring[destination]);
+}
+
+
+
+
+/**
+ * @brief Number of received bytes lost on a port since start-up
+ * @note Counts both hardware overruns (RXOF) and bytes dropped because the RX ring was full
+ */
+uint32_t uart_rx_overruns(destination_t destination)
+{
+  return (destination < USART_PORT_COUNT) ? rx_overruns[destination] : 0;
+}
+
+
+
+
+/**
+ * @brief Discards everything waiting in a port's RX ring
+ */
+void uart_rx_clear(destination_t destination)
+{
+  if (destination >= USART_PORT_COUNT || destination == Expander)
+  {
+      return;
+  }
+  if (rx_dma_enabled[destination])
+  {
+      usart_rx_dma_sync(destination);
+  }
+  NVIC_DisableIRQ(usart_rx_irqs[destination]);
+  NVIC_DisableIRQ(LDMA_IRQn);
+  ring_buffer_clear(&rx_ring[destination]);
+  NVIC_EnableIRQ(LDMA_IRQn);
+  NVIC_EnableIRQ(usart_rx_irqs[destination]);
+}
+
+
+
+
+/**
+ * @brief Switches a port's receiver to circular LDMA with idle-line detection
+ * @param destination: Port to switch (any destination_t except Expander)
+ * @param storage: DMA ring storage, must stay valid while DMA mode is enabled
+ * @param size: Bytes of storage - power of two, 16 to 2 * DMA_MAX_XFER
+ * @param callback: Called from interrupt context with each new span when a
+ *                  burst ends (USART_RX_IDLE_BITS of idle line) or half the
+ *                  ring has filled. NULL leaves the bytes for uart_read() /
+ *                  uart_rx_span() in the main loop.
+ * @return true if DMA mode was started
+ * @note Replaces the per-byte RXDATAV interrupt, anything already in the
+ *       interrupt-fed ring is discarded
+ */
+bool uart_rx_dma_enable(destination_t destination, uint8_t *storage, uint16_t size, uart_rx_span_callback_t callback)
+{
+  USART_TypeDef *usart;
+  uint16_t half = size / 2;
+
+  if (destination >= USART_PORT_COUNT || destination == Expander ||
+      size < 16 || size > 2 * DMA_MAX_XFER || (size & (size - 1)) != 0)
+  {
+      return false;
+  }
+  usart = usart_ports[destination];
+
+  uart_rx_dma_disable(destination);
+
+  USART_IntDisable(usart, USART_IEN_RXDATAV);
+  NVIC_DisableIRQ(usart_rx_irqs[destination]);
+  ring_buffer_init(&rx_ring[destination], storage, size);
+  rx_dma_callback[destination] = callback;
+  rx_bursts[destination] = 0;
+  NVIC_EnableIRQ(usart_rx_irqs[destination]);
+
+  LDMA_TransferCfg_t cfg = LDMA_TRANSFER_CFG_PERIPHERAL(usart_rx_dma_signals[destination]);
+  LDMA_Descriptor_t first = LDMA_DESCRIPTOR_LINKREL_P2M_BYTE(&usart->RXDATA, storage, half, 1);
+  LDMA_Descriptor_t second = LDMA_DESCRIPTOR_LINKREL_P2M_BYTE(&usart->RXDATA, storage + half, half, -1);
+
+  rx_dma_desc[destination][0] = first;                                          // DONE interrupt at each half
+  rx_dma_desc[destination][1] = second;                                         // links back to the first for ever
+
+  dma_set_callback(DMA_CH_UART_RX(destination), usart_rx_dma_event, (void *)(uintptr_t)destination);
+  rx_dma_enabled[destination] = true;
+  LDMA_StartTransfer(DMA_CH_UART_RX(destination), &cfg, &rx_dma_desc[destination][0]);
+
+  usart->TIMECMP0 = ((uint32_t)USART_RX_IDLE_BITS << _USART_TIMECMP0_TCMPVAL_SHIFT)   // restart on every stop bit,
+                  | USART_TIMECMP0_TSTART_RXEOF                                 // stop when a new start bit arrives,
+                  | USART_TIMECMP0_TSTOP_RXACT                                  // fire after IDLE_BITS of silence
+                  | USART_TIMECMP0_RESTARTEN;
+  USART_IntClear(usart, USART_IFC_TCMP0);
+  USART_IntEnable(usart, USART_IEN_TCMP0);
+
+  return true;
+}
+
+
+
+
+/**
+ * @brief Returns a port from circular LDMA receive to the per-byte RX interrupt
+ * @param destination: Port to switch back
+ * @note Unread bytes in the DMA ring are discarded
+ */
+void uart_rx_dma_disable(destination_t destination)
+{
+  USART_TypeDef *usart;
+
+  if (destination >= USART_PORT_COUNT || !rx_dma_enabled[destination])
+  {
+      return;
+  }
+  usart = usart_ports[destination];
+
+  USART_IntDisable(usart, USART_IEN_TCMP0);
+  usart->TIMECMP0 = 0;
+  LDMA_StopTransfer(DMA_CH_UART_RX(destination));
+  dma_set_callback(DMA_CH_UART_RX(destination), NULL, NULL);
+
+  NVIC_DisableIRQ(usart_rx_irqs[destination]);
+  rx_dma_enabled[destination] = false;
+  rx_dma_callback[destination] = NULL;
+  ring_buffer_init(&rx_ring[destination], rx_storage[destination], USART_RX_RING_SIZE);
+  USART_IntEnable(usart, USART_IEN_RXDATAV);
+  NVIC_EnableIRQ(usart_rx_irqs[destination]);
+}
+
+
+
+
+/**
+ * @brief Zero-copy access to received bytes on a port
+ * @param destination: Port to read
+ * @param data: Set to the oldest unread byte
+ * @return Number of contiguous bytes at *data (0 if nothing is waiting)
+ * @note Call uart_rx_span_release() once the bytes have been used. On a DMA
+ *       port the span points into the DMA ring; on other ports into the RX ring.
+ */
+uint16_t uart_rx_span(destination_t destination, const uint8_t **data)
+{
+  if (destination >= USART_PORT_COUNT || destination == Expander)
+  {
+      return 0;
+  }
+  if (rx_dma_enabled[destination])
+  {
+      usart_rx_dma_sync(destination);
+  }
+  return ring_buffer_peek_contiguous(&rx_ring[destination], data);
+}
+
+
+
+
+/**
+ * @brief Releases bytes obtained with uart_rx_span()
+ * @param destination: Port the span came from
+ * @param len: Number of bytes used (no more than uart_rx_span() returned)
+ */
+void uart_rx_span_release(destination_t destination, uint16_t len)
+{
+  if (destination >= USART_PORT_COUNT || destination == Expander)
+  {
+      return;
+  }
+  ring_buffer_consume(&rx_ring[destination], len);
+}
+
+
+
+
+/**
+ * @brief Number of idle-line timeouts (received bursts) on a DMA port since it was enabled
+ */
+uint32_t uart_rx_bursts(destination_t destination)
+{
+  return (destination < USART_PORT_COUNT) ? rx_bursts[destination] : 0;
+}
+
+
+
+
+/**
+ * @brief Blocking single character receive
+ * @param usart: Peripheral to read from
+ * @return Received character
+ * @note Asynchronous ports are fed by the RX interrupt, so this reads from the
+ *       port's RX ring (sleeping while empty). Only the SPI port still polls RXDATAV.
+ */
+char USART_ReceiveChar(USART_TypeDef *usart)
+{
+  char input = 0;
+
+  for (int port = 0; port < USART_PORT_COUNT; port++)
+  {
+      if (usart_ports[port] == usart && port != Expander)
+      {
+          uart_read((destination_t)port, &input, 1, UART_WAIT_FOREVER);
+          return input;
+      }
+  }
+
+    while (!(usart->STATUS & USART_STATUS_RXDATAV))     // Wait until data is available
+    {
+        // Wait for RX buffer to have data
+    }
+    input = USART_Rx(usart);
+
+    return input;     // Read and return the received byte
+}
+
+
+
+
+/*==============================================================================
+ * TX INTERRUPT HANDLERS
+ *============================================================================*/
+
+/**
+ * @brief TXC handler for RS485 ports - releases DE once everything has left the wire
+ * @param destination: Port that raised the interrupt
+ * @note If more data was queued after the last byte (ring, DMA queue or a byte
+ *       already in TXDATA clearing STATUS.TXC) DE stays on and TXC stays armed
+ */
+static void usart_tx_complete_isr(destination_t destination)
+{
+  USART_TypeDef *usart = usart_ports[destination];
+  const uart_port_config_t *config = &usart_config[destination];
+
+  usart->IFC = USART_IF_TXC;
+
+  if (!ring_buffer_is_empty(&tx_ring[destination]) || tx_dma_active[destination] ||
+      !dma_queue_is_empty(&tx_dma_queue[destination]) || !(usart->STATUS & USART_STATUS_TXC))
+  {
+      return;
+  }
+
+  GPIO_PinOutClear(config->de_port, config->de_pin);
+  if (usart->IF & USART_IF_TCMP1)                                               // measured by the USART from the end of the stop bit
+  {
+      rs485_late[destination]++;
+  }
+  rs485_released[destination]++;
+
+  usart->IEN &= ~USART_IEN_TXC;
+  rs485_de_on[destination] = false;
+}
+
+
+/**
+ * @brief Common TXBL handler - refills the USART TX buffer from the port's ring
+ * @param destination: Port that raised the interrupt
+ * @note TXBL stays asserted while the TX buffer has room, so the interrupt is
+ *       switched off as soon as the ring runs dry and back on by usart_tx_start()
+ * @note Hands the port over to the LDMA when the ring reaches a queued job's mark
+ */
+static void usart_tx_isr(destination_t destination)
+{
+  USART_TypeDef *usart = usart_ports[destination];
+  uint8_t c;
+
+  if (usart->IF & usart->IEN & USART_IF_TXC)                                    // first, so the bus is released as early as possible
+  {
+      usart_tx_complete_isr(destination);
+  }
+
+  if (rx_dma_enabled[destination])
+  {
+      usart_rx_idle_isr(destination);
+  }
+
+  if (!(usart->IEN & USART_IEN_TXBL))                                           // not draining (e.g. only the idle timeout fired)
+  {
+      return;
+  }
+
+  while (usart->STATUS & USART_STATUS_TXBL)
+  {
+      if (usart_tx_at_dma_mark(destination))                                    // a DMA job was queued at this point
+      {
+          usart->IEN &= ~USART_IEN_TXBL;
+          usart_tx_dma_start(destination);
+          return;
+      }
+      if (!ring_buffer_get(&tx_ring[destination], &c))
+      {
+          usart->IEN &= ~USART_IEN_TXBL;
+          return;
+      }
+      usart->TXDATA = c;
+  }
+}
+
+void USART0_TX_IRQHandler(void)   { usart_tx_isr(IMU);       }
+void USART1_TX_IRQHandler(void)   { usart_tx_isr(PDEM);      }
+void USART2_TX_IRQHandler(void)   { usart_tx_isr(Node);      }
+void USART3_TX_IRQHandler(void)   { usart_tx_isr(Thrusters); }
+void USART5_TX_IRQHandler(void)   { usart_tx_isr(SDAS);      }
+void UART0_TX_IRQHandler(void)    { usart_tx_isr(FCPU);      }
+void UART1_TX_IRQHandler(void)    { usart_tx_isr(USBL);      }
+
+
+
+
+/*==============================================================================
+ * RX INTERRUPT HANDLERS
+ *============================================================================*/
+
+/**
+ * @brief Multidrop receive - filters address frames, queues data frames sent to us
+ * @param destination: Port in multidrop mode
+ * @note Data frames already in the RX FIFO behind a foreign address frame are
+ *       dropped in software as RXBLOCK only applies to frames still arriving
+ */
+static void usart_rx_multidrop_isr(destination_t destination)
+{
+  USART_TypeDef *usart = usart_ports[destination];
+  uint32_t frame;
+  uint8_t byte;
+
+  usart->IFC = USART_IF_MPAF;
+
+  while (usart->STATUS & USART_STATUS_RXDATAV)
+  {
+      frame = usart->RXDATAX;
+      byte = (uint8_t)frame;
+
+      if (frame & MULTIDROP_ADDRESS_BIT)
+      {
+          mp_selected[destination] = (byte == mp_address[destination]) || (byte == UART_MULTIDROP_BROADCAST);
+          if (mp_selected[destination])
+          {
+              usart->CMD = USART_CMD_RXBLOCKDIS;
+              mp_matched[destination]++;
+          }
+          else
+          {
+              usart->CMD = USART_CMD_RXBLOCKEN;
+              mp_ignored[destination]++;
+          }
+      }
+      else if (mp_selected[destination] && !ring_buffer_put(&rx_ring[destination], byte))
+      {
+          rx_overruns[destination]++;
+      }
+  }
+}
+
+
+/**
+ * @brief Common RXDATAV handler - moves every waiting byte into the port's ring
+ * @param destination: Port that raised the interrupt
+ * @note Ports in circular DMA mode only take RXOF and the idle timeout here
+ */
+static void usart_rx_isr(destination_t destination)
+{
+  USART_TypeDef *usart = usart_ports[destination];
+
+  if (usart->IF & USART_IF_RXOF)                                                // hardware lost a byte before we got here
+  {
+      usart->IFC = USART_IF_RXOF;
+      rx_overruns[destination]++;
+  }
+
+  if (rx_dma_enabled[destination])                                              // LDMA owns RXDATA
+  {
+      usart_rx_idle_isr(destination);
+      return;
+  }
+
+  if (mp_enabled[destination])
+  {
+      usart_rx_multidrop_isr(destination);
+      return;
+  }
+
+  while (usart->STATUS & USART_STATUS_RXDATAV)
+  {
+      if (!ring_buffer_put(&rx_ring[destination], (uint8_t)usart->RXDATA))
+      {
+          rx_overruns[destination]++;
+      }
+  }
+}
+
+void USART0_RX_IRQHandler(void)   { usart_rx_isr(IMU);       }
+void USART1_RX_IRQHandler(void)   { usart_rx_isr(PDEM);      }
+void USART2_RX_IRQHandler(void)   { usart_rx_isr(Node);      }
+void USART3_RX_IRQHandler(void)   { usart_rx_isr(Thrusters); }
+void USART5_RX_IRQHandler(void)   { usart_rx_isr(SDAS);      }
+void UART0_RX_IRQHandler(void)    { usart_rx_isr(FCPU);      }
+void UART1_RX_IRQHandler(void)    { usart_rx_isr(USBL);      }
@@ -5,13 +5,116 @@
  *      Author: JonathanStorey
  */
 #include "em_usart.h"
+#include "em_gpio.h"
+#include "defines.h"
+#include "dma_queue.h"
+#include "ring_buffer.h"
 
 #ifndef USART_H_
 #define USART_H_
 
+#include <stdint.h>
+
+/*==============================================================================
+ * TX RING CONFIGURATION
+ *============================================================================*/
+#define USART_PORT_COUNT        8       ///< One port per destination_t entry
+#define USART_TX_RING_SIZE      256     ///< Bytes of TX buffering per port (power of two)
+#define USART_RX_RING_SIZE      256     ///< Bytes of RX buffering per port (power of two)
+
+#define USART_RX_DMA_RING_SIZE  1024    ///< Circular LDMA RX buffer for streaming ports (power of two, max 4096)
+#define USART_RX_IDLE_BITS      20      ///< Idle line time (bit periods, max 255) that ends a burst
+#define USART_RS485_TURN_BITS   1       ///< Software DE held longer than this (bit periods) after the stop bit counts as late
+#define UART_DE_SOFTWARE        (-1)    ///< de_csloc: DE is a GPIO driven from the TXC interrupt
+
+#define UART_MULTIDROP_BROADCAST 0xFF   ///< Multidrop address every node accepts
+#define THRUSTER_NODE_ADDRESS   0x00    ///< This node's address on the Thruster bus
+#define THRUSTER_BROADCAST      UART_MULTIDROP_BROADCAST
+
+#define UART_WAIT_FOREVER       0xFFFFFFFFUL    ///< uart_read() timeout: wait until n bytes arrive
+
+/**
+ * @brief What put_char() does when a port's TX ring is full
+ */
+typedef enum {
+    UART_TX_BLOCK,                      ///< Wait for the TXBL interrupt to make room (default)
+    UART_TX_DROP,                       ///< Discard the new byte
+    UART_TX_OVERWRITE                   ///< Discard the oldest queued byte to make room
+} uart_tx_policy_t;
+
+/**
+ * @brief Line settings for one asynchronous port (8 data bits, no flow control)
+ */
+typedef struct {
+    uint32_t baudrate;                  ///< Requested bit rate
+    USART_Parity_TypeDef parity;        ///< usartNoParity / usartEvenParity / usartOddParity
+    USART_Stopbits_TypeDef stopbits;    ///< usartStopbits1 / usartStopbits2
+    USART_OVS_TypeDef oversampling;     ///< usartOVS16 default, lower ratios reach higher baud rates
+    bool rs485;                         ///< Half-duplex transceiver with a driver enable pin
+    GPIO_Port_TypeDef de_port;          ///< RS485 DE (RTS) port, ignored unless rs485
+    uint8_t de_pin;                     ///< RS485 DE (RTS) pin, ignored unless rs485
+    int8_t de_csloc;                    ///< USART CS location DE sits on (AUTOCS drives it), or UART_DE_SOFTWARE
+} uart_port_config_t;
+
 void usart_init(void);
 void put_char(char c, int);
 void print_string(const char *str, int);
 char USART_ReceiveChar(USART_TypeDef *usart);
 
+uint16_t uart_write(destination_t destination, const void *buf, uint16_t len);
+/**
+ * @brief Builds one record in place in a TX ring, see uart_tx_produce()
+ */
+typedef uint16_t (*uart_tx_producer_t)(ring_buffer_t *ring, void *ctx);
+
+uint16_t uart_tx_produce(destination_t destination, uint16_t need, uart_tx_producer_t producer, void *ctx);
+void uart_set_tx_policy(destination_t destination, uart_tx_policy_t policy);
+void uart_tx_flush(destination_t destination);
+uint16_t uart_tx_pending(destination_t destination);
+uint32_t uart_tx_dropped(destination_t destination);
+
+/**
+ * @brief uart_write_dma() completion callback (interrupt context)
+ */
+typedef dma_callback_t uart_dma_callback_t;
+
+bool uart_write_dma(destination_t destination, const void *buf, size_t len, uart_dma_callback_t callback);
+void print_string_dma(const char *str, int destination);
+
+bool uart_configure(destination_t destination, const uart_port_config_t *config);
+bool uart_get_config(destination_t destination, uart_port_config_t *config);
+uint32_t uart_actual_baudrate(destination_t destination);
+int32_t uart_baud_error_ppm(destination_t destination);
+void uart_print_config(destination_t destination, int output);
+uint32_t uart_spi_set_bitrate(uint32_t bitrate);
+uint32_t uart_spi_bitrate(void);
+void uart_rs485_turnaround(destination_t destination, uint32_t *released, uint32_t *late);
+
+bool uart_multidrop_enable(destination_t destination, uint8_t own_address);
+void uart_multidrop_disable(destination_t destination);
+uint16_t uart_write_addressed(destination_t destination, uint8_t address, const void *payload, uint16_t len);
+void uart_multidrop_stats(destination_t destination, uint32_t *matched, uint32_t *ignored);
+void thruster_bus_init(void);
+uint16_t thruster_send(uint8_t addr, const void *payload, uint16_t len);
+
+uint16_t uart_read(destination_t destination, void *buf, uint16_t n, uint32_t timeout_ms);
+uint16_t uart_available(destination_t destination);
+uint32_t uart_rx_overruns(destination_t destination);
+void uart_rx_clear(destination_t destination);
+
+/**
+ * @brief Received burst handed out by circular LDMA RX (interrupt context)
+ * @param destination: Port the bytes arrived on
+ * @param data: Bytes inside the port's DMA ring - valid until the ring wraps
+ *              back over them, copy anything that must be kept
+ * @param len: Number of bytes at data
+ */
+typedef void (*uart_rx_span_callback_t)(int destination, const uint8_t *data, uint16_t len);
+
+bool uart_rx_dma_enable(destination_t destination, uint8_t *storage, uint16_t size, uart_rx_span_callback_t callback);
+void uart_rx_dma_disable(destination_t destination);
+uint16_t uart_rx_span(destination_t destination, const uint8_t **data);
+void uart_rx_span_release(destination_t destination, uint16_t len);
+uint32_t uart_rx_bursts(destination_t destination);
+
 #endif /* USART_H_ */
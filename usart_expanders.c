@@ -3,153 +3,722 @@
 #include "em_cmu.h"
 #include "em_usart.h"
 #include "em_gpio.h"
+#include "em_core.h"
 #include "defines.h"
 #include "helpers.h"
 #include "usart_expanders.h"
+#include "spi_bus.h"
+#include "dma.h"
+#include "expander_io.h"
+#include "usart.h"
 #include "hw_timer.h"
 
 
 
 
+/*==============================================================================
+ * INITIALISATION
+ *============================================================================*/
+
+/**
+ * @brief Per-channel line settings applied by MAX14830_InitExpanders()
+ * @note Divisors come from max14830_calc_divisor() on the expander's fREF, and
+ *       can be changed later per channel with MAX14830_SetBaud()
+ */
+static const max14830_channel_config_t max14830_channel_config[4] =
+{
+    /* lcr                      baud    fifotrig                                                             */
+    { MAX14830_LCR_WORD_LEN_8,  9600,   (1 << MAX14830_FIFOTRIG_RX_SHIFT) | (1 << MAX14830_FIFOTRIG_TX_SHIFT) },   // UART0
+    { MAX14830_LCR_WORD_LEN_8,  9600,   (1 << MAX14830_FIFOTRIG_RX_SHIFT) | (1 << MAX14830_FIFOTRIG_TX_SHIFT) },   // UART1
+    { MAX14830_LCR_WORD_LEN_8,  9600,   (1 << MAX14830_FIFOTRIG_RX_SHIFT) | (1 << MAX14830_FIFOTRIG_TX_SHIFT) },   // UART2
+    { MAX14830_LCR_WORD_LEN_8,  9600,   (1 << MAX14830_FIFOTRIG_RX_SHIFT) | (1 << MAX14830_FIFOTRIG_TX_SHIFT) },   // UART3
+};
+
+/**
+ * @brief Rates every channel must be able to switch to at run time
+ * @note The PLL is shared by all four UARTs, so fREF is chosen once for the
+ *       whole set (57.6 MHz from a 4 MHz crystal - all exact)
+ */
+static const uint32_t max14830_baud_rates[] =
+{
+    9600, 19200, 38400, 57600, 115200, 230400, 460800, 921600
+};
+
+#define MAX14830_DIVLSB_RESET       0x01        // DIVLSB reads back 0x01 once a channel is out of reset
+
+static uint32_t max14830_fref[3];               // Reference clock per expander, 0 until initialised
+static uint32_t max14830_baud[3][4];            // Rate last programmed per channel
+
+/**
+ * @brief Registers the shadow cache may answer for, one bit per address
+ * @note Left out: THR / RHR, ISR, LSR, SPCLCHRSTS, STSINT, the FIFO levels and
+ *       GLOBALIRQ / GLOBALCMD, which either change on their own, clear on read
+ *       or are commands. MODE2 is cached except for writes with RST or FIFORST.
+ */
+#define MAX14830_SHADOW_REG(reg)    (1UL << (reg))
+#define MAX14830_SHADOW_CACHEABLE   (MAX14830_SHADOW_REG(MAX14830_IRQEN_REG)      | MAX14830_SHADOW_REG(MAX14830_LSRINTEN_REG)    | \
+                                     MAX14830_SHADOW_REG(MAX14830_SPCLCHRINT_REG) | MAX14830_SHADOW_REG(MAX14830_STSINTEN_REG)    | \
+                                     MAX14830_SHADOW_REG(MAX14830_MODE1_REG)      | MAX14830_SHADOW_REG(MAX14830_MODE2_REG)       | \
+                                     MAX14830_SHADOW_REG(MAX14830_LCR_REG)        | MAX14830_SHADOW_REG(MAX14830_RXIMEOUT_REG)    | \
+                                     MAX14830_SHADOW_REG(MAX14830_HDPLXDELAY_REG) | MAX14830_SHADOW_REG(MAX14830_IRDA_REG)        | \
+                                     MAX14830_SHADOW_REG(MAX14830_FLOWLVL_REG)    | MAX14830_SHADOW_REG(MAX14830_FIFOTRIGLVL_REG) | \
+                                     MAX14830_SHADOW_REG(MAX14830_FLOWCTRL_REG)   | MAX14830_SHADOW_REG(MAX14830_XON1_REG)        | \
+                                     MAX14830_SHADOW_REG(MAX14830_XON2_REG)       | MAX14830_SHADOW_REG(MAX14830_XOFF1_REG)       | \
+                                     MAX14830_SHADOW_REG(MAX14830_XOFF2_REG)      | MAX14830_SHADOW_REG(MAX14830_GPIOCONFIG_REG)  | \
+                                     MAX14830_SHADOW_REG(MAX14830_GPIODATA_REG)   | MAX14830_SHADOW_REG(MAX14830_PLLCFG_REG)      | \
+                                     MAX14830_SHADOW_REG(MAX14830_BRGCFG_REG)     | MAX14830_SHADOW_REG(MAX14830_DIVLSB_REG)      | \
+                                     MAX14830_SHADOW_REG(MAX14830_DIVMSB_REG)     | MAX14830_SHADOW_REG(MAX14830_CLKSRC_REG))
+
+static uint8_t max14830_shadow[3][4][0x20];     // Last value written per register
+static uint32_t max14830_shadow_valid[3][4];    // MAX14830_SHADOW_REG() bit per register holding a known value
+static uint32_t max14830_shadow_saved;          // SPI transactions the cache made unnecessary
+
+/**
+ * @brief Microseconds since a hw_timer_cycles() stamp
+ */
+static uint32_t MAX14830_ElapsedUs(uint32_t start)
+{
+    return hw_timer_cycles_to_ns(hw_timer_cycles() - start) / 1000;
+}
+
 /**
- * @brief Complete initialization function for MAX14830 UART1 with 4MHz crystal
- * Configures UART1 for 9600 baud, 8N1 format with standard settings
+ * @brief Program one channel's BRGCFG, DIVLSB and DIVMSB in one burst
+ */
+static void MAX14830_WriteDivisor(uint8_t expander, uint8_t uart, const max14830_divisor_t *divisor)
+{
+    const uint8_t brg[3] =                      // BRGCFG, DIVLSB, DIVMSB (0x1B - 0x1D)
+    {
+        divisor->brgcfg,
+        (uint8_t)(divisor->div & 0xFF),
+        (uint8_t)(divisor->div >> 8)
+    };
+
+    MAX14830_WriteBurst(expander, uart, MAX14830_BRGCFG_REG, brg, sizeof(brg));
+}
+
+/**
+ * @brief Write one channel's configuration in three SPI bursts
+ * @note Burst writes auto-increment the register address (THR excepted), so
+ *       each burst covers a run of adjacent writable registers
+ */
+static void MAX14830_ApplyChannelConfig(uint8_t expander, uint8_t uart, const max14830_channel_config_t *config)
+{
+    const uint8_t mode[8] =                     // MODE1 .. FIFOTRIGLVL (0x09 - 0x10)
+    {
+        0x00,                                   // MODE1: normal operation
+        0x00,                                   // MODE2: out of reset, FIFOs running
+        config->lcr,                            // LCR
+        0x00,                                   // RXTIMEOUT: off
+        0x00,                                   // HDPLXDELAY
+        0x00,                                   // IRDA: off
+        0x00,                                   // FLOWLVL
+        config->fifotrig                        // FIFOTRIGLVL
+    };
+    const uint8_t flow[5] = { 0x00, 0x00, 0x00, 0x00, 0x00 };      // FLOWCTRL, XON1, XON2, XOFF1, XOFF2 (0x13 - 0x17)
+    max14830_divisor_t divisor;
+
+    MAX14830_WriteBurst(expander, uart, MAX14830_MODE1_REG, mode, sizeof(mode));
+    MAX14830_WriteBurst(expander, uart, MAX14830_FLOWCTRL_REG, flow, sizeof(flow));
+    if (max14830_calc_divisor(max14830_fref[expander - EXPANDER_A], config->baud, &divisor))
+    {
+        MAX14830_WriteDivisor(expander, uart, &divisor);
+        max14830_baud[expander - EXPANDER_A][uart] = config->baud;
+    }
+    MAX14830_WriteRegister(expander, uart, MAX14830_IRQEN_REG, 0x00);          // interrupts off - poll, or see expander_irq_enable()
+    MAX14830_WriteRegister(expander, uart, MAX14830_LSRINTEN_REG, 0x00);
+    MAX14830_WriteRegister(expander, uart, MAX14830_SPCLCHRINT_REG, 0x00);
+    MAX14830_WriteRegister(expander, uart, MAX14830_STSINTEN_REG, 0x00);
+}
+
+/**
+ * @brief Bring up several expanders together, polling for readiness instead of sleeping
+ * @param expander_mask Bit (expander - EXPANDER_A) set for each expander to initialise
+ * @param timing Filled with per-stage timings (may be NULL)
+ * @return true if every channel came out of reset and every clock became ready
+ * @note The stages are interleaved across expanders: all channels are reset,
+ *       then all are polled until DIVLSB reads back its reset value, then all
+ *       PLLs are started and polled for STSINT CLKREADY, then all channels are
+ *       configured. Each expander's wait overlaps the others'.
+ */
+bool MAX14830_InitExpanders(uint8_t expander_mask, max14830_init_timing_t *timing)
+{
+    uint32_t start = hw_timer_cycles();
+    uint32_t stage = start;
+    uint16_t waiting = 0;                       // bit (expander - 1) * 4 + uart
+    uint8_t clock_waiting = 0;                  // bit expander - 1
+    max14830_init_timing_t t = { 0 };
+    max14830_clock_t clock;
+
+    /* Stage 1: reset every channel */
+    for (uint8_t expander = EXPANDER_A; expander <= EXPANDER_C; expander++)
+    {
+        if (!(expander_mask & (1 << (expander - EXPANDER_A))))
+        {
+            continue;
+        }
+        for (uint8_t uart = 0; uart < 4; uart++)
+        {
+            MAX14830_WriteRegister(expander, uart, MAX14830_MODE2_REG, MAX14830_MODE2_RST);
+            MAX14830_WriteRegister(expander, uart, MAX14830_MODE2_REG, 0x00);
+            waiting |= (uint16_t)(1u << ((expander - EXPANDER_A) * 4 + uart));
+        }
+        clock_waiting |= (uint8_t)(1u << (expander - EXPANDER_A));
+    }
+
+    /* Stage 2: wait for every channel to come out of reset */
+    while (waiting && MAX14830_ElapsedUs(stage) < MAX14830_INIT_TIMEOUT_US)
+    {
+        for (uint8_t bit = 0; bit < 12; bit++)
+        {
+            if ((waiting & (1u << bit)) &&
+                MAX14830_ReadRegister(EXPANDER_A + bit / 4, bit % 4, MAX14830_DIVLSB_REG) == MAX14830_DIVLSB_RESET)
+            {
+                waiting &= (uint16_t)~(1u << bit);
+            }
+            t.polls++;
+        }
+    }
+    t.reset_us = MAX14830_ElapsedUs(stage);
+    stage = hw_timer_cycles();
+
+    /* Stage 3: start the crystal and PLL on every expander, wait for CLKREADY */
+    max14830_calc_clock(MAX14830_CRYSTAL_FREQ, max14830_baud_rates, sizeof(max14830_baud_rates) / sizeof(max14830_baud_rates[0]), &clock, NULL);
+    for (uint8_t expander = EXPANDER_A; expander <= EXPANDER_C; expander++)
+    {
+        if (clock_waiting & (1 << (expander - EXPANDER_A)))
+        {
+            if (!clock.bypass)
+            {
+                MAX14830_WriteRegister(expander, MAX14830_UART0, MAX14830_PLLCFG_REG, clock.pllcfg);
+            }
+            MAX14830_WriteRegister(expander, MAX14830_UART0, MAX14830_CLKSRC_REG,       // global - MUST go through UART0
+                                   MAX14830_CLKSOURCE_CRYSTALEN | (clock.bypass ? MAX14830_CLKSOURCE_PLLBYPASS : MAX14830_CLKSOURCE_PLLEN));
+            max14830_fref[expander - EXPANDER_A] = clock.fref;
+        }
+    }
+    while (clock_waiting && MAX14830_ElapsedUs(stage) < MAX14830_INIT_TIMEOUT_US)
+    {
+        for (uint8_t expander = EXPANDER_A; expander <= EXPANDER_C; expander++)
+        {
+            if ((clock_waiting & (1 << (expander - EXPANDER_A))) &&
+                (MAX14830_ReadRegister(expander, MAX14830_UART0, MAX14830_STSINT_REG) & MAX14830_STSINT_CLKREADY))
+            {
+                clock_waiting &= (uint8_t)~(1u << (expander - EXPANDER_A));
+            }
+            t.polls++;
+        }
+    }
+    t.clock_us = MAX14830_ElapsedUs(stage);
+    stage = hw_timer_cycles();
+
+    /* Stage 4: configure every channel from the table */
+    for (uint8_t expander = EXPANDER_A; expander <= EXPANDER_C; expander++)
+    {
+        if (expander_mask & (1 << (expander - EXPANDER_A)))
+        {
+            for (uint8_t uart = 0; uart < 4; uart++)
+            {
+                MAX14830_ApplyChannelConfig(expander, uart, &max14830_channel_config[uart]);
+            }
+        }
+    }
+    t.config_us = MAX14830_ElapsedUs(stage);
+    t.total_us = MAX14830_ElapsedUs(start);
+    t.ok = (waiting == 0) && (clock_waiting == 0);
+
+    if (timing)
+    {
+        *timing = t;
+    }
+    return t.ok;
+}
+
+/**
+ * @brief Complete initialization function for one MAX14830 with 4MHz crystal
+ * Configures all four UARTs for 9600 baud, 8N1 format with standard settings
+ * @note Prefer MAX14830_InitExpanders() to bring several expanders up together
  */
 void MAX14830_UART_Init(uint8_t expander)
 {
-    MAX14830_WriteRegister(expander,MAX14830_UART0, MAX14830_MODE2_REG, MAX14830_MODE2_RST);     // Step 1: Reset the specific UART channel first (optional but recommended)
-    hw_timer1_ms(2);                                                                             // Wait for reset to complete
-    MAX14830_WriteRegister(expander, MAX14830_UART0, MAX14830_CLKSRC_REG, MAX14830_CLKSOURCE_CRYSTALEN | MAX14830_CLKSOURCE_PLLEN);     // Step 2: Configure Clock Source - Enable crystal oscillator and PLL !!! MUST BE WRITTEN TO USART_0!!!
-    MAX14830_WriteRegister(expander, MAX14830_UART0, MAX14830_PLLCFG_REG, 0x48);                // Step 3: Configure PLL for 4 MHz crystal,PLL config 0x48: predivider=8, factor=1 gives good internal clock for UART
-    hw_timer1_ms(5);                                                                            // Wait for PLL to stabilize
-
-
-
-
-    MAX14830_WriteRegister(expander, MAX14830_UART0, MAX14830_DIVLSB_REG, 156);                  // Step 4: Configure Baud Rate Generator for 9600 baud with 4MHz crystal
-    MAX14830_WriteRegister(expander, MAX14830_UART0, MAX14830_DIVMSB_REG, 0);                   // With 4MHz and PLL settings: Divisor ≈ 26 for 9600 baud,     // Actual baud rate will be ~9615 (0.16% error - acceptable)
-    MAX14830_WriteRegister(expander, MAX14830_UART0, MAX14830_BRGCFG_REG, 0x04);                //
-    MAX14830_WriteRegister(expander, MAX14830_UART0, MAX14830_LCR_REG, MAX14830_LCR_WORD_LEN_8);// Step 5: Configure Line Control Register for 8N1 format,     // 8 data bits, no parity, 1 stop bit
-    MAX14830_WriteRegister(expander, MAX14830_UART0, MAX14830_FIFOTRIGLVL_REG,(1 << MAX14830_FIFOTRIG_RX_SHIFT) | (1 << MAX14830_FIFOTRIG_TX_SHIFT));     // Step 6: Configure FIFO trigger levels,     // RX trigger at 1 character, TX trigger at 1 character for responsive operation
-    MAX14830_WriteRegister(expander, MAX14830_UART0, MAX14830_MODE1_REG, 0x00);                 // Step 7: Configure MODE1 register - normal UART operation,     // All special functions disabled for standard UART behavior
-    MAX14830_WriteRegister(expander, MAX14830_UART0, MAX14830_MODE2_REG, 0x00);                 // Step 8: Configure MODE2 register - clear reset and special modes , // Ensure FIFO is not in reset state, normal operation mode
-    MAX14830_WriteRegister(expander, MAX14830_UART0, MAX14830_FLOWCTRL_REG, 0x00);              // Step 9: Configure Flow Control - disabled for basic operation,    // No hardware or software flow control
-    MAX14830_WriteRegister(expander, MAX14830_UART0, MAX14830_RXIMEOUT_REG, 0x00);              // Step 10: Configure RX timeout - disabled for this basic setup
- //   uint8_t temp = MAX14830_ReadRegister(MAX14830_UART1, MAX14830_ISR_REG);                   // Step 11: Clear any pending interrupts by reading the ISR
-  //  (void)temp;                                                                               // Suppress unused variable warning
-    MAX14830_WriteRegister(expander, MAX14830_UART0, MAX14830_IRQEN_REG,0x00);                  // Disable all interrupts, must poll the ISR instead
-    MAX14830_WriteRegister(expander, MAX14830_UART0, MAX14830_LSRINTEN_REG,0x00);               // Disable the line status interrupts
-    MAX14830_WriteRegister(expander, MAX14830_UART0, MAX14830_SPCLCHRINT_REG,0x00);             // Disable special character interrupts
-    MAX14830_WriteRegister(expander, MAX14830_UART0, MAX14830_STSINTEN_REG,0x00);               // Disable system interrupt interrupts
-  //  uint8_t temp = MAX14830_ReadRegister(MAX14830_UART1, MAX14830_STSINT_REG);                // use to check if clock is ready
-  //  MAX14830_WriteRegister(expander, MAX14830_UART0, MAX14830_MODE1_REG,0x00);                  // enables TX and RX, see mode 1 reg
-  //  MAX14830_WriteRegister(expander, MAX14830_UART0, MAX14830_GLOBALCMD_REG, 0x02);             // Step 13: Enable UART1 via Global Command Register,     // Bit 1 (0x02) enables UART1 transmitter and receiver
-
-
-
-
-
-    MAX14830_WriteRegister(expander, MAX14830_UART1, MAX14830_DIVLSB_REG, 156);                  // Step 4: Configure Baud Rate Generator for 9600 baud with 4MHz crystal
-    MAX14830_WriteRegister(expander, MAX14830_UART1, MAX14830_DIVMSB_REG, 0);                   // With 4MHz and PLL settings: Divisor ≈ 26 for 9600 baud,     // Actual baud rate will be ~9615 (0.16% error - acceptable)
-    MAX14830_WriteRegister(expander, MAX14830_UART1, MAX14830_BRGCFG_REG, 0x04);                //
-    MAX14830_WriteRegister(expander, MAX14830_UART1, MAX14830_LCR_REG, MAX14830_LCR_WORD_LEN_8);// Step 5: Configure Line Control Register for 8N1 format,     // 8 data bits, no parity, 1 stop bit
-    MAX14830_WriteRegister(expander, MAX14830_UART1, MAX14830_FIFOTRIGLVL_REG,(1 << MAX14830_FIFOTRIG_RX_SHIFT) | (1 << MAX14830_FIFOTRIG_TX_SHIFT));     // Step 6: Configure FIFO trigger levels,     // RX trigger at 1 character, TX trigger at 1 character for responsive operation
-    MAX14830_WriteRegister(expander, MAX14830_UART1, MAX14830_MODE1_REG, 0x00);                 // Step 7: Configure MODE1 register - normal UART operation,     // All special functions disabled for standard UART behavior
-    MAX14830_WriteRegister(expander, MAX14830_UART1, MAX14830_MODE2_REG, 0x00);                 // Step 8: Configure MODE2 register - clear reset and special modes , // Ensure FIFO is not in reset state, normal operation mode
-    MAX14830_WriteRegister(expander, MAX14830_UART1, MAX14830_FLOWCTRL_REG, 0x00);              // Step 9: Configure Flow Control - disabled for basic operation,    // No hardware or software flow control
-    MAX14830_WriteRegister(expander, MAX14830_UART1, MAX14830_RXIMEOUT_REG, 0x00);              // Step 10: Configure RX timeout - disabled for this basic setup
-    //   uint8_t temp = MAX14830_ReadRegister(MAX14830_UART1, MAX14830_ISR_REG);                   // Step 11: Clear any pending interrupts by reading the ISR
-    //  (void)temp;                                                                               // Suppress unused variable warning
-    MAX14830_WriteRegister(expander, MAX14830_UART1, MAX14830_IRQEN_REG,0x00);                  // Disable all interrupts, must poll the ISR instead
-    MAX14830_WriteRegister(expander, MAX14830_UART1, MAX14830_LSRINTEN_REG,0x00);               // Disable the line status interrupts
-    MAX14830_WriteRegister(expander, MAX14830_UART1, MAX14830_SPCLCHRINT_REG,0x00);             // Disable special character interrupts
-    MAX14830_WriteRegister(expander, MAX14830_UART1, MAX14830_STSINTEN_REG,0x00);               // Disable system interrupt interrupts
-    //  uint8_t temp = MAX14830_ReadRegister(MAX14830_UART1, MAX14830_STSINT_REG);                // use to check if clock is ready
- //   MAX14830_WriteRegister(expander, MAX14830_UART1, MAX14830_MODE1_REG,0x00);                  // enables TX and RX, see mode 1 reg
-  //  MAX14830_WriteRegister(expander, MAX14830_UART1, MAX14830_GLOBALCMD_REG, 0x02);             // Step 13: Enable UART1 via Global Command Register,     // Bit 1 (0x02) enables UART1 transmitter and receiver
-
-
-
-
-    MAX14830_WriteRegister(expander, MAX14830_UART2, MAX14830_DIVLSB_REG, 156);                  // Step 4: Configure Baud Rate Generator for 9600 baud with 4MHz crystal
-    MAX14830_WriteRegister(expander, MAX14830_UART2, MAX14830_DIVMSB_REG, 0);                   // With 4MHz and PLL settings: Divisor ≈ 26 for 9600 baud,     // Actual baud rate will be ~9615 (0.16% error - acceptable)
-    MAX14830_WriteRegister(expander, MAX14830_UART2, MAX14830_BRGCFG_REG, 0x04);                //
-    MAX14830_WriteRegister(expander, MAX14830_UART2, MAX14830_LCR_REG, MAX14830_LCR_WORD_LEN_8);// Step 5: Configure Line Control Register for 8N1 format,     // 8 data bits, no parity, 1 stop bit
-    MAX14830_WriteRegister(expander, MAX14830_UART2, MAX14830_FIFOTRIGLVL_REG,(1 << MAX14830_FIFOTRIG_RX_SHIFT) | (1 << MAX14830_FIFOTRIG_TX_SHIFT));     // Step 6: Configure FIFO trigger levels,     // RX trigger at 1 character, TX trigger at 1 character for responsive operation
-    MAX14830_WriteRegister(expander, MAX14830_UART2, MAX14830_MODE1_REG, 0x00);                 // Step 7: Configure MODE1 register - normal UART operation,     // All special functions disabled for standard UART behavior
-    MAX14830_WriteRegister(expander, MAX14830_UART2, MAX14830_MODE2_REG, 0x00);                 // Step 8: Configure MODE2 register - clear reset and special modes , // Ensure FIFO is not in reset state, normal operation mode
-    MAX14830_WriteRegister(expander, MAX14830_UART2, MAX14830_FLOWCTRL_REG, 0x00);              // Step 9: Configure Flow Control - disabled for basic operation,    // No hardware or software flow control
-    MAX14830_WriteRegister(expander, MAX14830_UART2, MAX14830_RXIMEOUT_REG, 0x00);              // Step 10: Configure RX timeout - disabled for this basic setup
-    //   uint8_t temp = MAX14830_ReadRegister(MAX14830_UART1, MAX14830_ISR_REG);                   // Step 11: Clear any pending interrupts by reading the ISR
-    //  (void)temp;                                                                               // Suppress unused variable warning
-    MAX14830_WriteRegister(expander, MAX14830_UART2, MAX14830_IRQEN_REG,0x00);                  // Disable all interrupts, must poll the ISR instead
-    MAX14830_WriteRegister(expander, MAX14830_UART2, MAX14830_LSRINTEN_REG,0x00);               // Disable the line status interrupts
-    MAX14830_WriteRegister(expander, MAX14830_UART2, MAX14830_SPCLCHRINT_REG,0x00);             // Disable special character interrupts
-    MAX14830_WriteRegister(expander, MAX14830_UART2, MAX14830_STSINTEN_REG,0x00);               // Disable system interrupt interrupts
-    //  uint8_t temp = MAX14830_ReadRegister(MAX14830_UART1, MAX14830_STSINT_REG);                // use to check if clock is ready
-  //  MAX14830_WriteRegister(expander, MAX14830_UART2, MAX14830_MODE1_REG,0x00);                  // enables TX and RX, see mode 1 reg
-  //  MAX14830_WriteRegister(expander, MAX14830_UART2, MAX14830_GLOBALCMD_REG, 0x02);             // Step 13: Enable UART1 via Global Command Register,     // Bit 1 (0x02) enables UART1 transmitter and receiver
-
-
-
-
-    MAX14830_WriteRegister(expander, MAX14830_UART3, MAX14830_DIVLSB_REG, 156);                  // Step 4: Configure Baud Rate Generator for 9600 baud with 4MHz crystal
-    MAX14830_WriteRegister(expander, MAX14830_UART3, MAX14830_DIVMSB_REG, 0);                   // With 4MHz and PLL settings: Divisor ≈ 26 for 9600 baud,     // Actual baud rate will be ~9615 (0.16% error - acceptable)
-    MAX14830_WriteRegister(expander, MAX14830_UART3, MAX14830_BRGCFG_REG, 0x04);                //
-    MAX14830_WriteRegister(expander, MAX14830_UART3, MAX14830_LCR_REG, MAX14830_LCR_WORD_LEN_8);// Step 5: Configure Line Control Register for 8N1 format,     // 8 data bits, no parity, 1 stop bit
-    MAX14830_WriteRegister(expander, MAX14830_UART3, MAX14830_FIFOTRIGLVL_REG,(1 << MAX14830_FIFOTRIG_RX_SHIFT) | (1 << MAX14830_FIFOTRIG_TX_SHIFT));     // Step 6: Configure FIFO trigger levels,     // RX trigger at 1 character, TX trigger at 1 character for responsive operation
-    MAX14830_WriteRegister(expander, MAX14830_UART3, MAX14830_MODE1_REG, 0x00);                 // Step 7: Configure MODE1 register - normal UART operation,     // All special functions disabled for standard UART behavior
-    MAX14830_WriteRegister(expander, MAX14830_UART3, MAX14830_MODE2_REG, 0x00);                 // Step 8: Configure MODE2 register - clear reset and special modes , // Ensure FIFO is not in reset state, normal operation mode
-    MAX14830_WriteRegister(expander, MAX14830_UART3, MAX14830_FLOWCTRL_REG, 0x00);              // Step 9: Configure Flow Control - disabled for basic operation,    // No hardware or software flow control
-    MAX14830_WriteRegister(expander, MAX14830_UART3, MAX14830_RXIMEOUT_REG, 0x00);              // Step 10: Configure RX timeout - disabled for this basic setup
-    //   uint8_t temp = MAX14830_ReadRegister(MAX14830_UART1, MAX14830_ISR_REG);                   // Step 11: Clear any pending interrupts by reading the ISR
-    //  (void)temp;                                                                               // Suppress unused variable warning
-    MAX14830_WriteRegister(expander, MAX14830_UART3, MAX14830_IRQEN_REG,0x00);                  // Disable all interrupts, must poll the ISR instead
-    MAX14830_WriteRegister(expander, MAX14830_UART3, MAX14830_LSRINTEN_REG,0x00);               // Disable the line status interrupts
-    MAX14830_WriteRegister(expander, MAX14830_UART3, MAX14830_SPCLCHRINT_REG,0x00);             // Disable special character interrupts
-    MAX14830_WriteRegister(expander, MAX14830_UART3, MAX14830_STSINTEN_REG,0x00);               // Disable system interrupt interrupts
-    //  uint8_t temp = MAX14830_ReadRegister(MAX14830_UART1, MAX14830_STSINT_REG);                // use to check if clock is ready
- //   MAX14830_WriteRegister(expander, MAX14830_UART3, MAX14830_MODE1_REG,0x00);                  // enables TX and RX, see mode 1 reg
- //   MAX14830_WriteRegister(expander, MAX14830_UART3, MAX14830_GLOBALCMD_REG, 0x02);             // Step 13: Enable UART1 via Global Command Register,     // Bit 1 (0x02) enables UART1 transmitter and receiver
-
-
-
-
-    hw_timer1_ms(2);                                                                              // Final delay to ensure UART is fully operational
+    MAX14830_InitExpanders((uint8_t)(1u << (expander - EXPANDER_A)), NULL);
+}
+
+
+
+
+
+/**
+ * @brief Change one channel's baud rate at run time
+ * @param expander Expander (EXPANDER_A/B/C)
+ * @param uart_channel UART channel (0-3)
+ * @param baud Requested rate in Hz
+ * @param result Divisor, achieved rate and error (may be NULL)
+ * @return false if the expander isn't initialised or the nearest rate is off
+ *         by more than MAX14830_BAUD_MAX_ERROR_PPM - nothing is written then
+ * @note Only BRGCFG / DIV change - the shared PLL is left alone, so the other
+ *       three channels keep their rates
+ */
+bool MAX14830_SetBaud(uint8_t expander, uint8_t uart_channel, uint32_t baud, max14830_divisor_t *result)
+{
+    max14830_divisor_t divisor;
+
+    if (expander < EXPANDER_A || expander > EXPANDER_C || uart_channel > MAX14830_UART3 ||
+        !max14830_calc_divisor(max14830_fref[expander - EXPANDER_A], baud, &divisor))
+    {
+        return false;
+    }
+    if (result)
+    {
+        *result = divisor;
+    }
+    if (divisor.error_ppm > MAX14830_BAUD_MAX_ERROR_PPM || divisor.error_ppm < -MAX14830_BAUD_MAX_ERROR_PPM)
+    {
+        return false;
+    }
+    MAX14830_WriteDivisor(expander, uart_channel, &divisor);
+    max14830_baud[expander - EXPANDER_A][uart_channel] = baud;
+    return true;
+}
+
+/**
+ * @brief Rate last programmed on a channel (0 before initialisation)
+ */
+uint32_t MAX14830_GetBaud(uint8_t expander, uint8_t uart_channel)
+{
+    if (expander < EXPANDER_A || expander > EXPANDER_C || uart_channel > MAX14830_UART3)
+    {
+        return 0;
+    }
+    return max14830_baud[expander - EXPANDER_A][uart_channel];
 }
 
+/**
+ * @brief Reference clock (fREF) of an expander in Hz (0 before initialisation)
+ */
+uint32_t MAX14830_GetReferenceClock(uint8_t expander)
+{
+    if (expander < EXPANDER_A || expander > EXPANDER_C)
+    {
+        return 0;
+    }
+    return max14830_fref[expander - EXPANDER_A];
+}
+
+
+
+
+
 
 
 
 
 /**
- * @brief Get recommended divisor values for common baud rates with 4MHz crystal
- * @param baudRate Desired baud rate
- * @return Divisor value (0 if baud rate not recommended)
+ * @brief Rates tried by MAX14830_TuneSpiClock(), slowest first
+ * @note uart_spi_set_bitrate() caps these at HFPERCLK / 2
  */
-uint16_t MAX14830_GetDivisorFor4MHz(uint32_t baudRate)
+static const uint32_t max14830_spi_steps[] =
 {
-    switch(baudRate)
+    MAX14830_SPI_START_FREQ, 1000000, 2000000, 4000000, 6000000, 8000000,
+    12000000, 16000000, 20000000, MAX14830_SPI_MAX_FREQ
+};
+
+#define MAX14830_SCRATCH_LEN        4           // XON1, XON2, XOFF1, XOFF2 (0x14 - 0x17) - unused with flow control off
+
+/**
+ * @brief Read REVID through extended addressing
+ * @note GLOBALCMD 0xCE maps the global registers 0x20 - 0x25 onto 0x00 - 0x05,
+ *       so MAX14830_REVID_REG goes out as 0x05. The bus lock keeps the
+ *       interrupt engine from reading IRQ / ISR while they're mapped away.
+ */
+uint8_t MAX14830_ReadRevId(uint8_t expander)
+{
+    uint8_t revid;
+
+    MAX14830_BusLock();
+    MAX14830_WriteRegister(expander, MAX14830_UART0, MAX14830_GLOBALCMD_REG, MAX14830_GLOBALCMD_EXTREG_ENABLE);
+    revid = MAX14830_ReadRegister(expander, MAX14830_UART0, MAX14830_REVID_REG);
+    MAX14830_WriteRegister(expander, MAX14830_UART0, MAX14830_GLOBALCMD_REG, MAX14830_GLOBALCMD_EXTREG_DISABLE);
+    MAX14830_BusUnlock();
+    return revid;
+}
+
+/**
+ * @brief Save / restore the scratch registers of every channel in a mask
+ */
+static void MAX14830_SaveScratch(uint8_t expander_mask, uint8_t saved[3][4][MAX14830_SCRATCH_LEN])
+{
+    for (uint8_t expander = EXPANDER_A; expander <= EXPANDER_C; expander++)
     {
-        case 1200:   return 208;  // 0.16% error
-        case 2400:   return 104;  // 0.16% error
-        case 4800:   return 52;   // 0.16% error
-        case 9600:   return 26;   // 0.16% error
-        case 19200:  return 13;   // 0.16% error
-        case 38400:  return 6;    // 4.17% error (acceptable)
-        case 57600:  return 4;    // 4.17% error (marginal)
-        case 115200: return 2;    // 8.33% error (not recommended)
-        default:     return 0;    // Calculate manually
+        if (expander_mask & (1 << (expander - EXPANDER_A)))
+        {
+            for (uint8_t uart = MAX14830_UART0; uart <= MAX14830_UART3; uart++)
+            {
+                MAX14830_ReadBurst(expander, uart, MAX14830_XON1_REG, saved[expander - EXPANDER_A][uart], MAX14830_SCRATCH_LEN);
+            }
+        }
     }
 }
 
+static void MAX14830_RestoreScratch(uint8_t expander_mask, uint8_t saved[3][4][MAX14830_SCRATCH_LEN])
+{
+    for (uint8_t expander = EXPANDER_A; expander <= EXPANDER_C; expander++)
+    {
+        if (expander_mask & (1 << (expander - EXPANDER_A)))
+        {
+            for (uint8_t uart = MAX14830_UART0; uart <= MAX14830_UART3; uart++)
+            {
+                MAX14830_WriteBurst(expander, uart, MAX14830_XON1_REG, saved[expander - EXPANDER_A][uart], MAX14830_SCRATCH_LEN);
+            }
+        }
+    }
+}
 
+/**
+ * @brief REVID reads and scratch round trips on every channel in a mask
+ * @note Patterns cycle 0x55 / 0xAA / 0xFF / 0x00 and are XORed with the
+ *       expander, channel and byte index, so a stuck line, a dropped bit or a
+ *       wrong channel address all show up as a mismatch
+ */
+static bool MAX14830_CheckLink(uint8_t expander_mask, uint8_t passes)
+{
+    static const uint8_t base[4] = { 0x55, 0xAA, 0xFF, 0x00 };
+    uint8_t pattern[MAX14830_SCRATCH_LEN];
+    uint8_t back[MAX14830_SCRATCH_LEN];
 
+    for (uint8_t pass = 0; pass < passes; pass++)
+    {
+        for (uint8_t expander = EXPANDER_A; expander <= EXPANDER_C; expander++)
+        {
+            if (!(expander_mask & (1 << (expander - EXPANDER_A))))
+            {
+                continue;
+            }
+            if (MAX14830_ReadRevId(expander) != MAX14830_REVID_DEFAULT)
+            {
+                return false;
+            }
+            for (uint8_t uart = MAX14830_UART0; uart <= MAX14830_UART3; uart++)
+            {
+                for (uint8_t i = 0; i < MAX14830_SCRATCH_LEN; i++)
+                {
+                    pattern[i] = base[(pass + i) % 4] ^ (uint8_t)(((expander - EXPANDER_A) << 4) | (uart << 2) | i);
+                }
+                MAX14830_WriteBurst(expander, uart, MAX14830_XON1_REG, pattern, MAX14830_SCRATCH_LEN);
+                MAX14830_ReadBurst(expander, uart, MAX14830_XON1_REG, back, MAX14830_SCRATCH_LEN);
+                for (uint8_t i = 0; i < MAX14830_SCRATCH_LEN; i++)
+                {
+                    if (back[i] != pattern[i])
+                    {
+                        return false;
+                    }
+                }
+            }
+        }
+    }
+    return true;
+}
 
+/**
+ * @brief Check the SPI link to several expanders at the current bit rate
+ * @param expander_mask Bit (expander - EXPANDER_A) per expander
+ * @param passes Number of REVID reads and scratch round trips per channel
+ * @return true if every read and round trip matched
+ */
+bool MAX14830_VerifyLink(uint8_t expander_mask, uint8_t passes)
+{
+    uint8_t saved[3][4][MAX14830_SCRATCH_LEN];
+    bool ok;
+
+    MAX14830_BusLock();
+    MAX14830_SaveScratch(expander_mask, saved);
+    ok = MAX14830_CheckLink(expander_mask, passes);
+    MAX14830_ShadowInvalidate(expander_mask);                                   // a failed check may have left anything behind
+    MAX14830_RestoreScratch(expander_mask, saved);
+    MAX14830_BusUnlock();
+    return ok;
+}
+
+/**
+ * @brief Wait for the LDMA SPI transaction queue to finish
+ * @note Completion comes from the SPI RX channel's done interrupt. When that
+ *       can't run (interrupts masked, or called from an ISR that outranks the
+ *       LDMA) the done flag is collected here instead, or this would wait forever.
+ */
+static void MAX14830_WaitSpiIdle(void)
+{
+    while (!spi_bus_idle())
+    {
+        if (CORE_IrqIsBlocked(LDMA_IRQn))
+        {
+            dma_poll_channel(DMA_CH_SPI_RX);
+        }
+    }
+}
+
+/**
+ * @brief Step the SPI bit rate up and keep the fastest rate that verifies
+ * @param expander_mask Bit (expander - EXPANDER_A) per expander - all must be powered and out of reset
+ * @param result Chosen rate, first failing rate and REVIDs (may be NULL)
+ * @return Rate settled on, Hz
+ * @note Each step gets MAX14830_SPI_STEP_PASSES checks and the sweep stops at
+ *       the first failure. The winner then has to survive
+ *       MAX14830_SPI_CONFIRM_PASSES more, or the previous step is used - a
+ *       rate that only just passed is no use for live traffic.
+ * @note Holds the bus lock throughout, so the interrupt engine waits
+ */
+uint32_t MAX14830_TuneSpiClock(uint8_t expander_mask, max14830_spi_tune_t *result)
+{
+    uint8_t saved[3][4][MAX14830_SCRATCH_LEN];
+    max14830_spi_tune_t tune = { 0 };
+    uint32_t previous = 0;
+
+    MAX14830_BusLock();
+    MAX14830_WaitSpiIdle();                                                     // the rate can't change under an LDMA transfer
+    uart_spi_set_bitrate(MAX14830_SPI_START_FREQ);
+    MAX14830_SaveScratch(expander_mask, saved);
+
+    for (uint8_t i = 0; i < sizeof(max14830_spi_steps) / sizeof(max14830_spi_steps[0]); i++)
+    {
+        uint32_t actual = uart_spi_set_bitrate(max14830_spi_steps[i]);
+
+        if (actual <= tune.bitrate)
+        {
+            continue;                                                           // capped or rounded onto a rate already passed
+        }
+        if (!MAX14830_CheckLink(expander_mask, MAX14830_SPI_STEP_PASSES))
+        {
+            tune.failed_at = actual;
+            break;
+        }
+        previous = tune.bitrate;
+        tune.bitrate = actual;
+        tune.steps++;
+    }
 
+    if (tune.bitrate)
+    {
+        uart_spi_set_bitrate(tune.bitrate);
+        if (!MAX14830_CheckLink(expander_mask, MAX14830_SPI_CONFIRM_PASSES))
+        {
+            tune.failed_at = tune.bitrate;
+            tune.bitrate = previous;
+            tune.steps--;
+        }
+    }
+    tune.ok = (tune.bitrate != 0);
+    tune.bitrate = uart_spi_set_bitrate(tune.ok ? tune.bitrate : MAX14830_SPI_START_FREQ);
+
+    MAX14830_ShadowInvalidate(expander_mask);                                   // writes at a failing rate may not have landed
+    MAX14830_RestoreScratch(expander_mask, saved);
+    for (uint8_t expander = EXPANDER_A; expander <= EXPANDER_C; expander++)
+    {
+        if (expander_mask & (1 << (expander - EXPANDER_A)))
+        {
+            tune.revid[expander - EXPANDER_A] = MAX14830_ReadRevId(expander);
+        }
+    }
+    MAX14830_BusUnlock();
+
+    if (result)
+    {
+        *result = tune;
+    }
+    return tune.bitrate;
+}
 
+static volatile uint8_t bus_lock_depth;                  // nesting count of MAX14830_BusLock()
+static uint32_t bus_irq_was_enabled;                     // GPIO_ODD_IRQn enable state when the lock was taken
 
+/**
+ * @brief Keep the expander interrupt service off the SPI bus
+ * @note Masks the PC5 (GPIO_ODD_IRQn) interrupt, so a main-context transaction
+ *       or read-modify sequence can't be split by the interrupt engine. Nests,
+ *       and is harmless when called from the interrupt itself.
+ */
+void MAX14830_BusLock(void)
+{
+    CORE_DECLARE_IRQ_STATE;
 
+    CORE_ENTER_ATOMIC();
+    if (bus_lock_depth++ == 0)
+    {
+        bus_irq_was_enabled = NVIC_GetEnableIRQ(GPIO_ODD_IRQn);
+        NVIC_DisableIRQ(GPIO_ODD_IRQn);
+    }
+    CORE_EXIT_ATOMIC();
+}
+
+/**
+ * @brief Release MAX14830_BusLock(), unmasking PC5 if it was enabled before
+ */
+void MAX14830_BusUnlock(void)
+{
+    CORE_DECLARE_IRQ_STATE;
+
+    CORE_ENTER_ATOMIC();
+    if (bus_lock_depth && --bus_lock_depth == 0 && bus_irq_was_enabled)
+    {
+        NVIC_EnableIRQ(GPIO_ODD_IRQn);
+    }
+    CORE_EXIT_ATOMIC();
+}
+
+/**
+ * @brief Drive the chip select of one expander
+ * @param expander Expander to select (EXPANDER_A/B/C)
+ * @param state Selected or Deselected
+ */
+static void MAX14830_ChipSelect(uint8_t expander, char state)
+{
+    if (state == Selected)
+    {
+        MAX14830_BusLock();                                                     // whole CS cycle is one transaction
+        while (!spi_bus_claim())                                                // queued LDMA transactions finish first,
+        {                                                                       // new ones wait for the deselect
+            MAX14830_WaitSpiIdle();
+        }
+    }
+    switch (expander)
+    {
+      case EXPANDER_A: Set_Expander_A_CS_State(state); break;
+      case EXPANDER_B: Set_Expander_B_CS_State(state); break;
+      case EXPANDER_C: Set_Expander_C_CS_State(state); break;
+    }
+    if (state == Deselected)
+    {
+        spi_bus_release();
+        MAX14830_BusUnlock();
+    }
+}
+
+/**
+ * @brief true if the shadow holds a known value for a register
+ */
+static bool MAX14830_ShadowValid(uint8_t expander, uint8_t uart_channel, uint8_t reg_addr)
+{
+    if (expander < EXPANDER_A || expander > EXPANDER_C || reg_addr >= 0x20)
+    {
+        return false;
+    }
+    return (max14830_shadow_valid[expander - EXPANDER_A][uart_channel & 0x03] & MAX14830_SHADOW_REG(reg_addr)) != 0;
+}
+
+/**
+ * @brief Record a value just written to a register
+ * @note A MODE2 reset puts the whole UART back to its reset values, so
+ *       everything cached for it is dropped
+ */
+static void MAX14830_ShadowStore(uint8_t expander, uint8_t uart_channel, uint8_t reg_addr, uint8_t value)
+{
+    uint32_t *valid;
+
+    if (expander < EXPANDER_A || expander > EXPANDER_C || reg_addr >= 0x20)
+    {
+        return;
+    }
+    valid = &max14830_shadow_valid[expander - EXPANDER_A][uart_channel & 0x03];
+
+    if (reg_addr == MAX14830_MODE2_REG && (value & MAX14830_MODE2_RST))
+    {
+        *valid = 0;
+    }
+    else if (!(MAX14830_SHADOW_CACHEABLE & MAX14830_SHADOW_REG(reg_addr)) ||
+             (reg_addr == MAX14830_MODE2_REG && (value & MAX14830_MODE2_FIFORST)))
+    {
+        *valid &= ~MAX14830_SHADOW_REG(reg_addr);
+    }
+    else
+    {
+        max14830_shadow[expander - EXPANDER_A][uart_channel & 0x03][reg_addr] = value;
+        *valid |= MAX14830_SHADOW_REG(reg_addr);
+    }
+}
+
+/**
+ * @brief true if a write would leave a register as it already is
+ */
+static bool MAX14830_ShadowHit(uint8_t expander, uint8_t uart_channel, uint8_t reg_addr, uint8_t value)
+{
+    return MAX14830_ShadowValid(expander, uart_channel, reg_addr) &&
+           max14830_shadow[expander - EXPANDER_A][uart_channel & 0x03][reg_addr] == value &&
+           !(reg_addr == MAX14830_MODE2_REG && (value & (MAX14830_MODE2_RST | MAX14830_MODE2_FIFORST)));
+}
+
+/**
+ * @brief Forget everything cached for some expanders
+ * @param expander_mask Bit (expander - EXPANDER_A) per expander
+ * @note Call after anything that changes registers behind the driver's back -
+ *       a reset pin, a power cycle, or writes that may not have landed
+ */
+void MAX14830_ShadowInvalidate(uint8_t expander_mask)
+{
+    for (uint8_t expander = 0; expander < 3; expander++)
+    {
+        if (expander_mask & (1 << expander))
+        {
+            for (uint8_t uart = MAX14830_UART0; uart <= MAX14830_UART3; uart++)
+            {
+                max14830_shadow_valid[expander][uart] = 0;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Last value written to a register, without touching the bus
+ * @param value Filled in when the shadow holds the register
+ * @return false if the register isn't cached or hasn't been written since a
+ *         reset or invalidate
+ */
+bool MAX14830_ShadowGet(uint8_t expander, uint8_t uart_channel, uint8_t reg_addr, uint8_t *value)
+{
+    if (!MAX14830_ShadowValid(expander, uart_channel, reg_addr))
+    {
+        return false;
+    }
+    *value = max14830_shadow[expander - EXPANDER_A][uart_channel & 0x03][reg_addr];
+    return true;
+}
+
+/**
+ * @brief SPI transactions the shadow cache has saved (skipped writes and reads)
+ */
+uint32_t MAX14830_ShadowSaved(void)
+{
+    return max14830_shadow_saved;
+}
+
+/**
+ * @brief Change some bits of a register and keep the rest
+ * @param expander Expander (EXPANDER_A/B/C)
+ * @param uart_channel UART channel (0-3)
+ * @param reg_addr Register address
+ * @param mask Bits to change
+ * @param value New value for those bits
+ * @return Value the register now holds
+ * @note A cached register needs no read back, and nothing is written if the
+ *       bits already match, so e.g. toggling LCR RTSBIT costs one write at most
+ */
+uint8_t MAX14830_UpdateBits(uint8_t expander, uint8_t uart_channel, uint8_t reg_addr, uint8_t mask, uint8_t value)
+{
+    uint8_t current;
+    uint8_t next;
+
+    MAX14830_BusLock();                                                         // read-modify-write is one step for the interrupt engine
+    if (MAX14830_ShadowValid(expander, uart_channel, reg_addr))
+    {
+        current = max14830_shadow[expander - EXPANDER_A][uart_channel & 0x03][reg_addr];
+        max14830_shadow_saved++;
+    }
+    else
+    {
+        current = MAX14830_ReadRegister(expander, uart_channel, reg_addr);
+    }
+    next = (uint8_t)((current & ~mask) | (value & mask));
+    MAX14830_WriteRegister(expander, uart_channel, reg_addr, (char)next);
+    MAX14830_BusUnlock();
+    return next;
+}
 
 /**
  * @brief Write a register on the MAX14830
@@ -163,102 +732,181 @@ void MAX14830_WriteRegister(uint8_t expander, uint8_t uart_channel, uint8_t reg_
                           ((uart_channel & 0x03) << 5) |                        // Set U1,U0 bits
                           (reg_addr & 0x1F);                                    // Set address bits A4-A0
 
-    switch (expander)                                                           // Select appropriate CS for the UART channel
+    MAX14830_BusLock();                                                         // cache check and write can't be split
+    if (MAX14830_ShadowHit(expander, uart_channel, reg_addr, (uint8_t)data))
     {
-      case EXPANDER_A: Set_Expander_A_CS_State(Selected); break;
-      case EXPANDER_B: Set_Expander_B_CS_State(Selected); break;
-      case EXPANDER_C: Set_Expander_C_CS_State(Selected); break;
+        max14830_shadow_saved++;                                                // already holds this value
+        MAX14830_BusUnlock();
+        return;
     }
 
+    MAX14830_ChipSelect(expander, Selected);                                    // Select appropriate CS for the UART channel
     hw_timer0_us_short(1);
     USART_SpiTransfer(USART4, command_byte);                                    // Send command byte with write bit
     USART_SpiTransfer(USART4, data);                                            // Send data byte
     hw_timer0_us_short(1);
-    switch (expander)
+    MAX14830_ChipSelect(expander, Deselected);
+    MAX14830_ShadowStore(expander, uart_channel, reg_addr, (uint8_t)data);
+    MAX14830_BusUnlock();
+}
+
+/**
+ * @brief Write a run of bytes to one register under a single chip select
+ * @param expander Expander to write (EXPANDER_A/B/C)
+ * @param uart_channel UART channel (0-3)
+ * @param reg_addr Register address - normally THR, so the bytes go into the TX FIFO
+ * @param buf Bytes to write
+ * @param len Number of bytes
+ * @note One command byte is followed by all the data bytes, so a burst costs
+ *       len + 1 SPI bytes and one CS cycle instead of 2 * len and len cycles
+ * @note The caller must make sure the TX FIFO has room for len bytes
+ */
+void MAX14830_WriteBurst(uint8_t expander, uint8_t uart_channel, uint8_t reg_addr, const uint8_t *buf, uint16_t len)
+{
+    uint8_t command_byte = 0x80 |                                               // Set W/R bit for write
+                          ((uart_channel & 0x03) << 5) |                        // Set U1,U0 bits
+                          (reg_addr & 0x1F);                                    // Set address bits A4-A0
+
+    bool unchanged = (reg_addr != MAX14830_THR_REG);
+
+    if (len == 0)
+    {
+        return;
+    }
+
+    MAX14830_BusLock();
+    for (uint16_t i = 0; unchanged && i < len; i++)                             // a register run that already matches is skipped whole
     {
-      case EXPANDER_A: Set_Expander_A_CS_State(Deselected); break;
-      case EXPANDER_B: Set_Expander_B_CS_State(Deselected); break;
-      case EXPANDER_C: Set_Expander_C_CS_State(Deselected); break;
+        unchanged = MAX14830_ShadowHit(expander, uart_channel, (uint8_t)(reg_addr + i), buf[i]);
+    }
+    if (unchanged)
+    {
+        max14830_shadow_saved++;
+        MAX14830_BusUnlock();
+        return;
     }
 
+    MAX14830_ChipSelect(expander, Selected);
+    hw_timer0_us_short(1);
+    USART_Tx(USART4, command_byte);                                             // Keep the TX double buffer full - nothing is read back
+    for (uint16_t i = 0; i < len; i++)
+    {
+        USART_Tx(USART4, buf[i]);
+    }
+    while (!(USART4->STATUS & USART_STATUS_TXC));                               // Last bit out before CS goes high
+    USART4->CMD = USART_CMD_CLEARRX;                                            // Discard the bytes clocked in meanwhile
+    hw_timer0_us_short(1);
+    MAX14830_ChipSelect(expander, Deselected);
+    for (uint16_t i = 0; reg_addr != MAX14830_THR_REG && i < len; i++)         // auto-increment - byte i landed in reg_addr + i
+    {
+        MAX14830_ShadowStore(expander, uart_channel, (uint8_t)(reg_addr + i), buf[i]);
+    }
+    MAX14830_BusUnlock();
 }
 
 /**
  * @brief Read a register from the MAX14830
- * @param uart_channel UART channel (0-3)  // FIXED: Added missing parameter
+ * @param expander Expander to read (EXPANDER_A/B/C)
+ * @param uart_channel UART channel (0-3)
  * @param reg_addr Register address
  * @return Register value
  */
-uint8_t MAX14830_ReadRegister(uint8_t uart_channel, uint8_t reg_addr)
+uint8_t MAX14830_ReadRegister(uint8_t expander, uint8_t uart_channel, uint8_t reg_addr)
 {
     uint8_t command_byte = 0x00 |                           // Clear W/R bit for read (bit 7 = 0)
                           ((uart_channel & 0x03) << 5) |    // Set U1,U0 bits
                           (reg_addr & 0x1F);                // Set address bits A4-A0
     uint8_t result;
 
-    Set_Expander_B_CS_State(Selected);
+    MAX14830_ChipSelect(expander, Selected);                // Select appropriate CS for the UART channel
     hw_timer0_us(2);
     USART_SpiTransfer(USART4, command_byte);  // Send command byte
     result = USART_SpiTransfer(USART4, 0x00); // Read data byte (send dummy)
-    Set_Expander_B_CS_State(Deselected);
+    MAX14830_ChipSelect(expander, Deselected);
 
     return result;
 }
 
 /**
- * @brief Send a character through MAX14830 UART1
- * @param character Character to send
+ * @brief Read a run of bytes from one register under a single chip select
+ * @param expander Expander to read (EXPANDER_A/B/C)
+ * @param uart_channel UART channel (0-3)
+ * @param reg_addr Register address - normally RHR, so the bytes come out of the RX FIFO
+ * @param buf Where to store the bytes
+ * @param len Number of bytes - no more than RXFIFOLVL when reading RHR
  */
-void MAX14830_SendChar(uint8_t expander, uint8_t uart_channel, char character)
+void MAX14830_ReadBurst(uint8_t expander, uint8_t uart_channel, uint8_t reg_addr, uint8_t *buf, uint16_t len)
 {
-    // Wait while TX FIFO is full (128 bytes max)
-    // FIXED: Added uart_channel parameter to ReadRegister call
-  //  while(MAX14830_ReadRegister(MAX14830_UART1, MAX14830_TXFIFOLVL_REG) >= 128);
-
-
-
-      MAX14830_WriteRegister(expander, uart_channel, MAX14830_THR_REG, character);
-
+    uint8_t command_byte = 0x00 |                           // Clear W/R bit for read (bit 7 = 0)
+                          ((uart_channel & 0x03) << 5) |    // Set U1,U0 bits
+                          (reg_addr & 0x1F);                // Set address bits A4-A0
 
-}
+    if (len == 0)
+    {
+        return;
+    }
 
-/**
- * @brief Receive a character from MAX14830 UART1
- * @return Received character, or 0 if no data available
- */
-uint8_t MAX14830_UART1_ReceiveChar(void)
-{
-    // Check if data is available in RX FIFO
-    if(MAX14830_ReadRegister(MAX14830_UART1, MAX14830_RXFIFOLVL_REG) > 0)
+    MAX14830_ChipSelect(expander, Selected);
+    hw_timer0_us_short(1);
+    USART_SpiTransfer(USART4, command_byte);
+    for (uint16_t i = 0; i < len; i++)
     {
-        return MAX14830_ReadRegister(MAX14830_UART1, MAX14830_RHR_REG);
+        buf[i] = USART_SpiTransfer(USART4, 0x00);
     }
-    return 0; // No data available
+    MAX14830_ChipSelect(expander, Deselected);
 }
 
 /**
- * @brief Check if MAX14830 UART1 has data available
- * @return 1 if data available, 0 if not
+ * @brief Send a character through an expander UART
+ * @param expander Expander (EXPANDER_A/B/C)
+ * @param uart_channel UART channel (0-3)
+ * @param character Character to send
+ * @note Goes through the channel's expander_write() queue, so the 128 byte
+ *       TX FIFO is never overrun. Waits with expander_tx_wait() if it is full.
  */
-uint8_t MAX14830_UART1_DataAvailable(void)
+void MAX14830_SendChar(uint8_t expander, uint8_t uart_channel, char character)
 {
-    return (MAX14830_ReadRegister(MAX14830_UART1, MAX14830_RXFIFOLVL_REG) > 0) ? 1 : 0;
-}
-
-
-
+    uint8_t ch = EXPANDER_CHANNEL(expander, uart_channel);
 
+    if (ch >= EXPANDER_CHANNEL_COUNT)
+    {
+        return;
+    }
+    while (expander_write(ch, &character, 1) == 0)
+    {
+        expander_tx_wait(ch);
+    }
+}
 
 /**
- * @brief Send a string through MAX14830 UART1
+ * @brief Send a string through an expander UART
+ * @param expander Expander (EXPANDER_A/B/C)
+ * @param uart_channel UART channel (0-3)
  * @param str Null-terminated string to send
+ * @note Queued with expander_write(), which burst-writes no more than the
+ *       TX FIFO has room for. Waits with expander_tx_wait() while the queue is
+ *       full, so a caller sending faster than the line rate is held back
+ *       instead of losing bytes, without polling TXFIFOLVL on every retry.
  */
 void MAX14830_SendString(uint8_t expander, uint8_t uart_channel, const char* str)
 {
-    while(*str)
+    uint8_t ch = EXPANDER_CHANNEL(expander, uart_channel);
+    uint16_t len = 0;
+    uint16_t sent;
+
+    if (ch >= EXPANDER_CHANNEL_COUNT)
     {
-        MAX14830_SendChar(expander, uart_channel, *str);
-        str++;
+        return;
+    }
+    while(str[len])
+    {
+        len++;
+    }
+    sent = expander_write(ch, str, len);
+    while (sent < len)
+    {
+        expander_tx_wait(ch);                                                   // queue full - no SPI until there is room
+        sent += expander_write(ch, &str[sent], len - sent);
     }
 }
 
@@ -266,28 +914,4 @@ void MAX14830_SendString(uint8_t expander, uint8_t uart_channel, const char* str
 
 
 
-/**
- * @brief Check for UART errors on MAX14830 UART1
- * @return Error flags from LSR register
- */
-uint8_t MAX14830_UART1_GetErrors(void)
-{
-    uint8_t lsr = MAX14830_ReadRegister(MAX14830_UART1, MAX14830_LSR_REG);
-    return lsr & (MAX14830_LSR_FRAMEERR | MAX14830_LSR_RXPARITYERR |
-                  MAX14830_LSR_RXOVERRUN | MAX14830_LSR_RXBREAK);
-}
-
-/**
- * @brief Clear UART errors on MAX14830 UART1
- */
-void MAX14830_UART1_ClearErrors(void)
-{
-    // Reading LSR register clears most error flags
-    uint8_t temp = MAX14830_ReadRegister(MAX14830_UART1, MAX14830_LSR_REG);
-    (void)temp; // Suppress unused variable warning
-
-    // Clear any pending error interrupts
-    temp = MAX14830_ReadRegister(MAX14830_UART1, MAX14830_ISR_REG);
-    (void)temp;
-}
 
@@ -21,11 +21,14 @@ extern "C" {
  *============================================================================*/
 #include <stdint.h>
 #include <stdbool.h>
+#include "max14830_baud.h"
 
 /*==============================================================================
  * MAX14830 REGISTER DEFINITIONS
  *============================================================================*/
 
+#define MAX14830_FIFO_SIZE      128   /**< Depth of each UART's TX and RX FIFO */
+
 /* MAX14830 Register Addresses */
 #define MAX14830_RHR_REG        0x00  /**< Receive Holding Register (Read) */
 #define MAX14830_THR_REG        0x00  /**< Transmit Holding Register (Write) */
@@ -84,6 +87,19 @@ extern "C" {
   #define MAX14830_IRQEN_SPCLCHRIEN       (1 << 1)  /**< Special Character Interrupt Enable */
   #define MAX14830_IRQEN_LSRERRIEN        (1 << 0)  /**< LSR Error Interrupt Enable */
 
+  /* ISR Register (0x02) Bit Definitions - cleared by reading */
+  #define MAX14830_ISR_CTSINT             (1 << 7)  /**< CTS Change */
+  #define MAX14830_ISR_RFIFOEMTYINT       (1 << 6)  /**< RX FIFO Empty */
+  #define MAX14830_ISR_TFIFOEMTYINT       (1 << 5)  /**< TX FIFO Empty */
+  #define MAX14830_ISR_TFIFOTRIGINT       (1 << 4)  /**< TX FIFO Trigger Level */
+  #define MAX14830_ISR_RFIFOTRIGINT       (1 << 3)  /**< RX FIFO Trigger Level */
+  #define MAX14830_ISR_STSINT             (1 << 2)  /**< Status (STSInt) */
+  #define MAX14830_ISR_SPCHARINT          (1 << 1)  /**< Special Character */
+  #define MAX14830_ISR_LSRERRINT          (1 << 0)  /**< LSR Error (LSRIntEn sources) */
+
+  /* GLOBALIRQ Register (0x1F read) - one bit per UART, active low */
+  #define MAX14830_GLOBALIRQ_IRQ(uart)    (1 << (uart))  /**< 0 = UART has an interrupt pending */
+
   /* LSR Register (0x04) Bit Definitions */
   #define MAX14830_LSR_CTSBIT             (1 << 7)  /**< CTS Bit */
   #define MAX14830_LSR_RXNOISE            (1 << 5)  /**< RX Noise */
@@ -149,6 +165,10 @@ extern "C" {
   /* Default Reset Values */
   #define MAX14830_REVID_DEFAULT          0xB4      /**< Revision ID Default */
 
+  /* GlobalCmd Register (0x1F, write) Commands */
+  #define MAX14830_GLOBALCMD_EXTREG_ENABLE  0xCE    /**< Map the global registers (0x20 - 0x25) onto 0x00 - 0x05 */
+  #define MAX14830_GLOBALCMD_EXTREG_DISABLE 0xCD    /**< Back to normal addressing */
+
   /* MAX14830 UART Channel Selection */
   #define MAX14830_UART0          0x00  /**< UART Channel 0 */
   #define MAX14830_UART1          0x01  /**< UART Channel 1 */
@@ -158,6 +178,8 @@ extern "C" {
   /* SPI Configuration */
   #define MAX14830_SPI_WRITE      0x80  /**< Write bit for SPI command */
   #define MAX14830_SPI_READ       0x00  /**< Read bit for SPI command */
+  #define MAX14830_COMMAND(write, uart, reg)  ((uint8_t)(((write) ? MAX14830_SPI_WRITE : MAX14830_SPI_READ) | \
+                                               (((uart) & 0x03) << 5) | ((reg) & 0x1F)))  /**< SPI command byte, e.g. for spi_bus transactions */
 
 
   #define EXPANDER_A  1
@@ -165,6 +187,45 @@ extern "C" {
   #define EXPANDER_C  3
 
 
+/*==============================================================================
+ * INITIALISATION TYPES
+ *============================================================================*/
+
+#define MAX14830_ALL_EXPANDERS      0x07        /**< MAX14830_InitExpanders() mask for A, B and C */
+#define MAX14830_INIT_TIMEOUT_US    20000       /**< Give up on a readiness poll stage after this long */
+#define MAX14830_BAUD_MAX_ERROR_PPM 20000       /**< MAX14830_SetBaud() refuses rates further off than 2% */
+
+/** @brief Line settings for one UART channel */
+typedef struct {
+    uint8_t lcr;                    /**< LCR value (word length, parity, stop bits) */
+    uint32_t baud;                  /**< Baud rate in Hz */
+    uint8_t fifotrig;               /**< FIFOTRIGLVL value */
+} max14830_channel_config_t;
+
+/** @brief Bring-up timing reported by MAX14830_InitExpanders() */
+typedef struct {
+    uint32_t reset_us;              /**< Reset until every channel reads DIVLSB back */
+    uint32_t clock_us;              /**< PLL start until every CLKREADY */
+    uint32_t config_us;             /**< Burst configuration of every channel */
+    uint32_t total_us;
+    uint16_t polls;                 /**< Readiness register reads */
+    bool ok;
+} max14830_init_timing_t;
+
+#define MAX14830_SPI_START_FREQ     500000      /**< Bring-up rate, known to work with the weakest drive */
+#define MAX14830_SPI_MAX_FREQ       26000000    /**< MAX14830 SCLK limit */
+#define MAX14830_SPI_STEP_PASSES    4           /**< Link checks at each step of MAX14830_TuneSpiClock() */
+#define MAX14830_SPI_CONFIRM_PASSES 32          /**< Link checks on the rate finally chosen */
+
+/** @brief Result of MAX14830_TuneSpiClock() */
+typedef struct {
+    uint32_t bitrate;               /**< Rate settled on, Hz */
+    uint32_t failed_at;             /**< First rate that failed, 0 if none did */
+    uint8_t revid[3];               /**< REVID read from A, B and C (0 if not in the mask) */
+    uint8_t steps;                  /**< Rates that passed */
+    bool ok;                        /**< false if even MAX14830_SPI_START_FREQ failed */
+} max14830_spi_tune_t;
+
 /*==============================================================================
  * FUNCTION PROTOTYPES
  *============================================================================*/
@@ -180,16 +241,65 @@ extern "C" {
  * @param uart_channel UART channel (0-3)
  * @param reg_addr Register address (0x00-0x25)
  * @param data Data to write
+ * @note Skipped if the shadow cache shows the register already holds data
  */
 void MAX14830_WriteRegister(uint8_t expander, uint8_t uart_channel, uint8_t reg_addr, char data);
 
 /**
  * @brief Read a register from the MAX14830
+ * @param expander Expander to read (EXPANDER_A/B/C)
  * @param uart_channel UART channel (0-3)
  * @param reg_addr Register address (0x00-0x25)
  * @return Register value
+ * @note The UART1 helpers below read Expander B
  */
-uint8_t MAX14830_ReadRegister(uint8_t uart_channel, uint8_t reg_addr);
+uint8_t MAX14830_ReadRegister(uint8_t expander, uint8_t uart_channel, uint8_t reg_addr);
+
+/**
+ * @brief Write a run of bytes to one register under a single chip select
+ * @param expander Expander to write (EXPANDER_A/B/C)
+ * @param uart_channel UART channel (0-3)
+ * @param reg_addr Register address (normally THR)
+ * @param buf Bytes to write
+ * @param len Number of bytes
+ */
+void MAX14830_WriteBurst(uint8_t expander, uint8_t uart_channel, uint8_t reg_addr, const uint8_t *buf, uint16_t len);
+
+/**
+ * @brief Read a run of bytes from one register under a single chip select
+ * @param expander Expander to read (EXPANDER_A/B/C)
+ * @param uart_channel UART channel (0-3)
+ * @param reg_addr Register address (normally RHR)
+ * @param buf Where to store the bytes
+ * @param len Number of bytes
+ */
+void MAX14830_ReadBurst(uint8_t expander, uint8_t uart_channel, uint8_t reg_addr, uint8_t *buf, uint16_t len);
+
+/**
+ * @brief Mask the expander interrupt (PC5) around main-context SPI sequences
+ * @note Every register access takes the lock itself - only needed to keep
+ *       several accesses together
+ */
+void MAX14830_BusLock(void);
+void MAX14830_BusUnlock(void);
+
+/**
+ * @brief Change some bits of a register and keep the rest
+ * @param mask Bits to change
+ * @param value New value for those bits
+ * @return Value the register now holds
+ * @note Registers in the shadow cache need no read back
+ */
+uint8_t MAX14830_UpdateBits(uint8_t expander, uint8_t uart_channel, uint8_t reg_addr, uint8_t mask, uint8_t value);
+
+/**
+ * @brief Shadow cache of the writable registers
+ * @note Writes of a value a register already holds are skipped. Invalidate
+ *       after a reset pin or power cycle; MODE2 RST is tracked automatically.
+ */
+void MAX14830_ShadowInvalidate(uint8_t expander_mask);
+bool MAX14830_ShadowGet(uint8_t expander, uint8_t uart_channel, uint8_t reg_addr, uint8_t *value);
+uint32_t MAX14830_ShadowSaved(void);
 
 /** @} */
 
@@ -200,11 +310,43 @@ uint8_t MAX14830_ReadRegister(uint8_t uart_channel, uint8_t reg_addr);
  */
 
 /**
- * @brief Complete initialization function for MAX14830 UART1 with 4MHz crystal
- * @note Configures UART1 for 9600 baud, 8N1 format with standard settings
+ * @brief Complete initialization function for one MAX14830 with 4MHz crystal
+ * @note Configures all four UARTs for 9600 baud, 8N1 format with standard settings
  */
 void MAX14830_UART_Init(uint8_t expander);
 
+/**
+ * @brief Bring up several expanders together, polling for readiness
+ * @param expander_mask Bit (expander - EXPANDER_A) per expander, e.g. MAX14830_ALL_EXPANDERS
+ * @param timing Per-stage timings (may be NULL)
+ * @return true if every channel left reset and every clock became ready in time
+ */
+bool MAX14830_InitExpanders(uint8_t expander_mask, max14830_init_timing_t *timing);
+
+/**
+ * @brief Read REVID through extended addressing
+ * @param expander Expander (EXPANDER_A/B/C)
+ * @return REVID, MAX14830_REVID_DEFAULT on a working link
+ */
+uint8_t MAX14830_ReadRevId(uint8_t expander);
+
+/**
+ * @brief Check the SPI link to several expanders at the current bit rate
+ * @param expander_mask Bit (expander - EXPANDER_A) per expander
+ * @param passes Number of REVID reads and scratch register round trips per channel
+ * @return true if every read and round trip matched
+ * @note The XON / XOFF registers are used as scratch and restored afterwards
+ */
+bool MAX14830_VerifyLink(uint8_t expander_mask, uint8_t passes);
+
+/**
+ * @brief Step the SPI bit rate up from MAX14830_SPI_START_FREQ and keep the fastest that verifies
+ * @param expander_mask Bit (expander - EXPANDER_A) per expander - all must be powered and out of reset
+ * @param result Chosen rate, first failing rate and REVIDs (may be NULL)
+ * @return Rate settled on, Hz
+ */
+uint32_t MAX14830_TuneSpiClock(uint8_t expander_mask, max14830_spi_tune_t *result);
+
 /**
  * @brief Initialize UART1 with custom baud rate (4MHz crystal optimized)
  * @param baudRate Desired baud rate (1200, 2400, 4800, 9600, 19200, 38400, 57600, 115200)
@@ -226,20 +368,16 @@ uint8_t MAX14830_UART1_IsReady(void);
  */
 
 /**
- * @brief Send a character through MAX14830 UART1
+ * @brief Send a character through a MAX14830 UART
  * @param character Character to send (0x00-0xFF)
  */
-void MAX14830_SendString(uint8_t expander, uint8_t uart_channel, const char* str);
-
-/**
- * @brief Receive a character from MAX14830 UART1
- * @return Received character, or 0 if no data available
- */
-uint8_t MAX14830_UART1_ReceiveChar(void);
+void MAX14830_SendChar(uint8_t expander, uint8_t uart_channel, char character);
 
 /**
- * @brief Send a null-terminated string through MAX14830 UART1
+ * @brief Send a null-terminated string through a MAX14830 UART
  * @param str Pointer to null-terminated string to send
+ * @note Queued through expander_write(), so any length is fine - waits while
+ *       the channel's TX queue is full
  */
 void MAX14830_SendString(uint8_t expander, uint8_t uart_channel, const char* str);
 
@@ -247,42 +385,38 @@ void MAX14830_SendString(uint8_t expander, uint8_t uart_channel, const char* str
 
 /**
  * @defgroup MAX14830_Status Status and Error Functions
- * @brief Data availability and error checking functions
+ * @brief Receive, availability and error queries for all 12 channels live in
+ *        expander_io.h (expander_read(), expander_available(), expander_get_rx_stats())
  * @{
  */
 
-/**
- * @brief Check if MAX14830 UART1 has data available to read
- * @return 1 if data available, 0 if no data
- */
-uint8_t MAX14830_UART1_DataAvailable(void);
+/** @} */
 
 /**
- * @brief Check for UART errors on MAX14830 UART1
- * @return Error flags from LSR register (frame, parity, overrun, break errors)
+ * @defgroup MAX14830_Utility Utility Functions
+ * @brief Helper functions for baud rate calculation and diagnostics
+ * @{
  */
-uint8_t MAX14830_UART1_GetErrors(void);
 
 /**
- * @brief Clear UART errors on MAX14830 UART1
- * @note Clears error flags by reading status registers
+ * @brief Change one channel's baud rate at run time (see max14830_baud.h)
+ * @param expander Expander (EXPANDER_A/B/C)
+ * @param uart_channel UART channel (0-3)
+ * @param baud Requested rate in Hz
+ * @param result Divisor, achieved rate and error (may be NULL)
+ * @return false if the rate can't be produced within MAX14830_BAUD_MAX_ERROR_PPM
  */
-void MAX14830_UART1_ClearErrors(void);
-
-/** @} */
+bool MAX14830_SetBaud(uint8_t expander, uint8_t uart_channel, uint32_t baud, max14830_divisor_t *result);
 
 /**
- * @defgroup MAX14830_Utility Utility Functions
- * @brief Helper functions for baud rate calculation and diagnostics
- * @{
+ * @brief Rate last programmed on a channel
  */
+uint32_t MAX14830_GetBaud(uint8_t expander, uint8_t uart_channel);
 
 /**
- * @brief Get recommended divisor values for common baud rates with 4MHz crystal
- * @param baudRate Desired baud rate
- * @return Divisor value (0 if baud rate not recommended/supported)
+ * @brief Reference clock (fREF) of an expander in Hz
  */
-uint16_t MAX14830_GetDivisorFor4MHz(uint32_t baudRate);
+uint32_t MAX14830_GetReferenceClock(uint8_t expander);
 
 /** @} */
 